@@ -0,0 +1,307 @@
+#include "bc_encoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "kat/utils/simd.hpp"
+
+namespace kat {
+    namespace {
+        constexpr size_t BLOCK_ROWS_PER_JOB = 4;
+
+        // 4x4 texels, always RGBA
+        struct Block {
+            alignas(16) uint8_t texels[16][4];
+        };
+
+        void fetch_block(const Image &image, uint32_t block_x, uint32_t block_y, Block &block) {
+            const uint32_t  channels = image.channels;
+            const std::byte *pixels  = image.pixels.data();
+
+            for (uint32_t y = 0; y < 4; y++) {
+                // partial blocks at the edges repeat the last row/column
+                const uint32_t sy = std::min(block_y * 4 + y, image.height - 1);
+                for (uint32_t x = 0; x < 4; x++) {
+                    const uint32_t   sx  = std::min(block_x * 4 + x, image.width - 1);
+                    const std::byte *src = pixels + (static_cast<size_t>(sy) * image.width + sx) * channels;
+                    uint8_t         *dst = block.texels[y * 4 + x];
+
+                    dst[0] = dst[1] = dst[2] = 0;
+                    dst[3]                   = 255;
+                    for (uint32_t c = 0; c < std::min(channels, 4u); c++) {
+                        dst[c] = static_cast<uint8_t>(src[c]);
+                    }
+                    if (channels == 1)
+                        dst[1] = dst[2] = dst[0];
+                }
+            }
+        }
+
+        uint16_t to_565(const int color[3]) {
+            return static_cast<uint16_t>((color[0] * 31 + 127) / 255 << 11 | (color[1] * 63 + 127) / 255 << 5 |
+                                         (color[2] * 31 + 127) / 255);
+        }
+
+        void from_565(uint16_t c, int color[3]) {
+            const int r = c >> 11 & 31, g = c >> 5 & 63, b = c & 31;
+            color[0]    = r << 3 | r >> 2;
+            color[1]    = g << 2 | g >> 4;
+            color[2]    = b << 3 | b >> 2;
+        }
+
+        // dot((texel - origin), axis) of all 16 texels, rgb only
+        void project(const Block &block, const int origin[3], const int axis[3], int32_t out[16]) {
+#ifdef KAT_SIMD_SSE2
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i o    = _mm_setr_epi16(static_cast<short>(origin[0]), static_cast<short>(origin[1]),
+                                                static_cast<short>(origin[2]), 0, static_cast<short>(origin[0]),
+                                                static_cast<short>(origin[1]), static_cast<short>(origin[2]), 0);
+            const __m128i a    = _mm_setr_epi16(static_cast<short>(axis[0]), static_cast<short>(axis[1]),
+                                                static_cast<short>(axis[2]), 0, static_cast<short>(axis[0]),
+                                                static_cast<short>(axis[1]), static_cast<short>(axis[2]), 0);
+
+            for (int i = 0; i < 16; i += 4) {
+                const __m128i texels = _mm_load_si128(reinterpret_cast<const __m128i *>(block.texels[i]));
+
+                // widen two texels at a time, madd leaves (r*ar + g*ag, b*ab) per texel
+                const __m128i lo = _mm_madd_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(texels, zero), o), a);
+                const __m128i hi = _mm_madd_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(texels, zero), o), a);
+
+                const __m128i lo_sum = _mm_add_epi32(lo, _mm_srli_epi64(lo, 32));
+                const __m128i hi_sum = _mm_add_epi32(hi, _mm_srli_epi64(hi, 32));
+
+                // lanes 0 and 2 of each sum hold the dots
+                const __m128i dots = _mm_castps_si128(
+                    _mm_shuffle_ps(_mm_castsi128_ps(lo_sum), _mm_castsi128_ps(hi_sum), _MM_SHUFFLE(2, 0, 2, 0)));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), dots);
+            }
+#else
+            for (int i = 0; i < 16; i++) {
+                out[i] = (block.texels[i][0] - origin[0]) * axis[0] + (block.texels[i][1] - origin[1]) * axis[1] +
+                         (block.texels[i][2] - origin[2]) * axis[2];
+            }
+#endif
+        }
+
+        void encode_color_block(const Block &block, uint8_t *out) {
+            int min[3] = { 255, 255, 255 }, max[3] = { 0, 0, 0 };
+#ifdef KAT_SIMD_SSE2
+            __m128i lo = _mm_set1_epi8(-1), hi = _mm_setzero_si128();
+            for (int i = 0; i < 16; i += 4) {
+                const __m128i texels = _mm_load_si128(reinterpret_cast<const __m128i *>(block.texels[i]));
+                lo                   = _mm_min_epu8(lo, texels);
+                hi                   = _mm_max_epu8(hi, texels);
+            }
+            // fold the four texels in each register down to one
+            lo = _mm_min_epu8(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)));
+            lo = _mm_min_epu8(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+            hi = _mm_max_epu8(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2)));
+            hi = _mm_max_epu8(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(2, 3, 0, 1)));
+
+            const auto lo_bits = static_cast<uint32_t>(_mm_cvtsi128_si32(lo));
+            const auto hi_bits = static_cast<uint32_t>(_mm_cvtsi128_si32(hi));
+            for (int c = 0; c < 3; c++) {
+                min[c] = static_cast<int>(lo_bits >> (c * 8) & 0xFF);
+                max[c] = static_cast<int>(hi_bits >> (c * 8) & 0xFF);
+            }
+#else
+            for (const auto &texel : block.texels) {
+                for (int c = 0; c < 3; c++) {
+                    min[c] = std::min<int>(min[c], texel[c]);
+                    max[c] = std::max<int>(max[c], texel[c]);
+                }
+            }
+#endif
+
+            // The box diagonal from min to max only follows the colours when they are positively correlated, flip
+            // green and blue along red where the covariance says otherwise.
+            int center[3], covariance[2] = { 0, 0 };
+            for (int c = 0; c < 3; c++) {
+                center[c] = (min[c] + max[c]) / 2;
+            }
+            for (const auto &texel : block.texels) {
+                const int r = texel[0] - center[0];
+                covariance[0] += r * (texel[1] - center[1]);
+                covariance[1] += r * (texel[2] - center[2]);
+            }
+            if (covariance[0] < 0)
+                std::swap(min[1], max[1]);
+            if (covariance[1] < 0)
+                std::swap(min[2], max[2]);
+
+            // pull the endpoints in a little, the extremes are usually outliers
+            for (int c = 0; c < 3; c++) {
+                const int inset = (max[c] - min[c]) / 16;
+                min[c] += inset;
+                max[c] -= inset;
+            }
+
+            uint16_t c0 = to_565(max), c1 = to_565(min);
+            if (c0 < c1)
+                std::swap(c0, c1);
+
+            uint32_t indices = 0;
+            if (c0 != c1) {
+                int e0[3], e1[3];
+                from_565(c0, e0);
+                from_565(c1, e1);
+
+                const int axis[3] = { e0[0] - e1[0], e0[1] - e1[1], e0[2] - e1[2] };
+                const int length  = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+                int32_t dots[16];
+                project(block, e1, axis, dots);
+
+                // position along c1 -> c0 in thirds, mapped to the palette order c0, c1, 2/3 c0, 1/3 c0
+                constexpr uint32_t ORDER[4] = { 1, 3, 2, 0 };
+                for (int i = 0; i < 16; i++) {
+                    const int t = std::clamp((6 * dots[i] + length) / (2 * length), 0, 3);
+                    indices |= ORDER[t] << (i * 2);
+                }
+            }
+
+            std::memcpy(out, &c0, 2);
+            std::memcpy(out + 2, &c1, 2);
+            std::memcpy(out + 4, &indices, 4);
+        }
+
+        void encode_channel_block(const Block &block, int channel, uint8_t *out) {
+            alignas(16) uint8_t values[16];
+            for (int i = 0; i < 16; i++) {
+                values[i] = block.texels[i][channel];
+            }
+
+            uint8_t min = 255, max = 0;
+            for (const uint8_t v : values) {
+                min = std::min(min, v);
+                max = std::max(max, v);
+            }
+
+            out[0] = max;
+            out[1] = min;
+
+            uint64_t indices = 0;
+            if (max != min) {
+                // position from max (0) to min (7) in sevenths, mapped to the palette order a0, a1, then a0 -> a1
+                uint8_t positions[16];
+#ifdef KAT_SIMD_SSE2
+                const __m128  scale  = _mm_set1_ps(7.0f / static_cast<float>(max - min));
+                const __m128  top    = _mm_set1_ps(static_cast<float>(max));
+                const __m128  half   = _mm_set1_ps(0.5f);
+                const __m128i packed = _mm_load_si128(reinterpret_cast<const __m128i *>(values));
+                const __m128i zero   = _mm_setzero_si128();
+
+                const __m128i words[2] = { _mm_unpacklo_epi8(packed, zero), _mm_unpackhi_epi8(packed, zero) };
+                __m128i       t[4];
+                for (int i = 0; i < 2; i++) {
+                    const __m128 a = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words[i], zero));
+                    const __m128 b = _mm_cvtepi32_ps(_mm_unpackhi_epi16(words[i], zero));
+                    t[i * 2]       = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(top, a), scale), half));
+                    t[i * 2 + 1]   = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(top, b), scale), half));
+                }
+                const __m128i narrow = _mm_packus_epi16(_mm_packs_epi32(t[0], t[1]), _mm_packs_epi32(t[2], t[3]));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(positions), narrow);
+#else
+                for (int i = 0; i < 16; i++) {
+                    positions[i] = static_cast<uint8_t>(((max - values[i]) * 14 + (max - min)) / (2 * (max - min)));
+                }
+#endif
+                for (int i = 0; i < 16; i++) {
+                    const uint64_t t     = std::min<uint8_t>(positions[i], 7);
+                    const uint64_t index = t == 0 ? 0 : t == 7 ? 1 : t + 1;
+                    indices |= index << (i * 3);
+                }
+            }
+
+            for (int i = 0; i < 6; i++) {
+                out[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+            }
+        }
+    } // namespace
+
+    TextureFormat bc_texture_format(BcFormat format, bool srgb) {
+        switch (format) {
+        case BcFormat::Bc1:
+            return srgb ? TextureFormat::Bc1Srgb : TextureFormat::Bc1Rgb;
+        case BcFormat::Bc3:
+            return srgb ? TextureFormat::Bc3Srgb : TextureFormat::Bc3;
+        case BcFormat::Bc4:
+            return TextureFormat::Bc4;
+        case BcFormat::Bc5:
+            return TextureFormat::Bc5;
+        }
+        throw std::runtime_error("Unknown BC format");
+    }
+
+    std::vector<std::byte> encode_bc(const Image &image, BcFormat format,
+                                     const std::shared_ptr<JobSystem> &job_system) {
+        if (image.hdr)
+            throw std::runtime_error("BC1-BC5 encoding needs an 8 bit image");
+        if (image.empty())
+            return {};
+
+        const uint32_t blocks_x   = (image.width + 3) / 4;
+        const uint32_t blocks_y   = (image.height + 3) / 4;
+        const size_t   block_size = format == BcFormat::Bc1 || format == BcFormat::Bc4 ? 8 : 16;
+
+        std::vector<std::byte> output(static_cast<size_t>(blocks_x) * blocks_y * block_size);
+
+        auto encode_rows = [&](size_t begin, size_t end) {
+            Block block;
+            for (size_t by = begin; by < end; by++) {
+                for (uint32_t bx = 0; bx < blocks_x; bx++) {
+                    auto *out = reinterpret_cast<uint8_t *>(output.data()) + (by * blocks_x + bx) * block_size;
+                    fetch_block(image, bx, static_cast<uint32_t>(by), block);
+
+                    switch (format) {
+                    case BcFormat::Bc1:
+                        encode_color_block(block, out);
+                        break;
+                    case BcFormat::Bc3:
+                        encode_channel_block(block, 3, out);
+                        encode_color_block(block, out + 8);
+                        break;
+                    case BcFormat::Bc4:
+                        encode_channel_block(block, 0, out);
+                        break;
+                    case BcFormat::Bc5:
+                        encode_channel_block(block, 0, out);
+                        encode_channel_block(block, 1, out + 8);
+                        break;
+                    }
+                }
+            }
+        };
+
+        if (job_system)
+            job_system->parallel_for(blocks_y, BLOCK_ROWS_PER_JOB, encode_rows);
+        else
+            encode_rows(0, blocks_y);
+
+        return output;
+    }
+
+    CompressedTexture compress_mip_chain(std::span<const Image> chain, BcFormat format, bool srgb,
+                                         const std::shared_ptr<JobSystem> &job_system) {
+        if (chain.empty())
+            throw std::runtime_error("Cannot compress an empty mip chain");
+
+        CompressedTexture texture;
+        texture.format = bc_texture_format(format, srgb);
+        texture.width  = chain.front().width;
+        texture.height = chain.front().height;
+        texture.levels = static_cast<uint32_t>(chain.size());
+
+        for (uint32_t level = 0; level < chain.size(); level++) {
+            const std::vector<std::byte> blocks = encode_bc(chain[level], format, job_system);
+
+            texture.subresources.push_back(
+                { level, 0, chain[level].width, chain[level].height, texture.data.size(), blocks.size() });
+            texture.data.insert(texture.data.end(), blocks.begin(), blocks.end());
+        }
+
+        return texture;
+    }
+
+} // namespace kat
@@ -0,0 +1,32 @@
+#pragma once
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "kat/assets/compressed_texture.hpp"
+#include "kat/assets/image.hpp"
+#include "kat/utils/job_system.hpp"
+
+namespace kat {
+
+    enum class BcFormat {
+        Bc1, // RGB, 4 bpp
+        Bc3, // RGBA, 8 bpp
+        Bc4, // R, 4 bpp
+        Bc5, // RG, 8 bpp (normal maps)
+    };
+
+    [[nodiscard]] TextureFormat bc_texture_format(BcFormat format, bool srgb);
+
+    // Real-time quality block compression of an 8 bit image: bounding box endpoints with inset, texels snapped to the
+    // nearest palette entry. Images with fewer than four channels read missing colour channels as 0 and alpha as 255,
+    // single channel images are treated as grey. Block rows are spread over the job system when one is given.
+    std::vector<std::byte> encode_bc(const Image &image, BcFormat format,
+                                     const std::shared_ptr<JobSystem> &job_system = nullptr);
+
+    // Compresses a mip chain (for example from generate_mip_chain) into a texture for upload or save_ktx2. sRGB only
+    // picks the format variant, the data is encoded as is.
+    CompressedTexture compress_mip_chain(std::span<const Image> chain, BcFormat format, bool srgb,
+                                         const std::shared_ptr<JobSystem> &job_system = nullptr);
+
+} // namespace kat
@@ -0,0 +1,370 @@
+#include "compressed_texture.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include "kat/utils/mapped_file.hpp"
+
+namespace kat {
+    namespace {
+        constexpr uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32,
+                                                  0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+        constexpr size_t KTX2_HEADER_SIZE      = 80;
+        constexpr size_t KTX2_LEVEL_INDEX_SIZE = 24;
+
+        constexpr uint32_t DDS_MAGIC                     = 0x20534444; // "DDS "
+        constexpr size_t   DDS_HEADER_END                = 128;
+        constexpr size_t   DDS_DX10_HEADER_SIZE          = 20;
+        constexpr uint32_t DDSCAPS2_CUBEMAP              = 0x200;
+        constexpr uint32_t DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+        struct FormatCode {
+            uint32_t      code;
+            TextureFormat format;
+        };
+
+        constexpr FormatCode VK_FORMATS[] = {
+            { 131, TextureFormat::Bc1Rgb },
+            { 132, TextureFormat::Bc1Srgb },
+            { 133, TextureFormat::Bc1Rgba },
+            { 134, TextureFormat::Bc1SrgbAlpha },
+            { 135, TextureFormat::Bc2 },
+            { 136, TextureFormat::Bc2Srgb },
+            { 137, TextureFormat::Bc3 },
+            { 138, TextureFormat::Bc3Srgb },
+            { 139, TextureFormat::Bc4 },
+            { 140, TextureFormat::Bc4Signed },
+            { 141, TextureFormat::Bc5 },
+            { 142, TextureFormat::Bc5Signed },
+            { 143, TextureFormat::Bc6hUfloat },
+            { 144, TextureFormat::Bc6hSfloat },
+            { 145, TextureFormat::Bc7 },
+            { 146, TextureFormat::Bc7Srgb },
+        };
+
+        // typeless variants load as unorm
+        constexpr FormatCode DXGI_FORMATS[] = {
+            { 70, TextureFormat::Bc1Rgba },
+            { 71, TextureFormat::Bc1Rgba },
+            { 72, TextureFormat::Bc1SrgbAlpha },
+            { 73, TextureFormat::Bc2 },
+            { 74, TextureFormat::Bc2 },
+            { 75, TextureFormat::Bc2Srgb },
+            { 76, TextureFormat::Bc3 },
+            { 77, TextureFormat::Bc3 },
+            { 78, TextureFormat::Bc3Srgb },
+            { 79, TextureFormat::Bc4 },
+            { 80, TextureFormat::Bc4 },
+            { 81, TextureFormat::Bc4Signed },
+            { 82, TextureFormat::Bc5 },
+            { 83, TextureFormat::Bc5 },
+            { 84, TextureFormat::Bc5Signed },
+            { 94, TextureFormat::Bc6hUfloat },
+            { 95, TextureFormat::Bc6hUfloat },
+            { 96, TextureFormat::Bc6hSfloat },
+            { 97, TextureFormat::Bc7 },
+            { 98, TextureFormat::Bc7 },
+            { 99, TextureFormat::Bc7Srgb },
+        };
+
+        constexpr uint32_t fourcc(const char (&s)[5]) {
+            return static_cast<uint32_t>(s[0]) | static_cast<uint32_t>(s[1]) << 8 | static_cast<uint32_t>(s[2]) << 16 |
+                   static_cast<uint32_t>(s[3]) << 24;
+        }
+
+        constexpr FormatCode FOURCC_FORMATS[] = {
+            { fourcc("DXT1"), TextureFormat::Bc1Rgba },
+            { fourcc("DXT2"), TextureFormat::Bc2 },
+            { fourcc("DXT3"), TextureFormat::Bc2 },
+            { fourcc("DXT4"), TextureFormat::Bc3 },
+            { fourcc("DXT5"), TextureFormat::Bc3 },
+            { fourcc("ATI1"), TextureFormat::Bc4 },
+            { fourcc("BC4U"), TextureFormat::Bc4 },
+            { fourcc("BC4S"), TextureFormat::Bc4Signed },
+            { fourcc("ATI2"), TextureFormat::Bc5 },
+            { fourcc("BC5U"), TextureFormat::Bc5 },
+            { fourcc("BC5S"), TextureFormat::Bc5Signed },
+        };
+
+        template <size_t N>
+        TextureFormat find_format(const FormatCode (&table)[N], uint32_t code, const char *container) {
+            for (const auto &entry : table) {
+                if (entry.code == code)
+                    return entry.format;
+            }
+            throw std::runtime_error(std::string(container) + ": unsupported format " + std::to_string(code));
+        }
+
+        template <typename T>
+        T read(std::span<const std::byte> bytes, size_t offset) {
+            if (offset + sizeof(T) > bytes.size())
+                throw std::runtime_error("compressed texture header truncated");
+
+            T value;
+            std::memcpy(&value, bytes.data() + offset, sizeof(T));
+            return value;
+        }
+
+        void add_subresource(CompressedTexture &texture, uint32_t level, uint32_t layer, size_t offset,
+                             size_t file_size) {
+            const uint32_t width  = std::max(texture.width >> level, 1u);
+            const uint32_t height = std::max(texture.height >> level, 1u);
+            const size_t   size   = compressed_image_size(texture.format, width, height);
+
+            if (offset + size > file_size)
+                throw std::runtime_error("compressed texture data truncated");
+
+            texture.subresources.push_back({ level, layer, width, height, offset, size });
+        }
+    } // namespace
+
+    bool is_ktx2(std::span<const std::byte> bytes) {
+        return bytes.size() >= sizeof(KTX2_IDENTIFIER) &&
+               std::memcmp(bytes.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0;
+    }
+
+    bool is_dds(std::span<const std::byte> bytes) {
+        return bytes.size() >= 4 && read<uint32_t>(bytes, 0) == DDS_MAGIC;
+    }
+
+    CompressedTexture parse_ktx2(std::span<const std::byte> bytes, bool copy_data) {
+        if (!is_ktx2(bytes) || bytes.size() < KTX2_HEADER_SIZE)
+            throw std::runtime_error("KTX2: not a KTX2 file");
+
+        const uint32_t vk_format   = read<uint32_t>(bytes, 12);
+        const uint32_t depth       = read<uint32_t>(bytes, 28);
+        const uint32_t layer_count = read<uint32_t>(bytes, 32);
+        const uint32_t face_count  = read<uint32_t>(bytes, 36);
+        const uint32_t level_count = read<uint32_t>(bytes, 40);
+
+        if (read<uint32_t>(bytes, 44) != 0)
+            throw std::runtime_error("KTX2: supercompressed files are not supported");
+        if (depth > 1)
+            throw std::runtime_error("KTX2: 3D textures are not supported");
+        if (face_count != 1 && face_count != 6)
+            throw std::runtime_error("KTX2: invalid face count");
+        if (face_count == 6 && layer_count > 1)
+            throw std::runtime_error("KTX2: cube map arrays are not supported");
+
+        CompressedTexture texture;
+        texture.format = find_format(VK_FORMATS, vk_format, "KTX2");
+        texture.width  = read<uint32_t>(bytes, 20);
+        texture.height = std::max(read<uint32_t>(bytes, 24), 1u);
+        texture.cube   = face_count == 6;
+        texture.layers = texture.cube ? 6 : std::max(layer_count, 1u);
+        texture.levels = std::max(level_count, 1u); // 0 asks the loader to generate mips, which we can't for BCn
+        if (copy_data)
+            texture.data.assign(bytes.begin(), bytes.end());
+
+        if (texture.width == 0 || texture.levels > Texture::mip_levels(texture.width, texture.height))
+            throw std::runtime_error("KTX2: invalid dimensions");
+
+        for (uint32_t level = 0; level < texture.levels; level++) {
+            const size_t index  = KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_SIZE;
+            const auto   offset = static_cast<size_t>(read<uint64_t>(bytes, index));
+
+            // layers and faces are packed back to back inside each level
+            const size_t image_size = compressed_image_size(texture.format, std::max(texture.width >> level, 1u),
+                                                            std::max(texture.height >> level, 1u));
+            for (uint32_t layer = 0; layer < texture.layers; layer++) {
+                add_subresource(texture, level, layer, offset + layer * image_size, bytes.size());
+            }
+        }
+
+        return texture;
+    }
+
+    CompressedTexture parse_dds(std::span<const std::byte> bytes, bool copy_data) {
+        if (!is_dds(bytes) || read<uint32_t>(bytes, 4) != 124)
+            throw std::runtime_error("DDS: not a DDS file");
+
+        const uint32_t four_cc = read<uint32_t>(bytes, 84);
+        const uint32_t caps2   = read<uint32_t>(bytes, 112);
+
+        CompressedTexture texture;
+        texture.height = read<uint32_t>(bytes, 12);
+        texture.width  = read<uint32_t>(bytes, 16);
+        texture.levels = std::max(read<uint32_t>(bytes, 28), 1u);
+        texture.cube   = (caps2 & DDSCAPS2_CUBEMAP) != 0;
+
+        size_t data_offset = DDS_HEADER_END;
+        if (four_cc == fourcc("DX10")) {
+            const uint32_t dxgi_format = read<uint32_t>(bytes, DDS_HEADER_END);
+            const uint32_t misc_flag   = read<uint32_t>(bytes, DDS_HEADER_END + 8);
+            const uint32_t array_size  = std::max(read<uint32_t>(bytes, DDS_HEADER_END + 12), 1u);
+
+            texture.format = find_format(DXGI_FORMATS, dxgi_format, "DDS");
+            texture.cube   = texture.cube || (misc_flag & DDS_RESOURCE_MISC_TEXTURECUBE) != 0;
+
+            if (texture.cube && array_size > 1)
+                throw std::runtime_error("DDS: cube map arrays are not supported");
+            texture.layers = texture.cube ? 6 : array_size;
+
+            data_offset += DDS_DX10_HEADER_SIZE;
+        }
+        else {
+            texture.format = find_format(FOURCC_FORMATS, four_cc, "DDS");
+            texture.layers = texture.cube ? 6 : 1;
+        }
+
+        if (texture.width == 0 || texture.height == 0 ||
+            texture.levels > Texture::mip_levels(texture.width, texture.height))
+            throw std::runtime_error("DDS: invalid dimensions");
+
+        if (copy_data)
+            texture.data.assign(bytes.begin(), bytes.end());
+
+        // unlike KTX2, every layer/face carries its whole mip chain before the next one starts
+        size_t offset = data_offset;
+        for (uint32_t layer = 0; layer < texture.layers; layer++) {
+            for (uint32_t level = 0; level < texture.levels; level++) {
+                add_subresource(texture, level, layer, offset, bytes.size());
+                offset += texture.subresources.back().size;
+            }
+        }
+
+        return texture;
+    }
+
+    CompressedTexture parse_compressed_texture(std::span<const std::byte> bytes, bool copy_data) {
+        if (is_ktx2(bytes))
+            return parse_ktx2(bytes, copy_data);
+        if (is_dds(bytes))
+            return parse_dds(bytes, copy_data);
+        throw std::runtime_error("not a KTX2 or DDS file");
+    }
+
+    CompressedTexture load_compressed_texture(const std::string &path) {
+        const MappedFile file(path);
+        try {
+            return parse_compressed_texture(file.span());
+        }
+        catch (const std::runtime_error &e) {
+            throw std::runtime_error(std::string(e.what()) + " (" + path + ")");
+        }
+    }
+
+    void save_ktx2(const std::string &path, const CompressedTexture &texture) {
+        // data format descriptor: colour model and the sample layout of one block
+        struct Sample {
+            uint32_t bit_offset;
+            uint32_t bit_length;
+            uint32_t channel;
+        };
+
+        uint32_t            vk_format = 0;
+        uint32_t            model     = 0;
+        std::vector<Sample> samples;
+
+        switch (texture.format) {
+        case TextureFormat::Bc1Rgb:
+        case TextureFormat::Bc1Srgb:
+            model   = 128;
+            samples = { { 0, 64, 0 } };
+            break;
+        case TextureFormat::Bc1Rgba:
+        case TextureFormat::Bc1SrgbAlpha:
+            model   = 128;
+            samples = { { 0, 64, 1 } };
+            break;
+        case TextureFormat::Bc3:
+        case TextureFormat::Bc3Srgb:
+            model   = 130;
+            samples = { { 0, 64, 15 }, { 64, 64, 0 } };
+            break;
+        case TextureFormat::Bc4:
+            model   = 131;
+            samples = { { 0, 64, 0 } };
+            break;
+        case TextureFormat::Bc5:
+            model   = 132;
+            samples = { { 0, 64, 0 }, { 64, 64, 1 } };
+            break;
+        default:
+            throw std::runtime_error("KTX2: writing this format is not supported");
+        }
+
+        for (const auto &entry : VK_FORMATS) {
+            if (entry.format == texture.format)
+                vk_format = entry.code;
+        }
+        const bool srgb = texture.format == TextureFormat::Bc1Srgb || texture.format == TextureFormat::Bc1SrgbAlpha ||
+                          texture.format == TextureFormat::Bc3Srgb;
+
+        std::vector<uint32_t> dfd;
+        const auto            block_bytes = static_cast<uint32_t>(24 + 16 * samples.size());
+        dfd.push_back(4 + block_bytes);
+        dfd.push_back(0);                                         // vendor id, descriptor type
+        dfd.push_back(2 | block_bytes << 16);                     // version, block size
+        dfd.push_back(model | 1u << 8 | (srgb ? 2u : 1u) << 16);  // model, BT.709 primaries, transfer, flags
+        dfd.push_back(3 | 3u << 8);                               // 4x4 texel block
+        dfd.push_back(static_cast<uint32_t>(block_size(texture.format))); // bytes per plane
+        dfd.push_back(0);
+        for (const Sample &s : samples) {
+            dfd.push_back(s.bit_offset | (s.bit_length - 1) << 16 | s.channel << 24);
+            dfd.push_back(0);
+            dfd.push_back(0);
+            dfd.push_back(std::numeric_limits<uint32_t>::max());
+        }
+
+        const size_t dfd_offset = KTX2_HEADER_SIZE + texture.levels * KTX2_LEVEL_INDEX_SIZE;
+        const size_t dfd_size   = dfd.size() * sizeof(uint32_t);
+        const size_t alignment  = block_size(texture.format);
+
+        // level payloads are stored smallest first, each aligned to the block size
+        std::vector<uint64_t> level_offsets(texture.levels), level_sizes(texture.levels);
+        size_t                end = dfd_offset + dfd_size;
+        for (uint32_t level = texture.levels; level-- > 0;) {
+            end                  = (end + alignment - 1) / alignment * alignment;
+            level_offsets[level] = end;
+            for (const auto &sub : texture.subresources) {
+                if (sub.level == level)
+                    level_sizes[level] += sub.size;
+            }
+            end += level_sizes[level];
+        }
+
+        std::vector<std::byte> file(end);
+        auto                   write = [&](size_t offset, const auto &value) {
+            std::memcpy(file.data() + offset, &value, sizeof(value));
+        };
+
+        std::memcpy(file.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+        write(12, vk_format);
+        write(16, uint32_t{ 1 }); // type size
+        write(20, texture.width);
+        write(24, texture.height);
+        write(28, uint32_t{ 0 }); // depth
+        write(32, texture.cube || texture.layers == 1 ? 0u : texture.layers);
+        write(36, texture.cube ? 6u : 1u);
+        write(40, texture.levels);
+        write(44, uint32_t{ 0 }); // no supercompression
+        write(48, static_cast<uint32_t>(dfd_offset));
+        write(52, static_cast<uint32_t>(dfd_size));
+
+        for (uint32_t level = 0; level < texture.levels; level++) {
+            const size_t index = KTX2_HEADER_SIZE + level * KTX2_LEVEL_INDEX_SIZE;
+            write(index, level_offsets[level]);
+            write(index + 8, level_sizes[level]);
+            write(index + 16, level_sizes[level]);
+        }
+
+        std::memcpy(file.data() + dfd_offset, dfd.data(), dfd_size);
+
+        for (const auto &sub : texture.subresources) {
+            const size_t image_size = compressed_image_size(texture.format, sub.width, sub.height);
+            std::memcpy(file.data() + level_offsets[sub.level] + sub.layer * image_size,
+                        texture.data.data() + sub.offset, sub.size);
+        }
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out)
+            throw std::runtime_error("Failed to open " + path + " for writing");
+        out.write(reinterpret_cast<const char *>(file.data()), static_cast<std::streamsize>(file.size()));
+    }
+
+} // namespace kat
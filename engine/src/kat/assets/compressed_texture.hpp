@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "kat/renderer/texture.hpp"
+
+namespace kat {
+
+    // One mip level of one array layer or cube face, as a byte range of CompressedTexture::data.
+    struct CompressedSubresource {
+        uint32_t level;
+        uint32_t layer; // cube face index for cube maps
+        uint32_t width;
+        uint32_t height;
+        size_t   offset;
+        size_t   size;
+    };
+
+    // Block compressed texture as stored in a KTX2 or DDS container, ready for glCompressedTextureSubImage.
+    struct CompressedTexture {
+        TextureFormat format = TextureFormat::Bc1Rgb;
+        uint32_t      width  = 0;
+        uint32_t      height = 0;
+        uint32_t      layers = 1; // 6 for cube maps
+        uint32_t      levels = 1;
+        bool          cube   = false;
+
+        std::vector<CompressedSubresource> subresources;
+        std::vector<std::byte>             data;
+    };
+
+    [[nodiscard]] bool is_ktx2(std::span<const std::byte> bytes);
+
+    [[nodiscard]] bool is_dds(std::span<const std::byte> bytes);
+
+    // Both throw on unsupported formats (anything but BC1-BC7), supercompressed KTX2 files, cube map arrays and
+    // truncated data. Without copy_data, CompressedTexture::data stays empty and the subresource offsets index
+    // `bytes`, for callers that keep the file mapped.
+    CompressedTexture parse_ktx2(std::span<const std::byte> bytes, bool copy_data = true);
+
+    CompressedTexture parse_dds(std::span<const std::byte> bytes, bool copy_data = true);
+
+    // Picks the parser from the file's magic.
+    CompressedTexture parse_compressed_texture(std::span<const std::byte> bytes, bool copy_data = true);
+
+    CompressedTexture load_compressed_texture(const std::string &path);
+
+    // Writes a KTX2 file without supercompression. Only BC1, BC3, BC4 and BC5 (the encoder's outputs) are supported.
+    void save_ktx2(const std::string &path, const CompressedTexture &texture);
+
+} // namespace kat
@@ -0,0 +1,816 @@
+#include "gltf_importer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+#include "kat/utils/mapped_file.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <nlohmann/json.hpp>
+
+namespace kat {
+    namespace {
+        using json = nlohmann::json;
+
+        constexpr uint32_t GLB_MAGIC      = 0x46546C67; // "glTF"
+        constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+        constexpr uint32_t GLB_CHUNK_BIN  = 0x004E4942; // "BIN\0"
+
+        constexpr int MODE_TRIANGLES = 4;
+
+        enum class ComponentType : int {
+            Byte          = 5120,
+            UnsignedByte  = 5121,
+            Short         = 5122,
+            UnsignedShort = 5123,
+            UnsignedInt   = 5125,
+            Float         = 5126,
+        };
+
+        size_t component_size(ComponentType type) {
+            switch (type) {
+            case ComponentType::Byte:
+            case ComponentType::UnsignedByte:
+                return 1;
+            case ComponentType::Short:
+            case ComponentType::UnsignedShort:
+                return 2;
+            case ComponentType::UnsignedInt:
+            case ComponentType::Float:
+                return 4;
+            }
+            throw std::runtime_error("glTF: unknown accessor component type");
+        }
+
+        int component_count(const std::string &type) {
+            if (type == "SCALAR")
+                return 1;
+            if (type == "VEC2")
+                return 2;
+            if (type == "VEC3")
+                return 3;
+            if (type == "VEC4" || type == "MAT2")
+                return 4;
+            if (type == "MAT3")
+                return 9;
+            if (type == "MAT4")
+                return 16;
+            throw std::runtime_error("glTF: unknown accessor type " + type);
+        }
+
+        template <typename T>
+        T load(const std::byte *p) {
+            T value;
+            std::memcpy(&value, p, sizeof(T));
+            return value;
+        }
+
+        // normalized integer -> float conversion follows the glTF 2.0 spec (signed types clamp to -1).
+        float read_component(const std::byte *p, ComponentType type, bool normalized) {
+            switch (type) {
+            case ComponentType::Float:
+                return load<float>(p);
+            case ComponentType::Byte: {
+                const auto v = static_cast<float>(load<int8_t>(p));
+                return normalized ? std::max(v / 127.0f, -1.0f) : v;
+            }
+            case ComponentType::UnsignedByte: {
+                const auto v = static_cast<float>(load<uint8_t>(p));
+                return normalized ? v / 255.0f : v;
+            }
+            case ComponentType::Short: {
+                const auto v = static_cast<float>(load<int16_t>(p));
+                return normalized ? std::max(v / 32767.0f, -1.0f) : v;
+            }
+            case ComponentType::UnsignedShort: {
+                const auto v = static_cast<float>(load<uint16_t>(p));
+                return normalized ? v / 65535.0f : v;
+            }
+            case ComponentType::UnsignedInt: {
+                const auto v = static_cast<double>(load<uint32_t>(p));
+                return static_cast<float>(normalized ? v / 4294967295.0 : v);
+            }
+            }
+            return 0.0f;
+        }
+
+        uint32_t read_index(const std::byte *p, ComponentType type) {
+            switch (type) {
+            case ComponentType::UnsignedByte:
+                return load<uint8_t>(p);
+            case ComponentType::UnsignedShort:
+                return load<uint16_t>(p);
+            case ComponentType::UnsignedInt:
+                return load<uint32_t>(p);
+            default:
+                throw std::runtime_error("glTF: invalid index component type");
+            }
+        }
+
+        struct BufferView {
+            size_t buffer = 0;
+            size_t offset = 0;
+            size_t length = 0;
+            size_t stride = 0;
+        };
+
+        struct SparseAccessor {
+            size_t        count = 0;
+            size_t        indices_view;
+            size_t        indices_offset;
+            ComponentType indices_type;
+            size_t        values_view;
+            size_t        values_offset;
+        };
+
+        struct Accessor {
+            int           view       = -1;
+            size_t        offset     = 0;
+            ComponentType type       = ComponentType::Float;
+            bool          normalized = false;
+            size_t        count      = 0;
+            int           components = 1;
+
+            std::optional<SparseAccessor> sparse;
+
+            [[nodiscard]] size_t element_size() const { return component_size(type) * components; }
+        };
+
+        enum class DecodeTarget { Position, Normal, Color, Uv, Index };
+
+        struct PrimitiveInfo {
+            size_t mesh;
+            int    material;
+
+            const Accessor *position = nullptr;
+            const Accessor *normal   = nullptr;
+            const Accessor *color    = nullptr;
+            const Accessor *uv       = nullptr;
+            const Accessor *indices  = nullptr;
+
+            size_t first_vertex = 0;
+            size_t vertex_count = 0;
+            size_t first_index  = 0;
+            size_t index_count  = 0;
+        };
+
+        // derived per-primitive data that doesn't fit in the decoded ranges
+        struct PrimitiveExtras {
+            MeshletData           meshlets;
+            std::vector<MeshLod>  lods;
+            std::vector<uint32_t> lod_indices; // levels 1.., laid out right after level 0
+        };
+
+        struct DecodeTask {
+            size_t          primitive;
+            DecodeTarget    target;
+            const Accessor *accessor;
+            size_t          begin;
+            size_t          end;
+        };
+
+        std::vector<std::byte> decode_base64(std::string_view input) {
+            static constexpr std::string_view ALPHABET =
+                "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+            std::vector<std::byte> output;
+            output.reserve(input.size() / 4 * 3);
+
+            uint32_t buffer = 0;
+            int      bits   = 0;
+            for (const char c : input) {
+                if (c == '=')
+                    break;
+
+                const size_t value = ALPHABET.find(c);
+                if (value == std::string_view::npos)
+                    continue;
+
+                buffer = (buffer << 6) | static_cast<uint32_t>(value);
+                bits += 6;
+                if (bits >= 8) {
+                    bits -= 8;
+                    output.push_back(static_cast<std::byte>((buffer >> bits) & 0xFF));
+                }
+            }
+
+            return output;
+        }
+
+        std::string decode_uri(std::string_view uri) {
+            std::string output;
+            output.reserve(uri.size());
+            for (size_t i = 0; i < uri.size(); i++) {
+                // a '%' without two hex digits after it isn't an escape and is kept as it is
+                if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(static_cast<unsigned char>(uri[i + 1])) &&
+                    std::isxdigit(static_cast<unsigned char>(uri[i + 2]))) {
+                    unsigned char byte = 0;
+                    std::from_chars(uri.data() + i + 1, uri.data() + i + 3, byte, 16);
+                    output.push_back(static_cast<char>(byte));
+                    i += 2;
+                }
+                else {
+                    output.push_back(uri[i]);
+                }
+            }
+            return output;
+        }
+
+        // Holds everything the accessors point into: the mapped files and any data uri payloads.
+        struct Document {
+            json                                     root;
+            std::vector<std::shared_ptr<MappedFile>> files;
+            std::vector<std::vector<std::byte>>      owned_buffers;
+            std::vector<std::span<const std::byte>>  buffers;
+            std::vector<BufferView>                  views;
+            std::vector<Accessor>                    accessors;
+
+            [[nodiscard]] std::span<const std::byte> view_bytes(size_t view) const {
+                const BufferView &v = views.at(view);
+                return buffers.at(v.buffer).subspan(v.offset, v.length);
+            }
+
+            [[nodiscard]] const std::byte *element(const Accessor &a, size_t index) const {
+                const BufferView &v      = views[a.view];
+                const size_t      stride = v.stride != 0 ? v.stride : a.element_size();
+                return buffers[v.buffer].data() + v.offset + a.offset + index * stride;
+            }
+        };
+
+        void parse_container(Document &doc, const std::string &path) {
+            auto file = MappedFile::open(path);
+            doc.files.push_back(file);
+
+            std::span<const std::byte> bytes = file->span();
+            std::optional<std::span<const std::byte>> bin_chunk;
+
+            if (bytes.size() >= 12 && load<uint32_t>(bytes.data()) == GLB_MAGIC) {
+                if (load<uint32_t>(bytes.data() + 4) != 2)
+                    throw std::runtime_error("glTF: unsupported GLB version in " + path);
+
+                const size_t length = std::min<size_t>(load<uint32_t>(bytes.data() + 8), bytes.size());
+
+                std::optional<std::span<const std::byte>> json_chunk;
+                size_t offset = 12;
+                while (offset + 8 <= length) {
+                    const uint32_t chunk_length = load<uint32_t>(bytes.data() + offset);
+                    const uint32_t chunk_type   = load<uint32_t>(bytes.data() + offset + 4);
+                    if (offset + 8 + chunk_length > length)
+                        throw std::runtime_error("glTF: truncated GLB chunk in " + path);
+
+                    std::span<const std::byte> chunk = bytes.subspan(offset + 8, chunk_length);
+                    if (chunk_type == GLB_CHUNK_JSON && !json_chunk)
+                        json_chunk = chunk;
+                    else if (chunk_type == GLB_CHUNK_BIN && !bin_chunk)
+                        bin_chunk = chunk;
+
+                    offset += 8 + ((chunk_length + 3) & ~3u);
+                }
+
+                if (!json_chunk)
+                    throw std::runtime_error("glTF: GLB without JSON chunk " + path);
+
+                const auto *begin = reinterpret_cast<const char *>(json_chunk->data());
+                doc.root          = json::parse(begin, begin + json_chunk->size());
+            }
+            else {
+                const auto *begin = reinterpret_cast<const char *>(bytes.data());
+                doc.root          = json::parse(begin, begin + bytes.size());
+            }
+
+            const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+
+            for (const auto &buffer : doc.root.value("buffers", json::array())) {
+                const size_t byte_length = buffer.at("byteLength").get<size_t>();
+
+                std::span<const std::byte> data;
+                if (!buffer.contains("uri")) {
+                    if (!bin_chunk)
+                        throw std::runtime_error("glTF: buffer without uri outside of a GLB");
+                    data = *bin_chunk;
+                }
+                else {
+                    const std::string uri = buffer.at("uri").get<std::string>();
+                    if (uri.starts_with("data:")) {
+                        const size_t comma = uri.find(',');
+                        doc.owned_buffers.push_back(decode_base64(std::string_view(uri).substr(comma + 1)));
+                        data = doc.owned_buffers.back();
+                    }
+                    else {
+                        auto mapped = MappedFile::open((directory / decode_uri(uri)).string());
+                        doc.files.push_back(mapped);
+                        data = mapped->span();
+                    }
+                }
+
+                if (data.size() < byte_length)
+                    throw std::runtime_error("glTF: buffer is smaller than its byteLength");
+
+                doc.buffers.push_back(data.first(byte_length));
+            }
+
+            for (const auto &view : doc.root.value("bufferViews", json::array())) {
+                BufferView v{
+                    .buffer = view.at("buffer").get<size_t>(),
+                    .offset = view.value("byteOffset", size_t{ 0 }),
+                    .length = view.at("byteLength").get<size_t>(),
+                    .stride = view.value("byteStride", size_t{ 0 }),
+                };
+
+                if (v.buffer >= doc.buffers.size() || v.offset + v.length > doc.buffers[v.buffer].size())
+                    throw std::runtime_error("glTF: buffer view out of bounds");
+
+                doc.views.push_back(v);
+            }
+
+            for (const auto &accessor : doc.root.value("accessors", json::array())) {
+                Accessor a{
+                    .view       = accessor.value("bufferView", -1),
+                    .offset     = accessor.value("byteOffset", size_t{ 0 }),
+                    .type       = static_cast<ComponentType>(accessor.at("componentType").get<int>()),
+                    .normalized = accessor.value("normalized", false),
+                    .count      = accessor.at("count").get<size_t>(),
+                    .components = component_count(accessor.at("type").get<std::string>()),
+                };
+
+                if (a.view >= 0 && a.count > 0) {
+                    if (static_cast<size_t>(a.view) >= doc.views.size())
+                        throw std::runtime_error("glTF: accessor references missing buffer view");
+
+                    const BufferView &v      = doc.views[a.view];
+                    const size_t      stride = v.stride != 0 ? v.stride : a.element_size();
+                    if (a.offset + (a.count - 1) * stride + a.element_size() > v.length)
+                        throw std::runtime_error("glTF: accessor out of bounds");
+                }
+
+                if (accessor.contains("sparse")) {
+                    const auto &sparse  = accessor.at("sparse");
+                    const auto &indices = sparse.at("indices");
+                    const auto &values  = sparse.at("values");
+
+                    a.sparse = SparseAccessor{
+                        .count          = sparse.at("count").get<size_t>(),
+                        .indices_view   = indices.at("bufferView").get<size_t>(),
+                        .indices_offset = indices.value("byteOffset", size_t{ 0 }),
+                        .indices_type   = static_cast<ComponentType>(indices.at("componentType").get<int>()),
+                        .values_view    = values.at("bufferView").get<size_t>(),
+                        .values_offset  = values.value("byteOffset", size_t{ 0 }),
+                    };
+
+                    const SparseAccessor &s = *a.sparse;
+                    if (s.indices_view >= doc.views.size() || s.values_view >= doc.views.size() ||
+                        s.indices_offset + s.count * component_size(s.indices_type) > doc.views[s.indices_view].length ||
+                        s.values_offset + s.count * a.element_size() > doc.views[s.values_view].length)
+                        throw std::runtime_error("glTF: sparse accessor out of bounds");
+                }
+
+                doc.accessors.push_back(a);
+            }
+        }
+
+        const Accessor *find_accessor(const Document &doc, const json &attributes, const char *name) {
+            if (!attributes.contains(name))
+                return nullptr;
+            return &doc.accessors.at(attributes.at(name).get<size_t>());
+        }
+
+        float *target_field(StandardVertex &vertex, DecodeTarget target) {
+            switch (target) {
+            case DecodeTarget::Position:
+                return glm::value_ptr(vertex.position);
+            case DecodeTarget::Normal:
+                return glm::value_ptr(vertex.normal);
+            case DecodeTarget::Color:
+                return glm::value_ptr(vertex.color);
+            case DecodeTarget::Uv:
+                return glm::value_ptr(vertex.uv);
+            default:
+                return nullptr;
+            }
+        }
+
+        int target_components(DecodeTarget target) {
+            switch (target) {
+            case DecodeTarget::Position:
+            case DecodeTarget::Normal:
+                return 3;
+            case DecodeTarget::Color:
+                return 4;
+            case DecodeTarget::Uv:
+                return 2;
+            default:
+                return 1;
+            }
+        }
+
+        void decode_element(const std::byte *src, const Accessor &a, float *dst, int components) {
+            const size_t size = component_size(a.type);
+            for (int c = 0; c < components; c++) {
+                dst[c] = read_component(src + c * size, a.type, a.normalized);
+            }
+        }
+
+        void run_decode_task(const Document &doc, const DecodeTask &task, const PrimitiveInfo &primitive,
+                             std::vector<StandardVertex> &vertices, std::vector<uint32_t> &indices) {
+            const Accessor &a = *task.accessor;
+
+            if (task.target == DecodeTarget::Index) {
+                uint32_t *dst = indices.data() + primitive.first_index;
+                if (a.view < 0) {
+                    std::fill(dst + task.begin, dst + task.end, 0u);
+                    return;
+                }
+                for (size_t i = task.begin; i < task.end; i++) {
+                    dst[i] = read_index(doc.element(a, i), a.type);
+                }
+                return;
+            }
+
+            const int components = std::min(a.components, target_components(task.target));
+            for (size_t i = task.begin; i < task.end; i++) {
+                float *dst = target_field(vertices[primitive.first_vertex + i], task.target);
+                if (a.view < 0) {
+                    std::fill(dst, dst + components, 0.0f);
+                }
+                else {
+                    decode_element(doc.element(a, i), a, dst, components);
+                }
+            }
+        }
+
+        void apply_sparse(const Document &doc, const Accessor &a, DecodeTarget target, const PrimitiveInfo &primitive,
+                          std::vector<StandardVertex> &vertices, std::vector<uint32_t> &indices) {
+            const SparseAccessor &s = *a.sparse;
+
+            const std::byte *index_data = doc.view_bytes(s.indices_view).data() + s.indices_offset;
+            const std::byte *value_data = doc.view_bytes(s.values_view).data() + s.values_offset;
+            const size_t     index_size = component_size(s.indices_type);
+
+            const int components = std::min(a.components, target_components(target));
+
+            for (size_t k = 0; k < s.count; k++) {
+                const uint32_t   element = read_index(index_data + k * index_size, s.indices_type);
+                const std::byte *value   = value_data + k * a.element_size();
+
+                if (element >= a.count)
+                    throw std::runtime_error("glTF: sparse index out of range");
+
+                if (target == DecodeTarget::Index) {
+                    indices[primitive.first_index + element] = read_index(value, a.type);
+                }
+                else {
+                    decode_element(value, a, target_field(vertices[primitive.first_vertex + element], target),
+                                   components);
+                }
+            }
+        }
+
+        void finish_primitive(const Document &doc, const PrimitiveInfo &primitive, const GltfImportOptions &options,
+                              std::vector<StandardVertex> &vertices, std::vector<uint32_t> &indices,
+                              PrimitiveExtras &extras) {
+            const std::pair<const Accessor *, DecodeTarget> attributes[] = {
+                { primitive.position, DecodeTarget::Position }, { primitive.normal, DecodeTarget::Normal },
+                { primitive.color, DecodeTarget::Color },       { primitive.uv, DecodeTarget::Uv },
+                { primitive.indices, DecodeTarget::Index },
+            };
+
+            for (const auto &[accessor, target] : attributes) {
+                if (accessor && accessor->sparse)
+                    apply_sparse(doc, *accessor, target, primitive, vertices, indices);
+            }
+
+            std::span<StandardVertex> verts(vertices.data() + primitive.first_vertex, primitive.vertex_count);
+            std::span<uint32_t>       idx(indices.data() + primitive.first_index, primitive.index_count);
+
+            if (!primitive.indices) {
+                for (size_t i = 0; i < idx.size(); i++) {
+                    idx[i] = static_cast<uint32_t>(i);
+                }
+            }
+
+            for (const uint32_t i : idx) {
+                if (i >= verts.size())
+                    throw std::runtime_error("glTF: vertex index out of range");
+            }
+
+            if (!primitive.color) {
+                for (auto &v : verts) {
+                    v.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+                }
+            }
+            else if (primitive.color->components == 3) {
+                for (auto &v : verts) {
+                    v.color.a = 1.0f;
+                }
+            }
+
+            if (!primitive.normal) {
+                // area weighted smooth normals
+                for (size_t t = 0; t + 2 < idx.size(); t += 3) {
+                    const glm::vec3 &a = verts[idx[t]].position;
+                    const glm::vec3 &b = verts[idx[t + 1]].position;
+                    const glm::vec3 &c = verts[idx[t + 2]].position;
+
+                    const glm::vec3 n = glm::cross(b - a, c - a);
+                    verts[idx[t]].normal += n;
+                    verts[idx[t + 1]].normal += n;
+                    verts[idx[t + 2]].normal += n;
+                }
+
+                for (auto &v : verts) {
+                    const float length = glm::length(v.normal);
+                    v.normal           = length > 0.0f ? v.normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+                }
+            }
+
+            if (options.lod_count > 1) {
+                std::vector<uint32_t> chain(idx.begin(), idx.end());
+                extras.lods = build_lod_chain(verts, chain, options.lod_count, options.lod_reduction, options.simplify);
+                extras.lod_indices.assign(chain.begin() + static_cast<ptrdiff_t>(idx.size()), chain.end());
+            }
+
+            // meshlets only reorder triangles within level 0, the lod ranges stay valid
+            if (options.build_meshlets)
+                extras.meshlets = build_meshlets(verts, idx);
+        }
+
+        Material parse_material(const json &material, const json &textures) {
+            auto texture_image = [&](const json &info) -> int {
+                const size_t texture = info.at("index").get<size_t>();
+                return textures.at(texture).value("source", -1);
+            };
+
+            Material m;
+            m.name = material.value("name", std::string());
+
+            if (material.contains("pbrMetallicRoughness")) {
+                const auto &pbr = material.at("pbrMetallicRoughness");
+
+                if (pbr.contains("baseColorFactor")) {
+                    const auto f        = pbr.at("baseColorFactor").get<std::vector<float>>();
+                    m.base_color_factor = { f.at(0), f.at(1), f.at(2), f.at(3) };
+                }
+
+                m.metallic_factor  = pbr.value("metallicFactor", 1.0f);
+                m.roughness_factor = pbr.value("roughnessFactor", 1.0f);
+
+                if (pbr.contains("baseColorTexture"))
+                    m.base_color_texture = texture_image(pbr.at("baseColorTexture"));
+                if (pbr.contains("metallicRoughnessTexture"))
+                    m.metallic_roughness_texture = texture_image(pbr.at("metallicRoughnessTexture"));
+            }
+
+            if (material.contains("normalTexture")) {
+                m.normal_texture = texture_image(material.at("normalTexture"));
+                m.normal_scale   = material.at("normalTexture").value("scale", 1.0f);
+            }
+
+            if (material.contains("occlusionTexture")) {
+                m.occlusion_texture  = texture_image(material.at("occlusionTexture"));
+                m.occlusion_strength = material.at("occlusionTexture").value("strength", 1.0f);
+            }
+
+            if (material.contains("emissiveTexture"))
+                m.emissive_texture = texture_image(material.at("emissiveTexture"));
+
+            if (material.contains("emissiveFactor")) {
+                const auto f      = material.at("emissiveFactor").get<std::vector<float>>();
+                m.emissive_factor = { f.at(0), f.at(1), f.at(2) };
+            }
+
+            const std::string alpha_mode = material.value("alphaMode", std::string("OPAQUE"));
+            if (alpha_mode == "MASK")
+                m.alpha_mode = AlphaMode::Mask;
+            else if (alpha_mode == "BLEND")
+                m.alpha_mode = AlphaMode::Blend;
+
+            m.alpha_cutoff = material.value("alphaCutoff", 0.5f);
+            m.double_sided = material.value("doubleSided", false);
+
+            return m;
+        }
+
+        GltfNode parse_node(const json &node) {
+            GltfNode n;
+            n.name     = node.value("name", std::string());
+            n.mesh     = node.value("mesh", -1);
+            n.children = node.value("children", std::vector<int>());
+
+            if (node.contains("matrix")) {
+                const auto m      = node.at("matrix").get<std::vector<float>>();
+                n.local_transform = glm::make_mat4(m.data());
+            }
+            else {
+                const auto t = node.value("translation", std::vector<float>{ 0.0f, 0.0f, 0.0f });
+                const auto r = node.value("rotation", std::vector<float>{ 0.0f, 0.0f, 0.0f, 1.0f });
+                const auto s = node.value("scale", std::vector<float>{ 1.0f, 1.0f, 1.0f });
+
+                const glm::quat rotation(r.at(3), r.at(0), r.at(1), r.at(2));
+
+                n.local_transform = glm::translate(glm::mat4(1.0f), glm::vec3(t.at(0), t.at(1), t.at(2))) *
+                                    glm::mat4_cast(rotation) *
+                                    glm::scale(glm::mat4(1.0f), glm::vec3(s.at(0), s.at(1), s.at(2)));
+            }
+
+            return n;
+        }
+    } // namespace
+
+    GltfImporter::GltfImporter(const std::shared_ptr<JobSystem>    &job_system,
+                               const std::shared_ptr<GpuResources> &resources) :
+        m_job_system(job_system), m_resources(resources) {}
+
+    GltfModel GltfImporter::load(const std::string &path, const GltfImportOptions &options) const {
+        Document doc;
+        parse_container(doc, path);
+
+        const json &root = doc.root;
+        GltfModel   model;
+
+        const json textures = root.value("textures", json::array());
+        for (const auto &material : root.value("materials", json::array())) {
+            model.materials.push_back(parse_material(material, textures));
+        }
+
+        const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+        for (const auto &image : root.value("images", json::array())) {
+            GltfImage img;
+            img.name      = image.value("name", std::string());
+            img.mime_type = image.value("mimeType", std::string());
+
+            if (image.contains("bufferView")) {
+                const auto bytes = doc.view_bytes(image.at("bufferView").get<size_t>());
+                img.data.assign(bytes.begin(), bytes.end());
+            }
+            else if (image.contains("uri")) {
+                const std::string uri = image.at("uri").get<std::string>();
+                if (uri.starts_with("data:"))
+                    img.data = decode_base64(std::string_view(uri).substr(uri.find(',') + 1));
+                else
+                    img.uri = (directory / decode_uri(uri)).string();
+            }
+
+            model.images.push_back(std::move(img));
+        }
+
+        // lay every primitive out back to back so that they can all share one vertex and one index buffer.
+        std::vector<PrimitiveInfo> primitives;
+        size_t                     total_vertices = 0;
+        size_t                     total_indices  = 0;
+
+        const json meshes = root.value("meshes", json::array());
+        for (size_t mesh = 0; mesh < meshes.size(); mesh++) {
+            model.meshes.push_back({ .name = meshes[mesh].value("name", std::string()) });
+
+            for (const auto &primitive : meshes[mesh].at("primitives")) {
+                if (primitive.value("mode", MODE_TRIANGLES) != MODE_TRIANGLES) {
+                    std::cerr << "glTF: skipping non triangle-list primitive in " << path << std::endl;
+                    continue;
+                }
+
+                const json &attributes = primitive.at("attributes");
+
+                PrimitiveInfo info{
+                    .mesh     = mesh,
+                    .material = primitive.value("material", -1),
+                    .position = find_accessor(doc, attributes, "POSITION"),
+                    .normal   = find_accessor(doc, attributes, "NORMAL"),
+                    .color    = find_accessor(doc, attributes, "COLOR_0"),
+                    .uv       = find_accessor(doc, attributes, "TEXCOORD_0"),
+                    .indices  = primitive.contains("indices")
+                                    ? &doc.accessors.at(primitive.at("indices").get<size_t>())
+                                    : nullptr,
+                };
+
+                if (!info.position) {
+                    std::cerr << "glTF: skipping primitive without POSITION in " << path << std::endl;
+                    continue;
+                }
+
+                info.vertex_count = info.position->count;
+                info.index_count  = info.indices ? info.indices->count : info.vertex_count;
+                info.first_vertex = total_vertices;
+                info.first_index  = total_indices;
+
+                for (const Accessor *a : { info.normal, info.color, info.uv }) {
+                    if (a && a->count != info.vertex_count)
+                        throw std::runtime_error("glTF: attribute count mismatch in " + path);
+                }
+
+                total_vertices += info.vertex_count;
+                total_indices += info.index_count;
+                primitives.push_back(info);
+            }
+        }
+
+        // split every accessor into bounded chunks so large meshes spread across all workers.
+        std::vector<DecodeTask> tasks;
+        const size_t            chunk = std::max<size_t>(options.elements_per_job, 1);
+        for (size_t p = 0; p < primitives.size(); p++) {
+            const PrimitiveInfo &info = primitives[p];
+
+            const std::pair<const Accessor *, DecodeTarget> attributes[] = {
+                { info.position, DecodeTarget::Position }, { info.normal, DecodeTarget::Normal },
+                { info.color, DecodeTarget::Color },       { info.uv, DecodeTarget::Uv },
+                { info.indices, DecodeTarget::Index },
+            };
+
+            for (const auto &[accessor, target] : attributes) {
+                if (!accessor)
+                    continue;
+                for (size_t begin = 0; begin < accessor->count; begin += chunk) {
+                    tasks.push_back({ p, target, accessor, begin, std::min(begin + chunk, accessor->count) });
+                }
+            }
+        }
+
+        std::vector<StandardVertex> vertices(total_vertices);
+        std::vector<uint32_t>       indices(total_indices);
+
+        m_job_system->parallel_for(tasks.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t t = begin; t < end; t++) {
+                run_decode_task(doc, tasks[t], primitives[tasks[t].primitive], vertices, indices);
+            }
+        });
+
+        // sparse substitution and derived data need the whole accessor, so they run per primitive.
+        std::vector<PrimitiveExtras> extras(primitives.size());
+        m_job_system->parallel_for(primitives.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t p = begin; p < end; p++) {
+                finish_primitive(doc, primitives[p], options, vertices, indices, extras[p]);
+            }
+        });
+
+        // lod sizes are only known now, repack so each primitive's levels follow its level 0
+        if (options.lod_count > 1) {
+            size_t packed_count = 0;
+            for (const auto &e : extras) {
+                packed_count += e.lod_indices.size();
+            }
+
+            std::vector<uint32_t> packed;
+            packed.reserve(indices.size() + packed_count);
+            for (size_t p = 0; p < primitives.size(); p++) {
+                PrimitiveInfo &info = primitives[p];
+
+                const auto first = indices.begin() + static_cast<ptrdiff_t>(info.first_index);
+                info.first_index = packed.size();
+                packed.insert(packed.end(), first, first + static_cast<ptrdiff_t>(info.index_count));
+                packed.insert(packed.end(), extras[p].lod_indices.begin(), extras[p].lod_indices.end());
+                info.index_count += extras[p].lod_indices.size();
+            }
+            indices = std::move(packed);
+        }
+
+        model.vertex_buffer = m_resources->create_buffer(vertices, BufferUsage::StaticDraw);
+        model.index_buffer  = m_resources->create_buffer(indices, BufferUsage::StaticDraw);
+
+        for (size_t p = 0; p < primitives.size(); p++) {
+            const PrimitiveInfo &info = primitives[p];
+
+            const BufferRange vertex_range{ model.vertex_buffer, info.first_vertex * sizeof(StandardVertex),
+                                            info.vertex_count * sizeof(StandardVertex) };
+            const BufferRange index_range{ model.index_buffer, info.first_index * sizeof(uint32_t),
+                                           info.index_count * sizeof(uint32_t) };
+
+            auto mesh = std::make_shared<Mesh>(m_resources, vertex_range, index_range, std::move(extras[p].meshlets),
+                                               std::move(extras[p].lods));
+            model.meshes[info.mesh].primitives.push_back({ .mesh = std::move(mesh), .material = info.material });
+        }
+
+        for (const auto &node : root.value("nodes", json::array())) {
+            model.nodes.push_back(parse_node(node));
+        }
+
+        const json scenes = root.value("scenes", json::array());
+        if (!scenes.empty()) {
+            const size_t scene = root.value("scene", size_t{ 0 });
+            model.root_nodes   = scenes.at(scene).value("nodes", std::vector<int>());
+        }
+        else {
+            std::vector<bool> is_child(model.nodes.size(), false);
+            for (const auto &node : model.nodes) {
+                for (const int child : node.children) {
+                    is_child.at(child) = true;
+                }
+            }
+            for (size_t i = 0; i < model.nodes.size(); i++) {
+                if (!is_child[i])
+                    model.root_nodes.push_back(static_cast<int>(i));
+            }
+        }
+
+        return model;
+    }
+
+} // namespace kat
@@ -0,0 +1,80 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "kat/renderer/buffer.hpp"
+#include "kat/renderer/gpu_resources.hpp"
+#include "kat/renderer/material.hpp"
+#include "kat/renderer/mesh.hpp"
+#include "kat/utils/job_system.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    struct GltfImage {
+        std::string name;
+        std::string uri; // resolved against the asset directory, empty for embedded images
+        std::string mime_type;
+
+        std::vector<std::byte> data; // encoded image bytes for images stored in a buffer view or data uri
+    };
+
+    struct GltfPrimitive {
+        std::shared_ptr<Mesh> mesh;
+        int                   material = -1;
+    };
+
+    struct GltfMesh {
+        std::string                name;
+        std::vector<GltfPrimitive> primitives;
+    };
+
+    struct GltfNode {
+        std::string      name;
+        int              mesh = -1;
+        glm::mat4        local_transform{ 1.0f };
+        std::vector<int> children;
+    };
+
+    struct GltfModel {
+        // every primitive of the asset lives in these two buffers, meshes reference ranges inside them. They belong
+        // to the model: destroy them through the importer's GpuResources once its meshes are gone.
+        Handle<Buffer> vertex_buffer;
+        Handle<Buffer> index_buffer;
+
+        std::vector<Material>  materials;
+        std::vector<GltfImage> images;
+        std::vector<GltfMesh>  meshes;
+        std::vector<GltfNode>  nodes;
+        std::vector<int>       root_nodes;
+    };
+
+    struct GltfImportOptions {
+        // accessors longer than this are split into several decode jobs.
+        size_t elements_per_job = 64 * 1024;
+
+        // reorder each primitive's indices into meshlets for cluster culling
+        bool build_meshlets = false;
+
+        // levels of detail per primitive (1 = full resolution only), appended after level 0 in the index buffer
+        size_t          lod_count     = 1;
+        float           lod_reduction = 0.5f;
+        SimplifyOptions simplify;
+    };
+
+    class GltfImporter {
+      public:
+        GltfImporter(const std::shared_ptr<JobSystem> &job_system, const std::shared_ptr<GpuResources> &resources);
+
+        // Loads a .gltf or .glb file. Binary buffers are memory mapped rather than read, so only the pages touched by
+        // accessors are paged in. Requires a current GL context for the final buffer upload.
+        [[nodiscard]] GltfModel load(const std::string &path, const GltfImportOptions &options = {}) const;
+
+      private:
+        std::shared_ptr<JobSystem>    m_job_system;
+        std::shared_ptr<GpuResources> m_resources;
+    };
+
+} // namespace kat
@@ -0,0 +1,60 @@
+#include "image.hpp"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "kat/utils/mapped_file.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+namespace kat {
+
+    Image decode_image(std::span<const std::byte> encoded, const ImageDecodeOptions &options) {
+        if (encoded.size() > static_cast<size_t>(std::numeric_limits<int>::max()))
+            throw std::runtime_error("Image too large to decode");
+
+        const auto *data   = reinterpret_cast<const stbi_uc *>(encoded.data());
+        const auto  length = static_cast<int>(encoded.size());
+
+        // the flip flag is global in stb_image unless set per thread
+        stbi_set_flip_vertically_on_load_thread(options.flip_vertically ? 1 : 0);
+
+        Image image;
+        image.hdr = stbi_is_hdr_from_memory(data, length) != 0;
+
+        const int desired = static_cast<int>(options.desired_channels);
+        int       width = 0, height = 0, channels = 0;
+
+        void *pixels;
+        if (image.hdr)
+            pixels = stbi_loadf_from_memory(data, length, &width, &height, &channels, desired);
+        else
+            pixels = stbi_load_from_memory(data, length, &width, &height, &channels, desired);
+
+        if (!pixels)
+            throw std::runtime_error(std::string("Failed to decode image: ") + stbi_failure_reason());
+
+        image.width    = static_cast<uint32_t>(width);
+        image.height   = static_cast<uint32_t>(height);
+        image.channels = options.desired_channels != 0 ? options.desired_channels : static_cast<uint32_t>(channels);
+
+        image.pixels.resize(image.row_size() * image.height);
+        std::memcpy(image.pixels.data(), pixels, image.pixels.size());
+        stbi_image_free(pixels);
+
+        return image;
+    }
+
+    Image load_image(const std::string &path, const ImageDecodeOptions &options) {
+        const MappedFile file(path);
+        try {
+            return decode_image(file.span(), options);
+        }
+        catch (const std::runtime_error &e) {
+            throw std::runtime_error(std::string(e.what()) + " (" + path + ")");
+        }
+    }
+
+} // namespace kat
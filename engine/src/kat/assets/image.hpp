@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace kat {
+
+    // Decoded, tightly packed pixels. 8 bit images hold one byte per channel, HDR images one float per channel.
+    struct Image {
+        uint32_t width    = 0;
+        uint32_t height   = 0;
+        uint32_t channels = 0;
+        bool     hdr      = false;
+
+        std::vector<std::byte> pixels;
+
+        [[nodiscard]] size_t pixel_size() const noexcept { return channels * (hdr ? sizeof(float) : 1); }
+
+        [[nodiscard]] size_t row_size() const noexcept { return width * pixel_size(); }
+
+        [[nodiscard]] bool empty() const noexcept { return pixels.empty(); }
+    };
+
+    struct ImageDecodeOptions {
+        // 0 keeps the channel count stored in the file
+        uint32_t desired_channels = 0;
+        bool     flip_vertically  = false;
+    };
+
+    // PNG, JPG, TGA, BMP, PSD, GIF and HDR through stb_image. Safe to call from several threads at once. Throws on
+    // malformed input.
+    Image decode_image(std::span<const std::byte> encoded, const ImageDecodeOptions &options = {});
+
+    Image load_image(const std::string &path, const ImageDecodeOptions &options = {});
+
+} // namespace kat
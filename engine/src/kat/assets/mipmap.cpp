@@ -0,0 +1,451 @@
+#include "mipmap.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+#include "kat/utils/simd.hpp"
+
+namespace kat {
+    namespace {
+        constexpr size_t ROWS_PER_JOB = 16;
+
+        // fine enough that the darkest sRGB steps still round correctly
+        constexpr size_t LINEAR_TO_SRGB_SIZE = 16384;
+
+        struct SrgbTables {
+            float   to_linear[256];
+            uint8_t from_linear[LINEAR_TO_SRGB_SIZE];
+
+            SrgbTables() {
+                for (int i = 0; i < 256; i++) {
+                    const float c = static_cast<float>(i) / 255.0f;
+                    to_linear[i]  = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                }
+
+                for (size_t i = 0; i < LINEAR_TO_SRGB_SIZE; i++) {
+                    const float l  = static_cast<float>(i) / static_cast<float>(LINEAR_TO_SRGB_SIZE - 1);
+                    const float s  = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                    from_linear[i] = static_cast<uint8_t>(std::clamp(s * 255.0f + 0.5f, 0.0f, 255.0f));
+                }
+            }
+        };
+
+        const SrgbTables &srgb_tables() {
+            static const SrgbTables tables;
+            return tables;
+        }
+
+        // working copy of a level, always four linear float channels per texel
+        struct Level {
+            uint32_t           width  = 0;
+            uint32_t           height = 0;
+            std::vector<float> texels;
+
+            Level(uint32_t w, uint32_t h) : width(w), height(h), texels(static_cast<size_t>(w) * h * 4) {}
+
+            float *row(uint32_t y) { return texels.data() + static_cast<size_t>(y) * width * 4; }
+
+            [[nodiscard]] const float *row(uint32_t y) const {
+                return texels.data() + static_cast<size_t>(y) * width * 4;
+            }
+        };
+
+        // separable filter weights: every output texel reads `taps` input texels
+        struct Taps {
+            uint32_t              taps = 0;
+            std::vector<uint32_t> index;
+            std::vector<float>    weight;
+        };
+
+        struct Layout {
+            uint32_t channels;
+            int      alpha; // channel holding alpha, -1 if none
+            bool     srgb;
+        };
+
+        void for_rows(const std::shared_ptr<JobSystem> &job_system, size_t rows,
+                      const std::function<void(size_t, size_t)> &fn) {
+            if (job_system)
+                job_system->parallel_for(rows, ROWS_PER_JOB, fn);
+            else
+                fn(0, rows);
+        }
+
+        Level decode_level(const Image &image, const Layout &layout, const std::shared_ptr<JobSystem> &job_system) {
+            Level          level(image.width, image.height);
+            const uint32_t channels = layout.channels;
+
+            // per channel conversion of 8 bit values, sRGB for colour and plain unorm for alpha
+            float unorm[4][256];
+            for (uint32_t c = 0; c < 4; c++) {
+                const bool srgb = layout.srgb && static_cast<int>(c) != layout.alpha;
+                for (int v = 0; v < 256; v++) {
+                    unorm[c][v] = srgb ? srgb_tables().to_linear[v] : static_cast<float>(v) / 255.0f;
+                }
+            }
+
+            for_rows(job_system, image.height, [&](size_t begin, size_t end) {
+                for (size_t y = begin; y < end; y++) {
+                    float          *dst = level.row(static_cast<uint32_t>(y));
+                    const std::byte *src = image.pixels.data() + y * image.row_size();
+
+                    for (uint32_t x = 0; x < image.width; x++) {
+                        float *texel = dst + x * 4;
+                        texel[0] = texel[1] = texel[2] = 0.0f;
+                        texel[3]                       = 1.0f;
+
+                        if (image.hdr) {
+                            std::memcpy(texel, src + x * channels * sizeof(float), channels * sizeof(float));
+                        }
+                        else {
+                            for (uint32_t c = 0; c < channels; c++) {
+                                texel[c] = unorm[c][static_cast<uint8_t>(src[x * channels + c])];
+                            }
+                        }
+                    }
+                }
+            });
+
+            return level;
+        }
+
+        Image encode_level(const Level &level, const Image &format, const Layout &layout, float alpha_scale,
+                           const std::shared_ptr<JobSystem> &job_system) {
+            Image image;
+            image.width    = level.width;
+            image.height   = level.height;
+            image.channels = format.channels;
+            image.hdr      = format.hdr;
+            image.pixels.resize(image.row_size() * image.height);
+
+            const uint8_t *to_srgb  = srgb_tables().from_linear;
+            const uint32_t channels = layout.channels;
+
+            // scale and clamp per channel, alpha also gets the coverage correction. Kaiser lobes can ring below zero.
+            float scale[4], limit[4];
+            bool  srgb[4];
+            for (uint32_t c = 0; c < 4; c++) {
+                const bool alpha = static_cast<int>(c) == layout.alpha;
+
+                srgb[c]  = layout.srgb && !alpha;
+                scale[c] = (alpha ? alpha_scale : 1.0f) * (srgb[c] ? LINEAR_TO_SRGB_SIZE - 1 : 255.0f);
+                limit[c] = srgb[c] ? LINEAR_TO_SRGB_SIZE - 1 : 255.0f;
+            }
+
+            for_rows(job_system, level.height, [&](size_t begin, size_t end) {
+                for (size_t y = begin; y < end; y++) {
+                    const float *src = level.row(static_cast<uint32_t>(y));
+                    std::byte   *dst = image.pixels.data() + y * image.row_size();
+
+                    for (uint32_t x = 0; x < level.width; x++) {
+                        if (image.hdr) {
+                            float texel[4];
+                            for (uint32_t c = 0; c < channels; c++) {
+                                texel[c] = std::max(src[x * 4 + c], 0.0f);
+                            }
+                            if (layout.alpha >= 0)
+                                texel[layout.alpha] = std::min(texel[layout.alpha] * alpha_scale, 1.0f);
+
+                            std::memcpy(dst + x * channels * sizeof(float), texel, channels * sizeof(float));
+                            continue;
+                        }
+
+                        for (uint32_t c = 0; c < channels; c++) {
+                            const float v = std::clamp(src[x * 4 + c] * scale[c] + 0.5f, 0.0f, limit[c]);
+                            const auto  i = static_cast<uint32_t>(v);
+
+                            dst[x * channels + c] = static_cast<std::byte>(srgb[c] ? to_srgb[i] : i);
+                        }
+                    }
+                }
+            });
+
+            return image;
+        }
+
+        // exact 2:1 reduction in both directions
+        void downsample_box(const Level &src, Level &dst, const std::shared_ptr<JobSystem> &job_system) {
+            for_rows(job_system, dst.height, [&](size_t begin, size_t end) {
+                for (size_t y = begin; y < end; y++) {
+                    const float *r0  = src.row(static_cast<uint32_t>(y * 2));
+                    const float *r1  = src.row(static_cast<uint32_t>(y * 2 + 1));
+                    float       *out = dst.row(static_cast<uint32_t>(y));
+
+                    uint32_t x = 0;
+#ifdef KAT_SIMD_AVX2
+                    // two output texels per iteration: sum the rows, then pair up horizontal neighbours across lanes
+                    const __m256 quarter8 = _mm256_set1_ps(0.25f);
+                    for (; x + 2 <= dst.width; x += 2) {
+                        const float *p  = r0 + x * 8;
+                        const float *q  = r1 + x * 8;
+                        const __m256 a  = _mm256_add_ps(_mm256_loadu_ps(p), _mm256_loadu_ps(q));
+                        const __m256 b  = _mm256_add_ps(_mm256_loadu_ps(p + 8), _mm256_loadu_ps(q + 8));
+                        const __m256 lo = _mm256_permute2f128_ps(a, b, 0x20);
+                        const __m256 hi = _mm256_permute2f128_ps(a, b, 0x31);
+                        _mm256_storeu_ps(out + x * 4, _mm256_mul_ps(_mm256_add_ps(lo, hi), quarter8));
+                    }
+#endif
+#ifdef KAT_SIMD_SSE2
+                    const __m128 quarter = _mm_set1_ps(0.25f);
+                    for (; x < dst.width; x++) {
+                        const float *p   = r0 + x * 8;
+                        const float *q   = r1 + x * 8;
+                        const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(p), _mm_loadu_ps(p + 4)),
+                                                      _mm_add_ps(_mm_loadu_ps(q), _mm_loadu_ps(q + 4)));
+                        _mm_storeu_ps(out + x * 4, _mm_mul_ps(sum, quarter));
+                    }
+#else
+                    for (; x < dst.width; x++) {
+                        for (int c = 0; c < 4; c++) {
+                            out[x * 4 + c] =
+                                (r0[x * 8 + c] + r0[x * 8 + 4 + c] + r1[x * 8 + c] + r1[x * 8 + 4 + c]) * 0.25f;
+                        }
+                    }
+#endif
+                }
+            });
+        }
+
+        // area weights of the output texel's footprint, handles odd sizes
+        Taps box_taps(uint32_t in, uint32_t out) {
+            const double scale = static_cast<double>(in) / out;
+
+            Taps taps;
+            taps.taps = static_cast<uint32_t>(std::ceil(scale)) + 1;
+            taps.index.resize(static_cast<size_t>(out) * taps.taps);
+            taps.weight.resize(static_cast<size_t>(out) * taps.taps);
+
+            for (uint32_t o = 0; o < out; o++) {
+                const double begin = o * scale;
+                const double end   = begin + scale;
+                const auto   first = static_cast<uint32_t>(std::floor(begin));
+
+                for (uint32_t t = 0; t < taps.taps; t++) {
+                    const double   texel   = static_cast<double>(first) + t;
+                    const uint32_t i       = std::min(first + t, in - 1);
+                    const double   overlap = std::min(end, texel + 1.0) - std::max(begin, texel);
+
+                    taps.index[o * taps.taps + t]  = i;
+                    taps.weight[o * taps.taps + t] = static_cast<float>(std::max(overlap, 0.0) / scale);
+                }
+            }
+
+            return taps;
+        }
+
+        double bessel_i0(double x) {
+            double sum = 1.0, term = 1.0;
+            for (int k = 1; k < 32; k++) {
+                term *= (x / (2.0 * k)) * (x / (2.0 * k));
+                sum += term;
+                if (term < sum * 1e-12)
+                    break;
+            }
+            return sum;
+        }
+
+        Taps kaiser_taps(uint32_t in, uint32_t out, float alpha, float radius) {
+            const double scale   = static_cast<double>(in) / out;
+            const double support = radius * scale; // in source texels
+            const double i0      = bessel_i0(alpha);
+
+            Taps taps;
+            taps.taps = static_cast<uint32_t>(std::ceil(support * 2.0)) + 1;
+            taps.index.resize(static_cast<size_t>(out) * taps.taps);
+            taps.weight.resize(static_cast<size_t>(out) * taps.taps);
+
+            for (uint32_t o = 0; o < out; o++) {
+                const double center = (o + 0.5) * scale - 0.5;
+                const auto   first  = static_cast<int64_t>(std::ceil(center - support));
+
+                double total = 0.0;
+                for (uint32_t t = 0; t < taps.taps; t++) {
+                    const int64_t i = first + t;
+                    const double  d = (i - center) / scale;
+                    const double  r = d / radius;
+
+                    double w = 0.0;
+                    if (std::abs(r) < 1.0) {
+                        const double sinc = d == 0.0 ? 1.0 : std::sin(std::numbers::pi * d) / (std::numbers::pi * d);
+                        w                 = sinc * bessel_i0(alpha * std::sqrt(1.0 - r * r)) / i0;
+                    }
+
+                    taps.index[o * taps.taps + t]  = static_cast<uint32_t>(std::clamp<int64_t>(i, 0, in - 1));
+                    taps.weight[o * taps.taps + t] = static_cast<float>(w);
+                    total += w;
+                }
+
+                for (uint32_t t = 0; t < taps.taps; t++) {
+                    taps.weight[o * taps.taps + t] = static_cast<float>(taps.weight[o * taps.taps + t] / total);
+                }
+            }
+
+            return taps;
+        }
+
+        // separable resample: horizontal into a temporary, then vertical as a weighted sum of whole rows
+        void resample(const Level &src, Level &dst, const Taps &horizontal, const Taps &vertical,
+                      const std::shared_ptr<JobSystem> &job_system) {
+            Level temp(dst.width, src.height);
+
+            for_rows(job_system, src.height, [&](size_t begin, size_t end) {
+                for (size_t y = begin; y < end; y++) {
+                    const float *in  = src.row(static_cast<uint32_t>(y));
+                    float       *out = temp.row(static_cast<uint32_t>(y));
+
+                    for (uint32_t x = 0; x < dst.width; x++) {
+                        const uint32_t *index  = &horizontal.index[x * horizontal.taps];
+                        const float    *weight = &horizontal.weight[x * horizontal.taps];
+#ifdef KAT_SIMD_SSE2
+                        __m128 acc = _mm_setzero_ps();
+                        for (uint32_t t = 0; t < horizontal.taps; t++) {
+                            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(in + index[t] * 4), _mm_set1_ps(weight[t])));
+                        }
+                        _mm_storeu_ps(out + x * 4, acc);
+#else
+                        for (int c = 0; c < 4; c++) {
+                            float acc = 0.0f;
+                            for (uint32_t t = 0; t < horizontal.taps; t++) {
+                                acc += in[index[t] * 4 + c] * weight[t];
+                            }
+                            out[x * 4 + c] = acc;
+                        }
+#endif
+                    }
+                }
+            });
+
+            const size_t row_floats = static_cast<size_t>(dst.width) * 4;
+
+            for_rows(job_system, dst.height, [&](size_t begin, size_t end) {
+                for (size_t y = begin; y < end; y++) {
+                    float          *out    = dst.row(static_cast<uint32_t>(y));
+                    const uint32_t *index  = &vertical.index[y * vertical.taps];
+                    const float    *weight = &vertical.weight[y * vertical.taps];
+
+                    std::fill(out, out + row_floats, 0.0f);
+
+                    for (uint32_t t = 0; t < vertical.taps; t++) {
+                        if (weight[t] == 0.0f)
+                            continue;
+
+                        const float *in = temp.row(index[t]);
+                        size_t       i  = 0;
+#ifdef KAT_SIMD_AVX2
+                        const __m256 w8 = _mm256_set1_ps(weight[t]);
+                        for (; i + 8 <= row_floats; i += 8) {
+                            _mm256_storeu_ps(out + i, _mm256_fmadd_ps(_mm256_loadu_ps(in + i), w8,
+                                                                      _mm256_loadu_ps(out + i)));
+                        }
+#endif
+#ifdef KAT_SIMD_SSE2
+                        const __m128 w4 = _mm_set1_ps(weight[t]);
+                        for (; i + 4 <= row_floats; i += 4) {
+                            const __m128 sum = _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), w4));
+                            _mm_storeu_ps(out + i, sum);
+                        }
+#endif
+                        for (; i < row_floats; i++) {
+                            out[i] += in[i] * weight[t];
+                        }
+                    }
+                }
+            });
+        }
+
+        float alpha_coverage(const Level &level, int alpha, float cutoff) {
+            size_t       passing = 0;
+            const size_t count   = static_cast<size_t>(level.width) * level.height;
+            for (size_t i = 0; i < count; i++) {
+                if (level.texels[i * 4 + alpha] > cutoff)
+                    passing++;
+            }
+            return static_cast<float>(passing) / static_cast<float>(count);
+        }
+
+        // Scale that lets `target` of the texels pass the cutoff: find the alpha value with that many texels above
+        // it and map it onto the cutoff.
+        float coverage_scale(const Level &level, int alpha, float cutoff, float target) {
+            const size_t count = static_cast<size_t>(level.width) * level.height;
+
+            std::vector<float> values(count);
+            for (size_t i = 0; i < count; i++) {
+                values[i] = level.texels[i * 4 + alpha];
+            }
+
+            const auto passing = static_cast<size_t>(std::lround(target * static_cast<float>(count)));
+            if (passing == 0)
+                return 1.0f;
+
+            // the passing-th largest value must end up just above the cutoff
+            const auto nth = values.begin() + static_cast<ptrdiff_t>(count - passing);
+            std::nth_element(values.begin(), nth, values.end());
+
+            return *nth > 0.0f ? std::min(cutoff / *nth * 1.001f, 4.0f) : 1.0f;
+        }
+    } // namespace
+
+    std::vector<Image> generate_mip_chain(Image source, const MipOptions &options,
+                                          const std::shared_ptr<JobSystem> &job_system) {
+        std::vector<Image> chain;
+        if (source.empty())
+            return chain;
+
+        const uint32_t full_chain = static_cast<uint32_t>(std::bit_width(std::max(source.width, source.height)));
+        const uint32_t levels     = options.max_levels == 0 ? full_chain : std::min(options.max_levels, full_chain);
+
+        Layout layout{
+            .channels = source.channels,
+            .alpha    = source.channels == 4 ? 3 : source.channels == 2 ? 1 : -1,
+            .srgb     = options.srgb && !source.hdr && source.channels >= 3,
+        };
+
+        Image format;
+        format.channels = source.channels;
+        format.hdr      = source.hdr;
+
+        if (levels <= 1) {
+            chain.push_back(std::move(source));
+            return chain;
+        }
+
+        Level current = decode_level(source, layout, job_system);
+        chain.reserve(levels);
+        chain.push_back(std::move(source));
+
+        const bool  coverage = options.preserve_alpha_coverage && layout.alpha >= 0;
+        const float target   = coverage ? alpha_coverage(current, layout.alpha, options.alpha_cutoff) : 0.0f;
+
+        while (chain.size() < levels) {
+            Level next(std::max(current.width / 2, 1u), std::max(current.height / 2, 1u));
+
+            const bool even = current.width == next.width * 2 && current.height == next.height * 2;
+            if (options.filter == MipFilter::Box && even) {
+                downsample_box(current, next, job_system);
+            }
+            else if (options.filter == MipFilter::Box) {
+                resample(current, next, box_taps(current.width, next.width), box_taps(current.height, next.height),
+                         job_system);
+            }
+            else {
+                resample(current, next,
+                         kaiser_taps(current.width, next.width, options.kaiser_alpha, options.kaiser_radius),
+                         kaiser_taps(current.height, next.height, options.kaiser_alpha, options.kaiser_radius),
+                         job_system);
+            }
+
+            // the scale only touches the encoded level, the next level still filters the unscaled alpha
+            const float alpha_scale =
+                coverage ? coverage_scale(next, layout.alpha, options.alpha_cutoff, target) : 1.0f;
+
+            chain.push_back(encode_level(next, format, layout, alpha_scale, job_system));
+            current = std::move(next);
+        }
+
+        return chain;
+    }
+
+} // namespace kat
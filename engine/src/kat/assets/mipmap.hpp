@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "kat/assets/image.hpp"
+#include "kat/utils/job_system.hpp"
+
+namespace kat {
+
+    enum class MipFilter {
+        Box,    // 2x2 average, cheapest, slightly blurry on odd sizes
+        Kaiser, // Kaiser windowed sinc, keeps more detail in the lower levels
+    };
+
+    struct MipOptions {
+        MipFilter filter = MipFilter::Box;
+
+        // Treat the colour channels of 3 and 4 channel 8 bit images as sRGB: they are filtered in linear space and
+        // encoded back afterwards. Alpha is always linear.
+        bool srgb = true;
+
+        // Rescale alpha in each level so the fraction of texels passing alpha_cutoff matches level 0. Keeps alpha
+        // tested foliage from thinning out in the distance.
+        bool  preserve_alpha_coverage = false;
+        float alpha_cutoff            = 0.5f;
+
+        // 0 builds the full chain down to 1x1
+        uint32_t max_levels = 0;
+
+        float kaiser_alpha  = 4.0f;
+        float kaiser_radius = 3.0f; // in destination texels
+    };
+
+    // Builds the mip chain of `source`, which becomes level 0. Levels keep the source's channel count and pixel type
+    // so they can go straight to Texture::upload. With a job system every level is split into row ranges across the
+    // workers (safe to call from inside a job).
+    std::vector<Image> generate_mip_chain(Image source, const MipOptions &options = {},
+                                          const std::shared_ptr<JobSystem> &job_system = nullptr);
+
+} // namespace kat
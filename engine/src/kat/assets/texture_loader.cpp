@@ -0,0 +1,360 @@
+#include "texture_loader.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+#include "kat/utils/mapped_file.hpp"
+
+namespace kat {
+
+    PixelFormat image_pixel_format(const Image &image) {
+        switch (image.channels) {
+        case 1:
+            return PixelFormat::Red;
+        case 2:
+            return PixelFormat::Rg;
+        case 3:
+            return PixelFormat::Rgb;
+        default:
+            return PixelFormat::Rgba;
+        }
+    }
+
+    TextureFormat image_texture_format(const Image &image, bool srgb) {
+        if (image.hdr) {
+            switch (image.channels) {
+            case 1:
+                return TextureFormat::R16F;
+            case 2:
+                return TextureFormat::Rg16F;
+            case 3:
+                return TextureFormat::Rgb16F;
+            default:
+                return TextureFormat::Rgba16F;
+            }
+        }
+
+        switch (image.channels) {
+        case 1:
+            return TextureFormat::R8;
+        case 2:
+            return TextureFormat::Rg8;
+        default:
+            // RGB is padded to four channels by the driver anyway, this keeps it a renderable format
+            return srgb ? TextureFormat::Srgb8Alpha8 : TextureFormat::Rgba8;
+        }
+    }
+
+    TextureLoader::TextureLoader(const std::shared_ptr<JobSystem> &job_system, size_t staging_size) :
+        m_job_system(job_system), m_staging(StreamBuffer::create(staging_size)),
+        m_completion(std::make_shared<Completion>()) {}
+
+    std::shared_ptr<TextureLoader> TextureLoader::create(const std::shared_ptr<JobSystem> &job_system,
+                                                         size_t staging_size) {
+        return std::make_shared<TextureLoader>(job_system, staging_size);
+    }
+
+    std::shared_ptr<TextureRequest> TextureLoader::load(const std::string &path, const TextureLoadOptions &options) {
+        return submit(Kind::Single, { Source{ path, {} } }, options);
+    }
+
+    std::shared_ptr<TextureRequest> TextureLoader::load(std::vector<std::byte> encoded,
+                                                        const TextureLoadOptions &options) {
+        std::vector<Source> sources;
+        sources.push_back({ {}, std::move(encoded) });
+        return submit(Kind::Single, std::move(sources), options);
+    }
+
+    std::shared_ptr<TextureRequest> TextureLoader::load_array(const std::vector<std::string> &paths,
+                                                              const TextureLoadOptions &options) {
+        std::vector<Source> sources;
+        for (const auto &path : paths) {
+            sources.push_back({ path, {} });
+        }
+        return submit(Kind::Array, std::move(sources), options);
+    }
+
+    std::shared_ptr<TextureRequest> TextureLoader::load_cube(const std::array<std::string, 6> &faces,
+                                                             const TextureLoadOptions &options) {
+        std::vector<Source> sources;
+        for (const auto &path : faces) {
+            sources.push_back({ path, {} });
+        }
+        return submit(Kind::Cube, std::move(sources), options);
+    }
+
+    std::shared_ptr<TextureRequest> TextureLoader::submit(Kind kind, std::vector<Source> sources,
+                                                          const TextureLoadOptions &options) {
+        auto job     = std::make_shared<Job>();
+        job->request = std::make_shared<TextureRequest>();
+        job->kind    = kind;
+        job->options = options;
+        job->sources = std::move(sources);
+        job->images.resize(job->sources.size());
+        job->errors.resize(job->sources.size());
+        job->remaining = job->sources.size();
+
+        m_pending++;
+
+        if (job->sources.empty()) {
+            job->errors.push_back("no images given");
+
+            std::lock_guard lock(m_completion->mutex);
+            m_completion->jobs.push_back(job);
+            return job->request;
+        }
+
+        // one decode per image so that arrays and cube maps spread over the workers too
+        for (size_t i = 0; i < job->sources.size(); i++) {
+            m_job_system->submit([job, i, completion = m_completion, job_system = m_job_system] {
+                const Source             &source  = job->sources[i];
+                const TextureLoadOptions &options = job->options;
+                const ImageDecodeOptions  decode  = { .flip_vertically = options.flip_vertically };
+
+                const MipOptions mips = {
+                    .filter                  = options.mip_filter,
+                    .srgb                    = options.srgb,
+                    .preserve_alpha_coverage = options.preserve_alpha_coverage,
+                    .alpha_cutoff            = options.alpha_cutoff,
+                    .max_levels              = options.generate_mipmaps ? 0u : 1u,
+                };
+
+                try {
+                    std::optional<MappedFile>  file;
+                    std::span<const std::byte> bytes = source.encoded;
+                    if (source.encoded.empty()) {
+                        file.emplace(source.path);
+                        bytes = file->span();
+                    }
+
+                    if (is_ktx2(bytes) || is_dds(bytes)) {
+                        if (job->kind != Kind::Single)
+                            throw std::runtime_error("block compressed files can't be used as array layers or faces");
+                        job->compressed = parse_compressed_texture(bytes);
+                    } else {
+                        job->images[i] = generate_mip_chain(decode_image(bytes, decode), mips, job_system);
+                    }
+                }
+                catch (const std::exception &e) {
+                    job->errors[i] = e.what();
+                }
+
+                if (job->remaining.fetch_sub(1) == 1) {
+                    std::lock_guard lock(completion->mutex);
+                    completion->jobs.push_back(job);
+                    completion->condition.notify_all();
+                }
+            });
+        }
+
+        return job->request;
+    }
+
+    void TextureLoader::update(size_t upload_budget) {
+        {
+            std::lock_guard lock(m_completion->mutex);
+            while (!m_completion->jobs.empty()) {
+                m_uploading.push_back(std::move(m_completion->jobs.front()));
+                m_completion->jobs.pop_front();
+            }
+        }
+
+        size_t budget = upload_budget;
+        while (!m_uploading.empty()) {
+            Job &job = *m_uploading.front();
+
+            std::string error;
+            for (const auto &e : job.errors) {
+                if (!e.empty()) {
+                    error = e;
+                    break;
+                }
+            }
+
+            if (error.empty()) {
+                try {
+                    if (!upload(job, budget))
+                        break;
+                }
+                catch (const std::runtime_error &e) {
+                    error = e.what();
+                }
+            }
+
+            if (!error.empty()) {
+                std::cerr << "Failed to load texture: " << error << std::endl;
+                job.request->m_state = TextureLoadState::Failed;
+                job.request->m_error = std::move(error);
+            }
+
+            m_uploading.pop_front();
+            m_pending--;
+        }
+
+        m_staging->fence();
+    }
+
+    void TextureLoader::wait_all() {
+        while (m_pending > 0) {
+            update(std::numeric_limits<size_t>::max());
+            if (m_pending == 0)
+                break;
+
+            // staging fences only signal once the commands reach the GPU
+            glFlush();
+
+            std::unique_lock lock(m_completion->mutex);
+            m_completion->condition.wait_for(lock, std::chrono::milliseconds(1),
+                                             [&] { return !m_completion->jobs.empty(); });
+        }
+    }
+
+    bool TextureLoader::upload(Job &job, size_t &budget) {
+        if (job.compressed)
+            return upload_compressed(job, budget);
+
+        const Image &first = job.images.front().front();
+
+        if (!job.texture) {
+            for (const auto &chain : job.images) {
+                const Image &image = chain.front();
+                if (image.width != first.width || image.height != first.height ||
+                    image.channels != first.channels || image.hdr != first.hdr)
+                    throw std::runtime_error("texture layers differ in size or format");
+            }
+
+            const TextureFormat format = image_texture_format(first, job.options.srgb);
+            const auto          levels = static_cast<uint32_t>(job.images.front().size());
+
+            switch (job.kind) {
+            case Kind::Single:
+                job.texture = Texture2D::create(first.width, first.height, format, levels);
+                break;
+            case Kind::Array:
+                job.texture = Texture2DArray::create(first.width, first.height,
+                                                     static_cast<uint32_t>(job.images.size()), format, levels);
+                break;
+            case Kind::Cube:
+                if (first.width != first.height)
+                    throw std::runtime_error("cube map faces must be square");
+                job.texture = TextureCube::create(first.width, format, levels);
+                break;
+            }
+        }
+
+        const PixelFormat format = image_pixel_format(first);
+        const PixelType   type   = first.hdr ? PixelType::Float : PixelType::UnsignedByte;
+
+        for (; job.next_layer < job.images.size(); job.next_layer++, job.next_level = 0) {
+            std::vector<Image> &chain = job.images[job.next_layer];
+            const auto          layer = static_cast<uint32_t>(job.next_layer);
+
+            for (; job.next_level < chain.size(); job.next_level++) {
+                Image           &image = chain[job.next_level];
+                const size_t     bytes = image.pixels.size();
+                const auto       level = static_cast<uint32_t>(job.next_level);
+                const glm::uvec2 size  = { image.width, image.height };
+
+                if (budget == 0)
+                    return false;
+
+                unsigned int buffer;
+                size_t       offset;
+                if (!stage(image.pixels.data(), bytes, buffer, offset))
+                    return false;
+
+                switch (job.kind) {
+                case Kind::Single:
+                    static_cast<Texture2D &>(*job.texture).upload(level, { 0, 0 }, size, format, type, buffer, offset);
+                    break;
+                case Kind::Array:
+                    static_cast<Texture2DArray &>(*job.texture)
+                        .upload(level, layer, { 0, 0 }, size, format, type, buffer, offset);
+                    break;
+                case Kind::Cube:
+                    static_cast<TextureCube &>(*job.texture)
+                        .upload(level, static_cast<CubeFace>(layer), { 0, 0 }, size, format, type, buffer, offset);
+                    break;
+                }
+
+                budget -= std::min(budget, bytes);
+                image.pixels = {};
+            }
+        }
+
+        job.texture->set_sampler(job.options.sampler);
+
+        job.request->m_texture = std::move(job.texture);
+        job.request->m_state   = TextureLoadState::Ready;
+        return true;
+    }
+
+    bool TextureLoader::upload_compressed(Job &job, size_t &budget) {
+        const CompressedTexture &source = *job.compressed;
+
+        if (!job.texture) {
+            if (source.cube)
+                job.texture = TextureCube::create(source.width, source.format, source.levels);
+            else if (source.layers > 1)
+                job.texture =
+                    Texture2DArray::create(source.width, source.height, source.layers, source.format, source.levels);
+            else
+                job.texture = Texture2D::create(source.width, source.height, source.format, source.levels);
+        }
+
+        for (; job.next_layer < source.subresources.size(); job.next_layer++) {
+            const CompressedSubresource &sub  = source.subresources[job.next_layer];
+            const glm::uvec2             size = { sub.width, sub.height };
+
+            if (budget == 0)
+                return false;
+
+            unsigned int buffer;
+            size_t       offset;
+            if (!stage(source.data.data() + sub.offset, sub.size, buffer, offset))
+                return false;
+
+            if (source.cube)
+                static_cast<TextureCube &>(*job.texture)
+                    .upload_compressed(sub.level, static_cast<CubeFace>(sub.layer), { 0, 0 }, size, sub.size, buffer,
+                                       offset);
+            else if (source.layers > 1)
+                static_cast<Texture2DArray &>(*job.texture)
+                    .upload_compressed(sub.level, sub.layer, { 0, 0 }, size, sub.size, buffer, offset);
+            else
+                static_cast<Texture2D &>(*job.texture).upload_compressed(sub.level, { 0, 0 }, size, sub.size, buffer,
+                                                                         offset);
+
+            budget -= std::min(budget, sub.size);
+        }
+
+        job.texture->set_sampler(job.options.sampler);
+        job.compressed.reset();
+
+        job.request->m_texture = std::move(job.texture);
+        job.request->m_state   = TextureLoadState::Ready;
+        return true;
+    }
+
+    bool TextureLoader::stage(const void *data, size_t bytes, unsigned int &buffer, size_t &offset) {
+        // data larger than the whole staging buffer goes up straight from client memory
+        if (bytes > m_staging->get_capacity()) {
+            buffer = 0;
+            offset = reinterpret_cast<size_t>(data);
+            return true;
+        }
+
+        const auto allocation = m_staging->try_allocate(bytes);
+        if (!allocation)
+            return false;
+
+        std::memcpy(allocation->data, data, bytes);
+        buffer = m_staging->get_handle();
+        offset = allocation->offset;
+        return true;
+    }
+
+} // namespace kat
@@ -0,0 +1,156 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "kat/assets/compressed_texture.hpp"
+#include "kat/assets/image.hpp"
+#include "kat/assets/mipmap.hpp"
+#include "kat/renderer/stream_buffer.hpp"
+#include "kat/renderer/texture.hpp"
+#include "kat/utils/job_system.hpp"
+
+namespace kat {
+
+    struct TextureLoadOptions {
+        // colour data is stored as sRGB, turn off for normal maps and other linear data
+        bool srgb             = true;
+        bool generate_mipmaps = true;
+        bool flip_vertically  = false;
+
+        // mips are built on the decode worker, see MipOptions
+        MipFilter mip_filter              = MipFilter::Box;
+        bool      preserve_alpha_coverage = false;
+        float     alpha_cutoff            = 0.5f;
+
+        SamplerState sampler;
+    };
+
+    // client pixel layout of a decoded image
+    [[nodiscard]] PixelFormat image_pixel_format(const Image &image);
+
+    // GPU format a decoded image is stored in; RGB is padded to RGBA, HDR images become half floats
+    [[nodiscard]] TextureFormat image_texture_format(const Image &image, bool srgb);
+
+    enum class TextureLoadState { Pending, Ready, Failed };
+
+    // Handle to a texture that is still being decoded or uploaded. Only touched on the GL thread.
+    class TextureRequest {
+      public:
+        [[nodiscard]] TextureLoadState get_state() const noexcept { return m_state; }
+
+        [[nodiscard]] bool is_ready() const noexcept { return m_state == TextureLoadState::Ready; }
+
+        // null until ready
+        [[nodiscard]] const std::shared_ptr<Texture> &get_texture() const noexcept { return m_texture; }
+
+        template <typename T>
+        [[nodiscard]] std::shared_ptr<T> get() const {
+            return std::dynamic_pointer_cast<T>(m_texture);
+        }
+
+        [[nodiscard]] const std::string &get_error() const noexcept { return m_error; }
+
+      private:
+        friend class TextureLoader;
+
+        TextureLoadState         m_state = TextureLoadState::Pending;
+        std::shared_ptr<Texture> m_texture;
+        std::string              m_error;
+    };
+
+    // Decodes images and builds their mip chains on the job system, then uploads them through a persistently mapped
+    // staging buffer. Decoding never touches GL, so the only main thread cost is the copy into the staging buffer and
+    // the upload commands. KTX2 and DDS files are uploaded as stored (format, mips, layers and faces come from the
+    // file, the mip and sRGB options are ignored) and have to be loaded with load(), not as array layers or faces.
+    class TextureLoader {
+      public:
+        explicit TextureLoader(const std::shared_ptr<JobSystem> &job_system, size_t staging_size = 64 * 1024 * 1024);
+
+        static std::shared_ptr<TextureLoader> create(const std::shared_ptr<JobSystem> &job_system,
+                                                     size_t staging_size = 64 * 1024 * 1024);
+
+        std::shared_ptr<TextureRequest> load(const std::string &path, const TextureLoadOptions &options = {});
+
+        // encoded file contents, e.g. images embedded in a glTF
+        std::shared_ptr<TextureRequest> load(std::vector<std::byte> encoded, const TextureLoadOptions &options = {});
+
+        // all layers must have the same size
+        std::shared_ptr<TextureRequest> load_array(const std::vector<std::string> &paths,
+                                                   const TextureLoadOptions &options = {});
+
+        // faces in CubeFace order: +X, -X, +Y, -Y, +Z, -Z
+        std::shared_ptr<TextureRequest> load_cube(const std::array<std::string, 6> &faces,
+                                                  const TextureLoadOptions &options = {});
+
+        // Creates and uploads textures whose decode has finished, copying at most `upload_budget` bytes this call.
+        // Call once per frame on the GL thread.
+        void update(size_t upload_budget = 32 * 1024 * 1024);
+
+        // Blocks until every request so far is ready or failed.
+        void wait_all();
+
+        [[nodiscard]] size_t get_pending_count() const noexcept { return m_pending; }
+
+      private:
+        enum class Kind { Single, Array, Cube };
+
+        struct Source {
+            std::string            path;
+            std::vector<std::byte> encoded; // used instead of path when not empty
+        };
+
+        struct Job {
+            std::shared_ptr<TextureRequest> request;
+            Kind                            kind;
+            TextureLoadOptions              options;
+            std::vector<Source>             sources;
+
+            // written by the decode jobs, one mip chain per layer
+            std::vector<std::vector<Image>> images;
+            std::vector<std::string>        errors;
+            std::atomic<size_t>             remaining;
+
+            // set instead of images for KTX2/DDS files
+            std::optional<CompressedTexture> compressed;
+
+            // upload progress, GL thread only
+            std::shared_ptr<Texture> texture;
+            size_t                   next_layer = 0;
+            size_t                   next_level = 0;
+        };
+
+        // outlives the loader while decode jobs are still running
+        struct Completion {
+            std::mutex                       mutex;
+            std::condition_variable          condition;
+            std::deque<std::shared_ptr<Job>> jobs;
+        };
+
+        std::shared_ptr<TextureRequest> submit(Kind kind, std::vector<Source> sources,
+                                               const TextureLoadOptions &options);
+
+        // returns false when the staging buffer ran out of room or budget, the job resumes next update
+        bool upload(Job &job, size_t &budget);
+
+        // next_layer counts subresources here
+        bool upload_compressed(Job &job, size_t &budget);
+
+        // copies into the staging buffer, or leaves `data` as the client pointer when it could never fit. Returns
+        // false when the staging buffer is full for now.
+        bool stage(const void *data, size_t bytes, unsigned int &buffer, size_t &offset);
+
+        std::shared_ptr<JobSystem>       m_job_system;
+        std::shared_ptr<StreamBuffer>    m_staging;
+        std::shared_ptr<Completion>      m_completion;
+        std::deque<std::shared_ptr<Job>> m_uploading;
+        size_t                           m_pending = 0;
+    };
+
+} // namespace kat
@@ -0,0 +1,619 @@
+#include "texture_streamer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#include "kat/assets/compressed_texture.hpp"
+#include "kat/assets/mipmap.hpp"
+#include "kat/renderer/shader.hpp"
+#include "kat/utils/mapped_file.hpp"
+
+namespace kat {
+    namespace {
+        constexpr uint32_t NO_FEEDBACK        = 0xFFFFFFFF;
+        constexpr size_t   MIN_TABLE_CAPACITY = 64;
+
+        std::string streaming_include() {
+            return "struct KatStream {\n"
+                   "    vec2  size;\n"
+                   "    float min_level;\n"
+                   "    uint  padding;\n"
+                   "};\n"
+                   "layout(std430, binding = " +
+                   std::to_string(STREAM_RESIDENCY_BINDING) +
+                   ") readonly buffer KatStreamResidency {\n"
+                   "    KatStream kat_streams[];\n"
+                   "};\n"
+                   "layout(std430, binding = " +
+                   std::to_string(STREAM_FEEDBACK_BINDING) +
+                   ") buffer KatStreamFeedback {\n"
+                   "    uint kat_stream_feedback[];\n"
+                   "};\n"
+                   "// Fragment shaders only. Level stream `id` needs at uv, one pixel in 16 reports it back.\n"
+                   "float kat_stream_lod(uint id, vec2 uv) {\n"
+                   "    vec2 texels = uv * kat_streams[id].size;\n"
+                   "    vec2 dx = dFdx(texels);\n"
+                   "    vec2 dy = dFdy(texels);\n"
+                   "    float lod = max(0.5 * log2(max(dot(dx, dx), dot(dy, dy))), 0.0);\n"
+                   "    uvec2 pixel = uvec2(gl_FragCoord.xy);\n"
+                   "    if (((pixel.x | pixel.y) & 3u) == 0u)\n"
+                   "        atomicMin(kat_stream_feedback[id], uint(lod));\n"
+                   "    return lod;\n"
+                   "}\n"
+                   "// Samples with the gradients widened so no level finer than the resident ones is touched.\n"
+                   "vec4 kat_stream_sample(sampler2D s, uint id, vec2 uv) {\n"
+                   "    vec2 dx = dFdx(uv);\n"
+                   "    vec2 dy = dFdy(uv);\n"
+                   "    float scale = exp2(max(kat_streams[id].min_level - kat_stream_lod(id, uv), 0.0));\n"
+                   "    return textureGrad(s, uv, dx * scale, dy * scale);\n"
+                   "}\n";
+        }
+    } // namespace
+
+    TextureStreamer::TextureStreamer(const std::shared_ptr<GpuResources>    &resources,
+                                     const std::shared_ptr<JobSystem>       &job_system,
+                                     const TextureStreamerOptions           &options,
+                                     const std::shared_ptr<TextureRegistry> &registry, size_t staging_size) :
+        m_resources(resources), m_job_system(job_system), m_registry(registry),
+        m_staging(StreamBuffer::create(staging_size)),
+        m_completions(std::make_shared<Completions>()), m_options(options),
+        // the registry's array fallback copies textures when they are added, it would never see committed levels
+        m_sparse(options.prefer_sparse && GLAD_GL_ARB_sparse_texture && (!registry || registry->is_bindless())),
+        m_residency(resources->create_buffer()), m_feedback(resources->create_buffer()) {
+        ShaderModule::register_include("kat/streaming.glsl", streaming_include());
+        resize_gpu_tables();
+    }
+
+    TextureStreamer::~TextureStreamer() {
+        if (m_readback_fence)
+            glDeleteSync(m_readback_fence);
+
+        if (m_readback != 0) {
+            glUnmapNamedBuffer(m_readback);
+            glDeleteBuffers(1, &m_readback);
+        }
+
+        m_resources->destroy(m_residency);
+        m_resources->destroy(m_feedback);
+    }
+
+    std::shared_ptr<TextureStreamer> TextureStreamer::create(const std::shared_ptr<GpuResources>    &resources,
+                                                             const std::shared_ptr<JobSystem>       &job_system,
+                                                             const TextureStreamerOptions           &options,
+                                                             const std::shared_ptr<TextureRegistry> &registry,
+                                                             size_t                                  staging_size) {
+        return std::make_shared<TextureStreamer>(resources, job_system, options, registry, staging_size);
+    }
+
+    uint32_t TextureStreamer::add(const std::string &path, const TextureLoadOptions &options) {
+        uint32_t id;
+        if (!m_free.empty()) {
+            id = m_free.back();
+            m_free.pop_back();
+        }
+        else {
+            id = static_cast<uint32_t>(m_streams.size());
+            m_streams.emplace_back();
+        }
+
+        Stream        &stream     = m_streams[id];
+        const uint32_t generation = stream.generation + 1;
+
+        stream            = {};
+        stream.path       = path;
+        stream.options    = options;
+        stream.generation = generation;
+        stream.used       = true;
+
+        resize_gpu_tables();
+
+        m_job_system->submit([id, generation, path, options, completions = m_completions,
+                              job_system = m_job_system] {
+            Completion completion{ id, generation, nullptr, {} };
+
+            try {
+                const auto file   = MappedFile::open(path);
+                auto       source = std::make_shared<Source>();
+
+                if (is_ktx2(file->span()) || is_dds(file->span())) {
+                    // the levels stay in the mapping until they are streamed in
+                    const CompressedTexture texture = parse_compressed_texture(file->span(), false);
+                    if (texture.cube || texture.layers != 1)
+                        throw std::runtime_error("only single 2D textures can be streamed");
+
+                    source->format       = texture.format;
+                    source->pixel_format = PixelFormat::Rgba;
+                    source->pixel_type   = PixelType::UnsignedByte;
+                    source->compressed   = true;
+                    source->width        = texture.width;
+                    source->height       = texture.height;
+                    source->levels.resize(texture.levels);
+                    source->file_levels.resize(texture.levels);
+                    source->file = file;
+
+                    for (const auto &sub : texture.subresources) {
+                        source->file_levels[sub.level] = file->span(sub.offset, sub.size);
+                    }
+                }
+                else {
+                    const MipOptions mips = {
+                        .filter                  = options.mip_filter,
+                        .srgb                    = options.srgb,
+                        .preserve_alpha_coverage = options.preserve_alpha_coverage,
+                        .alpha_cutoff            = options.alpha_cutoff,
+                        .max_levels              = options.generate_mipmaps ? 0u : 1u,
+                    };
+
+                    std::vector<Image> chain = generate_mip_chain(
+                        decode_image(file->span(), { .flip_vertically = options.flip_vertically }), mips, job_system);
+
+                    const Image &first   = chain.front();
+                    source->format       = image_texture_format(first, options.srgb);
+                    source->pixel_format = image_pixel_format(first);
+                    source->pixel_type   = first.hdr ? PixelType::Float : PixelType::UnsignedByte;
+                    source->compressed   = false;
+                    source->width        = first.width;
+                    source->height       = first.height;
+
+                    for (auto &image : chain) {
+                        source->levels.push_back(std::move(image.pixels));
+                    }
+                }
+
+                completion.source = std::move(source);
+            }
+            catch (const std::exception &e) {
+                completion.error = path + ": " + e.what();
+            }
+
+            std::lock_guard lock(completions->mutex);
+            completions->done.push_back(std::move(completion));
+        });
+
+        return id;
+    }
+
+    void TextureStreamer::remove(uint32_t id) {
+        Stream &stream = m_streams.at(id);
+        if (!stream.used)
+            return;
+
+        if (m_registry && stream.registry_index != NO_TEXTURE)
+            m_registry->remove(stream.registry_index);
+        if (stream.texture)
+            m_resident_bytes -= resident_bytes(stream, stream.resident);
+
+        // a decode still in flight sees the generation change and is dropped
+        const uint32_t generation = stream.generation;
+        stream                    = {};
+        stream.generation         = generation;
+
+        m_gpu_streams[id] = {};
+        m_residency_dirty = true;
+        m_free.push_back(id);
+    }
+
+    void TextureStreamer::request_level(uint32_t id, uint32_t level) {
+        Stream &stream = m_streams.at(id);
+        if (stream.cpu_frame != m_frame) {
+            stream.cpu_level = level;
+            stream.cpu_frame = m_frame;
+        }
+        else {
+            stream.cpu_level = std::min(stream.cpu_level, level);
+        }
+    }
+
+    uint32_t TextureStreamer::select_level(uint32_t width, uint32_t height, float uv_density, float distance,
+                                           float projection_scale) {
+        // texels of the full resolution level that land on one pixel
+        const float texels = static_cast<float>(std::max(width, height)) * uv_density * std::max(distance, 1e-4f) /
+                             std::max(projection_scale, 1e-6f);
+        if (texels <= 1.0f)
+            return 0;
+        return static_cast<uint32_t>(std::floor(std::log2(texels)));
+    }
+
+    void TextureStreamer::update(size_t upload_budget) {
+        std::deque<Completion> done;
+        std::deque<LevelRead>  reads;
+        {
+            std::lock_guard lock(m_completions->mutex);
+            std::swap(done, m_completions->done);
+            std::swap(reads, m_completions->reads);
+        }
+
+        for (auto &completion : done) {
+            Stream &stream = m_streams[completion.id];
+            if (!stream.used || stream.generation != completion.generation)
+                continue;
+
+            if (completion.error.empty()) {
+                try {
+                    finish_load(completion.id, std::move(completion.source));
+                    continue;
+                }
+                catch (const std::runtime_error &e) {
+                    completion.error = stream.path + ": " + e.what();
+                }
+            }
+
+            std::cerr << "Failed to stream texture: " << completion.error << std::endl;
+            stream.state  = StreamState::Failed;
+            stream.source = nullptr;
+        }
+
+        for (auto &read : reads) {
+            Stream &stream = m_streams[read.id];
+            if (!stream.used || stream.generation != read.generation)
+                continue;
+
+            // levels that went up from the mapping in the meantime are dropped
+            stream.reading = false;
+            for (uint32_t i = 0; i < read.levels.size(); i++) {
+                if (read.first + i < stream.resident)
+                    stream.source->levels[read.first + i] = std::move(read.levels[i]);
+            }
+        }
+
+        read_feedback();
+        plan_budget();
+
+        // evict first so the memory is free for what streams in
+        for (uint32_t id = 0; id < m_streams.size(); id++) {
+            const Stream &stream = m_streams[id];
+            if (stream.state == StreamState::Ready && stream.resident < stream.target)
+                set_resident(id, stream.target);
+        }
+
+        // largest shortfall first, each texture moves as many levels as the upload budget allows
+        std::vector<uint32_t> missing;
+        for (uint32_t id = 0; id < m_streams.size(); id++) {
+            const Stream &stream = m_streams[id];
+            if (stream.state == StreamState::Ready && stream.resident > stream.target)
+                missing.push_back(id);
+        }
+        std::ranges::sort(missing, [&](uint32_t a, uint32_t b) {
+            return m_streams[a].resident - m_streams[a].target > m_streams[b].resident - m_streams[b].target;
+        });
+
+        size_t budget = upload_budget;
+        for (const uint32_t id : missing) {
+            const Stream &stream = m_streams[id];
+
+            uint32_t first = stream.resident;
+            size_t   bytes = 0;
+            while (first > stream.target) {
+                const size_t next = level_bytes(stream, first - 1);
+                // a level bigger than the whole budget still goes up, on its own
+                if (bytes + next > budget && !(bytes == 0 && budget == upload_budget))
+                    break;
+                bytes += next;
+                first--;
+            }
+
+            if (first == stream.resident)
+                break;
+
+            // levels of a mapped file are read before they go up, what is already in memory goes up now
+            const uint32_t loaded = loaded_level(stream, first);
+            if (loaded > first && !stream.reading)
+                read_levels(id, first, loaded);
+            if (loaded < stream.resident)
+                set_resident(id, loaded);
+
+            budget -= std::min(budget, bytes);
+            if (budget == 0)
+                break;
+        }
+
+        if (m_residency_dirty) {
+            m_resources->get(m_residency).set(m_gpu_streams, BufferUsage::DynamicDraw);
+            m_residency_dirty = false;
+        }
+
+        m_staging->fence();
+        m_frame++;
+    }
+
+    void TextureStreamer::bind() const {
+        m_resources->get(m_residency).bind_base(BufferTarget::ShaderStorage, STREAM_RESIDENCY_BINDING);
+        m_resources->get(m_feedback).bind_base(BufferTarget::ShaderStorage, STREAM_FEEDBACK_BINDING);
+    }
+
+    void TextureStreamer::finish_load(uint32_t id, std::shared_ptr<Source> source) {
+        Stream &stream = m_streams[id];
+        stream.source  = std::move(source);
+
+        const Source &src = *stream.source;
+        stream.levels     = static_cast<uint32_t>(src.levels.size());
+
+        // first level that fits in tail_size
+        stream.tail = 0;
+        while (stream.tail + 1 < stream.levels &&
+               std::max(src.width >> stream.tail, src.height >> stream.tail) > m_options.tail_size)
+            stream.tail++;
+
+        if (m_sparse && stream.levels > 1 && Texture2D::supports_sparse(src.format, src.width, src.height)) {
+            stream.texture = Texture2D::create_sparse(src.width, src.height, src.format, stream.levels);
+            stream.texture->set_sampler(stream.options.sampler);
+
+            // the mip tail can only be committed as a whole, keep all of it resident; tail levels of a mapped file are
+            // small enough to be read right here
+            stream.tail = std::min(stream.tail, stream.texture->get_sparse_levels());
+            for (uint32_t level = stream.tail; level < stream.levels; level++) {
+                stream.texture->commit(level, true);
+                upload_level(stream, *stream.texture, level, level);
+            }
+        }
+        else {
+            stream.texture = Texture2D::create(std::max(src.width >> stream.tail, 1u),
+                                               std::max(src.height >> stream.tail, 1u), src.format,
+                                               stream.levels - stream.tail);
+            stream.texture->set_sampler(stream.options.sampler);
+            for (uint32_t level = stream.tail; level < stream.levels; level++) {
+                upload_level(stream, *stream.texture, level, level - stream.tail);
+            }
+        }
+
+        stream.resident = stream.tail;
+        stream.target   = stream.tail;
+        stream.state    = StreamState::Ready;
+        m_resident_bytes += resident_bytes(stream, stream.resident);
+
+        m_gpu_streams[id] = { static_cast<float>(src.width), static_cast<float>(src.height),
+                              stream.texture->is_sparse() ? static_cast<float>(stream.resident) : 0.0f, 0 };
+        m_residency_dirty = true;
+
+        if (m_registry)
+            stream.registry_index = m_registry->add(stream.texture, stream.options.sampler);
+    }
+
+    void TextureStreamer::read_feedback() {
+        if (m_readback_fence) {
+            const GLenum status = glClientWaitSync(m_readback_fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                return;
+
+            glDeleteSync(m_readback_fence);
+            m_readback_fence = nullptr;
+
+            const size_t count = std::min(m_streams.size(), m_readback_count);
+            for (size_t id = 0; id < count; id++) {
+                Stream        &stream = m_streams[id];
+                const uint32_t level  = m_readback_data[id];
+                if (level == NO_FEEDBACK || stream.state != StreamState::Ready)
+                    continue;
+
+                stream.feedback_level = level;
+                stream.feedback_frame = m_readback_frame;
+            }
+        }
+
+        // take what the shaders wrote since the last round and start over
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        const unsigned int feedback = m_resources->get(m_feedback).get_handle();
+        glCopyNamedBufferSubData(feedback, m_readback, 0, 0,
+                                 static_cast<GLsizeiptr>(m_readback_count * sizeof(uint32_t)));
+        glClearNamedBufferData(feedback, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &NO_FEEDBACK);
+
+        m_readback_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_readback_frame = m_frame;
+    }
+
+    void TextureStreamer::plan_budget() {
+        struct Candidate {
+            uint64_t age;
+            size_t   bytes; // of the finest level it would give up next
+            uint32_t id;
+        };
+
+        // stale textures give up levels first, then the biggest levels
+        auto lower_priority = [](const Candidate &a, const Candidate &b) {
+            return a.age != b.age ? a.age < b.age : a.bytes < b.bytes;
+        };
+
+        size_t                 total = 0;
+        std::vector<Candidate> candidates;
+
+        for (uint32_t id = 0; id < m_streams.size(); id++) {
+            Stream &stream = m_streams[id];
+            if (stream.state != StreamState::Ready)
+                continue;
+
+            stream.target = std::min(requested_level(stream), stream.tail);
+            total += resident_bytes(stream, stream.target);
+
+            if (stream.target < stream.tail) {
+                const uint64_t last = std::max(stream.feedback_frame, stream.cpu_frame);
+                candidates.push_back({ m_frame - last, level_bytes(stream, stream.target), id });
+            }
+        }
+
+        std::ranges::make_heap(candidates, lower_priority);
+        while (total > m_options.budget && !candidates.empty()) {
+            std::ranges::pop_heap(candidates, lower_priority);
+            const Candidate candidate = candidates.back();
+            candidates.pop_back();
+
+            Stream &stream = m_streams[candidate.id];
+            total -= candidate.bytes;
+            stream.target++;
+
+            if (stream.target < stream.tail) {
+                candidates.push_back({ candidate.age, level_bytes(stream, stream.target), candidate.id });
+                std::ranges::push_heap(candidates, lower_priority);
+            }
+        }
+    }
+
+    void TextureStreamer::set_resident(uint32_t id, uint32_t first) {
+        Stream &stream = m_streams[id];
+        if (first == stream.resident)
+            return;
+
+        Source &src = *stream.source;
+
+        if (stream.texture->is_sparse()) {
+            for (uint32_t level = stream.resident; level < first; level++) {
+                stream.texture->commit(level, false);
+            }
+            for (uint32_t level = first; level < stream.resident; level++) {
+                stream.texture->commit(level, true);
+                upload_level(stream, *stream.texture, level, level);
+            }
+
+            m_gpu_streams[id].min_level = static_cast<float>(first);
+            m_residency_dirty           = true;
+        }
+        else {
+            auto texture = Texture2D::create(std::max(src.width >> first, 1u), std::max(src.height >> first, 1u),
+                                             src.format, stream.levels - first);
+            texture->set_sampler(stream.options.sampler);
+
+            // levels both textures hold move over on the GPU
+            for (uint32_t level = std::max(first, stream.resident); level < stream.levels; level++) {
+                glCopyImageSubData(stream.texture->get_handle(), GL_TEXTURE_2D,
+                                   static_cast<GLint>(level - stream.resident), 0, 0, 0, texture->get_handle(),
+                                   GL_TEXTURE_2D, static_cast<GLint>(level - first), 0, 0, 0,
+                                   static_cast<GLsizei>(std::max(src.width >> level, 1u)),
+                                   static_cast<GLsizei>(std::max(src.height >> level, 1u)), 1);
+            }
+            for (uint32_t level = first; level < stream.resident; level++) {
+                upload_level(stream, *texture, level, level - first);
+            }
+
+            stream.texture = std::move(texture);
+            if (m_registry)
+                m_registry->replace(stream.registry_index, stream.texture, stream.options.sampler);
+        }
+
+        // a mapped file's levels are read again when they are needed again
+        if (src.file) {
+            const uint32_t end = std::max(first, stream.resident);
+            for (uint32_t level = first < stream.resident ? first : 0; level < end; level++) {
+                src.levels[level] = {};
+            }
+        }
+
+        m_resident_bytes = m_resident_bytes - resident_bytes(stream, stream.resident) + resident_bytes(stream, first);
+        stream.resident  = first;
+    }
+
+    void TextureStreamer::read_levels(uint32_t id, uint32_t first, uint32_t last) {
+        Stream &stream = m_streams[id];
+        stream.reading = true;
+
+        m_job_system->submit([id, generation = stream.generation, first, last, source = stream.source,
+                              completions = m_completions] {
+            LevelRead read{ id, generation, first, {} };
+
+            // copying pages the levels in here instead of on the GL thread
+            for (uint32_t level = first; level < last; level++) {
+                const std::span<const std::byte> data = source->file_levels[level];
+                read.levels.emplace_back(data.begin(), data.end());
+            }
+
+            std::lock_guard lock(completions->mutex);
+            completions->reads.push_back(std::move(read));
+        });
+    }
+
+    uint32_t TextureStreamer::loaded_level(const Stream &stream, uint32_t first) {
+        const Source &src = *stream.source;
+        if (!src.file)
+            return first;
+
+        uint32_t level = stream.resident;
+        while (level > first && !src.levels[level - 1].empty())
+            level--;
+        return level;
+    }
+
+    void TextureStreamer::upload_level(const Stream &stream, const Texture2D &texture, uint32_t level,
+                                       uint32_t texture_level) {
+        const Source                    &src  = *stream.source;
+        const std::span<const std::byte> data = level_data(src, level);
+        const glm::uvec2 size = { std::max(src.width >> level, 1u), std::max(src.height >> level, 1u) };
+
+        // straight from client memory when the staging ring is full or too small, uploads never wait on the GPU
+        unsigned int buffer = 0;
+        auto         offset = reinterpret_cast<size_t>(data.data());
+        if (data.size() <= m_staging->get_capacity()) {
+            if (const auto allocation = m_staging->try_allocate(data.size())) {
+                std::memcpy(allocation->data, data.data(), data.size());
+                buffer = m_staging->get_handle();
+                offset = allocation->offset;
+            }
+        }
+
+        if (src.compressed)
+            texture.upload_compressed(texture_level, { 0, 0 }, size, data.size(), buffer, offset);
+        else
+            texture.upload(texture_level, { 0, 0 }, size, src.pixel_format, src.pixel_type, buffer, offset);
+    }
+
+    std::span<const std::byte> TextureStreamer::level_data(const Source &source, uint32_t level) {
+        if (source.file && source.levels[level].empty())
+            return source.file_levels[level];
+        return source.levels[level];
+    }
+
+    uint32_t TextureStreamer::requested_level(const Stream &stream) const {
+        uint32_t level = stream.tail;
+        if (stream.feedback_frame != 0 && m_frame - stream.feedback_frame < m_options.idle_frames)
+            level = std::min(level, stream.feedback_level);
+        if (stream.cpu_frame != 0 && m_frame - stream.cpu_frame < m_options.idle_frames)
+            level = std::min(level, stream.cpu_level);
+        return level;
+    }
+
+    size_t TextureStreamer::level_bytes(const Stream &stream, uint32_t level) {
+        const Source &src = *stream.source;
+        return texture_level_size(src.format, std::max(src.width >> level, 1u), std::max(src.height >> level, 1u));
+    }
+
+    size_t TextureStreamer::resident_bytes(const Stream &stream, uint32_t first) {
+        size_t bytes = 0;
+        for (uint32_t level = first; level < stream.levels; level++) {
+            bytes += level_bytes(stream, level);
+        }
+        return bytes;
+    }
+
+    void TextureStreamer::resize_gpu_tables() {
+        const size_t capacity = std::max(std::bit_ceil(m_streams.size()), MIN_TABLE_CAPACITY);
+        if (capacity <= m_readback_count)
+            return;
+
+        // any round in flight reads the old buffers, drop it
+        if (m_readback_fence) {
+            glDeleteSync(m_readback_fence);
+            m_readback_fence = nullptr;
+        }
+        if (m_readback != 0) {
+            glUnmapNamedBuffer(m_readback);
+            glDeleteBuffers(1, &m_readback);
+        }
+
+        const auto       bytes = static_cast<GLsizeiptr>(capacity * sizeof(uint32_t));
+        constexpr GLenum flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glCreateBuffers(1, &m_readback);
+        glNamedBufferStorage(m_readback, bytes, nullptr, flags);
+        m_readback_data  = static_cast<const uint32_t *>(glMapNamedBufferRange(m_readback, 0, bytes, flags));
+        m_readback_count = capacity;
+
+        Buffer &feedback = m_resources->get(m_feedback);
+        feedback.set(nullptr, static_cast<size_t>(bytes), BufferUsage::DynamicCopy);
+        glClearNamedBufferData(feedback.get_handle(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &NO_FEEDBACK);
+
+        m_gpu_streams.resize(capacity);
+        m_resources->get(m_residency).set(m_gpu_streams, BufferUsage::DynamicDraw);
+        m_residency_dirty = false;
+    }
+
+} // namespace kat
@@ -0,0 +1,233 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "kat/assets/texture_loader.hpp"
+#include "kat/renderer/gpu_resources.hpp"
+#include "kat/renderer/stream_buffer.hpp"
+#include "kat/renderer/texture.hpp"
+#include "kat/renderer/texture_registry.hpp"
+#include "kat/utils/job_system.hpp"
+#include "kat/utils/mapped_file.hpp"
+
+namespace kat {
+
+    // shader storage bindings used by the "kat/streaming.glsl" include
+    constexpr unsigned int STREAM_RESIDENCY_BINDING = 11;
+    constexpr unsigned int STREAM_FEEDBACK_BINDING  = 12;
+
+    struct TextureStreamerOptions {
+        // GPU memory shared by all streamed textures
+        size_t budget = 512 * 1024 * 1024;
+
+        // levels no larger than this on either side are uploaded first and never evicted
+        uint32_t tail_size = 128;
+
+        // a texture nobody asked for in this many updates drops back to its tail
+        uint32_t idle_frames = 120;
+
+        // GL_ARB_sparse_texture commits and releases single levels in place, without it a texture is reallocated
+        // whenever its resident range changes
+        bool prefer_sparse = true;
+    };
+
+    enum class StreamState { Loading, Ready, Failed };
+
+    // Keeps the mip levels of many textures on the GPU that are actually needed, within a memory budget. Images are
+    // decoded on the job system and their mip chain stays in system memory. KTX2/DDS files are only parsed and stay
+    // mapped, finer levels are read from the file on the job system when they are requested and dropped once they
+    // are uploaded, so the system memory they take is bounded by the upload budget. The GPU gets the small tail
+    // levels first and finer levels as they are requested, coarse to fine, a few per update.
+    //
+    // Requests come from request_level() and from the shaders: fragment shaders that include "kat/streaming.glsl"
+    // report the level they need with kat_stream_lod(), the results are read back a few frames later without
+    // stalling. kat_stream_sample() also clamps sampling to the resident levels of sparse textures.
+    class TextureStreamer {
+      public:
+        // With a registry, every texture gets a registry index that stays valid across reallocations.
+        TextureStreamer(const std::shared_ptr<GpuResources> &resources, const std::shared_ptr<JobSystem> &job_system,
+                        const TextureStreamerOptions           &options      = {},
+                        const std::shared_ptr<TextureRegistry> &registry     = nullptr,
+                        size_t                                  staging_size = 64 * 1024 * 1024);
+
+        ~TextureStreamer();
+
+        TextureStreamer(const TextureStreamer &)            = delete;
+        TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+        static std::shared_ptr<TextureStreamer> create(const std::shared_ptr<GpuResources>    &resources,
+                                                       const std::shared_ptr<JobSystem>       &job_system,
+                                                       const TextureStreamerOptions           &options  = {},
+                                                       const std::shared_ptr<TextureRegistry> &registry = nullptr,
+                                                       size_t staging_size = 64 * 1024 * 1024);
+
+        // The id is also the index shaders pass to kat_stream_lod()/kat_stream_sample().
+        uint32_t add(const std::string &path, const TextureLoadOptions &options = {});
+
+        void remove(uint32_t id);
+
+        [[nodiscard]] StreamState get_state(uint32_t id) const { return m_streams.at(id).state; }
+
+        // Null until the tail is uploaded. Without sparse textures this is a different texture after every change,
+        // prefer the registry index.
+        [[nodiscard]] const std::shared_ptr<Texture2D> &get_texture(uint32_t id) const {
+            return m_streams.at(id).texture;
+        }
+
+        // NO_TEXTURE until ready or without a registry
+        [[nodiscard]] uint32_t get_registry_index(uint32_t id) const { return m_streams.at(id).registry_index; }
+
+        // finest level on the GPU
+        [[nodiscard]] uint32_t get_resident_level(uint32_t id) const { return m_streams.at(id).resident; }
+
+        // CPU side request for this update, combined with the shader feedback (the finer level wins).
+        void request_level(uint32_t id, uint32_t level);
+
+        // Level a width x height texture needs on screen: `uv_density` is UV units per object unit, distance and
+        // projection_scale as for Mesh::select_lod.
+        [[nodiscard]] static uint32_t select_level(uint32_t width, uint32_t height, float uv_density, float distance,
+                                                   float projection_scale);
+
+        // Finishes loads, reads back feedback, then evicts and streams levels to fit the budget, copying at most
+        // `upload_budget` bytes of finer levels. Call once per frame on the GL thread.
+        void update(size_t upload_budget = 16 * 1024 * 1024);
+
+        // residency and feedback buffers for the streaming include
+        void bind() const;
+
+        [[nodiscard]] size_t get_resident_bytes() const noexcept { return m_resident_bytes; }
+
+        [[nodiscard]] bool is_sparse() const noexcept { return m_sparse; }
+
+      private:
+        // written by the decode job, only `levels` changes afterwards
+        struct Source {
+            TextureFormat format;
+            PixelFormat   pixel_format;
+            PixelType     pixel_type;
+            bool          compressed;
+            uint32_t      width;
+            uint32_t      height;
+
+            // the whole decoded chain, or for a mapped file the levels read so far and not yet uploaded
+            std::vector<std::vector<std::byte>> levels;
+
+            // KTX2/DDS, every level in the mapping
+            std::shared_ptr<MappedFile>             file;
+            std::vector<std::span<const std::byte>> file_levels;
+        };
+
+        struct Stream {
+            std::string        path;
+            TextureLoadOptions options;
+            StreamState        state      = StreamState::Loading;
+            uint32_t           generation = 0;
+            bool               used       = false;
+            bool               reading    = false; // levels are being read from the file
+
+            std::shared_ptr<Source>    source;
+            std::shared_ptr<Texture2D> texture;
+            uint32_t                   registry_index = NO_TEXTURE;
+
+            uint32_t levels   = 0;
+            uint32_t tail     = 0; // first level of the always resident tail
+            uint32_t resident = 0; // finest level on the GPU
+            uint32_t target   = 0; // finest level that fits the budget
+
+            uint32_t feedback_level = 0;
+            uint64_t feedback_frame = 0;
+            uint32_t cpu_level      = 0;
+            uint64_t cpu_frame      = 0;
+        };
+
+        struct Completion {
+            uint32_t                id;
+            uint32_t                generation;
+            std::shared_ptr<Source> source;
+            std::string             error;
+        };
+
+        // levels [first, first + levels.size()) of a mapped file
+        struct LevelRead {
+            uint32_t                            id;
+            uint32_t                            generation;
+            uint32_t                            first;
+            std::vector<std::vector<std::byte>> levels;
+        };
+
+        // shared with the decode and read jobs, outlives the streamer
+        struct Completions {
+            std::mutex             mutex;
+            std::deque<Completion> done;
+            std::deque<LevelRead>  reads;
+        };
+
+        // std430 layout of KatStream
+        struct GpuStream {
+            float    width;
+            float    height;
+            float    min_level;
+            uint32_t padding;
+        };
+
+        void finish_load(uint32_t id, std::shared_ptr<Source> source);
+
+        // copies levels [first, last) out of the stream's mapped file on the job system
+        void read_levels(uint32_t id, uint32_t first, uint32_t last);
+
+        // coarsest level at or above `first` from which on everything up to the resident levels is in memory
+        [[nodiscard]] static uint32_t loaded_level(const Stream &stream, uint32_t first);
+
+        void read_feedback();
+
+        // picks each stream's target level so that the total fits the budget
+        void plan_budget();
+
+        // makes exactly [first, levels) resident, uploading what is new
+        void set_resident(uint32_t id, uint32_t first);
+
+        void upload_level(const Stream &stream, const Texture2D &texture, uint32_t level, uint32_t texture_level);
+
+        [[nodiscard]] static std::span<const std::byte> level_data(const Source &source, uint32_t level);
+
+        // finest level asked for within the last idle_frames, the tail when there is none
+        [[nodiscard]] uint32_t requested_level(const Stream &stream) const;
+
+        [[nodiscard]] static size_t level_bytes(const Stream &stream, uint32_t level);
+
+        [[nodiscard]] static size_t resident_bytes(const Stream &stream, uint32_t first);
+
+        // grows the feedback and residency buffers to cover every stream id
+        void resize_gpu_tables();
+
+        std::shared_ptr<GpuResources>    m_resources;
+        std::shared_ptr<JobSystem>       m_job_system;
+        std::shared_ptr<TextureRegistry> m_registry;
+        std::shared_ptr<StreamBuffer>    m_staging;
+        std::shared_ptr<Completions>     m_completions;
+        TextureStreamerOptions           m_options;
+        bool                             m_sparse;
+
+        std::vector<Stream>   m_streams;
+        std::vector<uint32_t> m_free;
+        uint64_t              m_frame          = 1;
+        size_t                m_resident_bytes = 0;
+
+        std::vector<GpuStream> m_gpu_streams;
+        Handle<Buffer>         m_residency;
+        Handle<Buffer>         m_feedback;
+        bool                   m_residency_dirty = true;
+
+        // persistently mapped copy of the feedback, read once its fence signals
+        unsigned int    m_readback       = 0;
+        const uint32_t *m_readback_data  = nullptr;
+        size_t          m_readback_count = 0;
+        GLsync          m_readback_fence = nullptr;
+        uint64_t        m_readback_frame = 0;
+    };
+
+} // namespace kat
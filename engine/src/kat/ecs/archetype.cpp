@@ -0,0 +1,91 @@
+#include "archetype.hpp"
+
+#include <algorithm>
+
+namespace kat {
+
+    Archetype::Archetype(std::vector<ComponentId> components) : m_components(std::move(components)) {
+        size_t row_size = sizeof(Entity);
+        for (const ComponentId component : m_components) {
+            m_infos.push_back(get_component_info(component));
+            m_mask.set(component);
+            row_size += m_infos.back().size;
+        }
+
+        m_offsets.resize(m_components.size());
+
+        // as many rows as fit once every column is aligned; a chunk holds at least one, however large
+        for (m_capacity = static_cast<uint32_t>(std::max<size_t>(CHUNK_SIZE / row_size, 1));; m_capacity--) {
+            size_t offset = sizeof(Entity) * m_capacity;
+            for (size_t i = 0; i < m_infos.size(); i++) {
+                offset       = (offset + m_infos[i].alignment - 1) / m_infos[i].alignment * m_infos[i].alignment;
+                m_offsets[i] = offset;
+                offset      += m_infos[i].size * m_capacity;
+            }
+
+            m_chunk_size = offset;
+            if (m_chunk_size <= CHUNK_SIZE || m_capacity == 1)
+                break;
+        }
+    }
+
+    Archetype::~Archetype() {
+        for (uint32_t row = 0; row < m_count; row++) {
+            for (uint32_t column = 0; column < m_infos.size(); column++) {
+                m_infos[column].destroy(get(column, row));
+            }
+        }
+    }
+
+    uint32_t Archetype::push(Entity entity) {
+        if (m_count == m_chunks.size() * m_capacity)
+            m_chunks.push_back(allocate_component_storage(m_chunk_size));
+
+        get_entities(m_count / m_capacity)[m_count % m_capacity] = entity;
+        return m_count++;
+    }
+
+    Entity Archetype::remove(uint32_t row) {
+        for (uint32_t column = 0; column < m_infos.size(); column++) {
+            m_infos[column].destroy(get(column, row));
+        }
+        return fill_hole(row);
+    }
+
+    Entity Archetype::move_row(uint32_t row, Archetype &to, uint32_t to_row) {
+        for (uint32_t column = 0; column < m_infos.size(); column++) {
+            void *value = get(column, row);
+            if (const int32_t target = to.find_column(m_components[column]); target >= 0)
+                m_infos[column].move_construct(to.get(static_cast<uint32_t>(target), to_row), value);
+            m_infos[column].destroy(value);
+        }
+        return fill_hole(row);
+    }
+
+    int32_t Archetype::find_column(ComponentId component) const noexcept {
+        const auto it = std::ranges::lower_bound(m_components, component);
+        return it != m_components.end() && *it == component ? static_cast<int32_t>(it - m_components.begin()) : -1;
+    }
+
+    Entity Archetype::fill_hole(uint32_t row) {
+        const uint32_t last  = --m_count;
+        Entity         moved = NO_ENTITY;
+
+        if (row != last) {
+            for (uint32_t column = 0; column < m_infos.size(); column++) {
+                m_infos[column].move_construct(get(column, row), get(column, last));
+                m_infos[column].destroy(get(column, last));
+            }
+
+            moved                                            = get_entities(last / m_capacity)[last % m_capacity];
+            get_entities(row / m_capacity)[row % m_capacity] = moved;
+        }
+
+        // keep one spare chunk so an entity moving back and forth doesn't allocate every time
+        if (m_chunks.size() > get_chunk_count() + 1)
+            m_chunks.pop_back();
+
+        return moved;
+    }
+
+} // namespace kat
@@ -0,0 +1,80 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "component.hpp"
+
+namespace kat {
+
+    // Storage for all entities with exactly one set of components. Rows live in fixed size chunks, each holding the
+    // entities of its rows followed by one contiguous array per component, so iterating a component touches only its
+    // own memory. Rows stay dense: removing one moves the last row into the hole.
+    class Archetype {
+      public:
+        static constexpr size_t CHUNK_SIZE = 16 * 1024;
+
+        // `components` sorted and without duplicates
+        explicit Archetype(std::vector<ComponentId> components);
+
+        ~Archetype();
+
+        Archetype(const Archetype &)            = delete;
+        Archetype &operator=(const Archetype &) = delete;
+
+        // Appends a row for `entity` and returns it. Its components are left unconstructed for the caller.
+        uint32_t push(Entity entity);
+
+        // Destroys the row's components and fills the hole, returns the entity that moved into `row` or NO_ENTITY.
+        Entity remove(uint32_t row);
+
+        // Like remove(), but moves the components `to` also has into its `to_row` instead of destroying them.
+        Entity move_row(uint32_t row, Archetype &to, uint32_t to_row);
+
+        // -1 when the archetype doesn't have the component
+        [[nodiscard]] int32_t find_column(ComponentId component) const noexcept;
+
+        [[nodiscard]] void *get(uint32_t column, uint32_t row) const noexcept {
+            return get_column(row / m_capacity, column) + static_cast<size_t>(row % m_capacity) * m_infos[column].size;
+        }
+
+        [[nodiscard]] std::byte *get_column(uint32_t chunk, uint32_t column) const noexcept {
+            return m_chunks[chunk].get() + m_offsets[column];
+        }
+
+        [[nodiscard]] Entity *get_entities(uint32_t chunk) const noexcept {
+            return reinterpret_cast<Entity *>(m_chunks[chunk].get());
+        }
+
+        // chunks holding at least one row
+        [[nodiscard]] uint32_t get_chunk_count() const noexcept { return (m_count + m_capacity - 1) / m_capacity; }
+
+        [[nodiscard]] uint32_t get_row_count(uint32_t chunk) const noexcept {
+            return std::min(m_count - chunk * m_capacity, m_capacity);
+        }
+
+        [[nodiscard]] const ComponentMask &get_mask() const noexcept { return m_mask; }
+
+        [[nodiscard]] const std::vector<ComponentId> &get_components() const noexcept { return m_components; }
+
+        [[nodiscard]] uint32_t get_count() const noexcept { return m_count; }
+
+        // rows per chunk
+        [[nodiscard]] uint32_t get_capacity() const noexcept { return m_capacity; }
+
+      private:
+        // moves the last row into `row`
+        Entity fill_hole(uint32_t row);
+
+        std::vector<ComponentId>   m_components;
+        std::vector<ComponentInfo> m_infos;
+        std::vector<size_t>        m_offsets; // of each column within a chunk, the entities come first
+        ComponentMask              m_mask;
+
+        uint32_t                      m_capacity   = 0;
+        size_t                        m_chunk_size = 0;
+        uint32_t                      m_count      = 0;
+        std::vector<ComponentStorage> m_chunks;
+    };
+
+} // namespace kat
@@ -0,0 +1,70 @@
+#include "command_buffer.hpp"
+
+#include <algorithm>
+
+#include "world.hpp"
+
+namespace kat {
+
+    CommandBuffer::CommandBuffer(World &world) : m_world(&world) {}
+
+    CommandBuffer::~CommandBuffer() { clear(); }
+
+    Entity CommandBuffer::create_entity() { return m_world->reserve(); }
+
+    void CommandBuffer::destroy_entity(Entity entity) {
+        std::lock_guard lock(m_mutex);
+        m_commands.push_back({ Command::Kind::Destroy, entity });
+    }
+
+    void CommandBuffer::flush() {
+        std::lock_guard lock(m_mutex);
+
+        m_world->flush_reservations();
+        for (const Command &command : m_commands) {
+            if (!m_world->is_alive(command.entity))
+                continue;
+
+            switch (command.kind) {
+            case Command::Kind::Destroy:
+                m_world->destroy_entity(command.entity);
+                break;
+            case Command::Kind::Add:
+                m_world->add_component(command.entity, command.component, command.value);
+                break;
+            case Command::Kind::Remove:
+                m_world->remove_component(command.entity, command.component);
+                break;
+            }
+        }
+
+        clear();
+    }
+
+    void *CommandBuffer::allocate(size_t size, size_t alignment) {
+        size_t offset = (m_used + alignment - 1) / alignment * alignment;
+        if (m_blocks.empty() || offset + size > m_blocks.back().size) {
+            const size_t block_size = std::max(size, BLOCK_SIZE);
+            m_blocks.push_back({ allocate_component_storage(block_size), block_size });
+            offset = 0;
+        }
+
+        m_used = offset + size;
+        return m_blocks.back().data.get() + offset;
+    }
+
+    void CommandBuffer::clear() {
+        // added values were moved into the world, but moved from objects still need destroying
+        for (const Command &command : m_commands) {
+            if (command.destroy)
+                command.destroy(command.value);
+        }
+        m_commands.clear();
+
+        // keep the first block for the next frame unless it was an oversized one
+        if (!m_blocks.empty())
+            m_blocks.erase(m_blocks.begin() + (m_blocks[0].size == BLOCK_SIZE ? 1 : 0), m_blocks.end());
+        m_used = 0;
+    }
+
+} // namespace kat
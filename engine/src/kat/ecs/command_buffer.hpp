@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "component.hpp"
+
+namespace kat {
+
+    class World;
+
+    // Structural changes recorded while systems iterate and applied later by flush(), in recording order. Commands
+    // for entities that died in the meantime are dropped. Recording is thread safe, so the body of a parallel query
+    // can record too.
+    class CommandBuffer {
+      public:
+        explicit CommandBuffer(World &world);
+
+        ~CommandBuffer();
+
+        CommandBuffer(const CommandBuffer &)            = delete;
+        CommandBuffer &operator=(const CommandBuffer &) = delete;
+
+        // The entity can be used in further commands right away, it is alive once flushed.
+        Entity create_entity();
+
+        void destroy_entity(Entity entity);
+
+        // replaces the value if the entity already has the component
+        template <typename T>
+        void add(Entity entity, T &&value) {
+            using C = std::remove_cvref_t<T>;
+
+            std::lock_guard lock(m_mutex);
+            void           *storage = allocate(sizeof(C), alignof(C));
+            new (storage) C(std::forward<T>(value));
+            m_commands.push_back({ Command::Kind::Add, entity, component_id<C>(), storage,
+                                   [](void *v) { static_cast<C *>(v)->~C(); } });
+        }
+
+        template <typename T>
+        void remove(Entity entity) {
+            std::lock_guard lock(m_mutex);
+            m_commands.push_back({ Command::Kind::Remove, entity, component_id<T>() });
+        }
+
+        void flush();
+
+        [[nodiscard]] bool empty() const noexcept { return m_commands.empty(); }
+
+      private:
+        struct Command {
+            enum class Kind : uint8_t { Destroy, Add, Remove };
+
+            Kind        kind;
+            Entity      entity;
+            ComponentId component = 0;
+            void       *value     = nullptr;
+            void        (*destroy)(void *) = nullptr;
+        };
+
+        struct Block {
+            ComponentStorage data;
+            size_t           size;
+        };
+
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+        // values never move once recorded, the buffer grows by whole blocks
+        void *allocate(size_t size, size_t alignment);
+
+        // destroys the recorded values, keeps one block for the next frame
+        void clear();
+
+        World               *m_world;
+        std::mutex           m_mutex;
+        std::vector<Command> m_commands;
+        std::vector<Block>   m_blocks;
+        size_t               m_used = 0; // of the last block
+    };
+
+} // namespace kat
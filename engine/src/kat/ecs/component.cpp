@@ -0,0 +1,42 @@
+#include "component.hpp"
+
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+
+namespace kat {
+    namespace {
+        struct Registry {
+            std::mutex                mutex;
+            std::deque<ComponentInfo> infos;
+        };
+
+        Registry &registry() {
+            static Registry registry;
+            return registry;
+        }
+    } // namespace
+
+    ComponentId register_component(const ComponentInfo &info) {
+        Registry        &r = registry();
+        std::lock_guard lock(r.mutex);
+
+        if (r.infos.size() == MAX_COMPONENTS)
+            throw std::runtime_error("Too many component types");
+
+        r.infos.push_back(info);
+        return static_cast<ComponentId>(r.infos.size() - 1);
+    }
+
+    ComponentInfo get_component_info(ComponentId id) {
+        Registry        &r = registry();
+        std::lock_guard lock(r.mutex);
+        return r.infos.at(id);
+    }
+
+    ComponentStorage allocate_component_storage(size_t size) {
+        return ComponentStorage(
+            static_cast<std::byte *>(::operator new(size, std::align_val_t{ MAX_COMPONENT_ALIGNMENT })));
+    }
+
+} // namespace kat
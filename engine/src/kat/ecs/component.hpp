@@ -0,0 +1,101 @@
+#pragma once
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+namespace kat {
+
+    // An index into the world's entity table plus the generation of that index, so handles to destroyed entities
+    // never match whatever reuses their index.
+    struct Entity {
+        uint32_t index      = std::numeric_limits<uint32_t>::max();
+        uint32_t generation = 0;
+
+        friend bool operator==(const Entity &lhs, const Entity &rhs) = default;
+    };
+
+    constexpr Entity NO_ENTITY = {};
+
+    using ComponentId = uint32_t;
+
+    constexpr size_t MAX_COMPONENTS          = 256;
+    constexpr size_t MAX_COMPONENT_ALIGNMENT = 64;
+
+    using ComponentMask = std::bitset<MAX_COMPONENTS>;
+
+    // What storage needs to know about a component type to move and destroy values it can't name.
+    struct ComponentInfo {
+        size_t      size;
+        size_t      alignment;
+        void        (*move_construct)(void *destination, void *source); // source is left moved from, not destroyed
+        void        (*destroy)(void *value);
+        const char *name;
+    };
+
+    // Thread safe. Throws once MAX_COMPONENTS types are registered.
+    ComponentId register_component(const ComponentInfo &info);
+
+    [[nodiscard]] ComponentInfo get_component_info(ComponentId id);
+
+    template <typename T>
+    ComponentId component_id() {
+        using C = std::remove_cvref_t<T>;
+        static_assert(std::is_nothrow_move_constructible_v<C>, "Components move between chunks and must not throw");
+        static_assert(alignof(C) <= MAX_COMPONENT_ALIGNMENT);
+
+        // const Position and Position are the same component
+        if constexpr (!std::is_same_v<T, C>) {
+            return component_id<C>();
+        }
+        else {
+            static const ComponentId id = register_component({
+                .size           = sizeof(C),
+                .alignment      = alignof(C),
+                .move_construct = [](void *destination, void *source) {
+                    new (destination) C(std::move(*static_cast<C *>(source)));
+                },
+                .destroy = [](void *value) { static_cast<C *>(value)->~C(); },
+                .name    = typeid(C).name(),
+            });
+            return id;
+        }
+    }
+
+    // The components a system reads and writes; const types in `of` are read, everything else is written.
+    struct ComponentAccess {
+        ComponentMask reads;
+        ComponentMask writes;
+        bool          exclusive = false; // conflicts with every other system
+
+        template <typename... Ts>
+        static ComponentAccess of() {
+            ComponentAccess access;
+            ((std::is_const_v<std::remove_reference_t<Ts>> ? access.reads : access.writes).set(component_id<Ts>()),
+             ...);
+            return access;
+        }
+
+        [[nodiscard]] bool conflicts(const ComponentAccess &other) const noexcept {
+            return exclusive || other.exclusive || (writes & (other.reads | other.writes)).any() ||
+                   (other.writes & reads).any();
+        }
+    };
+
+    struct ComponentStorageDeleter {
+        void operator()(std::byte *data) const noexcept {
+            ::operator delete(data, std::align_val_t{ MAX_COMPONENT_ALIGNMENT });
+        }
+    };
+
+    // raw memory aligned for any component
+    using ComponentStorage = std::unique_ptr<std::byte[], ComponentStorageDeleter>;
+
+    [[nodiscard]] ComponentStorage allocate_component_storage(size_t size);
+
+} // namespace kat
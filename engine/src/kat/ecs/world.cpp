@@ -0,0 +1,258 @@
+#include "world.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace kat {
+
+    World::World(const std::shared_ptr<JobSystem> &job_system) : m_job_system(job_system) {
+        find_archetype({});
+    }
+
+    World::~World() = default;
+
+    std::shared_ptr<World> World::create(const std::shared_ptr<JobSystem> &job_system) {
+        return std::make_shared<World>(job_system);
+    }
+
+    Entity World::create_entity() {
+        begin_structural_change();
+
+        const Entity entity = reserve();
+        flush_reservations();
+        return entity;
+    }
+
+    void World::destroy_entity(Entity entity) {
+        begin_structural_change();
+
+        EntityRecord &record = get_record(entity);
+        if (const Entity moved = m_archetypes[record.archetype]->remove(record.row); moved != NO_ENTITY)
+            m_records[moved.index].row = record.row;
+
+        record.archetype = NO_ARCHETYPE;
+        record.generation++;
+        m_entity_count--;
+
+        m_free.push_back(entity.index);
+        m_free_cursor = static_cast<int64_t>(m_free.size());
+    }
+
+    bool World::is_alive(Entity entity) const noexcept {
+        return entity.index < m_records.size() && m_records[entity.index].generation == entity.generation &&
+               m_records[entity.index].archetype != NO_ARCHETYPE;
+    }
+
+    void World::add_system(std::string name, const ComponentAccess &access, std::function<void(SystemContext &)> fn) {
+        m_systems.push_back(std::make_unique<System>(std::move(name), access, std::move(fn), *this));
+        m_stages_dirty = true;
+    }
+
+    void World::update(float dt) {
+        if (m_stages_dirty)
+            build_stages();
+
+        m_running = true;
+        try {
+            for (const std::vector<System *> &stage : m_stages) {
+                const auto run = [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; i++) {
+                        SystemContext context = { *this, stage[i]->commands, dt };
+                        stage[i]->fn(context);
+                    }
+                };
+
+                if (m_job_system)
+                    m_job_system->parallel_for(stage.size(), 1, run);
+                else
+                    run(0, stage.size());
+            }
+        }
+        catch (...) {
+            m_running = false;
+            throw;
+        }
+        m_running = false;
+
+        for (const std::unique_ptr<System> &system : m_systems) {
+            system->commands.flush();
+        }
+    }
+
+    Entity World::reserve() {
+        // free indices first, then new ones past the end of the records
+        const int64_t cursor = m_free_cursor.fetch_sub(1, std::memory_order_relaxed);
+        if (cursor > 0) {
+            const uint32_t index = m_free[static_cast<size_t>(cursor - 1)];
+            return { index, m_records[index].generation };
+        }
+        return { static_cast<uint32_t>(m_records.size() - cursor), 0 };
+    }
+
+    void World::flush_reservations() {
+        const int64_t cursor = m_free_cursor.load(std::memory_order_relaxed);
+        if (cursor == static_cast<int64_t>(m_free.size()))
+            return;
+
+        const size_t kept      = static_cast<size_t>(std::max<int64_t>(cursor, 0));
+        const size_t first_new = m_records.size();
+        m_records.resize(m_records.size() + static_cast<size_t>(std::max<int64_t>(-cursor, 0)));
+
+        // reserved entities start out without components
+        const auto place = [&](uint32_t index) {
+            m_records[index].archetype = 0;
+            m_records[index].row       = m_archetypes[0]->push({ index, m_records[index].generation });
+            m_entity_count++;
+        };
+
+        for (size_t i = kept; i < m_free.size(); i++) {
+            place(m_free[i]);
+        }
+        for (size_t index = first_new; index < m_records.size(); index++) {
+            place(static_cast<uint32_t>(index));
+        }
+
+        m_free.resize(kept);
+        m_free_cursor = static_cast<int64_t>(kept);
+    }
+
+    Entity World::create_with(std::span<const ComponentId> components, std::span<void *const> values) {
+        ComponentMask mask;
+        for (const ComponentId component : components) {
+            if (mask.test(component))
+                throw std::runtime_error("Entity created with the same component twice");
+            mask.set(component);
+        }
+
+        const Entity     entity    = create_entity();
+        const uint32_t   archetype = find_archetype(mask);
+        const uint32_t   row       = move_entity(entity, archetype);
+        const Archetype &storage   = *m_archetypes[archetype];
+
+        for (size_t i = 0; i < components.size(); i++) {
+            const uint32_t column = static_cast<uint32_t>(storage.find_column(components[i]));
+            get_component_info(components[i]).move_construct(storage.get(column, row), values[i]);
+        }
+        return entity;
+    }
+
+    void World::add_component(Entity entity, ComponentId component, void *value) {
+        begin_structural_change();
+
+        const EntityRecord &record = get_record(entity);
+        const ComponentInfo info   = get_component_info(component);
+
+        if (const int32_t column = m_archetypes[record.archetype]->find_column(component); column >= 0) {
+            void *existing = m_archetypes[record.archetype]->get(static_cast<uint32_t>(column), record.row);
+            info.destroy(existing);
+            info.move_construct(existing, value);
+            return;
+        }
+
+        const uint32_t   archetype = find_edge(record.archetype, component, true);
+        const uint32_t   row       = move_entity(entity, archetype);
+        const Archetype &storage   = *m_archetypes[archetype];
+        info.move_construct(storage.get(static_cast<uint32_t>(storage.find_column(component)), row), value);
+    }
+
+    void World::remove_component(Entity entity, ComponentId component) {
+        begin_structural_change();
+
+        const EntityRecord &record = get_record(entity);
+        if (m_archetypes[record.archetype]->find_column(component) < 0)
+            return;
+
+        move_entity(entity, find_edge(record.archetype, component, false));
+    }
+
+    void *World::get_component(Entity entity, ComponentId component) const {
+        if (!is_alive(entity))
+            throw std::runtime_error("Entity is not alive");
+
+        const EntityRecord &record  = m_records[entity.index];
+        const Archetype    &storage = *m_archetypes[record.archetype];
+        const int32_t       column  = storage.find_column(component);
+        return column < 0 ? nullptr : storage.get(static_cast<uint32_t>(column), record.row);
+    }
+
+    World::EntityRecord &World::get_record(Entity entity) {
+        if (!is_alive(entity))
+            throw std::runtime_error("Entity is not alive");
+        return m_records[entity.index];
+    }
+
+    void World::begin_structural_change() {
+        if (m_running)
+            throw std::runtime_error("Structural changes while systems run must go through their CommandBuffer");
+
+        // rows may move from here on, reserved entities need theirs first
+        flush_reservations();
+    }
+
+    uint32_t World::find_archetype(const ComponentMask &mask) {
+        if (const auto it = m_archetype_lookup.find(mask); it != m_archetype_lookup.end())
+            return it->second;
+
+        std::vector<ComponentId> components;
+        for (size_t component = 0; component < MAX_COMPONENTS; component++) {
+            if (mask.test(component))
+                components.push_back(static_cast<ComponentId>(component));
+        }
+
+        const uint32_t index = static_cast<uint32_t>(m_archetypes.size());
+        m_archetypes.push_back(std::make_unique<Archetype>(std::move(components)));
+        m_archetype_lookup.emplace(mask, index);
+        return index;
+    }
+
+    uint32_t World::find_edge(uint32_t archetype, ComponentId component, bool add) {
+        auto          &edges = add ? m_add_edges : m_remove_edges;
+        const uint64_t key   = static_cast<uint64_t>(archetype) << 32 | component;
+
+        if (const auto it = edges.find(key); it != edges.end())
+            return it->second;
+
+        ComponentMask mask = m_archetypes[archetype]->get_mask();
+        mask.set(component, add);
+
+        const uint32_t target = find_archetype(mask);
+        edges.emplace(key, target);
+        return target;
+    }
+
+    uint32_t World::move_entity(Entity entity, uint32_t archetype) {
+        EntityRecord &record = m_records[entity.index];
+        Archetype    &from   = *m_archetypes[record.archetype];
+        Archetype    &to     = *m_archetypes[archetype];
+
+        const uint32_t row = to.push(entity);
+        if (const Entity moved = from.move_row(record.row, to, row); moved != NO_ENTITY)
+            m_records[moved.index].row = record.row;
+
+        record.archetype = archetype;
+        record.row       = row;
+        return row;
+    }
+
+    void World::build_stages() {
+        // a system goes into the first stage after every earlier system it conflicts with
+        std::vector<size_t> stage_of(m_systems.size());
+        m_stages.clear();
+
+        for (size_t i = 0; i < m_systems.size(); i++) {
+            size_t stage = 0;
+            for (size_t j = 0; j < i; j++) {
+                if (m_systems[i]->access.conflicts(m_systems[j]->access))
+                    stage = std::max(stage, stage_of[j] + 1);
+            }
+
+            stage_of[i] = stage;
+            if (stage == m_stages.size())
+                m_stages.emplace_back();
+            m_stages[stage].push_back(m_systems[i].get());
+        }
+
+        m_stages_dirty = false;
+    }
+
+} // namespace kat
@@ -0,0 +1,340 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "archetype.hpp"
+#include "command_buffer.hpp"
+#include "component.hpp"
+#include "kat/utils/job_system.hpp"
+
+namespace kat {
+
+    class World;
+
+    struct SystemContext {
+        World         &world;
+        CommandBuffer &commands; // the system's own, flushed after every system ran
+        float          dt;
+    };
+
+    // Every entity that has all of `Ts`. The matching archetypes and their column indices are cached and only new
+    // archetypes are checked again, so a query kept across frames costs nothing to look up. const types are only
+    // read, which lets systems that merely read the same component run in parallel.
+    template <typename... Ts>
+    class Query {
+      public:
+        explicit Query(World &world);
+
+        // fn(Ts &...) or fn(Entity, Ts &...) for every entity
+        template <typename F>
+        void each(F &&fn);
+
+        // like each(), with the chunks split across the world's job system
+        template <typename F>
+        void par_each(F &&fn);
+
+        // fn(std::span<const Entity>, std::span<Ts>...) once per chunk, for loops over whole arrays
+        template <typename F>
+        void each_chunk(F &&fn);
+
+        [[nodiscard]] size_t count();
+
+      private:
+        struct Match {
+            uint32_t                            archetype;
+            std::array<uint32_t, sizeof...(Ts)> columns;
+        };
+
+        void refresh();
+
+        template <typename F, size_t... I>
+        void run_chunk(F &fn, const Match &match, uint32_t chunk, std::index_sequence<I...>);
+
+        template <typename F>
+        void run_rows(F &fn, const Match &match, uint32_t chunk);
+
+        World                                  *m_world;
+        std::array<ComponentId, sizeof...(Ts)> m_components;
+        ComponentMask                          m_mask;
+        std::vector<Match>                     m_matches;
+        size_t                                 m_checked = 0; // archetypes already matched
+    };
+
+    // Entities and their components, stored by archetype, plus the systems that run on them every update().
+    //
+    // Structural changes (creating and destroying entities, adding and removing components) move rows between
+    // archetypes, so they are not allowed while systems run; systems record them in their CommandBuffer instead.
+    // Systems declare which components they read and write, and update() runs those that don't conflict in parallel.
+    class World {
+      public:
+        explicit World(const std::shared_ptr<JobSystem> &job_system = nullptr);
+
+        ~World();
+
+        World(const World &)            = delete;
+        World &operator=(const World &) = delete;
+
+        static std::shared_ptr<World> create(const std::shared_ptr<JobSystem> &job_system = nullptr);
+
+        Entity create_entity();
+
+        template <typename... Ts>
+        Entity create_entity(Ts &&...components) {
+            std::tuple<std::remove_cvref_t<Ts>...> values(std::forward<Ts>(components)...);
+
+            const std::array<ComponentId, sizeof...(Ts)> ids = { component_id<Ts>()... };
+            const std::array<void *, sizeof...(Ts)>       pointers =
+                std::apply([](auto &...v) { return std::array<void *, sizeof...(Ts)>{ &v... }; }, values);
+            return create_with(ids, pointers);
+        }
+
+        void destroy_entity(Entity entity);
+
+        [[nodiscard]] bool is_alive(Entity entity) const noexcept;
+
+        // replaces the value if the entity already has the component
+        template <typename T>
+        void add(Entity entity, T &&value) {
+            std::remove_cvref_t<T> component(std::forward<T>(value));
+            add_component(entity, component_id<T>(), &component);
+        }
+
+        template <typename T>
+        void remove(Entity entity) {
+            remove_component(entity, component_id<T>());
+        }
+
+        // nullptr when the entity doesn't have the component
+        template <typename T>
+        [[nodiscard]] T *get(Entity entity) const {
+            return static_cast<T *>(get_component(entity, component_id<T>()));
+        }
+
+        template <typename T>
+        [[nodiscard]] bool has(Entity entity) const {
+            return get<T>(entity) != nullptr;
+        }
+
+        template <typename... Ts>
+        [[nodiscard]] Query<Ts...> query() {
+            return Query<Ts...>(*this);
+        }
+
+        // Systems run in update() in the order they were added, except that systems without conflicting access may
+        // run at the same time.
+        void add_system(std::string name, const ComponentAccess &access, std::function<void(SystemContext &)> fn);
+
+        // fn(SystemContext &, Query<Ts...> &), the access is derived from `Ts`
+        template <typename... Ts, typename F>
+        void add_system(std::string name, F &&fn) {
+            add_system(std::move(name), ComponentAccess::of<Ts...>(),
+                       [query = Query<Ts...>(*this), fn = std::forward<F>(fn)](SystemContext &context) mutable {
+                           fn(context, query);
+                       });
+        }
+
+        // Runs every system, then applies their commands in the order the systems were added.
+        void update(float dt);
+
+        // Thread safe. The entity is alive after the next flush_reservations(), which every structural change does.
+        Entity reserve();
+
+        void flush_reservations();
+
+        [[nodiscard]] size_t get_entity_count() const noexcept { return m_entity_count; }
+
+        [[nodiscard]] size_t get_archetype_count() const noexcept { return m_archetypes.size(); }
+
+        [[nodiscard]] const Archetype &get_archetype(uint32_t index) const { return *m_archetypes.at(index); }
+
+        [[nodiscard]] const std::shared_ptr<JobSystem> &get_job_system() const noexcept { return m_job_system; }
+
+      private:
+        template <typename...>
+        friend class Query;
+
+        friend class CommandBuffer;
+
+        static constexpr uint32_t NO_ARCHETYPE = std::numeric_limits<uint32_t>::max();
+
+        struct EntityRecord {
+            uint32_t generation = 0;
+            uint32_t archetype  = NO_ARCHETYPE; // dead or only reserved
+            uint32_t row        = 0;
+        };
+
+        struct System {
+            System(std::string name, const ComponentAccess &access, std::function<void(SystemContext &)> fn,
+                   World &world) :
+                name(std::move(name)), access(access), fn(std::move(fn)), commands(world) {}
+
+            std::string                          name;
+            ComponentAccess                      access;
+            std::function<void(SystemContext &)> fn;
+            CommandBuffer                        commands;
+        };
+
+        Entity create_with(std::span<const ComponentId> components, std::span<void *const> values);
+
+        // moves `value` into the entity's component
+        void add_component(Entity entity, ComponentId component, void *value);
+
+        void remove_component(Entity entity, ComponentId component);
+
+        [[nodiscard]] void *get_component(Entity entity, ComponentId component) const;
+
+        // throws for dead entities
+        EntityRecord &get_record(Entity entity);
+
+        // throws while systems run
+        void begin_structural_change();
+
+        uint32_t find_archetype(const ComponentMask &mask);
+
+        uint32_t find_edge(uint32_t archetype, ComponentId component, bool add);
+
+        // Moves the entity's row, keeping the components both archetypes have. Returns the new row, whose other
+        // components still need constructing.
+        uint32_t move_entity(Entity entity, uint32_t archetype);
+
+        // groups of systems without conflicts, in order
+        void build_stages();
+
+        std::shared_ptr<JobSystem> m_job_system;
+
+        std::vector<std::unique_ptr<Archetype>>     m_archetypes; // the first one has no components
+        std::unordered_map<ComponentMask, uint32_t> m_archetype_lookup;
+        std::unordered_map<uint64_t, uint32_t>      m_add_edges; // archetype << 32 | component -> archetype
+        std::unordered_map<uint64_t, uint32_t>      m_remove_edges;
+
+        std::vector<EntityRecord> m_records;
+        std::vector<uint32_t>     m_free;
+        std::atomic<int64_t>      m_free_cursor  = 0; // m_free entries not reserved yet, negative past the end
+        size_t                    m_entity_count = 0;
+
+        std::vector<std::unique_ptr<System>> m_systems;
+        std::vector<std::vector<System *>>   m_stages;
+        bool                                 m_stages_dirty = false;
+        bool                                 m_running      = false;
+    };
+
+    template <typename... Ts>
+    Query<Ts...>::Query(World &world) : m_world(&world), m_components{ component_id<Ts>()... } {
+        for (const ComponentId component : m_components) {
+            m_mask.set(component);
+        }
+    }
+
+    template <typename... Ts>
+    template <typename F>
+    void Query<Ts...>::each(F &&fn) {
+        refresh();
+        for (const Match &match : m_matches) {
+            const uint32_t chunks = m_world->m_archetypes[match.archetype]->get_chunk_count();
+            for (uint32_t chunk = 0; chunk < chunks; chunk++) {
+                run_rows(fn, match, chunk);
+            }
+        }
+    }
+
+    template <typename... Ts>
+    template <typename F>
+    void Query<Ts...>::par_each(F &&fn) {
+        refresh();
+
+        std::vector<std::pair<const Match *, uint32_t>> chunks;
+        for (const Match &match : m_matches) {
+            const uint32_t count = m_world->m_archetypes[match.archetype]->get_chunk_count();
+            for (uint32_t chunk = 0; chunk < count; chunk++) {
+                chunks.emplace_back(&match, chunk);
+            }
+        }
+
+        const auto run = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                run_rows(fn, *chunks[i].first, chunks[i].second);
+            }
+        };
+
+        if (m_world->m_job_system)
+            m_world->m_job_system->parallel_for(chunks.size(), 1, run);
+        else
+            run(0, chunks.size());
+    }
+
+    template <typename... Ts>
+    template <typename F>
+    void Query<Ts...>::each_chunk(F &&fn) {
+        refresh();
+        for (const Match &match : m_matches) {
+            const uint32_t chunks = m_world->m_archetypes[match.archetype]->get_chunk_count();
+            for (uint32_t chunk = 0; chunk < chunks; chunk++) {
+                run_chunk(fn, match, chunk, std::index_sequence_for<Ts...>{});
+            }
+        }
+    }
+
+    template <typename... Ts>
+    size_t Query<Ts...>::count() {
+        refresh();
+
+        size_t count = 0;
+        for (const Match &match : m_matches) {
+            count += m_world->m_archetypes[match.archetype]->get_count();
+        }
+        return count;
+    }
+
+    template <typename... Ts>
+    void Query<Ts...>::refresh() {
+        // archetypes are never removed, only the ones added since the last look need matching
+        const auto &archetypes = m_world->m_archetypes;
+        for (; m_checked < archetypes.size(); m_checked++) {
+            const Archetype &archetype = *archetypes[m_checked];
+            if ((archetype.get_mask() & m_mask) != m_mask)
+                continue;
+
+            Match match = { static_cast<uint32_t>(m_checked) };
+            for (size_t i = 0; i < m_components.size(); i++) {
+                match.columns[i] = static_cast<uint32_t>(archetype.find_column(m_components[i]));
+            }
+            m_matches.push_back(match);
+        }
+    }
+
+    template <typename... Ts>
+    template <typename F, size_t... I>
+    void Query<Ts...>::run_chunk(F &fn, const Match &match, uint32_t chunk, std::index_sequence<I...>) {
+        const Archetype &archetype = *m_world->m_archetypes[match.archetype];
+        const uint32_t   rows      = archetype.get_row_count(chunk);
+
+        fn(std::span<const Entity>(archetype.get_entities(chunk), rows),
+           std::span<Ts>(reinterpret_cast<Ts *>(archetype.get_column(chunk, match.columns[I])), rows)...);
+    }
+
+    template <typename... Ts>
+    template <typename F>
+    void Query<Ts...>::run_rows(F &fn, const Match &match, uint32_t chunk) {
+        auto rows = [&](std::span<const Entity> entities, std::span<Ts>... columns) {
+            for (size_t i = 0; i < entities.size(); i++) {
+                if constexpr (std::is_invocable_v<F &, Entity, Ts &...>)
+                    fn(entities[i], columns[i]...);
+                else
+                    fn(columns[i]...);
+            }
+        };
+        run_chunk(rows, match, chunk, std::index_sequence_for<Ts...>{});
+    }
+
+} // namespace kat
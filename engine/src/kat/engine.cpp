@@ -7,6 +7,10 @@
 
 
 #include "input_manager.hpp"
+#include "ecs/world.hpp"
+#include "renderer/destruction_queue.hpp"
+#include "renderer/gpu_resources.hpp"
+#include "utils/job_system.hpp"
 #include "window.hpp"
 
 namespace kat {
@@ -88,6 +92,10 @@ namespace kat {
         DestroyWindow(dummy);
 
         m_input_manager = std::make_shared<kat::InputManager>(nullptr);
+        m_job_system    = JobSystem::create();
+        m_world         = World::create(m_job_system);
+        m_gpu_resources = GpuResources::create();
+        m_last_update   = std::chrono::steady_clock::now();
     }
 
     std::string read_file(const std::string &path) {
@@ -118,7 +126,15 @@ namespace kat {
             DispatchMessage(&msg);
         }
 
+        const auto now = std::chrono::steady_clock::now();
+        m_world->update(std::chrono::duration<float>(now - m_last_update).count());
+        m_last_update = now;
+
         m_window_update_signal.emit();
+
+        // windows painted during the message loop above, that frame is submitted now
+        m_gpu_resources->end_frame();
+        DestructionQueue::get().end_frame();
     }
 
     void Engine::set_vsync(bool vsync) {
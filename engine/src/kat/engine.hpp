@@ -12,12 +12,18 @@
 
 #include <glm/glm.hpp>
 
+#include <chrono>
 #include <exception>
 #include <stdexcept>
 
 namespace kat {
     class InputManager;
 
+    class JobSystem;
+
+    class World;
+
+    class GpuResources;
 
     constexpr wchar_t WINDOW_CLASS_NAME[] = L"KATWINDOWCLASS";
 
@@ -92,6 +98,14 @@ namespace kat {
 
         [[nodiscard]] std::shared_ptr<InputManager> get_input_manager() const;
 
+        [[nodiscard]] const std::shared_ptr<JobSystem> &get_job_system() const { return m_job_system; }
+
+        // entities and systems, the systems run once per update() on the job system
+        [[nodiscard]] const std::shared_ptr<World> &get_world() const { return m_world; }
+
+        // handle based buffers and shaders, advanced a frame at the end of every update()
+        [[nodiscard]] const std::shared_ptr<GpuResources> &get_gpu_resources() const { return m_gpu_resources; }
+
       private:
         Engine();
 
@@ -101,6 +115,11 @@ namespace kat {
         std::shared_ptr<Window>       m_primary_window;
         std::shared_ptr<Renderer>     m_active_renderer;
         std::shared_ptr<InputManager> m_input_manager;
+        std::shared_ptr<JobSystem>    m_job_system;
+        std::shared_ptr<World>        m_world;
+        std::shared_ptr<GpuResources> m_gpu_resources;
+
+        std::chrono::steady_clock::time_point m_last_update;
 
         signal<void()>                 m_window_update_signal;
         signal<void()>                 m_window_redraw_request_signal;
@@ -0,0 +1,562 @@
+#include "animation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
+#include "kat/utils/simd.hpp"
+
+namespace kat {
+    namespace {
+        constexpr float SQRT_HALF = 0.70710678f;
+
+        size_t padded(uint32_t joints) { return (static_cast<size_t>(joints) + 7) & ~size_t{ 7 }; }
+
+        // Smallest three: the largest component is dropped and rebuilt from the unit length, which leaves the other
+        // three in [-1/sqrt(2), 1/sqrt(2)]. Its index goes into the spare top bits of the first two words.
+        std::array<uint16_t, 3> encode_rotation(const glm::vec4 &q) {
+            int largest = 0;
+            for (int i = 1; i < 4; i++) {
+                if (std::abs(q[i]) > std::abs(q[largest]))
+                    largest = i;
+            }
+
+            // q and -q are the same rotation, the dropped component is always positive
+            const float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+            std::array<uint16_t, 3> key{};
+            for (int i = 0, k = 0; i < 4; i++) {
+                if (i == largest)
+                    continue;
+
+                const float unorm = std::clamp(q[i] * sign * SQRT_HALF + 0.5f, 0.0f, 1.0f);
+                key[k++]          = static_cast<uint16_t>(std::lround(unorm * 32767.0f));
+            }
+            key[0] |= static_cast<uint16_t>((largest & 1) << 15);
+            key[1] |= static_cast<uint16_t>((largest >> 1) << 15);
+            return key;
+        }
+
+        void decode_rotation(const std::array<uint16_t, 3> &key, float out[4]) {
+            const int largest = key[0] >> 15 | (key[1] >> 15) << 1;
+
+            float sum = 0.0f;
+            for (int i = 0, k = 0; i < 4; i++) {
+                if (i == largest)
+                    continue;
+
+                const float v = (static_cast<float>(key[k++] & 0x7fff) * (1.0f / 32767.0f) - 0.5f) *
+                                std::numbers::sqrt2_v<float>;
+                out[i] = v;
+                sum += v * v;
+            }
+            out[largest] = std::sqrt(std::max(1.0f - sum, 0.0f));
+        }
+
+        // sampling interpolates rotations the same way, flipping the second key onto the first one's hemisphere
+        glm::vec4 nlerp(const glm::vec4 &a, const glm::vec4 &b, float t) {
+            const glm::vec4 r = a + ((glm::dot(a, b) < 0.0f ? -b : b) - a) * t;
+            return r / std::sqrt(glm::dot(r, r));
+        }
+
+        float rotation_error(const glm::vec4 &a, const glm::vec4 &b) {
+            return 2.0f * std::acos(std::min(std::abs(glm::dot(a, b)), 1.0f));
+        }
+
+        // Frames to keep: from each kept frame the next one is the furthest whose interpolation reproduces every
+        // frame in between within `tolerance`.
+        template <typename T, typename Lerp, typename Error>
+        std::vector<uint32_t> reduce_keys(const std::vector<T> &values, float tolerance, Lerp lerp, Error error) {
+            const auto count = static_cast<uint32_t>(values.size());
+
+            std::vector<uint32_t> kept = { 0 };
+            for (uint32_t from = 0; from + 1 < count;) {
+                uint32_t to = from + 1;
+                for (bool fits = true; fits && to + 1 < count;) {
+                    const uint32_t next = to + 1;
+                    for (uint32_t k = from + 1; k < next && fits; k++) {
+                        const float t = static_cast<float>(k - from) / static_cast<float>(next - from);
+                        fits          = error(lerp(values[from], values[next], t), values[k]) <= tolerance;
+                    }
+                    if (fits)
+                        to = next;
+                }
+                kept.push_back(to);
+                from = to;
+            }
+
+            // a track that doesn't move at all keeps a single key
+            if (kept.size() == 2 && error(values.front(), values.back()) <= tolerance)
+                kept.pop_back();
+            return kept;
+        }
+
+        uint16_t quantize(float v, float minimum, float extent) {
+            return extent > 0.0f
+                       ? static_cast<uint16_t>(std::lround(std::clamp((v - minimum) / extent, 0.0f, 1.0f) * 65535.0f))
+                       : 0;
+        }
+
+        float dequantize(uint16_t q, float minimum, float extent) {
+            return minimum + static_cast<float>(q) * (extent * (1.0f / 65535.0f));
+        }
+
+        // out = a + (b - a) * t, t per element or t[0] for all
+        template <bool PerElement>
+        void lerp_lanes(const float *a, const float *b, const float *t, float *out, size_t count) {
+            size_t i = 0;
+#ifdef KAT_SIMD_AVX2
+            for (; i + 8 <= count; i += 8) {
+                const __m256 w  = PerElement ? _mm256_loadu_ps(t + i) : _mm256_set1_ps(t[0]);
+                const __m256 va = _mm256_loadu_ps(a + i);
+                const __m256 vb = _mm256_loadu_ps(b + i);
+                _mm256_storeu_ps(out + i, _mm256_add_ps(va, _mm256_mul_ps(_mm256_sub_ps(vb, va), w)));
+            }
+#endif
+#ifdef KAT_SIMD_SSE2
+            for (; i + 4 <= count; i += 4) {
+                const __m128 w  = PerElement ? _mm_loadu_ps(t + i) : _mm_set1_ps(t[0]);
+                const __m128 va = _mm_loadu_ps(a + i);
+                const __m128 vb = _mm_loadu_ps(b + i);
+                _mm_storeu_ps(out + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), w)));
+            }
+#endif
+            for (; i < count; i++) {
+                out[i] = a[i] + (b[i] - a[i]) * (PerElement ? t[i] : t[0]);
+            }
+        }
+
+        // normalized lerp of the rotations along the shorter arc
+        template <bool PerElement>
+        void nlerp_lanes(const Pose &a, const Pose &b, const float *t, Pose &out) {
+            const float *ax = a.rotation[0].data(), *ay = a.rotation[1].data(), *az = a.rotation[2].data(),
+                        *aw = a.rotation[3].data();
+            const float *bx = b.rotation[0].data(), *by = b.rotation[1].data(), *bz = b.rotation[2].data(),
+                        *bw = b.rotation[3].data();
+            float *ox = out.rotation[0].data(), *oy = out.rotation[1].data(), *oz = out.rotation[2].data(),
+                  *ow = out.rotation[3].data();
+
+            const size_t count = a.get_padded_count();
+
+            size_t i = 0;
+#ifdef KAT_SIMD_AVX2
+            {
+                const __m256 sign = _mm256_set1_ps(-0.0f);
+                const __m256 one  = _mm256_set1_ps(1.0f);
+
+                for (; i + 8 <= count; i += 8) {
+                    const __m256 w  = PerElement ? _mm256_loadu_ps(t + i) : _mm256_set1_ps(t[0]);
+                    const __m256 x0 = _mm256_loadu_ps(ax + i), y0 = _mm256_loadu_ps(ay + i);
+                    const __m256 z0 = _mm256_loadu_ps(az + i), w0 = _mm256_loadu_ps(aw + i);
+                    __m256       x1 = _mm256_loadu_ps(bx + i), y1 = _mm256_loadu_ps(by + i);
+                    __m256       z1 = _mm256_loadu_ps(bz + i), w1 = _mm256_loadu_ps(bw + i);
+
+                    // moves the dot product's sign onto b, which flips b onto a's hemisphere
+                    const __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x0, x1), _mm256_mul_ps(y0, y1)),
+                                                   _mm256_add_ps(_mm256_mul_ps(z0, z1), _mm256_mul_ps(w0, w1)));
+                    const __m256 flip = _mm256_and_ps(d, sign);
+                    x1                = _mm256_xor_ps(x1, flip);
+                    y1                = _mm256_xor_ps(y1, flip);
+                    z1                = _mm256_xor_ps(z1, flip);
+                    w1                = _mm256_xor_ps(w1, flip);
+
+                    const __m256 x = _mm256_add_ps(x0, _mm256_mul_ps(_mm256_sub_ps(x1, x0), w));
+                    const __m256 y = _mm256_add_ps(y0, _mm256_mul_ps(_mm256_sub_ps(y1, y0), w));
+                    const __m256 z = _mm256_add_ps(z0, _mm256_mul_ps(_mm256_sub_ps(z1, z0), w));
+                    const __m256 r = _mm256_add_ps(w0, _mm256_mul_ps(_mm256_sub_ps(w1, w0), w));
+
+                    const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(
+                        _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)),
+                        _mm256_add_ps(_mm256_mul_ps(z, z), _mm256_mul_ps(r, r))));
+                    const __m256 inverse = _mm256_div_ps(one, length);
+                    _mm256_storeu_ps(ox + i, _mm256_mul_ps(x, inverse));
+                    _mm256_storeu_ps(oy + i, _mm256_mul_ps(y, inverse));
+                    _mm256_storeu_ps(oz + i, _mm256_mul_ps(z, inverse));
+                    _mm256_storeu_ps(ow + i, _mm256_mul_ps(r, inverse));
+                }
+            }
+#endif
+#ifdef KAT_SIMD_SSE2
+            {
+                const __m128 sign = _mm_set1_ps(-0.0f);
+                const __m128 one  = _mm_set1_ps(1.0f);
+
+                for (; i + 4 <= count; i += 4) {
+                    const __m128 w  = PerElement ? _mm_loadu_ps(t + i) : _mm_set1_ps(t[0]);
+                    const __m128 x0 = _mm_loadu_ps(ax + i), y0 = _mm_loadu_ps(ay + i);
+                    const __m128 z0 = _mm_loadu_ps(az + i), w0 = _mm_loadu_ps(aw + i);
+                    __m128       x1 = _mm_loadu_ps(bx + i), y1 = _mm_loadu_ps(by + i);
+                    __m128       z1 = _mm_loadu_ps(bz + i), w1 = _mm_loadu_ps(bw + i);
+
+                    const __m128 d    = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x0, x1), _mm_mul_ps(y0, y1)),
+                                                   _mm_add_ps(_mm_mul_ps(z0, z1), _mm_mul_ps(w0, w1)));
+                    const __m128 flip = _mm_and_ps(d, sign);
+                    x1                = _mm_xor_ps(x1, flip);
+                    y1                = _mm_xor_ps(y1, flip);
+                    z1                = _mm_xor_ps(z1, flip);
+                    w1                = _mm_xor_ps(w1, flip);
+
+                    const __m128 x = _mm_add_ps(x0, _mm_mul_ps(_mm_sub_ps(x1, x0), w));
+                    const __m128 y = _mm_add_ps(y0, _mm_mul_ps(_mm_sub_ps(y1, y0), w));
+                    const __m128 z = _mm_add_ps(z0, _mm_mul_ps(_mm_sub_ps(z1, z0), w));
+                    const __m128 r = _mm_add_ps(w0, _mm_mul_ps(_mm_sub_ps(w1, w0), w));
+
+                    const __m128 length  = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+                                                                  _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(r, r))));
+                    const __m128 inverse = _mm_div_ps(one, length);
+                    _mm_storeu_ps(ox + i, _mm_mul_ps(x, inverse));
+                    _mm_storeu_ps(oy + i, _mm_mul_ps(y, inverse));
+                    _mm_storeu_ps(oz + i, _mm_mul_ps(z, inverse));
+                    _mm_storeu_ps(ow + i, _mm_mul_ps(r, inverse));
+                }
+            }
+#endif
+            for (; i < count; i++) {
+                const float w    = PerElement ? t[i] : t[0];
+                const float d    = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i] + aw[i] * bw[i];
+                const float flip = std::signbit(d) ? -1.0f : 1.0f;
+
+                const float x = ax[i] + (bx[i] * flip - ax[i]) * w;
+                const float y = ay[i] + (by[i] * flip - ay[i]) * w;
+                const float z = az[i] + (bz[i] * flip - az[i]) * w;
+                const float r = aw[i] + (bw[i] * flip - aw[i]) * w;
+
+                const float inverse = 1.0f / std::sqrt(x * x + y * y + z * z + r * r);
+                ox[i]               = x * inverse;
+                oy[i]               = y * inverse;
+                oz[i]               = z * inverse;
+                ow[i]               = r * inverse;
+            }
+        }
+
+        template <bool PerElement>
+        void blend_lanes(const Pose &a, const Pose &b, const float *t, Pose &out) {
+            if (a.joint_count != b.joint_count)
+                throw std::runtime_error("Blended poses need the same number of joints");
+
+            out.resize(a.joint_count);
+
+            const size_t count = a.get_padded_count();
+            nlerp_lanes<PerElement>(a, b, t, out);
+            for (int c = 0; c < 3; c++) {
+                lerp_lanes<PerElement>(a.translation[c].data(), b.translation[c].data(), t, out.translation[c].data(),
+                                       count);
+                lerp_lanes<PerElement>(a.scale[c].data(), b.scale[c].data(), t, out.scale[c].data(), count);
+            }
+        }
+
+        // translation * rotation * scale
+        JointMatrix compose(const Pose &pose, uint32_t j) {
+            const float x = pose.rotation[0][j], y = pose.rotation[1][j], z = pose.rotation[2][j],
+                        w = pose.rotation[3][j];
+            const float sx = pose.scale[0][j], sy = pose.scale[1][j], sz = pose.scale[2][j];
+
+            return { {
+                glm::vec4((1.0f - 2.0f * (y * y + z * z)) * sx, 2.0f * (x * y - w * z) * sy,
+                          2.0f * (x * z + w * y) * sz, pose.translation[0][j]),
+                glm::vec4(2.0f * (x * y + w * z) * sx, (1.0f - 2.0f * (x * x + z * z)) * sy,
+                          2.0f * (y * z - w * x) * sz, pose.translation[1][j]),
+                glm::vec4(2.0f * (x * z - w * y) * sx, 2.0f * (y * z + w * x) * sy,
+                          (1.0f - 2.0f * (x * x + y * y)) * sz, pose.translation[2][j]),
+            } };
+        }
+
+        JointMatrix multiply(const JointMatrix &a, const JointMatrix &b) {
+            JointMatrix result;
+            for (int r = 0; r < 3; r++) {
+                const glm::vec4 &row = a.rows[r];
+                result.rows[r] = b.rows[0] * row.x + b.rows[1] * row.y + b.rows[2] * row.z +
+                                 glm::vec4(0.0f, 0.0f, 0.0f, row.w);
+            }
+            return result;
+        }
+    } // namespace
+
+    Pose::Pose(uint32_t joint_count) { resize(joint_count); }
+
+    void Pose::resize(uint32_t count) {
+        joint_count = count;
+
+        // the padding holds identity transforms, so whole SIMD lanes can be interpolated and normalized
+        const size_t size = padded(count);
+        for (int c = 0; c < 4; c++) {
+            rotation[c].resize(size);
+            std::fill(rotation[c].begin() + count, rotation[c].end(), c == 3 ? 1.0f : 0.0f);
+        }
+        for (int c = 0; c < 3; c++) {
+            translation[c].resize(size);
+            scale[c].resize(size);
+            std::fill(translation[c].begin() + count, translation[c].end(), 0.0f);
+            std::fill(scale[c].begin() + count, scale[c].end(), 1.0f);
+        }
+    }
+
+    void Pose::set(uint32_t joint, const Transform &transform) {
+        rotation[0][joint] = transform.rotation.x;
+        rotation[1][joint] = transform.rotation.y;
+        rotation[2][joint] = transform.rotation.z;
+        rotation[3][joint] = transform.rotation.w;
+        for (int c = 0; c < 3; c++) {
+            translation[c][joint] = transform.translation[c];
+            scale[c][joint]       = transform.scale[c];
+        }
+    }
+
+    Transform Pose::get(uint32_t joint) const {
+        Transform transform;
+        transform.rotation = glm::quat(rotation[3][joint], rotation[0][joint], rotation[1][joint], rotation[2][joint]);
+        for (int c = 0; c < 3; c++) {
+            transform.translation[c] = translation[c][joint];
+            transform.scale[c]       = scale[c][joint];
+        }
+        return transform;
+    }
+
+    Skeleton::Skeleton(std::vector<int32_t> parents, const std::vector<Transform> &rest_pose,
+                       const std::vector<glm::mat4> &inverse_bind, std::vector<std::string> names) :
+        m_parents(std::move(parents)), m_rest_pose(static_cast<uint32_t>(m_parents.size())),
+        m_names(std::move(names)) {
+        const size_t joints = m_parents.size();
+        if (rest_pose.size() != joints || inverse_bind.size() != joints ||
+            (!m_names.empty() && m_names.size() != joints))
+            throw std::runtime_error("Skeleton needs a rest transform and inverse bind matrix for every joint");
+
+        m_inverse_bind.reserve(joints);
+        for (uint32_t j = 0; j < joints; j++) {
+            if (m_parents[j] < -1 || m_parents[j] >= static_cast<int32_t>(j))
+                throw std::runtime_error("Skeleton joints must come after their parents");
+
+            m_rest_pose.set(j, rest_pose[j]);
+
+            const glm::mat4 &m = inverse_bind[j];
+            m_inverse_bind.push_back({ {
+                glm::vec4(m[0][0], m[1][0], m[2][0], m[3][0]),
+                glm::vec4(m[0][1], m[1][1], m[2][1], m[3][1]),
+                glm::vec4(m[0][2], m[1][2], m[2][2], m[3][2]),
+            } });
+        }
+    }
+
+    std::shared_ptr<Skeleton> Skeleton::create(std::vector<int32_t> parents, const std::vector<Transform> &rest_pose,
+                                               const std::vector<glm::mat4> &inverse_bind,
+                                               std::vector<std::string>      names) {
+        return std::make_shared<Skeleton>(std::move(parents), rest_pose, inverse_bind, std::move(names));
+    }
+
+    int32_t Skeleton::find_joint(const std::string &name) const {
+        const auto it = std::ranges::find(m_names, name);
+        return it == m_names.end() ? -1 : static_cast<int32_t>(it - m_names.begin());
+    }
+
+    AnimationClip::AnimationClip(const RawAnimation &raw, const ClipCompression &compression) :
+        m_joint_count(static_cast<uint32_t>(raw.rotations.size())), m_sample_rate(raw.sample_rate) {
+        if (raw.translations.size() != m_joint_count || raw.scales.size() != m_joint_count)
+            throw std::runtime_error("Animation needs rotation, translation and scale tracks for every joint");
+        if (!(raw.sample_rate > 0.0f))
+            throw std::runtime_error("Animation sample rate must be positive");
+
+        size_t frames = 1;
+        for (uint32_t j = 0; j < m_joint_count; j++) {
+            frames = std::max({ frames, raw.rotations[j].size(), raw.translations[j].size(), raw.scales[j].size() });
+        }
+        if (frames > 65536)
+            throw std::runtime_error("Animation has more frames than 16 bit key times can address");
+
+        for (uint32_t j = 0; j < m_joint_count; j++) {
+            for (const size_t size : { raw.rotations[j].size(), raw.translations[j].size(), raw.scales[j].size() }) {
+                if (size != 1 && size != frames)
+                    throw std::runtime_error("Animation tracks need a single frame or the clip's frame count");
+            }
+        }
+
+        m_last_frame = static_cast<float>(frames - 1);
+        m_duration   = m_last_frame / m_sample_rate;
+
+        for (uint32_t j = 0; j < m_joint_count; j++) {
+            add_rotation_track(m_rotations, raw.rotations[j], compression.rotation_tolerance);
+            add_vector_track(m_translations, raw.translations[j], compression.translation_tolerance);
+            add_vector_track(m_scales, raw.scales[j], compression.scale_tolerance);
+        }
+    }
+
+    std::shared_ptr<AnimationClip> AnimationClip::create(const RawAnimation &raw, const ClipCompression &compression) {
+        return std::make_shared<AnimationClip>(raw, compression);
+    }
+
+    void AnimationClip::add_rotation_track(Channel &channel, const std::vector<glm::quat> &track, float tolerance) {
+        std::vector<glm::vec4> values;
+        values.reserve(track.size());
+        for (const glm::quat &q : track) {
+            const glm::vec4 v(q.x, q.y, q.z, q.w);
+            values.push_back(v / std::sqrt(glm::dot(v, v)));
+        }
+
+        const std::vector<uint32_t> kept = reduce_keys(values, tolerance, nlerp, rotation_error);
+
+        channel.tracks.push_back({ static_cast<uint32_t>(channel.frames.size()), static_cast<uint32_t>(kept.size()) });
+        for (const uint32_t frame : kept) {
+            channel.frames.push_back(static_cast<uint16_t>(frame));
+            channel.keys.push_back(encode_rotation(values[frame]));
+        }
+    }
+
+    void AnimationClip::add_vector_track(Channel &channel, const std::vector<glm::vec3> &track, float tolerance) {
+        const std::vector<uint32_t> kept = reduce_keys(
+            track, tolerance, [](const glm::vec3 &a, const glm::vec3 &b, float t) { return a + (b - a) * t; },
+            [](const glm::vec3 &a, const glm::vec3 &b) { return glm::length(a - b); });
+
+        glm::vec3 minimum = track[kept.front()];
+        glm::vec3 maximum = minimum;
+        for (const uint32_t frame : kept) {
+            minimum = glm::min(minimum, track[frame]);
+            maximum = glm::max(maximum, track[frame]);
+        }
+        const glm::vec3 extent = maximum - minimum;
+
+        channel.tracks.push_back({ static_cast<uint32_t>(channel.frames.size()), static_cast<uint32_t>(kept.size()) });
+        channel.minimum.push_back(minimum);
+        channel.extent.push_back(extent);
+        for (const uint32_t frame : kept) {
+            const glm::vec3 &v = track[frame];
+            channel.frames.push_back(static_cast<uint16_t>(frame));
+            channel.keys.push_back({ quantize(v.x, minimum.x, extent.x), quantize(v.y, minimum.y, extent.y),
+                                     quantize(v.z, minimum.z, extent.z) });
+        }
+    }
+
+    void AnimationClip::find_keys(const Channel &channel, uint32_t track, float frame, uint32_t &cursor,
+                                  float &weight) {
+        const Track &t = channel.tracks[track];
+        if (t.count == 1) {
+            cursor = 0;
+            weight = 0.0f;
+            return;
+        }
+
+        // playback mostly stays between the same keys or moves on by one, search only when it jumped
+        const uint16_t *frames = channel.frames.data() + t.first;
+        const auto      within = [&](uint32_t c) {
+            return c + 1 < t.count && frames[c] <= frame && frame < frames[c + 1];
+        };
+        if (!within(cursor)) {
+            if (within(cursor + 1))
+                cursor++;
+            else
+                cursor = static_cast<uint32_t>(std::upper_bound(frames + 1, frames + t.count - 1, frame) - frames) - 1;
+        }
+
+        weight = (frame - static_cast<float>(frames[cursor])) /
+                 static_cast<float>(frames[cursor + 1] - frames[cursor]);
+    }
+
+    void AnimationClip::sample(float time, Pose &out, SamplingCache &cache) const {
+        if (cache.m_clip != this) {
+            cache.m_clip = this;
+            cache.m_cursors.assign(static_cast<size_t>(m_joint_count) * 3, 0);
+        }
+
+        // the first keys are decoded straight into `out`, the second ones into `next`, then a SIMD pass over all
+        // joints interpolates between them
+        thread_local Pose               next;
+        thread_local std::vector<float> weights[3];
+
+        out.resize(m_joint_count);
+        next.resize(m_joint_count);
+        for (auto &w : weights) {
+            w.assign(out.get_padded_count(), 0.0f);
+        }
+
+        const float frame = std::min(std::clamp(time, 0.0f, m_duration) * m_sample_rate, m_last_frame);
+
+        using Components          = std::vector<float>[3];
+        const auto sample_vectors = [&](const Channel &channel, uint32_t j, uint32_t &cursor, float &weight,
+                                        Components &first, Components &second) {
+            find_keys(channel, j, frame, cursor, weight);
+
+            const Track     &track   = channel.tracks[j];
+            const auto      &a       = channel.keys[track.first + cursor];
+            const auto      &b       = channel.keys[track.first + std::min(cursor + 1, track.count - 1)];
+            const glm::vec3 &minimum = channel.minimum[j];
+            const glm::vec3 &extent  = channel.extent[j];
+            for (int c = 0; c < 3; c++) {
+                first[c][j]  = dequantize(a[c], minimum[c], extent[c]);
+                second[c][j] = dequantize(b[c], minimum[c], extent[c]);
+            }
+        };
+
+        uint32_t *cursors = cache.m_cursors.data();
+        for (uint32_t j = 0; j < m_joint_count; j++) {
+            uint32_t &cursor = cursors[j * 3];
+            find_keys(m_rotations, j, frame, cursor, weights[0][j]);
+
+            const Track &track = m_rotations.tracks[j];
+            float        a[4], b[4];
+            decode_rotation(m_rotations.keys[track.first + cursor], a);
+            decode_rotation(m_rotations.keys[track.first + std::min(cursor + 1, track.count - 1)], b);
+            for (int c = 0; c < 4; c++) {
+                out.rotation[c][j]  = a[c];
+                next.rotation[c][j] = b[c];
+            }
+
+            sample_vectors(m_translations, j, cursors[j * 3 + 1], weights[1][j], out.translation, next.translation);
+            sample_vectors(m_scales, j, cursors[j * 3 + 2], weights[2][j], out.scale, next.scale);
+        }
+
+        const size_t count = out.get_padded_count();
+        nlerp_lanes<true>(out, next, weights[0].data(), out);
+        for (int c = 0; c < 3; c++) {
+            lerp_lanes<true>(out.translation[c].data(), next.translation[c].data(), weights[1].data(),
+                             out.translation[c].data(), count);
+            lerp_lanes<true>(out.scale[c].data(), next.scale[c].data(), weights[2].data(), out.scale[c].data(),
+                             count);
+        }
+    }
+
+    size_t AnimationClip::get_key_count() const noexcept {
+        return m_rotations.keys.size() + m_translations.keys.size() + m_scales.keys.size();
+    }
+
+    size_t AnimationClip::get_memory_size() const noexcept {
+        size_t size = 0;
+        for (const Channel *channel : { &m_rotations, &m_translations, &m_scales }) {
+            size += channel->tracks.size() * sizeof(Track) + channel->frames.size() * sizeof(uint16_t) +
+                    channel->keys.size() * sizeof(channel->keys[0]) +
+                    (channel->minimum.size() + channel->extent.size()) * sizeof(glm::vec3);
+        }
+        return size;
+    }
+
+    void blend_poses(const Pose &a, const Pose &b, float weight, Pose &out) { blend_lanes<false>(a, b, &weight, out); }
+
+    void blend_poses(const Pose &a, const Pose &b, std::span<const float> joint_weights, Pose &out) {
+        if (joint_weights.size() < a.joint_count)
+            throw std::runtime_error("Blend needs a weight for every joint");
+
+        // zero weights for the padding
+        thread_local std::vector<float> weights;
+        weights.assign(a.get_padded_count(), 0.0f);
+        std::copy_n(joint_weights.begin(), a.joint_count, weights.begin());
+
+        blend_lanes<true>(a, b, weights.data(), out);
+    }
+
+    void build_palette(const Skeleton &skeleton, const Pose &pose, std::span<JointMatrix> out) {
+        const uint32_t joints = skeleton.get_joint_count();
+        if (pose.joint_count != joints || out.size() < joints)
+            throw std::runtime_error("Palette needs a pose of the skeleton and room for all of its joints");
+
+        const std::span<const int32_t>     parents      = skeleton.get_parents();
+        const std::span<const JointMatrix> inverse_bind = skeleton.get_inverse_bind();
+
+        // parents come first, so every parent's model transform is ready before its children need it
+        thread_local std::vector<JointMatrix> model;
+        model.resize(joints);
+        for (uint32_t j = 0; j < joints; j++) {
+            const JointMatrix local = compose(pose, j);
+            model[j]                = parents[j] < 0 ? local : multiply(model[parents[j]], local);
+            out[j]                  = multiply(model[j], inverse_bind[j]);
+        }
+    }
+
+} // namespace kat
@@ -0,0 +1,165 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "kat/utils/transform.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace kat {
+
+    // Local joint transforms as structure of arrays, so sampling and blending run over 8 joints at a time. The arrays
+    // are padded to a multiple of 8 joints with identity transforms.
+    struct Pose {
+        explicit Pose(uint32_t joint_count = 0);
+
+        void resize(uint32_t joint_count);
+
+        void set(uint32_t joint, const Transform &transform);
+
+        [[nodiscard]] Transform get(uint32_t joint) const;
+
+        // joints including the padding
+        [[nodiscard]] size_t get_padded_count() const noexcept { return rotation[0].size(); }
+
+        uint32_t           joint_count = 0;
+        std::vector<float> rotation[4]; // x, y, z, w
+        std::vector<float> translation[3];
+        std::vector<float> scale[3];
+    };
+
+    // Row major 3x4 affine matrix, the last row is always 0, 0, 0, 1. std430 layout of three vec4.
+    struct JointMatrix {
+        glm::vec4 rows[3];
+    };
+
+    static_assert(sizeof(JointMatrix) == 48);
+
+    class Skeleton {
+      public:
+        // Joints are ordered parents first, parents[j] < j or -1 for a root. `inverse_bind` takes model space to
+        // joint space in the bind pose.
+        Skeleton(std::vector<int32_t> parents, const std::vector<Transform> &rest_pose,
+                 const std::vector<glm::mat4> &inverse_bind, std::vector<std::string> names = {});
+
+        static std::shared_ptr<Skeleton> create(std::vector<int32_t> parents, const std::vector<Transform> &rest_pose,
+                                                const std::vector<glm::mat4> &inverse_bind,
+                                                std::vector<std::string>      names = {});
+
+        [[nodiscard]] uint32_t get_joint_count() const noexcept { return static_cast<uint32_t>(m_parents.size()); }
+
+        [[nodiscard]] std::span<const int32_t> get_parents() const noexcept { return m_parents; }
+
+        [[nodiscard]] const Pose &get_rest_pose() const noexcept { return m_rest_pose; }
+
+        [[nodiscard]] std::span<const JointMatrix> get_inverse_bind() const noexcept { return m_inverse_bind; }
+
+        // -1 when there is no joint with that name
+        [[nodiscard]] int32_t find_joint(const std::string &name) const;
+
+      private:
+        std::vector<int32_t>     m_parents;
+        Pose                     m_rest_pose;
+        std::vector<JointMatrix> m_inverse_bind;
+        std::vector<std::string> m_names;
+    };
+
+    // Uniformly sampled source data, as an importer or authoring tool produces it. Tracks are indexed [joint][frame];
+    // a track with a single frame is constant, every other track has the clip's full frame count.
+    struct RawAnimation {
+        float                               sample_rate = 30.0f; // frames per second
+        std::vector<std::vector<glm::quat>> rotations;
+        std::vector<std::vector<glm::vec3>> translations;
+        std::vector<std::vector<glm::vec3>> scales;
+    };
+
+    // Keys that linear interpolation of their neighbours reproduces within these errors are dropped. The errors are
+    // per joint in local space, children of a joint inherit its error.
+    struct ClipCompression {
+        float rotation_tolerance    = 0.0005f; // radians
+        float translation_tolerance = 0.0005f; // units
+        float scale_tolerance       = 0.0005f;
+    };
+
+    class AnimationClip;
+
+    // The keys each track sampled last, so a playback moving forward finds the next keys without a search. Keep one
+    // per playback; it resets itself when used with another clip.
+    class SamplingCache {
+      private:
+        friend class AnimationClip;
+
+        const AnimationClip  *m_clip = nullptr;
+        std::vector<uint32_t> m_cursors;
+    };
+
+    // A compressed clip. Rotations are stored as the smallest three components at 15 bits each, translations and
+    // scales as 16 bits per component within each track's range, and key times as 16 bit frame numbers, so a key
+    // takes 8 bytes at most. Only the keys that survive reduction are stored.
+    class AnimationClip {
+      public:
+        explicit AnimationClip(const RawAnimation &raw, const ClipCompression &compression = {});
+
+        static std::shared_ptr<AnimationClip> create(const RawAnimation     &raw,
+                                                     const ClipCompression &compression = {});
+
+        // `time` is clamped to the clip, resizes `out` to the clip's joints
+        void sample(float time, Pose &out, SamplingCache &cache) const;
+
+        [[nodiscard]] float get_duration() const noexcept { return m_duration; }
+
+        [[nodiscard]] uint32_t get_joint_count() const noexcept { return m_joint_count; }
+
+        [[nodiscard]] size_t get_key_count() const noexcept;
+
+        // size of the compressed data
+        [[nodiscard]] size_t get_memory_size() const noexcept;
+
+      private:
+        struct Track {
+            uint32_t first; // into frames and keys
+            uint32_t count;
+        };
+
+        struct Channel {
+            std::vector<Track>                   tracks; // one per joint
+            std::vector<uint16_t>                frames;
+            std::vector<std::array<uint16_t, 3>> keys;
+
+            // dequantization of every track, unused for rotations
+            std::vector<glm::vec3> minimum;
+            std::vector<glm::vec3> extent;
+        };
+
+        static void add_rotation_track(Channel &channel, const std::vector<glm::quat> &track, float tolerance);
+
+        static void add_vector_track(Channel &channel, const std::vector<glm::vec3> &track, float tolerance);
+
+        // the keys around `frame` and the weight of the second, `cursor` is the first key's index in the track
+        static void find_keys(const Channel &channel, uint32_t track, float frame, uint32_t &cursor, float &weight);
+
+        uint32_t m_joint_count = 0;
+        float    m_duration    = 0.0f;
+        float    m_sample_rate = 30.0f;
+        float    m_last_frame  = 0.0f;
+
+        Channel m_rotations;
+        Channel m_translations;
+        Channel m_scales;
+    };
+
+    // out = a + (b - a) * weight, rotations interpolated along the shorter arc. `out` may be `a` or `b`.
+    void blend_poses(const Pose &a, const Pose &b, float weight, Pose &out);
+
+    // with a weight per joint, e.g. to layer an upper body clip over a walk
+    void blend_poses(const Pose &a, const Pose &b, std::span<const float> joint_weights, Pose &out);
+
+    // Skinning matrices (model space transform times inverse bind) of every joint of `pose`.
+    void build_palette(const Skeleton &skeleton, const Pose &pose, std::span<JointMatrix> out);
+
+} // namespace kat
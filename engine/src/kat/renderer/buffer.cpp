@@ -1,5 +1,7 @@
 #include "buffer.hpp"
 
+#include "destruction_queue.hpp"
+
 namespace kat {
 
     Buffer::Buffer() {
@@ -12,13 +14,22 @@ namespace kat {
     }
 
     Buffer::~Buffer() {
-        glDeleteBuffers(1, &m_buffer);
+        DestructionQueue::get().enqueue(GpuObjectType::Buffer, m_buffer);
     }
 
     void Buffer::bind(BufferTarget target) const {
         glBindBuffer(static_cast<GLenum>(target), m_buffer);
     }
 
+    void Buffer::bind_base(BufferTarget target, unsigned int index) const {
+        glBindBufferBase(static_cast<GLenum>(target), index, m_buffer);
+    }
+
+    void Buffer::bind_range(BufferTarget target, unsigned int index, size_t offset, size_t size) const {
+        glBindBufferRange(static_cast<GLenum>(target), index, m_buffer, static_cast<GLintptr>(offset),
+                          static_cast<GLsizeiptr>(size));
+    }
+
     void Buffer::clear() {
         set(nullptr, 0, BufferUsage::StaticDraw);
     }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "kat/engine.hpp"
+#include "kat/utils/handle_pool.hpp"
 
 namespace kat {
 
@@ -10,6 +11,9 @@ namespace kat {
         Uniform = GL_UNIFORM_BUFFER,
         ShaderStorage = GL_SHADER_STORAGE_BUFFER,
         Texture = GL_TEXTURE_BUFFER,
+        DrawIndirect = GL_DRAW_INDIRECT_BUFFER,
+        DispatchIndirect = GL_DISPATCH_INDIRECT_BUFFER,
+        Parameter = GL_PARAMETER_BUFFER,
     };
 
     enum class BufferUsage : GLenum {
@@ -62,8 +66,16 @@ namespace kat {
 
         ~Buffer();
 
+        Buffer(const Buffer &)            = delete;
+        Buffer &operator=(const Buffer &) = delete;
+
         void bind(BufferTarget target) const;
 
+        // indexed binding for uniform/shader storage blocks
+        void bind_base(BufferTarget target, unsigned int index) const;
+
+        void bind_range(BufferTarget target, unsigned int index, size_t offset, size_t size) const;
+
         void clear();
 
         void set(const void* data, size_t size, BufferUsage usage = BufferUsage::UseCurrent);
@@ -76,10 +88,28 @@ namespace kat {
 
         [[nodiscard]] unsigned int get_handle() const noexcept { return m_buffer; }
 
+        [[nodiscard]] size_t get_size() const noexcept { return m_current_size; }
+
       private:
         unsigned int m_buffer;
         size_t m_current_size = 0;
         BufferUsage m_current_usage = BufferUsage::Undefined;
     };
 
+    // Matches the GL layout consumed by glMultiDrawElementsIndirect.
+    struct DrawElementsIndirectCommand {
+        uint32_t count;
+        uint32_t instance_count;
+        uint32_t first_index;
+        int32_t  base_vertex;
+        uint32_t base_instance;
+    };
+
+    // A byte range inside a pooled buffer, used when several objects share one GL buffer.
+    struct BufferRange {
+        Handle<Buffer> buffer;
+        size_t         offset = 0;
+        size_t         size   = 0;
+    };
+
 } // namespace kat
@@ -0,0 +1,427 @@
+#include "clustered_lighting.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <string>
+
+namespace kat {
+    namespace {
+        const std::string LIGHTS_FUNCTIONS_SOURCE = R"(
+// view depth of a fragment, gl_FragCoord.z in the default [0, 1] depth range
+float kat_view_depth(float depth) {
+    float near = kat_cluster_depth.x;
+    float far  = kat_cluster_depth.y;
+    return 2.0 * near * far / (far + near - (depth * 2.0 - 1.0) * (far - near));
+}
+
+uint kat_cluster(vec4 frag_coord) {
+    uvec2 tile  = min(uvec2(frag_coord.xy / kat_cluster_tile.xy), kat_cluster_grid.xy - 1u);
+    float slice = log(kat_view_depth(frag_coord.z)) * kat_cluster_depth.z + kat_cluster_depth.w;
+    uint  z     = uint(clamp(slice, 0.0, float(kat_cluster_grid.z - 1u)));
+    return tile.x + kat_cluster_grid.x * (tile.y + kat_cluster_grid.y * z);
+}
+
+uint kat_cluster_light_count(uint cluster) {
+    return kat_cluster_counts[cluster];
+}
+
+KatLight kat_cluster_light(uint cluster, uint i) {
+    return kat_lights[kat_light_indices[cluster * kat_cluster_grid.w + i]];
+}
+
+// light arriving at `position` before the surface's BRDF, `direction` points towards the light
+vec3 kat_light_radiance(KatLight light, vec3 position, out vec3 direction) {
+    vec3  to_light  = light.position_range.xyz - position;
+    float distance2 = max(dot(to_light, to_light), 1e-8);
+    direction       = to_light * inversesqrt(distance2);
+
+    // inverse square falloff, windowed to reach zero at the range
+    float ratio  = distance2 / (light.position_range.w * light.position_range.w);
+    float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+    float spot   = smoothstep(light.direction_cos_outer.w, light.color_cos_inner.w,
+                              dot(-direction, light.direction_cos_outer.xyz));
+
+    return light.color_cos_inner.rgb * (window * window * spot / max(distance2, 1e-4));
+}
+
+// Lambert diffuse and Blinn-Phong specular from every light of the fragment's cluster
+vec3 kat_shade_lights(vec4 frag_coord, vec3 position, vec3 normal, vec3 view_direction, vec3 albedo,
+                      float specular, float shininess) {
+    uint cluster = kat_cluster(frag_coord);
+    uint count   = kat_cluster_light_count(cluster);
+
+    vec3 result = vec3(0.0);
+    for (uint i = 0u; i < count; i++) {
+        vec3 direction;
+        vec3 radiance = kat_light_radiance(kat_cluster_light(cluster, i), position, direction);
+
+        float n_dot_l = max(dot(normal, direction), 0.0);
+        float n_dot_h = max(dot(normal, normalize(direction + view_direction)), 0.0);
+        result += radiance * n_dot_l * (albedo + specular * pow(n_dot_h, shininess));
+    }
+    return result;
+}
+)";
+
+        const std::string ASSIGN_SHADER_SOURCE = R"(#version 460 core
+layout(local_size_x = 64) in;
+
+struct Light {
+    vec4 position_range;
+    vec4 color_cos_inner;
+    vec4 direction_cos_outer;
+    vec4 bounds;
+};
+
+layout(std430, binding = 0) readonly buffer Lights {
+    Light lights[];
+};
+
+layout(std430, binding = 1) buffer Grid {
+    uvec4 grid;
+    vec4  depth;
+    vec4  tile;
+    uint  counts[];
+};
+
+layout(std430, binding = 2) writeonly buffer Indices {
+    uint indices[];
+};
+
+uniform mat4 u_view;
+uniform mat4 u_inverse_projection;
+uniform uint u_light_count;
+
+shared vec3 s_min;
+shared vec3 s_max;
+shared uint s_count;
+
+vec3 view_point(vec2 ndc, float view_depth) {
+    vec4 p = u_inverse_projection * vec4(ndc, -1.0, 1.0);
+    p.xyz /= p.w;
+    return p.xyz * (view_depth / -p.z);
+}
+
+// one work group per cluster, its threads split the lights
+void main() {
+    uvec3 c       = gl_WorkGroupID;
+    uint  cluster = c.x + grid.x * (c.y + grid.y * c.z);
+
+    if (gl_LocalInvocationIndex == 0u) {
+        float near = depth.x;
+        float far  = depth.y;
+        float d0   = near * pow(far / near, float(c.z) / float(grid.z));
+        float d1   = near * pow(far / near, float(c.z + 1u) / float(grid.z));
+
+        vec2 lo = vec2(c.xy) / vec2(grid.xy) * 2.0 - 1.0;
+        vec2 hi = vec2(c.xy + 1u) / vec2(grid.xy) * 2.0 - 1.0;
+
+        vec3 bounds_min = vec3(1e30);
+        vec3 bounds_max = vec3(-1e30);
+        for (int i = 0; i < 4; i++) {
+            vec2 ndc = vec2((i & 1) != 0 ? hi.x : lo.x, (i & 2) != 0 ? hi.y : lo.y);
+            vec3 a   = view_point(ndc, d0);
+            vec3 b   = view_point(ndc, d1);
+            bounds_min = min(bounds_min, min(a, b));
+            bounds_max = max(bounds_max, max(a, b));
+        }
+
+        s_min   = bounds_min;
+        s_max   = bounds_max;
+        s_count = 0u;
+    }
+
+    memoryBarrierShared();
+    barrier();
+
+    for (uint i = gl_LocalInvocationIndex; i < u_light_count; i += gl_WorkGroupSize.x) {
+        vec4 bounds = lights[i].bounds;
+        vec3 center = (u_view * vec4(bounds.xyz, 1.0)).xyz;
+        vec3 d      = max(max(s_min - center, center - s_max), 0.0);
+        if (dot(d, d) > bounds.w * bounds.w)
+            continue;
+
+        uint slot = atomicAdd(s_count, 1u);
+        if (slot < grid.w)
+            indices[cluster * grid.w + slot] = i;
+    }
+
+    memoryBarrierShared();
+    barrier();
+
+    if (gl_LocalInvocationIndex == 0u)
+        counts[cluster] = min(s_count, grid.w);
+}
+)";
+
+        float distance_squared(const Aabb &box, const glm::vec3 &point) {
+            const glm::vec3 d = glm::max(glm::max(box.min - point, point - box.max), glm::vec3(0.0f));
+            return glm::dot(d, d);
+        }
+    } // namespace
+
+    GpuLight to_gpu_light(const Light &light) {
+        const glm::vec3 color = light.color * light.intensity;
+
+        if (light.type == LightType::Point || light.outer_angle >= std::numbers::pi_v<float> * 0.5f) {
+            // a cone wider than a half space is bounded by the whole sphere anyway
+            const float cos_outer = light.type == LightType::Point ? -2.0f : std::cos(light.outer_angle);
+            const float cos_inner = light.type == LightType::Point ? -1.0f : std::cos(light.inner_angle);
+            return { glm::vec4(light.position, light.range), glm::vec4(color, cos_inner),
+                     glm::vec4(light.direction, cos_outer), glm::vec4(light.position, light.range) };
+        }
+
+        // smallest sphere around the cone: through the apex and the rim for narrow cones, around the rim otherwise
+        const float angle = light.outer_angle;
+        glm::vec4   bounds;
+        if (angle > std::numbers::pi_v<float> * 0.25f) {
+            bounds = glm::vec4(light.position + light.direction * (light.range * std::cos(angle)),
+                               light.range * std::sin(angle));
+        } else {
+            const float radius = light.range / (2.0f * std::cos(angle));
+            bounds             = glm::vec4(light.position + light.direction * radius, radius);
+        }
+
+        return { glm::vec4(light.position, light.range), glm::vec4(color, std::cos(light.inner_angle)),
+                 glm::vec4(light.direction, std::cos(angle)), bounds };
+    }
+
+    ClusteredLighting::ClusteredLighting(const std::shared_ptr<GpuResources> &resources, const ClusterOptions &options,
+                                         const std::shared_ptr<JobSystem> &job_system) :
+        m_resources(resources), m_options(options), m_job_system(job_system) {
+        const uint32_t clusters = get_cluster_count();
+
+        m_header.grid = glm::uvec4(options.grid, options.max_lights_per_cluster);
+
+        m_light_buffer = m_resources->create_buffer(nullptr, sizeof(GpuLight), BufferUsage::DynamicDraw);
+        m_grid_buffer  = m_resources->create_buffer(nullptr, sizeof(GridHeader) + clusters * sizeof(uint32_t),
+                                                    BufferUsage::DynamicCopy);
+        m_index_buffer = m_resources->create_buffer(
+            nullptr, static_cast<size_t>(clusters) * options.max_lights_per_cluster * sizeof(uint32_t),
+            BufferUsage::DynamicCopy);
+
+        ShaderModule::register_include(
+            "kat/lights.glsl",
+            "struct KatLight {\n"
+            "    vec4 position_range;\n"
+            "    vec4 color_cos_inner;\n"
+            "    vec4 direction_cos_outer;\n"
+            "    vec4 bounds;\n"
+            "};\n"
+            "layout(std430, binding = " +
+                std::to_string(LIGHT_TABLE_BINDING) +
+                ") readonly buffer KatLightTable {\n"
+                "    KatLight kat_lights[];\n"
+                "};\n"
+                "layout(std430, binding = " +
+                std::to_string(LIGHT_GRID_BINDING) +
+                ") readonly buffer KatLightGrid {\n"
+                "    uvec4 kat_cluster_grid;\n"
+                "    vec4  kat_cluster_depth;\n"
+                "    vec4  kat_cluster_tile;\n"
+                "    uint  kat_cluster_counts[];\n"
+                "};\n"
+                "layout(std430, binding = " +
+                std::to_string(LIGHT_INDEX_BINDING) +
+                ") readonly buffer KatLightIndices {\n"
+                "    uint kat_light_indices[];\n"
+                "};\n" +
+                LIGHTS_FUNCTIONS_SOURCE);
+    }
+
+    ClusteredLighting::~ClusteredLighting() {
+        m_resources->destroy(m_light_buffer);
+        m_resources->destroy(m_grid_buffer);
+        m_resources->destroy(m_index_buffer);
+    }
+
+    std::shared_ptr<ClusteredLighting> ClusteredLighting::create(const std::shared_ptr<GpuResources> &resources,
+                                                                 const ClusterOptions                &options,
+                                                                 const std::shared_ptr<JobSystem>    &job_system) {
+        return std::make_shared<ClusteredLighting>(resources, options, job_system);
+    }
+
+    void ClusteredLighting::set_lights(std::span<const Light> lights) {
+        m_lights.clear();
+        m_lights.reserve(lights.size());
+        for (const auto &light : lights) {
+            m_lights.push_back(to_gpu_light(light));
+        }
+
+        if (!m_lights.empty())
+            m_resources->get(m_light_buffer)
+                .set(m_lights.data(), m_lights.size() * sizeof(GpuLight), BufferUsage::DynamicDraw);
+    }
+
+    void ClusteredLighting::update(const glm::mat4 &view, const glm::mat4 &projection, float near, float far,
+                                   const glm::uvec2 &viewport_size) {
+        const auto  slices = static_cast<float>(m_options.grid.z);
+        const float range  = std::log(far / near);
+
+        m_header.depth = { near, far, slices / range, -slices * std::log(near) / range };
+        m_header.tile  = glm::vec4(glm::vec2(viewport_size) / glm::vec2(m_options.grid.x, m_options.grid.y), 0.0f,
+                                   0.0f);
+
+        if (m_options.gpu_assignment)
+            assign_gpu(view, projection);
+        else {
+            update_clusters(projection);
+            assign_cpu(view);
+        }
+    }
+
+    void ClusteredLighting::assign_gpu(const glm::mat4 &view, const glm::mat4 &projection) {
+        const Buffer &grid_buffer = m_resources->get(m_grid_buffer);
+        if (!m_assign_pipeline) {
+            m_assign_pipeline = ComputePipeline::create(ASSIGN_SHADER_SOURCE);
+            m_assign_pipeline->set_storage(0, m_resources->get(m_light_buffer), ComputeAccess::ReadOnly);
+            m_assign_pipeline->set_storage(1, grid_buffer);
+            m_assign_pipeline->set_storage(2, m_resources->get(m_index_buffer));
+        }
+
+        MemoryBarriers::require(grid_buffer, GL_BUFFER_UPDATE_BARRIER_BIT);
+        glNamedBufferSubData(grid_buffer.get_handle(), 0, sizeof(GridHeader), &m_header);
+
+        const Shader &shader = m_assign_pipeline->get_shader();
+        shader.uniform_matrix4f("u_view", view);
+        shader.uniform_matrix4f("u_inverse_projection", glm::inverse(projection));
+        shader.uniform1ui("u_light_count", static_cast<uint32_t>(m_lights.size()));
+
+        // one work group per cluster
+        m_assign_pipeline->dispatch_groups(m_options.grid.x, m_options.grid.y, m_options.grid.z);
+    }
+
+    void ClusteredLighting::update_clusters(const glm::mat4 &projection) {
+        if (!m_clusters.empty() && projection == m_cluster_projection)
+            return;
+
+        m_cluster_projection = projection;
+        m_clusters.resize(get_cluster_count());
+
+        const glm::mat4 inverse = glm::inverse(projection);
+        const glm::uvec3 grid   = m_options.grid;
+        const float      near   = m_header.depth.x;
+        const float      far    = m_header.depth.y;
+
+        const auto view_point = [&](const glm::vec2 &ndc, float view_depth) {
+            glm::vec4 p = inverse * glm::vec4(ndc, -1.0f, 1.0f);
+            p /= p.w;
+            return glm::vec3(p) * (view_depth / -p.z);
+        };
+
+        for (uint32_t z = 0; z < grid.z; z++) {
+            const float d0 = near * std::pow(far / near, static_cast<float>(z) / static_cast<float>(grid.z));
+            const float d1 = near * std::pow(far / near, static_cast<float>(z + 1) / static_cast<float>(grid.z));
+
+            for (uint32_t y = 0; y < grid.y; y++) {
+                for (uint32_t x = 0; x < grid.x; x++) {
+                    const glm::vec2 lo = glm::vec2(x, y) / glm::vec2(grid.x, grid.y) * 2.0f - 1.0f;
+                    const glm::vec2 hi = glm::vec2(x + 1, y + 1) / glm::vec2(grid.x, grid.y) * 2.0f - 1.0f;
+
+                    Aabb &bounds = m_clusters[x + grid.x * (y + grid.y * z)];
+                    bounds       = {};
+                    for (int i = 0; i < 4; i++) {
+                        const glm::vec2 ndc = { i & 1 ? hi.x : lo.x, i & 2 ? hi.y : lo.y };
+                        bounds.expand(view_point(ndc, d0));
+                        bounds.expand(view_point(ndc, d1));
+                    }
+                }
+            }
+        }
+    }
+
+    void ClusteredLighting::assign_cpu(const glm::mat4 &view) {
+        const glm::uvec3 grid     = m_options.grid;
+        const uint32_t   max      = m_options.max_lights_per_cluster;
+        const uint32_t   clusters = get_cluster_count();
+
+        // bin the lights by the depth slices they reach first, a cluster then only tests its slice's lights
+        std::vector<glm::vec4>             spheres(m_lights.size());
+        std::vector<std::vector<uint32_t>> slices(grid.z);
+        for (uint32_t i = 0; i < m_lights.size(); i++) {
+            const glm::vec4 &bounds = m_lights[i].bounds;
+            const glm::vec3  center = glm::vec3(view * glm::vec4(glm::vec3(bounds), 1.0f));
+            spheres[i]              = glm::vec4(center, bounds.w);
+
+            const float depth = -center.z;
+            if (depth + bounds.w < m_header.depth.x || depth - bounds.w > m_header.depth.y)
+                continue;
+
+            const auto slice = [&](float d) {
+                const float s = std::log(std::max(d, m_header.depth.x)) * m_header.depth.z + m_header.depth.w;
+                return static_cast<uint32_t>(std::clamp(s, 0.0f, static_cast<float>(grid.z - 1)));
+            };
+            for (uint32_t z = slice(depth - bounds.w); z <= slice(depth + bounds.w); z++) {
+                slices[z].push_back(i);
+            }
+        }
+
+        m_counts.assign(clusters, 0);
+        m_indices.resize(static_cast<size_t>(clusters) * max);
+
+        const auto assign = [&](size_t begin, size_t end) {
+            for (size_t c = begin; c < end; c++) {
+                const Aabb &bounds = m_clusters[c];
+                uint32_t   *list   = m_indices.data() + c * max;
+                uint32_t    count  = 0;
+
+                for (const uint32_t i : slices[c / (grid.x * grid.y)]) {
+                    const glm::vec4 &sphere = spheres[i];
+                    if (distance_squared(bounds, glm::vec3(sphere)) > sphere.w * sphere.w)
+                        continue;
+
+                    list[count++] = i;
+                    if (count == max)
+                        break;
+                }
+                m_counts[c] = count;
+            }
+        };
+
+        if (m_job_system)
+            m_job_system->parallel_for(clusters, 64, assign);
+        else
+            assign(0, clusters);
+
+        // the GPU path may have written them last
+        const Buffer &grid_buffer  = m_resources->get(m_grid_buffer);
+        const Buffer &index_buffer = m_resources->get(m_index_buffer);
+        MemoryBarriers::issue(MemoryBarriers::pending(grid_buffer, GL_BUFFER_UPDATE_BARRIER_BIT) |
+                              MemoryBarriers::pending(index_buffer, GL_BUFFER_UPDATE_BARRIER_BIT));
+        glNamedBufferSubData(grid_buffer.get_handle(), 0, sizeof(GridHeader), &m_header);
+        glNamedBufferSubData(grid_buffer.get_handle(), sizeof(GridHeader), clusters * sizeof(uint32_t),
+                             m_counts.data());
+        glNamedBufferSubData(index_buffer.get_handle(), 0,
+                             static_cast<GLsizeiptr>(m_indices.size() * sizeof(uint32_t)), m_indices.data());
+    }
+
+    void ClusteredLighting::bind() const {
+        const Buffer &grid_buffer  = m_resources->get(m_grid_buffer);
+        const Buffer &index_buffer = m_resources->get(m_index_buffer);
+        MemoryBarriers::issue(MemoryBarriers::pending(grid_buffer, GL_SHADER_STORAGE_BARRIER_BIT) |
+                              MemoryBarriers::pending(index_buffer, GL_SHADER_STORAGE_BARRIER_BIT));
+
+        m_resources->get(m_light_buffer).bind_base(BufferTarget::ShaderStorage, LIGHT_TABLE_BINDING);
+        grid_buffer.bind_base(BufferTarget::ShaderStorage, LIGHT_GRID_BINDING);
+        index_buffer.bind_base(BufferTarget::ShaderStorage, LIGHT_INDEX_BINDING);
+    }
+
+    uint32_t ClusteredLighting::get_cluster_index(const glm::vec2 &pixel, float view_depth) const {
+        const glm::uvec3 grid = m_options.grid;
+
+        const glm::uvec2 tile  = glm::min(glm::uvec2(pixel / glm::vec2(m_header.tile)),
+                                          glm::uvec2(grid.x - 1, grid.y - 1));
+        const float      slice = std::log(view_depth) * m_header.depth.z + m_header.depth.w;
+        const auto       z     = static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(grid.z - 1)));
+        return tile.x + grid.x * (tile.y + grid.y * z);
+    }
+
+    std::span<const uint32_t> ClusteredLighting::get_cluster_lights(uint32_t cluster) const {
+        if (m_counts.empty())
+            return {};
+        return { m_indices.data() + static_cast<size_t>(cluster) * m_options.max_lights_per_cluster,
+                 m_counts.at(cluster) };
+    }
+
+} // namespace kat
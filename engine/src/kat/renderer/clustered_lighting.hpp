@@ -0,0 +1,136 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "compute_pipeline.hpp"
+#include "gpu_resources.hpp"
+#include "kat/utils/aabb.hpp"
+#include "kat/utils/job_system.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    // shader storage bindings used by the "kat/lights.glsl" include
+    constexpr unsigned int LIGHT_TABLE_BINDING = 14;
+    constexpr unsigned int LIGHT_GRID_BINDING  = 15;
+    constexpr unsigned int LIGHT_INDEX_BINDING = 16;
+
+    enum class LightType : uint32_t { Point, Spot };
+
+    struct Light {
+        LightType type      = LightType::Point;
+        glm::vec3 position  = { 0.0f, 0.0f, 0.0f };
+        glm::vec3 direction = { 0.0f, 0.0f, -1.0f }; // spot lights only, normalized
+        glm::vec3 color     = { 1.0f, 1.0f, 1.0f };
+        float     intensity = 1.0f;
+        float     range     = 10.0f; // no light reaches past this distance
+
+        // spot cone half angles in radians, the light fades out between the two
+        float inner_angle = 0.5f;
+        float outer_angle = 0.6f;
+    };
+
+    // std430 layout of KatLight. Point lights get a cone that covers every direction.
+    struct GpuLight {
+        glm::vec4 position_range;
+        glm::vec4 color_cos_inner; // color premultiplied by intensity
+        glm::vec4 direction_cos_outer;
+        glm::vec4 bounds; // world space bounding sphere, used for assignment only
+    };
+
+    static_assert(sizeof(GpuLight) == 64);
+
+    [[nodiscard]] GpuLight to_gpu_light(const Light &light);
+
+    struct ClusterOptions {
+        // tiles across and down the screen, depth slices between the near and far plane (exponentially spaced)
+        glm::uvec3 grid = { 16, 9, 24 };
+
+        // lights past this count in one cluster are dropped
+        uint32_t max_lights_per_cluster = 256;
+
+        // assignment in a compute shader, otherwise on the job system (or the calling thread without one)
+        bool gpu_assignment = true;
+    };
+
+    // Clustered forward shading: the view frustum is cut into a grid of froxels and every froxel gets the list of
+    // lights whose bounds touch it, so a fragment only loops over the lights near it. Shaders include
+    // "kat/lights.glsl" and call kat_shade_lights() (or walk kat_cluster_light() themselves) with gl_FragCoord.
+    //
+    // Lists live in fixed size slots of max_lights_per_cluster indices, which costs memory but needs no second
+    // pass to compact them. Only perspective projections are supported.
+    class ClusteredLighting {
+      public:
+        explicit ClusteredLighting(const std::shared_ptr<GpuResources> &resources, const ClusterOptions &options = {},
+                                   const std::shared_ptr<JobSystem> &job_system = nullptr);
+
+        ~ClusteredLighting();
+
+        ClusteredLighting(const ClusteredLighting &)            = delete;
+        ClusteredLighting &operator=(const ClusteredLighting &) = delete;
+
+        static std::shared_ptr<ClusteredLighting> create(const std::shared_ptr<GpuResources> &resources,
+                                                         const ClusterOptions                &options    = {},
+                                                         const std::shared_ptr<JobSystem>    &job_system = nullptr);
+
+        void set_lights(std::span<const Light> lights);
+
+        // Assigns lights to clusters for this camera. `near` and `far` must be the planes of `projection`.
+        void update(const glm::mat4 &view, const glm::mat4 &projection, float near, float far,
+                    const glm::uvec2 &viewport_size);
+
+        void bind() const;
+
+        [[nodiscard]] size_t get_light_count() const noexcept { return m_lights.size(); }
+
+        [[nodiscard]] uint32_t get_cluster_count() const noexcept {
+            return m_options.grid.x * m_options.grid.y * m_options.grid.z;
+        }
+
+        [[nodiscard]] const ClusterOptions &get_options() const noexcept { return m_options; }
+
+        // cluster of a pixel (from the bottom left, like gl_FragCoord) at a positive view space depth, the same one
+        // the include picks
+        [[nodiscard]] uint32_t get_cluster_index(const glm::vec2 &pixel, float view_depth) const;
+
+        // CPU assignment only: the lights of a cluster after the last update()
+        [[nodiscard]] std::span<const uint32_t> get_cluster_lights(uint32_t cluster) const;
+
+      private:
+        // std430 header of KatLightGrid, the per-cluster counts follow
+        struct GridHeader {
+            glm::uvec4 grid;  // x, y, z, max lights per cluster
+            glm::vec4  depth; // near, far, slice scale, slice bias
+            glm::vec4  tile;  // pixels per tile
+        };
+
+        void update_clusters(const glm::mat4 &projection);
+
+        void assign_cpu(const glm::mat4 &view);
+
+        void assign_gpu(const glm::mat4 &view, const glm::mat4 &projection);
+
+        std::shared_ptr<GpuResources> m_resources;
+        ClusterOptions                m_options;
+        std::shared_ptr<JobSystem>    m_job_system;
+
+        std::vector<GpuLight> m_lights;
+        GridHeader            m_header{};
+
+        // view space cluster bounds for the CPU path, rebuilt when the projection changes
+        std::vector<Aabb> m_clusters;
+        glm::mat4         m_cluster_projection = glm::mat4(0.0f);
+
+        std::vector<uint32_t> m_counts;
+        std::vector<uint32_t> m_indices;
+
+        Handle<Buffer>                   m_light_buffer;
+        Handle<Buffer>                   m_grid_buffer;
+        Handle<Buffer>                   m_index_buffer;
+        std::shared_ptr<ComputePipeline> m_assign_pipeline;
+    };
+
+} // namespace kat
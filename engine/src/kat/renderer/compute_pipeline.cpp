@@ -0,0 +1,159 @@
+#include "compute_pipeline.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace kat {
+    namespace {
+        // buffer and texture names are separate namespaces in GL
+        uint64_t buffer_key(const Buffer &buffer) { return buffer.get_handle(); }
+
+        uint64_t texture_key(const Texture &texture) { return uint64_t{ 1 } << 32 | texture.get_handle(); }
+    } // namespace
+
+    std::unordered_map<uint64_t, GLbitfield> &MemoryBarriers::writes() {
+        static std::unordered_map<uint64_t, GLbitfield> outstanding;
+        return outstanding;
+    }
+
+    void MemoryBarriers::record_write(const Buffer &buffer) { writes()[buffer_key(buffer)] = GL_ALL_BARRIER_BITS; }
+
+    void MemoryBarriers::record_write(const Texture &texture) {
+        writes()[texture_key(texture)] = GL_ALL_BARRIER_BITS;
+    }
+
+    GLbitfield MemoryBarriers::pending(const Buffer &buffer, GLbitfield bits) {
+        const auto it = writes().find(buffer_key(buffer));
+        return it == writes().end() ? 0 : it->second & bits;
+    }
+
+    GLbitfield MemoryBarriers::pending(const Texture &texture, GLbitfield bits) {
+        const auto it = writes().find(texture_key(texture));
+        return it == writes().end() ? 0 : it->second & bits;
+    }
+
+    void MemoryBarriers::require(const Buffer &buffer, GLbitfield bits) { issue(pending(buffer, bits)); }
+
+    void MemoryBarriers::require(const Texture &texture, GLbitfield bits) { issue(pending(texture, bits)); }
+
+    void MemoryBarriers::issue(GLbitfield bits) {
+        if (bits == 0)
+            return;
+
+        glMemoryBarrier(bits);
+
+        // a barrier covers every write before it, not just the resource that asked for it
+        auto &outstanding = writes();
+        for (auto it = outstanding.begin(); it != outstanding.end();) {
+            it->second &= ~bits;
+            it = it->second == 0 ? outstanding.erase(it) : std::next(it);
+        }
+    }
+
+    ComputePipeline::ComputePipeline(const std::string &source) :
+        m_shader(Shader::create({ { source, ShaderType::Compute } })),
+        m_work_group_size(m_shader->get_work_group_size()) {
+        if (m_work_group_size.x == 0)
+            throw std::runtime_error("Compute program failed to build or has no work group size");
+    }
+
+    std::shared_ptr<ComputePipeline> ComputePipeline::create(const std::string &source) {
+        return std::make_shared<ComputePipeline>(source);
+    }
+
+    void ComputePipeline::set_storage(uint32_t binding, const Buffer &buffer, ComputeAccess access) {
+        set({ .kind = Binding::Kind::Storage, .index = binding, .buffer = &buffer, .access = access });
+    }
+
+    void ComputePipeline::set_uniform_buffer(uint32_t binding, const Buffer &buffer) {
+        set({ .kind = Binding::Kind::Uniform, .index = binding, .buffer = &buffer });
+    }
+
+    void ComputePipeline::set_image(uint32_t unit, const Texture &texture, uint32_t level, ComputeAccess access,
+                                    TextureFormat format) {
+        set({ .kind    = Binding::Kind::Image,
+              .index   = unit,
+              .texture = &texture,
+              .level   = level,
+              .access  = access,
+              .format  = format });
+    }
+
+    void ComputePipeline::set_texture(uint32_t unit, const Texture &texture) {
+        set({ .kind = Binding::Kind::Texture, .index = unit, .texture = &texture });
+    }
+
+    void ComputePipeline::set(const Binding &binding) {
+        // every kind has its own binding points, storage block 0 and image unit 0 are unrelated
+        const auto it = std::ranges::find_if(
+            m_bindings, [&](const Binding &b) { return b.kind == binding.kind && b.index == binding.index; });
+        if (it != m_bindings.end())
+            *it = binding;
+        else
+            m_bindings.push_back(binding);
+    }
+
+    void ComputePipeline::begin(GLbitfield extra_barriers) const {
+        GLbitfield barriers = extra_barriers;
+        for (const Binding &b : m_bindings) {
+            switch (b.kind) {
+            case Binding::Kind::Storage:
+                b.buffer->bind_base(BufferTarget::ShaderStorage, b.index);
+                barriers |= MemoryBarriers::pending(*b.buffer, GL_SHADER_STORAGE_BARRIER_BIT);
+                break;
+            case Binding::Kind::Uniform:
+                b.buffer->bind_base(BufferTarget::Uniform, b.index);
+                barriers |= MemoryBarriers::pending(*b.buffer, GL_UNIFORM_BARRIER_BIT);
+                break;
+            case Binding::Kind::Image:
+                glBindImageTexture(b.index, b.texture->get_handle(), static_cast<GLint>(b.level), GL_TRUE, 0,
+                                   static_cast<GLenum>(b.access), static_cast<GLenum>(b.format));
+                barriers |= MemoryBarriers::pending(*b.texture, GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+                break;
+            case Binding::Kind::Texture:
+                b.texture->bind(b.index);
+                barriers |= MemoryBarriers::pending(*b.texture, GL_TEXTURE_FETCH_BARRIER_BIT);
+                break;
+            }
+        }
+
+        MemoryBarriers::issue(barriers);
+        m_shader->bind();
+    }
+
+    void ComputePipeline::end() const {
+        for (const Binding &b : m_bindings) {
+            if (b.access == ComputeAccess::ReadOnly)
+                continue;
+
+            if (b.buffer)
+                MemoryBarriers::record_write(*b.buffer);
+            else
+                MemoryBarriers::record_write(*b.texture);
+        }
+    }
+
+    void ComputePipeline::dispatch(uint32_t x, uint32_t y, uint32_t z) {
+        dispatch_groups((x + m_work_group_size.x - 1) / m_work_group_size.x,
+                        (y + m_work_group_size.y - 1) / m_work_group_size.y,
+                        (z + m_work_group_size.z - 1) / m_work_group_size.z);
+    }
+
+    void ComputePipeline::dispatch_groups(uint32_t x, uint32_t y, uint32_t z) {
+        if (x == 0 || y == 0 || z == 0)
+            return;
+
+        begin(0);
+        glDispatchCompute(x, y, z);
+        end();
+    }
+
+    void ComputePipeline::dispatch_indirect(const Buffer &arguments, size_t offset) {
+        begin(MemoryBarriers::pending(arguments, GL_COMMAND_BARRIER_BIT));
+        arguments.bind(BufferTarget::DispatchIndirect);
+        glDispatchComputeIndirect(static_cast<GLintptr>(offset));
+        end();
+    }
+
+} // namespace kat
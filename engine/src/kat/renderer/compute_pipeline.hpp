@@ -0,0 +1,117 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer.hpp"
+#include "shader.hpp"
+#include "texture.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    enum class ComputeAccess : GLenum {
+        ReadOnly  = GL_READ_ONLY,
+        WriteOnly = GL_WRITE_ONLY,
+        ReadWrite = GL_READ_WRITE,
+    };
+
+    // Tracks shader writes that later commands can't see yet. GL only makes incoherent writes (storage buffers,
+    // images) visible after a glMemoryBarrier with the bit of the way they are used next; recording writes and
+    // declaring uses lets the barriers be issued only when some use actually depends on an earlier write, with
+    // exactly the bits it needs. ComputePipeline does both on its own, code that consumes compute results elsewhere
+    // (indirect draws, vertex pulling, readbacks) calls require() first.
+    class MemoryBarriers {
+      public:
+        static void record_write(const Buffer &buffer);
+
+        static void record_write(const Texture &texture);
+
+        // `bits` are the GL_*_BARRIER_BIT of the coming use, only those still outstanding for it are issued
+        static void require(const Buffer &buffer, GLbitfield bits);
+
+        static void require(const Texture &texture, GLbitfield bits);
+
+        // the outstanding ones among `bits` without issuing them, to combine several uses into one barrier
+        [[nodiscard]] static GLbitfield pending(const Buffer &buffer, GLbitfield bits);
+
+        [[nodiscard]] static GLbitfield pending(const Texture &texture, GLbitfield bits);
+
+        // issues a barrier and marks its bits as done for every resource
+        static void issue(GLbitfield bits);
+
+      private:
+        static std::unordered_map<uint64_t, GLbitfield> &writes();
+    };
+
+    // A compute program with a table of the resources it binds. The table stays set between dispatches, so a
+    // pipeline that always works on the same buffers binds them once at creation. Every dispatch binds the table,
+    // waits for earlier shader writes to what it reads (see MemoryBarriers) and records what it writes.
+    //
+    // The table holds plain references, resources must outlive the dispatches that use them and be bound again
+    // when they are replaced.
+    class ComputePipeline {
+      public:
+        explicit ComputePipeline(const std::string &source);
+
+        ComputePipeline(const ComputePipeline &)            = delete;
+        ComputePipeline &operator=(const ComputePipeline &) = delete;
+
+        static std::shared_ptr<ComputePipeline> create(const std::string &source);
+
+        // for uniforms
+        [[nodiscard]] const Shader &get_shader() const noexcept { return *m_shader; }
+
+        // local_size_x/y/z of the shader
+        [[nodiscard]] glm::uvec3 get_work_group_size() const noexcept { return m_work_group_size; }
+
+        void set_storage(uint32_t binding, const Buffer &buffer, ComputeAccess access = ComputeAccess::ReadWrite);
+
+        void set_uniform_buffer(uint32_t binding, const Buffer &buffer);
+
+        void set_image(uint32_t unit, const Texture &texture, uint32_t level, ComputeAccess access,
+                       TextureFormat format);
+
+        // sampled through the texture's own sampler state
+        void set_texture(uint32_t unit, const Texture &texture);
+
+        void clear_bindings() noexcept { m_bindings.clear(); }
+
+        // enough work groups to cover this many invocations, a shader with local_size_x = 64 and a count of 100
+        // runs 2 groups and must check its index against the count itself
+        void dispatch(uint32_t x, uint32_t y = 1, uint32_t z = 1);
+
+        void dispatch_groups(uint32_t x, uint32_t y = 1, uint32_t z = 1);
+
+        // group counts read from three uints at `offset`, typically written by an earlier dispatch
+        void dispatch_indirect(const Buffer &arguments, size_t offset = 0);
+
+      private:
+        struct Binding {
+            enum class Kind : uint8_t { Storage, Uniform, Image, Texture };
+
+            Kind           kind;
+            uint32_t       index;
+            const Buffer  *buffer  = nullptr;
+            const Texture *texture = nullptr;
+            uint32_t       level   = 0;
+            ComputeAccess  access  = ComputeAccess::ReadOnly;
+            TextureFormat  format  = TextureFormat::R32F;
+        };
+
+        void set(const Binding &binding);
+
+        // binds the table and the program, waiting for the writes it depends on
+        void begin(GLbitfield extra_barriers) const;
+
+        void end() const;
+
+        std::shared_ptr<Shader> m_shader;
+        glm::uvec3              m_work_group_size;
+        std::vector<Binding>    m_bindings;
+    };
+
+} // namespace kat
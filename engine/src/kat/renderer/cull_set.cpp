@@ -0,0 +1,235 @@
+#include "cull_set.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+#include "kat/utils/simd.hpp"
+
+namespace kat {
+    namespace {
+        // big enough to amortise the job overhead, a multiple of 8 so chunks start on whole AVX2 groups
+        constexpr size_t OBJECTS_PER_JOB = 16384;
+
+#ifdef KAT_SIMD_AVX2
+        // lane indices of the set bits of every 8 bit mask, packed to the front
+        struct CompactTable {
+            alignas(32) std::array<std::array<uint32_t, 8>, 256> lanes{};
+
+            constexpr CompactTable() {
+                for (uint32_t mask = 0; mask < 256; mask++) {
+                    uint32_t n = 0;
+                    for (uint32_t lane = 0; lane < 8; lane++) {
+                        if (mask & (1u << lane))
+                            lanes[mask][n++] = lane;
+                    }
+                }
+            }
+        };
+
+        constexpr CompactTable COMPACT_TABLE;
+#endif
+    } // namespace
+
+    CullSet::CullSet(const std::shared_ptr<JobSystem> &job_system) : m_job_system(job_system) {}
+
+    std::shared_ptr<CullSet> CullSet::create(const std::shared_ptr<JobSystem> &job_system) {
+        return std::make_shared<CullSet>(job_system);
+    }
+
+    uint32_t CullSet::add_sphere(const glm::vec3 &center, float radius) {
+        const uint32_t id = allocate_id();
+        store(m_slots[id], center, glm::vec3(radius), radius);
+        return id;
+    }
+
+    uint32_t CullSet::add_aabb(const glm::vec3 &min, const glm::vec3 &max) {
+        const uint32_t  id      = allocate_id();
+        const glm::vec3 extents = (max - min) * 0.5f;
+        store(m_slots[id], (min + max) * 0.5f, extents, glm::length(extents));
+        return id;
+    }
+
+    void CullSet::set_sphere(uint32_t id, const glm::vec3 &center, float radius) {
+        store(m_slots.at(id), center, glm::vec3(radius), radius);
+    }
+
+    void CullSet::set_aabb(uint32_t id, const glm::vec3 &min, const glm::vec3 &max) {
+        const glm::vec3 extents = (max - min) * 0.5f;
+        store(m_slots.at(id), (min + max) * 0.5f, extents, glm::length(extents));
+    }
+
+    void CullSet::remove(uint32_t id) {
+        const uint32_t slot = m_slots.at(id);
+        const uint32_t last = static_cast<uint32_t>(m_ids.size() - 1);
+
+        // move the last object into the hole to keep the arrays dense
+        for (auto *array : arrays()) {
+            (*array)[slot] = array->back();
+            array->pop_back();
+        }
+
+        m_ids[slot]          = m_ids[last];
+        m_slots[m_ids[slot]] = slot;
+        m_ids.pop_back();
+
+        m_free.push_back(id);
+    }
+
+    uint32_t CullSet::allocate_id() {
+        uint32_t id;
+        if (!m_free.empty()) {
+            id = m_free.back();
+            m_free.pop_back();
+        } else {
+            id = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back(0);
+        }
+
+        m_slots[id] = static_cast<uint32_t>(m_ids.size());
+        m_ids.push_back(id);
+        for (auto *array : arrays()) {
+            array->push_back(0.0f);
+        }
+        return id;
+    }
+
+    void CullSet::store(uint32_t slot, const glm::vec3 &center, const glm::vec3 &extents, float radius) {
+        m_center_x[slot] = center.x;
+        m_center_y[slot] = center.y;
+        m_center_z[slot] = center.z;
+        m_extent_x[slot] = extents.x;
+        m_extent_y[slot] = extents.y;
+        m_extent_z[slot] = extents.z;
+        m_radius[slot]   = radius;
+    }
+
+    void CullSet::cull(const Frustum &frustum, std::vector<uint32_t> &visible) const {
+        const size_t count = m_ids.size();
+        visible.resize(count);
+
+        if (!m_job_system || count <= OBJECTS_PER_JOB) {
+            visible.resize(cull_range(frustum, 0, count, visible.data()));
+            return;
+        }
+
+        // every chunk compacts into the front of its own range of `visible`, then the ranges are joined
+        const size_t chunks = (count + OBJECTS_PER_JOB - 1) / OBJECTS_PER_JOB;
+        m_chunk_counts.resize(chunks);
+
+        m_job_system->parallel_for(count, OBJECTS_PER_JOB, [&](size_t begin, size_t end) {
+            m_chunk_counts[begin / OBJECTS_PER_JOB] = cull_range(frustum, begin, end, visible.data() + begin);
+        });
+
+        size_t total = m_chunk_counts[0];
+        for (size_t chunk = 1; chunk < chunks; chunk++) {
+            std::memmove(visible.data() + total, visible.data() + chunk * OBJECTS_PER_JOB,
+                         m_chunk_counts[chunk] * sizeof(uint32_t));
+            total += m_chunk_counts[chunk];
+        }
+        visible.resize(total);
+    }
+
+    size_t CullSet::cull_range(const Frustum &frustum, size_t begin, size_t end, uint32_t *out) const {
+        size_t n = 0;
+        size_t i = begin;
+
+        // Per plane: the center's distance d and the box's projected radius |n.x| ex + |n.y| ey + |n.z| ez. The
+        // object is outside when d < -min(box radius, sphere radius).
+#ifdef KAT_SIMD_AVX2
+        {
+            __m256 nx[6], ny[6], nz[6], nw[6], ax[6], ay[6], az[6];
+            for (int p = 0; p < 6; p++) {
+                const glm::vec4 &plane = frustum.planes[p];
+                nx[p]                  = _mm256_set1_ps(plane.x);
+                ny[p]                  = _mm256_set1_ps(plane.y);
+                nz[p]                  = _mm256_set1_ps(plane.z);
+                nw[p]                  = _mm256_set1_ps(plane.w);
+                ax[p]                  = _mm256_set1_ps(std::abs(plane.x));
+                ay[p]                  = _mm256_set1_ps(std::abs(plane.y));
+                az[p]                  = _mm256_set1_ps(std::abs(plane.z));
+            }
+
+            // n never passes i, so the 8 wide store stays inside [begin, i + 8)
+            for (; i + 8 <= end; i += 8) {
+                const __m256 cx = _mm256_loadu_ps(m_center_x.data() + i);
+                const __m256 cy = _mm256_loadu_ps(m_center_y.data() + i);
+                const __m256 cz = _mm256_loadu_ps(m_center_z.data() + i);
+                const __m256 ex = _mm256_loadu_ps(m_extent_x.data() + i);
+                const __m256 ey = _mm256_loadu_ps(m_extent_y.data() + i);
+                const __m256 ez = _mm256_loadu_ps(m_extent_z.data() + i);
+                const __m256 r  = _mm256_loadu_ps(m_radius.data() + i);
+
+                __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+                for (int p = 0; p < 6; p++) {
+                    const __m256 d =
+                        _mm256_fmadd_ps(nx[p], cx, _mm256_fmadd_ps(ny[p], cy, _mm256_fmadd_ps(nz[p], cz, nw[p])));
+                    const __m256 br =
+                        _mm256_fmadd_ps(ax[p], ex, _mm256_fmadd_ps(ay[p], ey, _mm256_mul_ps(az[p], ez)));
+                    const __m256 distance = _mm256_add_ps(d, _mm256_min_ps(br, r));
+                    inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+                }
+
+                const auto    mask  = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+                const __m256i ids   = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(m_ids.data() + i));
+                const __m256i lanes =
+                    _mm256_load_si256(reinterpret_cast<const __m256i *>(COMPACT_TABLE.lanes[mask].data()));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + n), _mm256_permutevar8x32_epi32(ids, lanes));
+                n += static_cast<size_t>(std::popcount(mask));
+            }
+        }
+#endif
+#ifdef KAT_SIMD_SSE2
+        {
+            const __m128 sign = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+            for (; i + 4 <= end; i += 4) {
+                const __m128 cx = _mm_loadu_ps(m_center_x.data() + i);
+                const __m128 cy = _mm_loadu_ps(m_center_y.data() + i);
+                const __m128 cz = _mm_loadu_ps(m_center_z.data() + i);
+                const __m128 ex = _mm_loadu_ps(m_extent_x.data() + i);
+                const __m128 ey = _mm_loadu_ps(m_extent_y.data() + i);
+                const __m128 ez = _mm_loadu_ps(m_extent_z.data() + i);
+                const __m128 r  = _mm_loadu_ps(m_radius.data() + i);
+
+                __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                for (const auto &plane : frustum.planes) {
+                    const __m128 px = _mm_set1_ps(plane.x);
+                    const __m128 py = _mm_set1_ps(plane.y);
+                    const __m128 pz = _mm_set1_ps(plane.z);
+
+                    const __m128 d  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)),
+                                                 _mm_add_ps(_mm_mul_ps(pz, cz), _mm_set1_ps(plane.w)));
+                    const __m128 br = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(px, sign), ex),
+                                                            _mm_mul_ps(_mm_and_ps(py, sign), ey)),
+                                                 _mm_mul_ps(_mm_and_ps(pz, sign), ez));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, _mm_min_ps(br, r)), _mm_setzero_ps()));
+                }
+
+                for (auto mask = static_cast<uint32_t>(_mm_movemask_ps(inside)); mask != 0; mask &= mask - 1) {
+                    out[n++] = m_ids[i + static_cast<size_t>(std::countr_zero(mask))];
+                }
+            }
+        }
+#endif
+        for (; i < end; i++) {
+            bool inside = true;
+            for (const auto &plane : frustum.planes) {
+                const float d  = plane.x * m_center_x[i] + plane.y * m_center_y[i] + plane.z * m_center_z[i] + plane.w;
+                const float br = std::abs(plane.x) * m_extent_x[i] + std::abs(plane.y) * m_extent_y[i] +
+                                 std::abs(plane.z) * m_extent_z[i];
+                if (d + std::min(br, m_radius[i]) < 0.0f) {
+                    inside = false;
+                    break;
+                }
+            }
+
+            if (inside)
+                out[n++] = m_ids[i];
+        }
+
+        return n;
+    }
+
+} // namespace kat
@@ -0,0 +1,129 @@
+#include "destruction_queue.hpp"
+
+#include <algorithm>
+#include <glad/wgl.h>
+#include <stdexcept>
+
+namespace kat {
+
+    DestructionQueue &DestructionQueue::get() {
+        // never destroyed, GL wrappers living in statics may still enqueue during static destruction
+        static DestructionQueue *queue = new DestructionQueue();
+        return *queue;
+    }
+
+    void DestructionQueue::enqueue(GpuObjectType type, unsigned int name) {
+        if (name == 0)
+            return;
+
+        const Context context = wglGetCurrentContext();
+
+        std::lock_guard lock(m_mutex);
+        m_enqueued[context][static_cast<size_t>(type)].push_back(name);
+    }
+
+    void DestructionQueue::end_frame() {
+        const Context context = wglGetCurrentContext();
+        if (!context)
+            return;
+
+        Names names;
+        {
+            std::lock_guard lock(m_mutex);
+            take(context, names);
+            take(nullptr, names);
+        }
+
+        // objects released during this frame may be used by any of its commands
+        if (std::ranges::any_of(names, [](const auto &type) { return !type.empty(); }))
+            m_batches.push_back({ context, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), std::move(names) });
+
+        retire(context, false);
+    }
+
+    void DestructionQueue::flush() {
+        const Context context = wglGetCurrentContext();
+        if (!context)
+            return;
+
+        Names names;
+        {
+            std::lock_guard lock(m_mutex);
+            take(context, names);
+        }
+        destroy(names);
+        retire(context, true);
+    }
+
+    size_t DestructionQueue::get_pending_count() {
+        size_t count = 0;
+
+        std::lock_guard lock(m_mutex);
+        for (const auto &[context, names] : m_enqueued) {
+            for (const auto &type : names) {
+                count += type.size();
+            }
+        }
+        for (const Batch &batch : m_batches) {
+            for (const auto &type : batch.names) {
+                count += type.size();
+            }
+        }
+        return count;
+    }
+
+    void DestructionQueue::take(Context context, Names &names) {
+        const auto it = m_enqueued.find(context);
+        if (it == m_enqueued.end())
+            return;
+
+        for (size_t type = 0; type < TYPE_COUNT; type++) {
+            names[type].insert(names[type].end(), it->second[type].begin(), it->second[type].end());
+        }
+        m_enqueued.erase(it);
+    }
+
+    void DestructionQueue::retire(Context context, bool wait) {
+        // the context's batches signal in order, the first one still pending ends the walk
+        for (auto it = m_batches.begin(); it != m_batches.end();) {
+            if (it->context != context) {
+                ++it;
+                continue;
+            }
+
+            const GLuint64 timeout = wait ? GL_TIMEOUT_IGNORED : 0;
+            const GLenum   status  = glClientWaitSync(it->sync, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+            if (status == GL_TIMEOUT_EXPIRED)
+                return;
+            if (status == GL_WAIT_FAILED)
+                throw std::runtime_error("glClientWaitSync failed on destruction queue fence");
+
+            glDeleteSync(it->sync);
+            destroy(it->names);
+            it = m_batches.erase(it);
+        }
+    }
+
+    void DestructionQueue::destroy(Names &names) {
+        const auto &buffers       = names[static_cast<size_t>(GpuObjectType::Buffer)];
+        const auto &vertex_arrays = names[static_cast<size_t>(GpuObjectType::VertexArray)];
+
+        if (!buffers.empty())
+            glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+        if (!vertex_arrays.empty())
+            glDeleteVertexArrays(static_cast<GLsizei>(vertex_arrays.size()), vertex_arrays.data());
+
+        // shaders and programs have no batched delete
+        for (const unsigned int shader : names[static_cast<size_t>(GpuObjectType::Shader)]) {
+            glDeleteShader(shader);
+        }
+        for (const unsigned int program : names[static_cast<size_t>(GpuObjectType::Program)]) {
+            glDeleteProgram(program);
+        }
+
+        for (auto &type : names) {
+            type.clear();
+        }
+    }
+
+} // namespace kat
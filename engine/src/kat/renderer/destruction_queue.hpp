@@ -0,0 +1,74 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "kat/engine.hpp"
+
+namespace kat {
+
+    enum class GpuObjectType : uint8_t {
+        Buffer,
+        VertexArray,
+        Shader,
+        Program,
+    };
+
+    // GL objects whose owners are gone. Destructors only hand their names over, from any thread and without touching
+    // GL; the GL thread fences everything handed over during a frame at end_frame() and deletes it in one call per
+    // type once that fence signals, so nothing is deleted while a submitted frame may still use it.
+    //
+    // Names belong to the context current on the thread that enqueued them and are only deleted while it is current,
+    // contexts don't share objects. Names enqueued without a current context go to the next one that ends a frame.
+    class DestructionQueue {
+      public:
+        DestructionQueue(const DestructionQueue &)            = delete;
+        DestructionQueue &operator=(const DestructionQueue &) = delete;
+
+        // the queue the GL wrappers' destructors use
+        static DestructionQueue &get();
+
+        // Thread safe, no GL calls. Ignores the null name.
+        void enqueue(GpuObjectType type, unsigned int name);
+
+        // GL thread, after submitting a frame. Handles the current context's names, does nothing without one.
+        void end_frame();
+
+        // GL thread. Waits for the current context's fences and deletes all of its names, before it goes away.
+        void flush();
+
+        // GL thread, objects enqueued or fenced but not deleted yet
+        [[nodiscard]] size_t get_pending_count();
+
+      private:
+        static constexpr size_t TYPE_COUNT = 4;
+
+        using Names   = std::array<std::vector<unsigned int>, TYPE_COUNT>;
+        using Context = void *; // HGLRC, null for names enqueued without a context
+
+        struct Batch {
+            Context context;
+            GLsync  sync;
+            Names   names;
+        };
+
+        DestructionQueue() = default;
+
+        // moves the names enqueued for `context` into `names`, expects m_mutex to be held
+        void take(Context context, Names &names);
+
+        // deletes the context's batches whose fence has signalled, optionally blocking on all of them
+        void retire(Context context, bool wait);
+
+        static void destroy(Names &names);
+
+        std::mutex                         m_mutex;
+        std::unordered_map<Context, Names> m_enqueued; // since each context's last end_frame, guarded by m_mutex
+
+        std::deque<Batch> m_batches; // GL thread only, oldest first
+    };
+
+} // namespace kat
@@ -0,0 +1,468 @@
+#include "frame_graph.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace kat {
+    namespace {
+        // the barrier a reader needs after a shader wrote a resource with image/storage stores
+        GLbitfield texture_barrier(TextureAccess access) {
+            switch (access) {
+            case TextureAccess::Sampled:
+                return GL_TEXTURE_FETCH_BARRIER_BIT;
+            case TextureAccess::Storage:
+                return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+            default:
+                return GL_FRAMEBUFFER_BARRIER_BIT;
+            }
+        }
+
+        GLbitfield buffer_barrier(BufferAccess access) {
+            switch (access) {
+            case BufferAccess::Indirect:
+                return GL_COMMAND_BARRIER_BIT;
+            case BufferAccess::Uniform:
+                return GL_UNIFORM_BARRIER_BIT;
+            case BufferAccess::Vertex:
+                return GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT;
+            default:
+                return GL_SHADER_STORAGE_BARRIER_BIT;
+            }
+        }
+
+        bool is_incoherent(TextureAccess access) { return access == TextureAccess::Storage; }
+
+        bool is_incoherent(BufferAccess access) { return access == BufferAccess::Storage; }
+
+        template <typename Use>
+        bool writes(const std::vector<Use> &uses, uint32_t resource) {
+            return std::ranges::any_of(uses, [&](const Use &use) { return use.write && use.resource == resource; });
+        }
+    } // namespace
+
+    FrameGraphTexture FrameGraphBuilder::create_texture(const std::string &name, const FrameTextureDesc &desc) {
+        m_graph.m_textures.push_back({ .name = name, .desc = desc });
+        return { static_cast<uint32_t>(m_graph.m_textures.size() - 1) };
+    }
+
+    FrameGraphBuffer FrameGraphBuilder::create_buffer(const std::string &name, const FrameBufferDesc &desc) {
+        m_graph.m_buffers.push_back({ .name = name, .desc = desc });
+        return { static_cast<uint32_t>(m_graph.m_buffers.size() - 1) };
+    }
+
+    FrameGraphTexture FrameGraphBuilder::read(FrameGraphTexture texture, TextureAccess access) {
+        m_graph.m_passes[m_pass].textures.push_back({ texture.index, access, false });
+        return texture;
+    }
+
+    FrameGraphBuffer FrameGraphBuilder::read(FrameGraphBuffer buffer, BufferAccess access) {
+        m_graph.m_passes[m_pass].buffers.push_back({ buffer.index, access, false });
+        return buffer;
+    }
+
+    FrameGraphTexture FrameGraphBuilder::write_color(FrameGraphTexture texture, std::optional<color> clear,
+                                                     uint32_t level) {
+        auto &pass = m_graph.m_passes[m_pass];
+        pass.textures.push_back({ texture.index, TextureAccess::ColorAttachment, true });
+        pass.attachments.push_back({ texture.index, level, false, clear, std::nullopt });
+        return texture;
+    }
+
+    FrameGraphTexture FrameGraphBuilder::write_depth(FrameGraphTexture texture, std::optional<float> clear,
+                                                     uint32_t level) {
+        auto &pass = m_graph.m_passes[m_pass];
+        pass.textures.push_back({ texture.index, TextureAccess::DepthAttachment, true });
+        pass.attachments.push_back({ texture.index, level, true, std::nullopt, clear });
+        return texture;
+    }
+
+    FrameGraphTexture FrameGraphBuilder::write_storage(FrameGraphTexture texture) {
+        m_graph.m_passes[m_pass].textures.push_back({ texture.index, TextureAccess::Storage, true });
+        return texture;
+    }
+
+    FrameGraphBuffer FrameGraphBuilder::write(FrameGraphBuffer buffer) {
+        m_graph.m_passes[m_pass].buffers.push_back({ buffer.index, BufferAccess::Storage, true });
+        return buffer;
+    }
+
+    void FrameGraphBuilder::side_effect() { m_graph.m_passes[m_pass].side_effect = true; }
+
+    Texture2D &FrameGraphResources::get_texture(FrameGraphTexture texture) const {
+        const auto &resource = m_graph.m_textures.at(texture.index);
+        if (!resource.texture)
+            throw std::runtime_error("frame graph texture '" + resource.name + "' is not used by any pass that runs");
+        return *resource.texture;
+    }
+
+    Buffer &FrameGraphResources::get_buffer(FrameGraphBuffer buffer) const {
+        const auto &resource = m_graph.m_buffers.at(buffer.index);
+        if (resource.buffer.is_null())
+            throw std::runtime_error("frame graph buffer '" + resource.name + "' is not used by any pass that runs");
+        return m_graph.m_resources->get(resource.buffer);
+    }
+
+    const FrameTextureDesc &FrameGraphResources::get_desc(FrameGraphTexture texture) const {
+        return m_graph.m_textures.at(texture.index).desc;
+    }
+
+    FrameGraph::~FrameGraph() {
+        for (const PooledBuffer &pooled : m_buffer_pool) {
+            m_resources->destroy(pooled.buffer);
+        }
+    }
+
+    std::shared_ptr<FrameGraph> FrameGraph::create(const std::shared_ptr<GpuResources> &resources) {
+        return std::make_shared<FrameGraph>(resources);
+    }
+
+    FrameGraphTexture FrameGraph::import_texture(const std::string &name, const std::shared_ptr<Texture2D> &texture) {
+        const FrameTextureDesc desc = { texture->get_width(), texture->get_height(), texture->get_format(),
+                                        texture->get_levels() };
+        m_textures.push_back({ .name = name, .desc = desc, .texture = texture, .imported = true });
+        return { static_cast<uint32_t>(m_textures.size() - 1) };
+    }
+
+    FrameGraphBuffer FrameGraph::import_buffer(const std::string &name, Handle<Buffer> buffer) {
+        const size_t size = m_resources->get(buffer).get_size();
+        m_buffers.push_back({ .name = name, .desc = { size }, .buffer = buffer, .imported = true });
+        return { static_cast<uint32_t>(m_buffers.size() - 1) };
+    }
+
+    void FrameGraph::compile() {
+        m_frame++;
+
+        cull_passes();
+        evict_idle();
+        assign_resources();
+        compute_barriers();
+
+        m_compiled = true;
+    }
+
+    void FrameGraph::cull_passes() {
+        // reference counting as in Frostbite's frame graph: a pass counts the resources it writes, a resource the
+        // passes that read it. Resources nobody reads release their writers, culled passes release what they read.
+        // Reading what the pass writes itself (read-modify-write) doesn't keep it alive.
+        std::vector<uint32_t> pass_refs(m_passes.size(), 0);
+        std::vector<uint32_t> texture_refs(m_textures.size(), 0);
+        std::vector<uint32_t> buffer_refs(m_buffers.size(), 0);
+
+        std::vector<std::vector<uint32_t>> texture_writers(m_textures.size());
+        std::vector<std::vector<uint32_t>> buffer_writers(m_buffers.size());
+
+        for (uint32_t p = 0; p < m_passes.size(); p++) {
+            Pass &pass  = m_passes[p];
+            pass.culled = false;
+
+            for (const auto &use : pass.textures) {
+                if (use.write) {
+                    pass_refs[p]++;
+                    texture_writers[use.resource].push_back(p);
+                    pass.side_effect |= m_textures[use.resource].imported;
+                } else if (!writes(pass.textures, use.resource)) {
+                    texture_refs[use.resource]++;
+                }
+            }
+            for (const auto &use : pass.buffers) {
+                if (use.write) {
+                    pass_refs[p]++;
+                    buffer_writers[use.resource].push_back(p);
+                    pass.side_effect |= m_buffers[use.resource].imported;
+                } else if (!writes(pass.buffers, use.resource)) {
+                    buffer_refs[use.resource]++;
+                }
+            }
+        }
+
+        std::vector<uint32_t> unused_textures;
+        std::vector<uint32_t> unused_buffers;
+
+        const auto cull = [&](uint32_t p) {
+            Pass &pass  = m_passes[p];
+            pass.culled = true;
+
+            for (const auto &use : pass.textures) {
+                if (!use.write && !writes(pass.textures, use.resource) && --texture_refs[use.resource] == 0)
+                    unused_textures.push_back(use.resource);
+            }
+            for (const auto &use : pass.buffers) {
+                if (!use.write && !writes(pass.buffers, use.resource) && --buffer_refs[use.resource] == 0)
+                    unused_buffers.push_back(use.resource);
+            }
+        };
+
+        const auto release = [&](const std::vector<uint32_t> &writers) {
+            for (const uint32_t p : writers) {
+                if (!m_passes[p].side_effect && !m_passes[p].culled && --pass_refs[p] == 0)
+                    cull(p);
+            }
+        };
+
+        // unread resources first, culling passes that write nothing pushes whatever only they read
+        for (uint32_t t = 0; t < m_textures.size(); t++) {
+            if (texture_refs[t] == 0)
+                unused_textures.push_back(t);
+        }
+        for (uint32_t b = 0; b < m_buffers.size(); b++) {
+            if (buffer_refs[b] == 0)
+                unused_buffers.push_back(b);
+        }
+        for (uint32_t p = 0; p < m_passes.size(); p++) {
+            if (pass_refs[p] == 0 && !m_passes[p].side_effect)
+                cull(p);
+        }
+
+        while (!unused_textures.empty() || !unused_buffers.empty()) {
+            if (!unused_textures.empty()) {
+                const uint32_t t = unused_textures.back();
+                unused_textures.pop_back();
+                release(texture_writers[t]);
+            } else {
+                const uint32_t b = unused_buffers.back();
+                unused_buffers.pop_back();
+                release(buffer_writers[b]);
+            }
+        }
+
+        m_culled_count = static_cast<size_t>(std::ranges::count_if(m_passes, &Pass::culled));
+    }
+
+    void FrameGraph::evict_idle() {
+        std::erase_if(m_texture_pool,
+                      [&](const PooledTexture &pooled) { return m_frame - pooled.last_frame > m_max_idle_frames; });
+        std::erase_if(m_buffer_pool, [&](const PooledBuffer &pooled) {
+            const bool idle = m_frame - pooled.last_frame > m_max_idle_frames;
+            if (idle)
+                m_resources->destroy(pooled.buffer);
+            return idle;
+        });
+
+        // Cached framebuffers keep their textures alive. One whose textures were evicted, resized or are no longer
+        // imported isn't bound anymore and goes the same way, which also keeps the GL names in the keys unique.
+        std::erase_if(m_framebuffers, [&](const CachedFramebuffer &cached) {
+            return m_frame - cached.last_frame > m_max_idle_frames;
+        });
+    }
+
+    void FrameGraph::assign_resources() {
+        constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+        std::vector<glm::uvec2> texture_lifetimes(m_textures.size(), glm::uvec2(NONE, 0));
+        std::vector<glm::uvec2> buffer_lifetimes(m_buffers.size(), glm::uvec2(NONE, 0));
+
+        for (uint32_t p = 0; p < m_passes.size(); p++) {
+            if (m_passes[p].culled)
+                continue;
+
+            for (const auto &use : m_passes[p].textures) {
+                auto &lifetime = texture_lifetimes[use.resource];
+                lifetime       = { std::min(lifetime.x, p), p };
+            }
+            for (const auto &use : m_passes[p].buffers) {
+                auto &lifetime = buffer_lifetimes[use.resource];
+                lifetime       = { std::min(lifetime.x, p), p };
+            }
+        }
+
+        std::vector<bool> textures_in_use(m_texture_pool.size(), false);
+        std::vector<bool> buffers_in_use(m_buffer_pool.size(), false);
+
+        // walking the passes in order hands a pooled object to the next resource once its last user is done
+        for (uint32_t p = 0; p < m_passes.size(); p++) {
+            for (uint32_t t = 0; t < m_textures.size(); t++) {
+                TextureResource &resource = m_textures[t];
+                if (!resource.imported && texture_lifetimes[t].x == p) {
+                    resource.pooled  = acquire_texture(resource.desc, textures_in_use);
+                    resource.texture = m_texture_pool[resource.pooled].texture;
+                }
+            }
+            for (uint32_t b = 0; b < m_buffers.size(); b++) {
+                BufferResource &resource = m_buffers[b];
+                if (!resource.imported && buffer_lifetimes[b].x == p) {
+                    resource.pooled = acquire_buffer(resource.desc.size, buffers_in_use);
+                    resource.buffer = m_buffer_pool[resource.pooled].buffer;
+                }
+            }
+
+            for (uint32_t t = 0; t < m_textures.size(); t++) {
+                if (m_textures[t].pooled != INVALID_FRAME_RESOURCE && texture_lifetimes[t].y == p)
+                    textures_in_use[m_textures[t].pooled] = false;
+            }
+            for (uint32_t b = 0; b < m_buffers.size(); b++) {
+                if (m_buffers[b].pooled != INVALID_FRAME_RESOURCE && buffer_lifetimes[b].y == p)
+                    buffers_in_use[m_buffers[b].pooled] = false;
+            }
+        }
+    }
+
+    uint32_t FrameGraph::acquire_texture(const FrameTextureDesc &desc, std::vector<bool> &in_use) {
+        for (uint32_t i = 0; i < m_texture_pool.size(); i++) {
+            if (!in_use[i] && m_texture_pool[i].desc == desc) {
+                in_use[i]                    = true;
+                m_texture_pool[i].last_frame = m_frame;
+                return i;
+            }
+        }
+
+        const TextureFilter min_filter = desc.levels > 1 ? TextureFilter::LinearMipmapLinear : TextureFilter::Linear;
+
+        auto texture = Texture2D::create(desc.width, desc.height, desc.format, desc.levels);
+        texture->set_sampler({ .min_filter = min_filter,
+                               .mag_filter = TextureFilter::Linear,
+                               .wrap_s     = TextureWrap::ClampToEdge,
+                               .wrap_t     = TextureWrap::ClampToEdge });
+
+        m_texture_pool.push_back({ desc, std::move(texture), m_frame });
+        in_use.push_back(true);
+        return static_cast<uint32_t>(m_texture_pool.size() - 1);
+    }
+
+    uint32_t FrameGraph::acquire_buffer(size_t size, std::vector<bool> &in_use) {
+        // the smallest free buffer that is large enough
+        uint32_t best = INVALID_FRAME_RESOURCE;
+        for (uint32_t i = 0; i < m_buffer_pool.size(); i++) {
+            if (!in_use[i] && m_buffer_pool[i].size >= size &&
+                (best == INVALID_FRAME_RESOURCE || m_buffer_pool[i].size < m_buffer_pool[best].size))
+                best = i;
+        }
+
+        if (best == INVALID_FRAME_RESOURCE) {
+            const Handle<Buffer> buffer = m_resources->create_buffer(nullptr, size, BufferUsage::DynamicCopy);
+            m_buffer_pool.push_back({ size, buffer, m_frame });
+            in_use.push_back(false);
+            best = static_cast<uint32_t>(m_buffer_pool.size() - 1);
+        }
+
+        in_use[best]                   = true;
+        m_buffer_pool[best].last_frame = m_frame;
+        return best;
+    }
+
+    void FrameGraph::compute_barriers() {
+        // Barrier bits still owed per resource: all of them right after a storage write, each cleared once a reader
+        // issued it. Storage writes are the only incoherent ones, attachment writes are ordered by GL itself.
+        std::vector<GLbitfield> texture_pending(m_textures.size(), 0);
+        std::vector<GLbitfield> buffer_pending(m_buffers.size(), 0);
+
+        for (auto &pass : m_passes) {
+            pass.barriers = 0;
+            if (pass.culled)
+                continue;
+
+            for (const auto &use : pass.textures) {
+                const GLbitfield bits = texture_barrier(use.access) & texture_pending[use.resource];
+                pass.barriers |= bits;
+                texture_pending[use.resource] &= ~bits;
+            }
+            for (const auto &use : pass.buffers) {
+                const GLbitfield bits = buffer_barrier(use.access) & buffer_pending[use.resource];
+                pass.barriers |= bits;
+                buffer_pending[use.resource] &= ~bits;
+            }
+
+            for (const auto &use : pass.textures) {
+                if (use.write)
+                    texture_pending[use.resource] = is_incoherent(use.access) ? GL_ALL_BARRIER_BITS : 0;
+            }
+            for (const auto &use : pass.buffers) {
+                if (use.write)
+                    buffer_pending[use.resource] = is_incoherent(use.access) ? GL_ALL_BARRIER_BITS : 0;
+            }
+        }
+    }
+
+    void FrameGraph::execute() {
+        if (!m_compiled)
+            compile();
+
+        const FrameGraphResources resources(*this);
+
+        // attachments set their own viewport, the default framebuffer gets the caller's back
+        glm::ivec4 viewport;
+        glGetIntegerv(GL_VIEWPORT, &viewport.x);
+
+        for (const auto &pass : m_passes) {
+            if (pass.culled)
+                continue;
+
+            glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, pass.name.c_str());
+
+            if (pass.barriers != 0)
+                glMemoryBarrier(pass.barriers);
+
+            bind_attachments(pass, viewport);
+            pass.execute(resources);
+
+            glPopDebugGroup();
+        }
+
+        Framebuffer::bind_default();
+        glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+    }
+
+    void FrameGraph::reset() {
+        m_passes.clear();
+        m_textures.clear();
+        m_buffers.clear();
+        m_compiled     = false;
+        m_culled_count = 0;
+    }
+
+    void FrameGraph::bind_attachments(const Pass &pass, const glm::ivec4 &viewport) {
+        if (pass.attachments.empty()) {
+            Framebuffer::bind_default();
+            glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+            return;
+        }
+
+        std::vector<glm::uvec2> key;
+        key.reserve(pass.attachments.size());
+        for (const auto &attachment : pass.attachments) {
+            key.emplace_back(m_textures[attachment.texture].texture->get_handle(), attachment.level);
+        }
+
+        auto entry = std::ranges::find(m_framebuffers, key, &CachedFramebuffer::key);
+        if (entry == m_framebuffers.end()) {
+            auto framebuffer = Framebuffer::create();
+
+            uint32_t color_index = 0;
+            for (const auto &attachment : pass.attachments) {
+                const auto &texture = m_textures[attachment.texture].texture;
+                if (attachment.depth)
+                    framebuffer->attach_depth(texture, attachment.level);
+                else
+                    framebuffer->attach_color(color_index++, texture, attachment.level);
+            }
+
+            try {
+                framebuffer->check();
+            }
+            catch (const std::runtime_error &e) {
+                throw std::runtime_error("Pass '" + pass.name + "': " + e.what());
+            }
+
+            m_framebuffers.push_back({ std::move(key), std::move(framebuffer) });
+            entry = m_framebuffers.end() - 1;
+        }
+
+        entry->last_frame = m_frame;
+
+        const Framebuffer &framebuffer = *entry->framebuffer;
+        framebuffer.bind();
+
+        uint32_t color_index = 0;
+        for (const auto &attachment : pass.attachments) {
+            if (attachment.depth) {
+                if (attachment.clear_depth)
+                    framebuffer.clear_depth(*attachment.clear_depth);
+            } else {
+                if (attachment.clear_color)
+                    framebuffer.clear_color(color_index, *attachment.clear_color);
+                color_index++;
+            }
+        }
+    }
+
+} // namespace kat
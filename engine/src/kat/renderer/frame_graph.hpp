@@ -0,0 +1,265 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "framebuffer.hpp"
+#include "gpu_resources.hpp"
+#include "texture.hpp"
+#include "kat/utils/color.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    struct FrameTextureDesc {
+        uint32_t      width;
+        uint32_t      height;
+        TextureFormat format;
+        uint32_t      levels = 1;
+
+        friend bool operator==(const FrameTextureDesc &, const FrameTextureDesc &) = default;
+    };
+
+    struct FrameBufferDesc {
+        size_t size;
+    };
+
+    // How a pass touches a resource. Decides the barriers in front of later passes and which textures get attached
+    // to the pass's framebuffer.
+    enum class TextureAccess { Sampled, Storage, ColorAttachment, DepthAttachment };
+
+    enum class BufferAccess { Storage, Indirect, Uniform, Vertex };
+
+    constexpr uint32_t INVALID_FRAME_RESOURCE = 0xFFFFFFFF;
+
+    struct FrameGraphTexture {
+        uint32_t index = INVALID_FRAME_RESOURCE;
+
+        [[nodiscard]] bool is_valid() const noexcept { return index != INVALID_FRAME_RESOURCE; }
+    };
+
+    struct FrameGraphBuffer {
+        uint32_t index = INVALID_FRAME_RESOURCE;
+
+        [[nodiscard]] bool is_valid() const noexcept { return index != INVALID_FRAME_RESOURCE; }
+    };
+
+    class FrameGraph;
+
+    // Handed to a pass's setup callback to declare what it reads and writes.
+    class FrameGraphBuilder {
+      public:
+        // Transient resources only exist while passes use them, their memory is shared with other transient
+        // resources of the same description whose lifetimes don't overlap.
+        FrameGraphTexture create_texture(const std::string &name, const FrameTextureDesc &desc);
+
+        FrameGraphBuffer create_buffer(const std::string &name, const FrameBufferDesc &desc);
+
+        FrameGraphTexture read(FrameGraphTexture texture, TextureAccess access = TextureAccess::Sampled);
+
+        FrameGraphBuffer read(FrameGraphBuffer buffer, BufferAccess access = BufferAccess::Storage);
+
+        // attachments are bound in declaration order, with an optional clear before the pass runs
+        FrameGraphTexture write_color(FrameGraphTexture texture, std::optional<color> clear = std::nullopt,
+                                      uint32_t level = 0);
+
+        FrameGraphTexture write_depth(FrameGraphTexture texture, std::optional<float> clear = std::nullopt,
+                                      uint32_t level = 0);
+
+        // image store from a shader
+        FrameGraphTexture write_storage(FrameGraphTexture texture);
+
+        FrameGraphBuffer write(FrameGraphBuffer buffer);
+
+        // The pass does something outside the graph (e.g. draws to the window), it is never culled.
+        void side_effect();
+
+      private:
+        friend class FrameGraph;
+
+        FrameGraphBuilder(FrameGraph &graph, uint32_t pass) : m_graph(graph), m_pass(pass) {}
+
+        FrameGraph &m_graph;
+        uint32_t    m_pass;
+    };
+
+    // Handed to a pass's execute callback, resolves handles to the GL objects of this frame.
+    class FrameGraphResources {
+      public:
+        [[nodiscard]] Texture2D &get_texture(FrameGraphTexture texture) const;
+
+        [[nodiscard]] Buffer &get_buffer(FrameGraphBuffer buffer) const;
+
+        [[nodiscard]] const FrameTextureDesc &get_desc(FrameGraphTexture texture) const;
+
+      private:
+        friend class FrameGraph;
+
+        explicit FrameGraphResources(const FrameGraph &graph) : m_graph(graph) {}
+
+        const FrameGraph &m_graph;
+    };
+
+    // Declarative description of a frame. Every frame passes are added again with add_pass(), then execute()
+    // compiles the graph:
+    //   - passes whose results nobody reads are culled (a pass is kept if it has side effects, writes an imported
+    //     resource, or writes something a kept pass reads),
+    //   - transient textures and buffers are assigned pooled GL objects, a pooled object is reused by another
+    //     resource as soon as the previous one's last pass is done and is freed after a few idle frames,
+    //   - glMemoryBarrier bits are derived from how a resource was last written and how it is read next.
+    // Passes run in the order they were added. A pass with attachments runs with a framebuffer of those attachments
+    // bound and the viewport set to their size, any other pass with the default framebuffer.
+    class FrameGraph {
+      public:
+        explicit FrameGraph(const std::shared_ptr<GpuResources> &resources) : m_resources(resources) {}
+
+        ~FrameGraph();
+
+        FrameGraph(const FrameGraph &)            = delete;
+        FrameGraph &operator=(const FrameGraph &) = delete;
+
+        static std::shared_ptr<FrameGraph> create(const std::shared_ptr<GpuResources> &resources);
+
+        // `Data` holds the handles the pass declares in setup and uses in execute.
+        template <typename Data>
+        const Data &add_pass(const std::string &name, const std::function<void(FrameGraphBuilder &, Data &)> &setup,
+                             std::function<void(const Data &, const FrameGraphResources &)> execute) {
+            auto data = std::make_shared<Data>();
+
+            const auto        index = static_cast<uint32_t>(m_passes.size());
+            FrameGraphBuilder builder(*this, index);
+            m_passes.push_back({ .name = name });
+
+            setup(builder, *data);
+            m_passes[index].execute = [data, execute = std::move(execute)](const FrameGraphResources &resources) {
+                execute(*data, resources);
+            };
+            return *data;
+        }
+
+        // Imported resources live outside the graph, they are never aliased and writing them keeps a pass alive.
+        FrameGraphTexture import_texture(const std::string &name, const std::shared_ptr<Texture2D> &texture);
+
+        // `buffer` has to live in the graph's GpuResources
+        FrameGraphBuffer import_buffer(const std::string &name, Handle<Buffer> buffer);
+
+        // Culls passes, assigns pooled objects and barriers. Called by execute() if needed.
+        void compile();
+
+        void execute();
+
+        // drops this frame's passes and resources, pooled objects stay for the next frame
+        void reset();
+
+        // frames a pooled object or cached framebuffer may stay unused before it is freed
+        void set_max_idle_frames(uint32_t frames) { m_max_idle_frames = frames; }
+
+        [[nodiscard]] size_t get_pass_count() const noexcept { return m_passes.size(); }
+
+        [[nodiscard]] size_t get_culled_pass_count() const noexcept { return m_culled_count; }
+
+        // GL objects behind all transient resources, at most the number of transient resources
+        [[nodiscard]] size_t get_pooled_texture_count() const noexcept { return m_texture_pool.size(); }
+
+        [[nodiscard]] size_t get_pooled_buffer_count() const noexcept { return m_buffer_pool.size(); }
+
+      private:
+        friend class FrameGraphBuilder;
+        friend class FrameGraphResources;
+
+        struct Attachment {
+            uint32_t             texture;
+            uint32_t             level;
+            bool                 depth;
+            std::optional<color> clear_color;
+            std::optional<float> clear_depth;
+        };
+
+        template <typename Access>
+        struct Use {
+            uint32_t resource;
+            Access   access;
+            bool     write;
+        };
+
+        struct Pass {
+            std::string                                      name;
+            std::function<void(const FrameGraphResources &)> execute;
+            std::vector<Use<TextureAccess>>                  textures;
+            std::vector<Use<BufferAccess>>                   buffers;
+            std::vector<Attachment>                          attachments;
+            bool                                             side_effect = false;
+            bool                                             culled      = false;
+            GLbitfield                                       barriers    = 0;
+        };
+
+        struct TextureResource {
+            std::string                name;
+            FrameTextureDesc           desc;
+            std::shared_ptr<Texture2D> texture; // imported, or the pooled texture while compiled
+            bool                       imported = false;
+            uint32_t                   pooled   = INVALID_FRAME_RESOURCE;
+        };
+
+        struct BufferResource {
+            std::string     name;
+            FrameBufferDesc desc;
+            Handle<Buffer>  buffer; // imported, or the pooled buffer while compiled
+            bool            imported = false;
+            uint32_t        pooled   = INVALID_FRAME_RESOURCE;
+        };
+
+        struct PooledTexture {
+            FrameTextureDesc           desc;
+            std::shared_ptr<Texture2D> texture;
+            uint64_t                   last_frame = 0;
+        };
+
+        struct PooledBuffer {
+            size_t         size;
+            Handle<Buffer> buffer;
+            uint64_t       last_frame = 0;
+        };
+
+        struct CachedFramebuffer {
+            std::vector<glm::uvec2>      key; // (texture handle, level) per attachment
+            std::shared_ptr<Framebuffer> framebuffer;
+            uint64_t                     last_frame = 0;
+        };
+
+        void cull_passes();
+
+        void assign_resources();
+
+        void compute_barriers();
+
+        // index of a free pooled object matching the resource, creating one if there is none
+        uint32_t acquire_texture(const FrameTextureDesc &desc, std::vector<bool> &in_use);
+
+        uint32_t acquire_buffer(size_t size, std::vector<bool> &in_use);
+
+        void evict_idle();
+
+        // passes without attachments draw to the default framebuffer with `viewport`
+        void bind_attachments(const Pass &pass, const glm::ivec4 &viewport);
+
+        std::shared_ptr<GpuResources> m_resources;
+
+        std::vector<Pass>            m_passes;
+        std::vector<TextureResource> m_textures;
+        std::vector<BufferResource>  m_buffers;
+        bool                         m_compiled     = false;
+        size_t                       m_culled_count = 0;
+
+        std::vector<PooledTexture>     m_texture_pool;
+        std::vector<PooledBuffer>      m_buffer_pool;
+        std::vector<CachedFramebuffer> m_framebuffers;
+        uint64_t                       m_frame           = 0;
+        uint32_t                       m_max_idle_frames = 3;
+    };
+
+} // namespace kat
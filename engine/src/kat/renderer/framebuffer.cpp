@@ -0,0 +1,170 @@
+#include "framebuffer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace kat {
+    namespace {
+        GLenum depth_attachment_point(TextureFormat format) {
+            return format == TextureFormat::Depth24Stencil8 ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+        }
+
+        glm::uvec2 level_size(const Texture2D &texture, uint32_t level) {
+            return { std::max(texture.get_width() >> level, 1u), std::max(texture.get_height() >> level, 1u) };
+        }
+    } // namespace
+
+    bool is_depth_format(TextureFormat format) {
+        return format == TextureFormat::Depth24Stencil8 || format == TextureFormat::Depth32F;
+    }
+
+    RenderTarget::RenderTarget(const RenderTargetDesc &desc) : m_desc(desc) {
+        if (desc.size.x == 0 || desc.size.y == 0)
+            throw std::runtime_error("Cannot create an empty render target");
+
+        if (desc.samples > 1) {
+            glCreateRenderbuffers(1, &m_renderbuffer);
+            glNamedRenderbufferStorageMultisample(m_renderbuffer, static_cast<GLsizei>(desc.samples),
+                                                  static_cast<GLenum>(desc.format), static_cast<GLsizei>(desc.size.x),
+                                                  static_cast<GLsizei>(desc.size.y));
+            return;
+        }
+
+        m_texture = Texture2D::create(desc.size.x, desc.size.y, desc.format, 1);
+        m_texture->set_sampler({ .min_filter = TextureFilter::Linear,
+                                 .mag_filter = TextureFilter::Linear,
+                                 .wrap_s     = TextureWrap::ClampToEdge,
+                                 .wrap_t     = TextureWrap::ClampToEdge });
+    }
+
+    RenderTarget::~RenderTarget() {
+        if (m_renderbuffer != 0)
+            glDeleteRenderbuffers(1, &m_renderbuffer);
+    }
+
+    std::shared_ptr<RenderTarget> RenderTarget::create(const RenderTargetDesc &desc) {
+        return std::make_shared<RenderTarget>(desc);
+    }
+
+    Framebuffer::Framebuffer() { glCreateFramebuffers(1, &m_framebuffer); }
+
+    Framebuffer::~Framebuffer() { glDeleteFramebuffers(1, &m_framebuffer); }
+
+    std::shared_ptr<Framebuffer> Framebuffer::create() { return std::make_shared<Framebuffer>(); }
+
+    void Framebuffer::attach_color(uint32_t index, const std::shared_ptr<RenderTarget> &target) {
+        if (m_colors.size() <= index)
+            m_colors.resize(index + 1);
+
+        attach(GL_COLOR_ATTACHMENT0 + index, m_colors[index], target, nullptr, 0);
+        update_draw_buffers();
+    }
+
+    void Framebuffer::attach_color(uint32_t index, const std::shared_ptr<Texture2D> &texture, uint32_t level) {
+        if (m_colors.size() <= index)
+            m_colors.resize(index + 1);
+
+        attach(GL_COLOR_ATTACHMENT0 + index, m_colors[index], nullptr, texture, level);
+        update_draw_buffers();
+    }
+
+    void Framebuffer::attach_depth(const std::shared_ptr<RenderTarget> &target) {
+        const TextureFormat format = target ? target->get_desc().format : TextureFormat::Depth32F;
+
+        // switching between depth and depth-stencil must not leave the old attachment point behind
+        glNamedFramebufferRenderbuffer(m_framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, 0);
+        attach(depth_attachment_point(format), m_depth, target, nullptr, 0);
+    }
+
+    void Framebuffer::attach_depth(const std::shared_ptr<Texture2D> &texture, uint32_t level) {
+        const TextureFormat format = texture ? texture->get_format() : TextureFormat::Depth32F;
+
+        glNamedFramebufferRenderbuffer(m_framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, 0);
+        attach(depth_attachment_point(format), m_depth, nullptr, texture, level);
+    }
+
+    void Framebuffer::attach(GLenum point, Slot &slot, const std::shared_ptr<RenderTarget> &target,
+                             const std::shared_ptr<Texture2D> &texture, uint32_t level) {
+        slot = { target, texture };
+
+        if (target && target->is_multisampled()) {
+            glNamedFramebufferRenderbuffer(m_framebuffer, point, GL_RENDERBUFFER, target->get_renderbuffer());
+            m_size    = target->get_size();
+            m_samples = target->get_desc().samples;
+            return;
+        }
+
+        const Texture2D *attached = target ? target->get_texture().get() : texture.get();
+        if (!attached) {
+            glNamedFramebufferTexture(m_framebuffer, point, 0, 0);
+            return;
+        }
+
+        glNamedFramebufferTexture(m_framebuffer, point, attached->get_handle(), static_cast<GLint>(level));
+        m_size    = level_size(*attached, level);
+        m_samples = 1;
+    }
+
+    void Framebuffer::update_draw_buffers() const {
+        std::vector<GLenum> buffers(m_colors.size(), GL_NONE);
+        GLenum              read_buffer = GL_NONE;
+        for (size_t i = 0; i < m_colors.size(); i++) {
+            if (!m_colors[i].target && !m_colors[i].texture)
+                continue;
+
+            buffers[i] = GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(i);
+            if (read_buffer == GL_NONE)
+                read_buffer = buffers[i];
+        }
+
+        // blits read from the first color attachment
+        glNamedFramebufferReadBuffer(m_framebuffer, read_buffer);
+        if (read_buffer == GL_NONE)
+            glNamedFramebufferDrawBuffer(m_framebuffer, GL_NONE);
+        else
+            glNamedFramebufferDrawBuffers(m_framebuffer, static_cast<GLsizei>(buffers.size()), buffers.data());
+    }
+
+    void Framebuffer::check() const {
+        const GLenum status = glCheckNamedFramebufferStatus(m_framebuffer, GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+            throw std::runtime_error("Incomplete framebuffer, status " + std::to_string(status));
+    }
+
+    void Framebuffer::bind() const {
+        glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+        glViewport(0, 0, static_cast<GLsizei>(m_size.x), static_cast<GLsizei>(m_size.y));
+    }
+
+    void Framebuffer::bind_default() { glBindFramebuffer(GL_FRAMEBUFFER, 0); }
+
+    void Framebuffer::clear_color(uint32_t index, const color &value) const {
+        glClearNamedFramebufferfv(m_framebuffer, GL_COLOR, static_cast<GLint>(index), &value.r);
+    }
+
+    void Framebuffer::clear_depth(float depth, int stencil) const {
+        const TextureFormat format = m_depth.target    ? m_depth.target->get_desc().format
+                                     : m_depth.texture ? m_depth.texture->get_format()
+                                                       : TextureFormat::Depth32F;
+
+        if (format == TextureFormat::Depth24Stencil8)
+            glClearNamedFramebufferfi(m_framebuffer, GL_DEPTH_STENCIL, 0, depth, stencil);
+        else
+            glClearNamedFramebufferfv(m_framebuffer, GL_DEPTH, 0, &depth);
+    }
+
+    void Framebuffer::blit(const Framebuffer &target, GLbitfield mask, GLenum filter) const {
+        glBlitNamedFramebuffer(m_framebuffer, target.m_framebuffer, 0, 0, static_cast<GLint>(m_size.x),
+                               static_cast<GLint>(m_size.y), 0, 0, static_cast<GLint>(target.m_size.x),
+                               static_cast<GLint>(target.m_size.y), mask, filter);
+    }
+
+    void Framebuffer::blit_to_default(const glm::ivec2 &position, const glm::uvec2 &size, GLbitfield mask,
+                                      GLenum filter) const {
+        glBlitNamedFramebuffer(m_framebuffer, 0, 0, 0, static_cast<GLint>(m_size.x), static_cast<GLint>(m_size.y),
+                               position.x, position.y, position.x + static_cast<GLint>(size.x),
+                               position.y + static_cast<GLint>(size.y), mask, filter);
+    }
+
+} // namespace kat
@@ -0,0 +1,129 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "texture.hpp"
+#include "kat/utils/color.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    struct RenderTargetDesc {
+        glm::uvec2    size;
+        TextureFormat format;
+        uint32_t      samples = 1;
+
+        friend bool operator==(const RenderTargetDesc &, const RenderTargetDesc &) = default;
+    };
+
+    [[nodiscard]] bool is_depth_format(TextureFormat format);
+
+    // Storage for one framebuffer attachment. Single sampled targets are textures so later passes can sample them,
+    // multisampled ones are renderbuffers that are only ever resolved.
+    class RenderTarget {
+      public:
+        explicit RenderTarget(const RenderTargetDesc &desc);
+
+        ~RenderTarget();
+
+        RenderTarget(const RenderTarget &)            = delete;
+        RenderTarget &operator=(const RenderTarget &) = delete;
+
+        static std::shared_ptr<RenderTarget> create(const RenderTargetDesc &desc);
+
+        [[nodiscard]] const RenderTargetDesc &get_desc() const noexcept { return m_desc; }
+
+        [[nodiscard]] glm::uvec2 get_size() const noexcept { return m_desc.size; }
+
+        [[nodiscard]] bool is_multisampled() const noexcept { return m_desc.samples > 1; }
+
+        [[nodiscard]] bool is_depth() const noexcept { return is_depth_format(m_desc.format); }
+
+        // null for multisampled targets
+        [[nodiscard]] const std::shared_ptr<Texture2D> &get_texture() const noexcept { return m_texture; }
+
+        // 0 for single sampled targets
+        [[nodiscard]] unsigned int get_renderbuffer() const noexcept { return m_renderbuffer; }
+
+      private:
+        RenderTargetDesc           m_desc;
+        std::shared_ptr<Texture2D> m_texture;
+        unsigned int               m_renderbuffer = 0;
+    };
+
+    // Framebuffer object. Attachments are kept alive while attached; every attachment must have the same size and
+    // sample count, check() reports anything else GL rejects.
+    class Framebuffer {
+      public:
+        Framebuffer();
+
+        ~Framebuffer();
+
+        Framebuffer(const Framebuffer &)            = delete;
+        Framebuffer &operator=(const Framebuffer &) = delete;
+
+        static std::shared_ptr<Framebuffer> create();
+
+        // Null detaches. Color attachments are drawn to in index order.
+        void attach_color(uint32_t index, const std::shared_ptr<RenderTarget> &target);
+
+        void attach_color(uint32_t index, const std::shared_ptr<Texture2D> &texture, uint32_t level = 0);
+
+        void attach_depth(const std::shared_ptr<RenderTarget> &target);
+
+        void attach_depth(const std::shared_ptr<Texture2D> &texture, uint32_t level = 0);
+
+        // throws if the attachments don't form a complete framebuffer
+        void check() const;
+
+        // binds and sets the viewport to the attachment size
+        void bind() const;
+
+        static void bind_default();
+
+        void clear_color(uint32_t index, const color &value) const;
+
+        // the stencil value is only written for depth-stencil formats
+        void clear_depth(float depth = 1.0f, int stencil = 0) const;
+
+        // Copies (and resolves, when this one is multisampled) into `target`, scaling if the sizes differ. Depth and
+        // stencil can only be copied between equal sizes with a nearest filter.
+        void blit(const Framebuffer &target, GLbitfield mask = GL_COLOR_BUFFER_BIT, GLenum filter = GL_NEAREST) const;
+
+        void blit_to_default(const glm::ivec2 &position, const glm::uvec2 &size, GLbitfield mask = GL_COLOR_BUFFER_BIT,
+                             GLenum filter = GL_LINEAR) const;
+
+        [[nodiscard]] unsigned int get_handle() const noexcept { return m_framebuffer; }
+
+        // size of the attachments, zero while nothing is attached
+        [[nodiscard]] glm::uvec2 get_size() const noexcept { return m_size; }
+
+        [[nodiscard]] uint32_t get_samples() const noexcept { return m_samples; }
+
+        [[nodiscard]] const std::shared_ptr<RenderTarget> &get_color(uint32_t index) const {
+            return m_colors.at(index).target;
+        }
+
+        [[nodiscard]] const std::shared_ptr<RenderTarget> &get_depth() const noexcept { return m_depth.target; }
+
+      private:
+        struct Slot {
+            std::shared_ptr<RenderTarget> target;
+            std::shared_ptr<Texture2D>    texture; // attached without a RenderTarget
+        };
+
+        void attach(GLenum point, Slot &slot, const std::shared_ptr<RenderTarget> &target,
+                    const std::shared_ptr<Texture2D> &texture, uint32_t level);
+
+        void update_draw_buffers() const;
+
+        unsigned int      m_framebuffer = 0;
+        std::vector<Slot> m_colors;
+        Slot              m_depth;
+        glm::uvec2        m_size    = { 0, 0 };
+        uint32_t          m_samples = 1;
+    };
+
+} // namespace kat
@@ -0,0 +1,50 @@
+#include "gpu_resources.hpp"
+
+namespace kat {
+
+    std::shared_ptr<GpuResources> GpuResources::create() {
+        return std::make_shared<GpuResources>();
+    }
+
+    Handle<Buffer> GpuResources::create_buffer() {
+        return m_buffers.emplace();
+    }
+
+    Handle<Buffer> GpuResources::create_buffer(const void *data, size_t size, BufferUsage usage) {
+        return m_buffers.emplace(data, size, usage);
+    }
+
+    Handle<VertexArray> GpuResources::create_vertex_array() {
+        return m_vertex_arrays.emplace();
+    }
+
+    Handle<ShaderModule> GpuResources::create_shader_module(const std::string &source, ShaderType type) {
+        return m_shader_modules.emplace(source, type);
+    }
+
+    Handle<Shader> GpuResources::create_shader(std::span<const Handle<ShaderModule>> modules) {
+        std::vector<const ShaderModule *> pointers;
+        for (const Handle<ShaderModule> module : modules) {
+            pointers.push_back(&m_shader_modules.at(module));
+        }
+        return m_shaders.emplace(std::span<const ShaderModule *const>(pointers));
+    }
+
+    Handle<Shader> GpuResources::create_shader(const std::vector<std::pair<std::string, ShaderType>> &modules) {
+        std::vector<std::shared_ptr<ShaderModule>> compiled;
+        for (const auto &[source, type] : modules) {
+            compiled.push_back(ShaderModule::create(source, type));
+        }
+        return m_shaders.emplace(compiled);
+    }
+
+    void GpuResources::end_frame() {
+        // the destructors only enqueue the GL names, the queue holds them until this frame's fence signals
+        m_buffers.collect(m_frame);
+        m_vertex_arrays.collect(m_frame);
+        m_shader_modules.collect(m_frame);
+        m_shaders.collect(m_frame);
+        m_frame++;
+    }
+
+} // namespace kat
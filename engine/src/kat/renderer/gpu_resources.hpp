@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "buffer.hpp"
+#include "shader.hpp"
+#include "vertex_array.hpp"
+#include "kat/utils/handle_pool.hpp"
+
+namespace kat {
+
+    // Buffers, vertex arrays and shaders owned by pools and referred to by Handle instead of shared_ptr: lookups are
+    // an index and a generation check, nothing is reference counted, and the objects of one type sit together in
+    // memory. destroy() takes effect for lookups right away, the object itself lives until end_frame() so references
+    // taken earlier in the frame stay valid, and its GL object then goes through the DestructionQueue.
+    class GpuResources {
+      public:
+        GpuResources() = default;
+
+        GpuResources(const GpuResources &)            = delete;
+        GpuResources &operator=(const GpuResources &) = delete;
+
+        static std::shared_ptr<GpuResources> create();
+
+        Handle<Buffer> create_buffer();
+
+        Handle<Buffer> create_buffer(const void *data, size_t size, BufferUsage usage = BufferUsage::DynamicDraw);
+
+        template <std::ranges::contiguous_range T>
+        Handle<Buffer> create_buffer(const T &range, BufferUsage usage = BufferUsage::DynamicDraw) {
+            return m_buffers.emplace(range, usage);
+        }
+
+        Handle<VertexArray> create_vertex_array();
+
+        Handle<ShaderModule> create_shader_module(const std::string &source, ShaderType type);
+
+        Handle<Shader> create_shader(std::span<const Handle<ShaderModule>> modules);
+
+        // compiles the modules just for this program
+        Handle<Shader> create_shader(const std::vector<std::pair<std::string, ShaderType>> &modules);
+
+        // throws for stale handles
+        template <typename T>
+        [[nodiscard]] T &get(Handle<T> handle) const {
+            return pool<T>().at(handle);
+        }
+
+        template <typename T>
+        [[nodiscard]] bool contains(Handle<T> handle) const noexcept {
+            return pool<T>().contains(handle);
+        }
+
+        template <typename T>
+        void destroy(Handle<T> handle) {
+            pool<T>().release(handle, m_frame);
+        }
+
+        // Call once per frame after its commands were submitted, before DestructionQueue::end_frame().
+        void end_frame();
+
+        [[nodiscard]] uint64_t get_frame() const noexcept { return m_frame; }
+
+      private:
+        template <typename T>
+        [[nodiscard]] HandlePool<T> &pool() const noexcept {
+            if constexpr (std::is_same_v<T, Buffer>)
+                return m_buffers;
+            else if constexpr (std::is_same_v<T, VertexArray>)
+                return m_vertex_arrays;
+            else if constexpr (std::is_same_v<T, ShaderModule>)
+                return m_shader_modules;
+            else
+                return m_shaders;
+        }
+
+        // mutable so that const lookups can hand out the pooled objects, like shared_ptr does
+        mutable HandlePool<Buffer>       m_buffers;
+        mutable HandlePool<VertexArray>  m_vertex_arrays;
+        mutable HandlePool<ShaderModule> m_shader_modules;
+        mutable HandlePool<Shader>       m_shaders;
+
+        uint64_t m_frame = 0;
+    };
+
+} // namespace kat
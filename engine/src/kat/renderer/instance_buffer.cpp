@@ -0,0 +1,37 @@
+#include "instance_buffer.hpp"
+
+namespace kat {
+
+    InstanceBuffer::InstanceBuffer(InstanceLayout layout, size_t stream_size) :
+        m_layout(std::move(layout)), m_stream(StreamBuffer::create(stream_size)) {
+        if (m_layout.stride == 0)
+            throw std::runtime_error("Instance layout needs a stride");
+    }
+
+    std::shared_ptr<InstanceBuffer> InstanceBuffer::create(InstanceLayout layout, size_t stream_size) {
+        return std::make_shared<InstanceBuffer>(std::move(layout), stream_size);
+    }
+
+    std::span<std::byte> InstanceBuffer::allocate(size_t count) {
+        const size_t first = m_data.size();
+        m_data.resize(first + count * m_layout.stride);
+        return std::span(m_data).subspan(first);
+    }
+
+    void InstanceBuffer::upload() {
+        // every draw of the previous upload has been issued by now
+        m_stream->fence();
+
+        m_count  = static_cast<uint32_t>(m_data.size() / m_layout.stride);
+        m_offset = 0;
+        if (m_count > 0) {
+            // vertex buffer offsets only need to be aligned to the attribute types
+            const auto allocation = m_stream->allocate(m_data.size(), 16);
+            std::memcpy(allocation.data, m_data.data(), m_data.size());
+            m_offset = allocation.offset;
+        }
+
+        m_data.clear();
+    }
+
+} // namespace kat
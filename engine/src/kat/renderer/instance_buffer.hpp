@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "stream_buffer.hpp"
+#include "vertex_array.hpp"
+
+namespace kat {
+
+    // Per-instance attributes as seen by the vertex shader, in locations after the mesh's own.
+    struct InstanceLayout {
+        std::vector<VertexAttribute> attributes;
+        size_t                       stride;
+
+        friend bool operator==(const InstanceLayout &lhs, const InstanceLayout &rhs) = default;
+    };
+
+    // Per-instance data that is refilled every frame. Instances are collected on the CPU and copied into a
+    // persistently mapped stream buffer by upload(); Mesh::render_instanced reads the last upload.
+    class InstanceBuffer {
+      public:
+        explicit InstanceBuffer(InstanceLayout layout, size_t stream_size = 16 * 1024 * 1024);
+
+        static std::shared_ptr<InstanceBuffer> create(InstanceLayout layout, size_t stream_size = 16 * 1024 * 1024);
+
+        // T must match the layout's stride
+        template <typename T>
+        void push(const T &instance) {
+            if (sizeof(T) != m_layout.stride)
+                throw std::runtime_error("Instance type does not match the layout stride");
+            std::memcpy(allocate(1).data(), &instance, sizeof(T));
+        }
+
+        // room for `count` instances, valid until the next call on the buffer
+        [[nodiscard]] std::span<std::byte> allocate(size_t count);
+
+        // Makes the instances pushed since the last upload the ones drawn, and starts an empty set.
+        void upload();
+
+        [[nodiscard]] const InstanceLayout &get_layout() const noexcept { return m_layout; }
+
+        // instances of the last upload
+        [[nodiscard]] uint32_t get_count() const noexcept { return m_count; }
+
+        [[nodiscard]] unsigned int get_handle() const noexcept { return m_stream->get_handle(); }
+
+        // byte offset of the last upload in the buffer
+        [[nodiscard]] size_t get_offset() const noexcept { return m_offset; }
+
+      private:
+        InstanceLayout                m_layout;
+        std::shared_ptr<StreamBuffer> m_stream;
+        std::vector<std::byte>        m_data;
+
+        uint32_t m_count  = 0;
+        size_t   m_offset = 0;
+    };
+
+} // namespace kat
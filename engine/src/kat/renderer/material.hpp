@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+
+#include "kat/utils/color.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    enum class AlphaMode { Opaque, Mask, Blend };
+
+    // Metallic-roughness material parameters. Texture slots are indices into the owning asset's image list, -1 when
+    // the slot is unused.
+    struct Material {
+        std::string name;
+
+        color     base_color_factor  = colors::WHITE;
+        float     metallic_factor    = 1.0f;
+        float     roughness_factor   = 1.0f;
+        glm::vec3 emissive_factor    = { 0.0f, 0.0f, 0.0f };
+        float     normal_scale       = 1.0f;
+        float     occlusion_strength = 1.0f;
+
+        AlphaMode alpha_mode   = AlphaMode::Opaque;
+        float     alpha_cutoff = 0.5f;
+        bool      double_sided = false;
+
+        int base_color_texture         = -1;
+        int metallic_roughness_texture = -1;
+        int normal_texture             = -1;
+        int occlusion_texture          = -1;
+        int emissive_texture           = -1;
+    };
+
+} // namespace kat
@@ -0,0 +1,114 @@
+#include "material_table.hpp"
+
+#include <string>
+
+#include "shader.hpp"
+#include "texture_registry.hpp"
+
+namespace kat {
+    namespace {
+        uint32_t texture_slot(int image, std::span<const uint32_t> textures) {
+            if (image < 0 || static_cast<size_t>(image) >= textures.size())
+                return NO_TEXTURE;
+            return textures[image];
+        }
+    } // namespace
+
+    GpuMaterial to_gpu_material(const Material &material, std::span<const uint32_t> textures) {
+        GpuMaterial gpu{};
+        gpu.base_color         = { material.base_color_factor.r, material.base_color_factor.g,
+                                   material.base_color_factor.b, material.base_color_factor.a };
+        gpu.emissive           = material.emissive_factor;
+        gpu.normal_scale       = material.normal_scale;
+        gpu.metallic           = material.metallic_factor;
+        gpu.roughness          = material.roughness_factor;
+        gpu.occlusion_strength = material.occlusion_strength;
+        gpu.alpha_cutoff       = material.alpha_cutoff;
+
+        gpu.base_color_texture         = texture_slot(material.base_color_texture, textures);
+        gpu.metallic_roughness_texture = texture_slot(material.metallic_roughness_texture, textures);
+        gpu.normal_texture             = texture_slot(material.normal_texture, textures);
+        gpu.occlusion_texture          = texture_slot(material.occlusion_texture, textures);
+        gpu.emissive_texture           = texture_slot(material.emissive_texture, textures);
+
+        if (material.alpha_mode == AlphaMode::Mask)
+            gpu.flags |= static_cast<uint32_t>(MaterialFlag::AlphaMask);
+        else if (material.alpha_mode == AlphaMode::Blend)
+            gpu.flags |= static_cast<uint32_t>(MaterialFlag::AlphaBlend);
+        if (material.double_sided)
+            gpu.flags |= static_cast<uint32_t>(MaterialFlag::DoubleSided);
+
+        return gpu;
+    }
+
+    MaterialTable::MaterialTable(const std::shared_ptr<GpuResources> &resources) :
+        m_resources(resources), m_buffer(resources->create_buffer()) {
+        ShaderModule::register_include("kat/materials.glsl",
+                                       "struct KatMaterial {\n"
+                                       "    vec4  base_color;\n"
+                                       "    vec3  emissive;\n"
+                                       "    float normal_scale;\n"
+                                       "    float metallic;\n"
+                                       "    float roughness;\n"
+                                       "    float occlusion_strength;\n"
+                                       "    float alpha_cutoff;\n"
+                                       "    uint  base_color_texture;\n"
+                                       "    uint  metallic_roughness_texture;\n"
+                                       "    uint  normal_texture;\n"
+                                       "    uint  occlusion_texture;\n"
+                                       "    uint  emissive_texture;\n"
+                                       "    uint  flags;\n"
+                                       "    uint  padding0;\n"
+                                       "    uint  padding1;\n"
+                                       "};\n"
+                                       "const uint KAT_MATERIAL_ALPHA_MASK = 1u;\n"
+                                       "const uint KAT_MATERIAL_ALPHA_BLEND = 2u;\n"
+                                       "const uint KAT_MATERIAL_DOUBLE_SIDED = 4u;\n"
+                                       "layout(std430, binding = " +
+                                           std::to_string(MATERIAL_TABLE_BINDING) +
+                                           ") readonly buffer KatMaterialTable {\n"
+                                           "    KatMaterial kat_materials[];\n"
+                                           "};\n");
+    }
+
+    MaterialTable::~MaterialTable() {
+        m_resources->destroy(m_buffer);
+    }
+
+    std::shared_ptr<MaterialTable> MaterialTable::create(const std::shared_ptr<GpuResources> &resources) {
+        return std::make_shared<MaterialTable>(resources);
+    }
+
+    uint32_t MaterialTable::add(const GpuMaterial &material) {
+        m_materials.push_back(material);
+        m_dirty = true;
+        return static_cast<uint32_t>(m_materials.size() - 1);
+    }
+
+    uint32_t MaterialTable::add(const Material &material, std::span<const uint32_t> textures) {
+        return add(to_gpu_material(material, textures));
+    }
+
+    void MaterialTable::set(uint32_t id, const GpuMaterial &material) {
+        m_materials.at(id) = material;
+        m_dirty            = true;
+    }
+
+    void MaterialTable::update() {
+        if (!m_dirty)
+            return;
+
+        // an empty storage buffer can't be bound, keep a default material around
+        Buffer &buffer = m_resources->get(m_buffer);
+        if (m_materials.empty())
+            buffer.set(std::vector<GpuMaterial>{ to_gpu_material({}, {}) }, BufferUsage::DynamicDraw);
+        else
+            buffer.set(m_materials, BufferUsage::DynamicDraw);
+        m_dirty = false;
+    }
+
+    void MaterialTable::bind() const {
+        m_resources->get(m_buffer).bind_base(BufferTarget::ShaderStorage, MATERIAL_TABLE_BINDING);
+    }
+
+} // namespace kat
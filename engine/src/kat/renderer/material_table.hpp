@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "gpu_resources.hpp"
+#include "material.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    // shader storage binding of the material table, see the "kat/materials.glsl" include
+    constexpr unsigned int MATERIAL_TABLE_BINDING = 9;
+
+    // bits of GpuMaterial::flags
+    enum class MaterialFlag : uint32_t {
+        AlphaMask   = 1 << 0,
+        AlphaBlend  = 1 << 1,
+        DoubleSided = 1 << 2,
+    };
+
+    // std430 layout of KatMaterial. Texture slots are TextureRegistry indices or NO_TEXTURE.
+    struct GpuMaterial {
+        glm::vec4 base_color;
+        glm::vec3 emissive;
+        float     normal_scale;
+        float     metallic;
+        float     roughness;
+        float     occlusion_strength;
+        float     alpha_cutoff;
+        uint32_t  base_color_texture;
+        uint32_t  metallic_roughness_texture;
+        uint32_t  normal_texture;
+        uint32_t  occlusion_texture;
+        uint32_t  emissive_texture;
+        uint32_t  flags;
+        uint32_t  padding[2];
+    };
+
+    static_assert(sizeof(GpuMaterial) == 80);
+
+    // `textures` maps the material's image indices to registry indices, e.g. one registered texture per GltfImage.
+    [[nodiscard]] GpuMaterial to_gpu_material(const Material &material, std::span<const uint32_t> textures);
+
+    // Every material in one shader storage buffer, indexed by material id, so draws with different materials can
+    // share a multi-draw call. Shaders include "kat/materials.glsl" and read kat_materials[id].
+    class MaterialTable {
+      public:
+        explicit MaterialTable(const std::shared_ptr<GpuResources> &resources);
+
+        ~MaterialTable();
+
+        MaterialTable(const MaterialTable &)            = delete;
+        MaterialTable &operator=(const MaterialTable &) = delete;
+
+        static std::shared_ptr<MaterialTable> create(const std::shared_ptr<GpuResources> &resources);
+
+        uint32_t add(const GpuMaterial &material);
+
+        uint32_t add(const Material &material, std::span<const uint32_t> textures = {});
+
+        void set(uint32_t id, const GpuMaterial &material);
+
+        [[nodiscard]] const GpuMaterial &get(uint32_t id) const { return m_materials.at(id); }
+
+        [[nodiscard]] size_t get_count() const noexcept { return m_materials.size(); }
+
+        // Uploads the table if it changed. Call before drawing, then bind().
+        void update();
+
+        void bind() const;
+
+      private:
+        std::shared_ptr<GpuResources> m_resources;
+        std::vector<GpuMaterial>      m_materials;
+        Handle<Buffer>                m_buffer;
+        bool                          m_dirty = true;
+    };
+
+} // namespace kat
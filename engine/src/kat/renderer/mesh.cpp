@@ -1,4 +1,142 @@
 #include "mesh.hpp"
 
+#include <algorithm>
+#include <numeric>
+
 namespace kat {
-} // kat
\ No newline at end of file
+
+    Mesh::Mesh(const std::shared_ptr<GpuResources> &resources, const std::vector<StandardVertex> &vertices) :
+        Mesh(resources, vertices, [&] {
+            std::vector<uint32_t> indices(vertices.size());
+            std::iota(indices.begin(), indices.end(), 0u);
+            return indices;
+        }()) {}
+
+    Mesh::Mesh(const std::shared_ptr<GpuResources> &resources, const std::vector<StandardVertex> &vertices,
+               const std::vector<uint32_t> &indices, const MeshBuildOptions &options) :
+        m_resources(resources), m_owns_buffers(true), m_vertex_count(static_cast<uint32_t>(vertices.size())) {
+        m_vertex_buffer = m_resources->create_buffer(vertices, BufferUsage::StaticDraw);
+
+        if (options.build_meshlets || options.lod_count > 1) {
+            std::vector<uint32_t> ordered = indices;
+            if (options.lod_count > 1)
+                m_lods = build_lod_chain(vertices, ordered, options.lod_count, options.lod_reduction, options.simplify);
+            if (options.build_meshlets)
+                m_meshlets = kat::build_meshlets(vertices, std::span(ordered).first(indices.size()));
+            m_index_buffer = m_resources->create_buffer(ordered, BufferUsage::StaticDraw);
+        }
+        else {
+            m_index_buffer = m_resources->create_buffer(indices, BufferUsage::StaticDraw);
+        }
+
+        if (m_lods.empty())
+            m_lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+
+        create_vertex_array(0);
+        upload_meshlets();
+    }
+
+    Mesh::Mesh(const std::shared_ptr<GpuResources> &resources, const BufferRange &vertices, const BufferRange &indices,
+               MeshletData meshlets, std::vector<MeshLod> lods) :
+        m_resources(resources), m_vertex_buffer(vertices.buffer), m_index_buffer(indices.buffer),
+        m_meshlets(std::move(meshlets)), m_lods(std::move(lods)), m_index_offset(indices.offset),
+        m_vertex_offset(vertices.offset),
+        m_vertex_count(static_cast<uint32_t>(vertices.size / sizeof(StandardVertex))) {
+        if (m_lods.empty())
+            m_lods.push_back({ 0, static_cast<uint32_t>(indices.size / sizeof(uint32_t)), 0.0f });
+
+        create_vertex_array(vertices.offset);
+        upload_meshlets();
+    }
+
+    Mesh::~Mesh() {
+        // destroying stale or null handles does nothing
+        m_resources->destroy(m_vertex_array);
+        for (const InstancedArray &array : m_instanced_arrays) {
+            m_resources->destroy(array.vertex_array);
+        }
+        m_resources->destroy(m_meshlet_buffer);
+
+        if (m_owns_buffers) {
+            m_resources->destroy(m_vertex_buffer);
+            m_resources->destroy(m_index_buffer);
+        }
+    }
+
+    void Mesh::upload_meshlets() {
+        if (!m_meshlets.empty())
+            m_meshlet_buffer = m_resources->create_buffer(m_meshlets.to_gpu(), BufferUsage::StaticDraw);
+    }
+
+    void Mesh::create_vertex_array(size_t vertex_offset) {
+        m_vertex_array = m_resources->create_vertex_array();
+        setup_vertex_array(m_resources->get(m_vertex_array), m_resources->get(m_vertex_buffer),
+                           m_resources->get(m_index_buffer), vertex_offset);
+    }
+
+    void Mesh::setup_vertex_array(VertexArray &vertex_array, const Buffer &vertices, const Buffer &indices,
+                                  size_t vertex_offset) {
+        vertex_array.vertex_buffer(vertices,
+                                   {
+                                       { 3, offsetof(StandardVertex, position) },
+                                       { 3, offsetof(StandardVertex, normal) },
+                                       { 4, offsetof(StandardVertex, color) },
+                                       { 2, offsetof(StandardVertex, uv) },
+                                   },
+                                   sizeof(StandardVertex), vertex_offset);
+        vertex_array.element_buffer(indices);
+    }
+
+    void Mesh::render(const std::shared_ptr<Renderer> &renderer, size_t lod) {
+        const MeshLod &level = m_lods[std::min(lod, m_lods.size() - 1)];
+
+        m_resources->get(m_vertex_array).bind();
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(level.index_count), GL_UNSIGNED_INT,
+                       reinterpret_cast<const void *>(m_index_offset + level.first_index * sizeof(uint32_t)));
+    }
+
+    void Mesh::render_instanced(const std::shared_ptr<Renderer> &renderer, const InstanceBuffer &instances,
+                                size_t lod) {
+        if (instances.get_count() == 0)
+            return;
+
+        const MeshLod &level = m_lods[std::min(lod, m_lods.size() - 1)];
+
+        auto it = std::ranges::find(m_instanced_arrays, instances.get_layout(), &InstancedArray::layout);
+        if (it == m_instanced_arrays.end()) {
+            InstancedArray array;
+            array.layout       = instances.get_layout();
+            array.vertex_array = m_resources->create_vertex_array();
+
+            VertexArray &vertex_array = m_resources->get(array.vertex_array);
+            setup_vertex_array(vertex_array, m_resources->get(m_vertex_buffer), m_resources->get(m_index_buffer),
+                               m_vertex_offset);
+            array.binding = vertex_array.instance_binding(array.layout.attributes);
+            m_instanced_arrays.push_back(std::move(array));
+            it = std::prev(m_instanced_arrays.end());
+        }
+
+        VertexArray &vertex_array = m_resources->get(it->vertex_array);
+        vertex_array.set_vertex_buffer(it->binding, instances.get_handle(), instances.get_offset(), it->layout.stride);
+        vertex_array.bind();
+        glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(level.index_count), GL_UNSIGNED_INT,
+                                reinterpret_cast<const void *>(m_index_offset + level.first_index * sizeof(uint32_t)),
+                                static_cast<GLsizei>(instances.get_count()));
+    }
+
+    size_t Mesh::select_lod(float distance, float projection_scale, float max_pixel_error) const {
+        const float d = std::max(distance, 1e-4f);
+
+        // errors grow with each level, walk down until the next one would be visible
+        size_t lod = 0;
+        while (lod + 1 < m_lods.size() && m_lods[lod + 1].error * projection_scale / d <= max_pixel_error) {
+            lod++;
+        }
+        return lod;
+    }
+
+    float Mesh::projection_scale(const glm::mat4 &projection, float viewport_height) {
+        return projection[1][1] * viewport_height * 0.5f;
+    }
+
+} // namespace kat
@@ -3,6 +3,10 @@
 #include <vector>
 
 #include "buffer.hpp"
+#include "gpu_resources.hpp"
+#include "instance_buffer.hpp"
+#include "mesh_simplifier.hpp"
+#include "meshlet.hpp"
 #include "renderer.hpp"
 #include "vertex_array.hpp"
 
@@ -10,22 +14,115 @@ namespace kat {
 
     struct StandardVertex {
         glm::vec3 position;
+        glm::vec3 normal;
         glm::vec4 color;
         glm::vec2 uv;
     };
 
+    struct MeshBuildOptions {
+        // reorder the indices into meshlets before upload
+        bool build_meshlets = false;
+
+        // total number of levels including the full resolution one, each simplified from the previous
+        size_t          lod_count     = 1;
+        float           lod_reduction = 0.5f;
+        SimplifyOptions simplify;
+    };
+
+    // Buffers and vertex arrays live in a GpuResources pool, so drawing a mesh looks them up by handle. The mesh
+    // destroys what it created when it goes away.
     class Mesh {
       public:
-        Mesh(const std::vector<StandardVertex>& vertices);
+        Mesh(const std::shared_ptr<GpuResources> &resources, const std::vector<StandardVertex> &vertices);
+
+        Mesh(const std::shared_ptr<GpuResources> &resources, const std::vector<StandardVertex> &vertices,
+             const std::vector<uint32_t> &indices, const MeshBuildOptions &options = {});
+
+        // Shares existing buffers of `resources`, the ranges are in bytes, and leaves destroying them to their owner.
+        // Index data is expected to be GL_UNSIGNED_INT and, when meshlets are given, already ordered to match them.
+        // `lods` index into the range, when empty the whole range is a single level.
+        Mesh(const std::shared_ptr<GpuResources> &resources, const BufferRange &vertices, const BufferRange &indices,
+             MeshletData meshlets = {}, std::vector<MeshLod> lods = {});
+
+        virtual ~Mesh();
+
+        Mesh(const Mesh &)            = delete;
+        Mesh &operator=(const Mesh &) = delete;
+
+        void render(const std::shared_ptr<Renderer> &renderer, size_t lod = 0);
+
+        // One draw of every instance in the last upload of `instances`. Instance attributes follow the four
+        // StandardVertex ones, starting at location 4.
+        void render_instanced(const std::shared_ptr<Renderer> &renderer, const InstanceBuffer &instances,
+                              size_t lod = 0);
+
+        // Picks the coarsest level whose error, projected to the screen, stays under max_pixel_error. `distance` is
+        // from the camera to the object in the same units as the mesh (scale it for scaled instances).
+        [[nodiscard]] size_t select_lod(float distance, float projection_scale, float max_pixel_error = 1.0f) const;
+
+        // Pixels per unit of object space error at distance 1, for select_lod.
+        [[nodiscard]] static float projection_scale(const glm::mat4 &projection, float viewport_height);
+
+        // StandardVertex layout over `vertices`, starting `vertex_offset` bytes in
+        static void setup_vertex_array(VertexArray &vertex_array, const Buffer &vertices, const Buffer &indices,
+                                       size_t vertex_offset = 0);
+
+        [[nodiscard]] uint32_t get_vertex_count() const noexcept { return m_vertex_count; }
+
+        // index count of the full resolution level
+        [[nodiscard]] uint32_t get_index_count() const noexcept { return m_lods.front().index_count; }
 
-        virtual ~Mesh() = default;
+        [[nodiscard]] size_t get_lod_count() const noexcept { return m_lods.size(); }
 
-        void render(const std::shared_ptr<Renderer> &renderer);
+        [[nodiscard]] const MeshLod &get_lod(size_t lod) const { return m_lods.at(lod); }
+
+        // byte offset of this mesh's indices inside the index buffer
+        [[nodiscard]] size_t get_index_offset() const noexcept { return m_index_offset; }
+
+        // byte offset of the first vertex inside the vertex buffer
+        [[nodiscard]] size_t get_vertex_offset() const noexcept { return m_vertex_offset; }
+
+        [[nodiscard]] Handle<Buffer> get_vertex_buffer() const noexcept { return m_vertex_buffer; }
+
+        [[nodiscard]] Handle<Buffer> get_index_buffer() const noexcept { return m_index_buffer; }
+
+        [[nodiscard]] const VertexArray &get_vertex_array() const { return m_resources->get(m_vertex_array); }
+
+        [[nodiscard]] const std::shared_ptr<GpuResources> &get_resources() const noexcept { return m_resources; }
+
+        [[nodiscard]] bool has_meshlets() const noexcept { return !m_meshlets.empty(); }
+
+        [[nodiscard]] const MeshletData &get_meshlets() const noexcept { return m_meshlets; }
+
+        // GpuMeshlet array for compute culling, a null handle when the mesh has no meshlets.
+        [[nodiscard]] Handle<Buffer> get_meshlet_buffer() const noexcept { return m_meshlet_buffer; }
 
       private:
-        std::unique_ptr<Buffer>      m_vertex_buffer;
-        std::unique_ptr<Buffer>      m_index_buffer;
-        std::unique_ptr<VertexArray> m_vertex_array;
+        void create_vertex_array(size_t vertex_offset);
+
+        void upload_meshlets();
+
+        // vertex arrays with an instance binding, one per instance layout used with this mesh
+        struct InstancedArray {
+            InstanceLayout      layout;
+            Handle<VertexArray> vertex_array;
+            unsigned int        binding;
+        };
+
+        std::shared_ptr<GpuResources> m_resources;
+        Handle<Buffer>                m_vertex_buffer;
+        Handle<Buffer>                m_index_buffer;
+        Handle<VertexArray>           m_vertex_array;
+        std::vector<InstancedArray>   m_instanced_arrays;
+        bool                          m_owns_buffers = false; // the vertex and index buffers, not shared ones
+
+        MeshletData          m_meshlets; // cover the first level only
+        Handle<Buffer>       m_meshlet_buffer;
+        std::vector<MeshLod> m_lods;
+
+        size_t   m_index_offset  = 0;
+        size_t   m_vertex_offset = 0;
+        uint32_t m_vertex_count  = 0;
     };
 
 } // namespace kat
@@ -0,0 +1,382 @@
+#include "mesh_simplifier.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+#include "mesh.hpp"
+
+namespace kat {
+    namespace {
+        // Symmetric 4x4 error quadric, stored as its 10 unique coefficients, plus the total weight of its planes so
+        // the error comes out as a squared distance in mesh units whatever the triangle sizes.
+        struct Quadric {
+            double a2 = 0, b2 = 0, c2 = 0, d2 = 0;
+            double ab = 0, ac = 0, ad = 0, bc = 0, bd = 0, cd = 0;
+            double w = 0;
+
+            static Quadric from_plane(const glm::vec3 &n, float d, double weight) {
+                const double a = n.x, b = n.y, c = n.z, dd = d;
+
+                Quadric q;
+                q.a2 = a * a * weight;
+                q.b2 = b * b * weight;
+                q.c2 = c * c * weight;
+                q.d2 = dd * dd * weight;
+                q.ab = a * b * weight;
+                q.ac = a * c * weight;
+                q.ad = a * dd * weight;
+                q.bc = b * c * weight;
+                q.bd = b * dd * weight;
+                q.cd = c * dd * weight;
+                q.w  = weight;
+                return q;
+            }
+
+            Quadric &operator+=(const Quadric &o) {
+                a2 += o.a2;
+                b2 += o.b2;
+                c2 += o.c2;
+                d2 += o.d2;
+                ab += o.ab;
+                ac += o.ac;
+                ad += o.ad;
+                bc += o.bc;
+                bd += o.bd;
+                cd += o.cd;
+                w  += o.w;
+                return *this;
+            }
+
+            friend Quadric operator+(Quadric lhs, const Quadric &rhs) { return lhs += rhs; }
+
+            [[nodiscard]] double evaluate(const glm::vec3 &p) const {
+                const double x = p.x, y = p.y, z = p.z;
+                const double e = a2 * x * x + b2 * y * y + c2 * z * z + d2 +
+                                 2.0 * (ab * x * y + ac * x * z + ad * x + bc * y * z + bd * y + cd * z);
+                return w > 0.0 ? std::max(e / w, 0.0) : 0.0;
+            }
+        };
+
+        enum class VertexKind : uint8_t { Manifold, Border, Locked };
+
+        struct PositionKey {
+            uint32_t x, y, z;
+
+            friend bool operator==(const PositionKey &, const PositionKey &) = default;
+        };
+
+        struct PositionKeyHash {
+            size_t operator()(const PositionKey &k) const noexcept {
+                return (static_cast<size_t>(k.x) * 73856093u) ^ (static_cast<size_t>(k.y) * 19349663u) ^
+                       (static_cast<size_t>(k.z) * 83492791u);
+            }
+        };
+
+        uint64_t edge_key(uint32_t a, uint32_t b) {
+            return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+        }
+
+        struct Collapse {
+            uint32_t from; // vertex indices, not positions
+            uint32_t to;
+            double   cost;  // ranking, includes the attribute penalty
+            double   error; // geometric only
+        };
+
+        glm::vec3 triangle_normal(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) {
+            return glm::cross(b - a, c - a);
+        }
+    } // namespace
+
+    SimplifyResult simplify(std::span<const StandardVertex> vertices, std::span<const uint32_t> indices,
+                            size_t target_index_count, const SimplifyOptions &options) {
+        SimplifyResult result{ std::vector<uint32_t>(indices.begin(), indices.end()), 0.0f };
+        if (indices.size() <= target_index_count || vertices.empty())
+            return result;
+
+        const size_t vertex_count = vertices.size();
+
+        // weld vertices that share a position; collapses operate on positions, attribute wedges ride along.
+        std::vector<uint32_t> position_of(vertex_count);
+        std::vector<uint32_t> wedges(vertex_count, 0);
+        {
+            std::unordered_map<PositionKey, uint32_t, PositionKeyHash> unique;
+            unique.reserve(vertex_count);
+            for (uint32_t v = 0; v < vertex_count; v++) {
+                const glm::vec3  &p   = vertices[v].position;
+                const PositionKey key = { std::bit_cast<uint32_t>(p.x), std::bit_cast<uint32_t>(p.y),
+                                          std::bit_cast<uint32_t>(p.z) };
+
+                position_of[v] = unique.try_emplace(key, v).first->second;
+                wedges[position_of[v]]++;
+            }
+        }
+
+        glm::vec3 min = vertices[0].position, max = vertices[0].position;
+        for (const auto &v : vertices) {
+            min = glm::min(min, v.position);
+            max = glm::max(max, v.position);
+        }
+        const double extent      = std::max(static_cast<double>(glm::length(max - min)), 1e-6);
+        const double error_limit = std::pow(options.target_error * extent, 2.0);
+
+        std::unordered_map<uint64_t, uint32_t> edge_use;
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            for (int k = 0; k < 3; k++) {
+                const uint32_t a = position_of[indices[t + k]];
+                const uint32_t b = position_of[indices[t + (k + 1) % 3]];
+                if (a != b)
+                    edge_use[edge_key(a, b)]++;
+            }
+        }
+
+        auto is_border_edge = [&](uint32_t a, uint32_t b) {
+            const auto it = edge_use.find(edge_key(a, b));
+            return it != edge_use.end() && it->second == 1;
+        };
+
+        std::vector<VertexKind> kind(vertex_count, VertexKind::Manifold);
+        std::vector<Quadric>    quadrics(vertex_count);
+
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            const uint32_t p[3] = {
+                position_of[indices[t]],
+                position_of[indices[t + 1]],
+                position_of[indices[t + 2]],
+            };
+
+            const glm::vec3 &a = vertices[p[0]].position;
+            const glm::vec3 &b = vertices[p[1]].position;
+            const glm::vec3 &c = vertices[p[2]].position;
+
+            glm::vec3   n    = triangle_normal(a, b, c);
+            const float area = glm::length(n);
+            if (area <= 0.0f)
+                continue;
+            n /= area;
+
+            const Quadric plane = Quadric::from_plane(n, -glm::dot(n, a), area * 0.5);
+            for (const uint32_t v : p) {
+                quadrics[v] += plane;
+            }
+
+            // border edges get a strong constraint plane perpendicular to the face to keep the outline in shape.
+            for (int k = 0; k < 3; k++) {
+                const uint32_t e0 = p[k], e1 = p[(k + 1) % 3];
+                if (!is_border_edge(e0, e1))
+                    continue;
+
+                const glm::vec3 &p0   = vertices[e0].position;
+                const glm::vec3 &p1   = vertices[e1].position;
+                const glm::vec3  edge = p1 - p0;
+                const float      len  = glm::length(edge);
+                if (len <= 0.0f)
+                    continue;
+
+                const glm::vec3 bn         = glm::normalize(glm::cross(edge / len, n));
+                const Quadric   constraint = Quadric::from_plane(bn, -glm::dot(bn, p0), len * len * 10.0);
+                quadrics[e0] += constraint;
+                quadrics[e1] += constraint;
+
+                kind[e0] = kind[e1] = options.lock_border ? VertexKind::Locked : VertexKind::Border;
+            }
+        }
+
+        for (uint32_t v = 0; v < vertex_count; v++) {
+            if (position_of[v] == v && wedges[v] > 1)
+                kind[v] = VertexKind::Locked; // attribute seam
+        }
+
+        auto attribute_error = [&](uint32_t a, uint32_t b) {
+            const StandardVertex &va = vertices[a];
+            const StandardVertex &vb = vertices[b];
+
+            const glm::vec3 dn = va.normal - vb.normal;
+            const glm::vec2 du = va.uv - vb.uv;
+            const glm::vec4 dc = va.color - vb.color;
+
+            const double e = glm::dot(dn, dn) * options.normal_weight * options.normal_weight +
+                             glm::dot(du, du) * options.uv_weight * options.uv_weight +
+                             glm::dot(dc, dc) * options.color_weight * options.color_weight;
+            return e * extent * extent;
+        };
+
+        std::vector<uint32_t> &triangles = result.indices;
+        std::vector<uint32_t>  remap(vertex_count);
+        std::vector<uint32_t>  adjacency_offsets(vertex_count + 1);
+        std::vector<uint32_t>  adjacency;
+        std::vector<Collapse>  candidates;
+        std::vector<uint8_t>   touched(vertex_count);
+        double                 max_error = 0.0;
+
+        while (triangles.size() > target_index_count) {
+            // position -> triangle adjacency for the current topology
+            std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+            for (const uint32_t v : triangles) {
+                adjacency_offsets[position_of[v] + 1]++;
+            }
+            std::partial_sum(adjacency_offsets.begin(), adjacency_offsets.end(), adjacency_offsets.begin());
+
+            adjacency.resize(triangles.size());
+            {
+                std::vector<uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+                for (size_t i = 0; i < triangles.size(); i++) {
+                    adjacency[fill[position_of[triangles[i]]]++] = static_cast<uint32_t>(i / 3);
+                }
+            }
+
+            auto consider = [&](uint32_t from, uint32_t to) {
+                const uint32_t pf = position_of[from];
+                const uint32_t pt = position_of[to];
+
+                // border vertices may only slide along the border
+                if (kind[pf] == VertexKind::Locked)
+                    return;
+                if (kind[pf] == VertexKind::Border && (kind[pt] != VertexKind::Border || !is_border_edge(pf, pt)))
+                    return;
+
+                const double error = (quadrics[pf] + quadrics[pt]).evaluate(vertices[pt].position);
+                if (error <= error_limit)
+                    candidates.push_back({ from, to, error + attribute_error(from, to), error });
+            };
+
+            candidates.clear();
+            for (size_t t = 0; t < triangles.size(); t += 3) {
+                for (int k = 0; k < 3; k++) {
+                    const uint32_t a = triangles[t + k];
+                    const uint32_t b = triangles[t + (k + 1) % 3];
+                    if (position_of[a] == position_of[b])
+                        continue;
+
+                    consider(a, b);
+                    consider(b, a);
+                }
+            }
+
+            if (candidates.empty())
+                break;
+
+            std::sort(candidates.begin(), candidates.end(),
+                      [](const Collapse &l, const Collapse &r) { return l.cost < r.cost; });
+
+            // each collapse removes about two triangles; don't overshoot the target by much in one pass.
+            const size_t triangles_to_remove = (triangles.size() - target_index_count) / 3;
+            const size_t budget              = std::max<size_t>(1, triangles_to_remove / 2);
+
+            std::iota(remap.begin(), remap.end(), 0u);
+            std::fill(touched.begin(), touched.end(), 0);
+
+            size_t collapses = 0;
+            for (const Collapse &c : candidates) {
+                if (collapses >= budget)
+                    break;
+
+                const uint32_t pf = position_of[c.from];
+                const uint32_t pt = position_of[c.to];
+                if (touched[pf] || touched[pt])
+                    continue;
+
+                const glm::vec3 &target = vertices[pt].position;
+
+                bool valid = true;
+                for (uint32_t a = adjacency_offsets[pf]; a < adjacency_offsets[pf + 1] && valid; a++) {
+                    const uint32_t *tri = &triangles[adjacency[a] * 3];
+
+                    bool has_target = false;
+                    for (int k = 0; k < 3; k++) {
+                        if (position_of[tri[k]] == pt) {
+                            has_target = true;
+                            // the collapsed vertex must land on the wedge the edge actually connects to.
+                            valid = tri[k] == c.to;
+                        }
+                    }
+                    if (has_target || !valid)
+                        continue;
+
+                    // reject collapses that would fold a surviving triangle over
+                    glm::vec3 before[3], after[3];
+                    for (int k = 0; k < 3; k++) {
+                        before[k] = vertices[tri[k]].position;
+                        after[k]  = position_of[tri[k]] == pf ? target : before[k];
+                    }
+
+                    const glm::vec3 n0 = triangle_normal(before[0], before[1], before[2]);
+                    const glm::vec3 n1 = triangle_normal(after[0], after[1], after[2]);
+                    valid              = glm::dot(n0, n1) > 0.0f;
+                }
+
+                if (!valid)
+                    continue;
+
+                remap[c.from] = c.to;
+                quadrics[pt] += quadrics[pf];
+                max_error = std::max(max_error, c.error);
+
+                // lock the whole one-ring so the flip checks of later collapses in this pass stay valid
+                for (uint32_t a = adjacency_offsets[pf]; a < adjacency_offsets[pf + 1]; a++) {
+                    for (int k = 0; k < 3; k++) {
+                        touched[position_of[triangles[adjacency[a] * 3 + k]]] = 1;
+                    }
+                }
+
+                collapses++;
+            }
+
+            if (collapses == 0)
+                break;
+
+            size_t write = 0;
+            for (size_t t = 0; t < triangles.size(); t += 3) {
+                const uint32_t a = remap[triangles[t]];
+                const uint32_t b = remap[triangles[t + 1]];
+                const uint32_t c = remap[triangles[t + 2]];
+
+                if (position_of[a] == position_of[b] || position_of[b] == position_of[c] ||
+                    position_of[a] == position_of[c])
+                    continue;
+
+                triangles[write++] = a;
+                triangles[write++] = b;
+                triangles[write++] = c;
+            }
+            triangles.resize(write);
+        }
+
+        result.error = static_cast<float>(std::sqrt(max_error));
+        return result;
+    }
+
+    std::vector<MeshLod> build_lod_chain(std::span<const StandardVertex> vertices, std::vector<uint32_t> &indices,
+                                         size_t lod_count, float reduction, const SimplifyOptions &options) {
+        std::vector<MeshLod> lods;
+        lods.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+
+        for (size_t level = 1; level < lod_count; level++) {
+            const MeshLod &previous = lods.back();
+
+            const std::span<const uint32_t> source(indices.data() + previous.first_index, previous.index_count);
+            const size_t target = static_cast<size_t>(previous.index_count * reduction) / 3 * 3;
+
+            SimplifyResult simplified = simplify(vertices, source, target, options);
+
+            // not worth another level if the simplifier got stuck on locked vertices or the error limit
+            if (simplified.indices.empty() || simplified.indices.size() > previous.index_count * 0.95f)
+                break;
+
+            const MeshLod lod = {
+                .first_index = static_cast<uint32_t>(indices.size()),
+                .index_count = static_cast<uint32_t>(simplified.indices.size()),
+                .error       = previous.error + simplified.error,
+            };
+
+            indices.insert(indices.end(), simplified.indices.begin(), simplified.indices.end());
+            lods.push_back(lod);
+        }
+
+        return lods;
+    }
+
+} // namespace kat
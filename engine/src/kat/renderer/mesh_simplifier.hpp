@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace kat {
+
+    struct StandardVertex;
+
+    struct SimplifyOptions {
+        // largest allowed deviation, relative to the mesh's bounding box diagonal
+        float target_error = 0.01f;
+
+        // keep open boundaries in place so neighbouring pieces still line up
+        bool lock_border = true;
+
+        // how strongly attribute differences push a collapse back in the order, the reported error is geometric only
+        float normal_weight = 0.5f;
+        float uv_weight     = 1.0f;
+        float color_weight  = 0.25f;
+    };
+
+    struct SimplifyResult {
+        std::vector<uint32_t> indices;
+        float                 error; // absolute, in mesh units
+    };
+
+    // One level of detail, as a range of the owning mesh's index buffer.
+    struct MeshLod {
+        uint32_t first_index;
+        uint32_t index_count;
+        float    error; // absolute object space error against the full resolution mesh
+    };
+
+    // Quadric error edge-collapse simplification. Vertices are never moved or created, collapses only merge a vertex
+    // into a neighbour, so every level of detail can share the original vertex buffer. Vertices on UV/normal seams are
+    // kept in place.
+    SimplifyResult simplify(std::span<const StandardVertex> vertices, std::span<const uint32_t> indices,
+                            size_t target_index_count, const SimplifyOptions &options = {});
+
+    // Appends up to lod_count - 1 simplified levels to `indices` (which holds level 0 on entry), each with roughly
+    // `reduction` times the triangles of the previous one. Stops early once a level no longer gets smaller.
+    std::vector<MeshLod> build_lod_chain(std::span<const StandardVertex> vertices, std::vector<uint32_t> &indices,
+                                         size_t lod_count, float reduction = 0.5f, const SimplifyOptions &options = {});
+
+} // namespace kat
@@ -0,0 +1,245 @@
+#include "meshlet.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "mesh.hpp"
+
+namespace kat {
+    namespace {
+        // Ritter's bounding sphere, good to within a few percent of the optimum.
+        glm::vec4 bounding_sphere(std::span<const StandardVertex> vertices, std::span<const uint32_t> points) {
+            glm::vec3 p = vertices[points[0]].position;
+
+            auto furthest_from = [&](const glm::vec3 &from) {
+                glm::vec3 best          = from;
+                float     best_distance = -1.0f;
+                for (const uint32_t i : points) {
+                    const glm::vec3 d        = vertices[i].position - from;
+                    const float     distance = glm::dot(d, d);
+                    if (distance > best_distance) {
+                        best_distance = distance;
+                        best          = vertices[i].position;
+                    }
+                }
+                return best;
+            };
+
+            const glm::vec3 a = furthest_from(p);
+            const glm::vec3 b = furthest_from(a);
+
+            glm::vec3 center = (a + b) * 0.5f;
+            float     radius = glm::length(b - a) * 0.5f;
+
+            for (const uint32_t i : points) {
+                const glm::vec3 &v        = vertices[i].position;
+                const float      distance = glm::length(v - center);
+                if (distance > radius) {
+                    const float new_radius = (radius + distance) * 0.5f;
+                    center += (v - center) * ((new_radius - radius) / distance);
+                    radius = new_radius;
+                }
+            }
+
+            return { center, radius };
+        }
+
+        glm::vec4 normal_cone(std::span<const StandardVertex> vertices, std::span<const uint32_t> indices) {
+            std::vector<glm::vec3> normals;
+            normals.reserve(indices.size() / 3);
+
+            glm::vec3 sum(0.0f);
+            for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+                const glm::vec3 &a = vertices[indices[t]].position;
+                const glm::vec3 &b = vertices[indices[t + 1]].position;
+                const glm::vec3 &c = vertices[indices[t + 2]].position;
+
+                const glm::vec3 n      = glm::cross(b - a, c - a);
+                const float     length = glm::length(n);
+                if (length <= std::numeric_limits<float>::epsilon())
+                    continue;
+
+                normals.push_back(n / length);
+                sum += normals.back();
+            }
+
+            const float sum_length = glm::length(sum);
+            if (normals.empty() || sum_length <= std::numeric_limits<float>::epsilon())
+                return { 0.0f, 0.0f, 0.0f, 1.0f };
+
+            const glm::vec3 axis = sum / sum_length;
+
+            float min_dot = 1.0f;
+            for (const auto &n : normals) {
+                min_dot = std::min(min_dot, glm::dot(axis, n));
+            }
+
+            // a cone wider than ~84 degrees can never be entirely back facing, cutoff 1 disables the test.
+            const float cutoff = min_dot <= 0.1f ? 1.0f : std::sqrt(1.0f - min_dot * min_dot);
+            return { axis, cutoff };
+        }
+    } // namespace
+
+    std::vector<GpuMeshlet> MeshletData::to_gpu() const {
+        std::vector<GpuMeshlet> gpu(meshlets.size());
+        for (size_t i = 0; i < meshlets.size(); i++) {
+            gpu[i] = {
+                .sphere      = { bounds.center_x[i], bounds.center_y[i], bounds.center_z[i], bounds.radius[i] },
+                .cone        = { bounds.axis_x[i], bounds.axis_y[i], bounds.axis_z[i], bounds.cutoff[i] },
+                .first_index = meshlets[i].first_index,
+                .index_count = meshlets[i].index_count,
+                .padding     = { 0, 0 },
+            };
+        }
+        return gpu;
+    }
+
+    MeshletData build_meshlets(std::span<const StandardVertex> vertices, std::span<uint32_t> indices,
+                               size_t max_vertices, size_t max_triangles) {
+        const size_t triangle_count = indices.size() / 3;
+
+        // vertex -> triangle adjacency in compressed rows
+        std::vector<uint32_t> adjacency_offsets(vertices.size() + 1, 0);
+        for (size_t i = 0; i < triangle_count * 3; i++) {
+            adjacency_offsets[indices[i] + 1]++;
+        }
+        for (size_t v = 0; v < vertices.size(); v++) {
+            adjacency_offsets[v + 1] += adjacency_offsets[v];
+        }
+
+        std::vector<uint32_t> adjacency(triangle_count * 3);
+        {
+            std::vector<uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+            for (size_t i = 0; i < triangle_count * 3; i++) {
+                adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        std::vector<bool>     emitted(triangle_count, false);
+        std::vector<uint32_t> vertex_stamp(vertices.size(), 0);
+        std::vector<uint32_t> ordered;
+        ordered.reserve(triangle_count * 3);
+
+        MeshletData data;
+
+        uint32_t              stamp = 1;
+        std::vector<uint32_t> meshlet_vertices;
+        size_t                meshlet_triangles = 0;
+        size_t                meshlet_start     = 0;
+        size_t                cursor            = 0;
+        uint32_t              last_triangle     = std::numeric_limits<uint32_t>::max();
+
+        auto new_vertex_count = [&](uint32_t triangle) {
+            size_t count = 0;
+            for (int k = 0; k < 3; k++) {
+                count += vertex_stamp[indices[triangle * 3 + k]] != stamp;
+            }
+            return count;
+        };
+
+        auto best_adjacent = [&](std::span<const uint32_t> around) {
+            uint32_t best       = std::numeric_limits<uint32_t>::max();
+            size_t   best_score = 4;
+            for (const uint32_t v : around) {
+                for (uint32_t a = adjacency_offsets[v]; a < adjacency_offsets[v + 1]; a++) {
+                    const uint32_t triangle = adjacency[a];
+                    if (emitted[triangle])
+                        continue;
+
+                    const size_t score = new_vertex_count(triangle);
+                    if (score < best_score) {
+                        best_score = score;
+                        best       = triangle;
+                    }
+                }
+            }
+            return best;
+        };
+
+        auto flush = [&] {
+            if (meshlet_triangles == 0)
+                return;
+
+            data.meshlets.push_back({
+                .first_index  = static_cast<uint32_t>(meshlet_start),
+                .index_count  = static_cast<uint32_t>(meshlet_triangles * 3),
+                .vertex_count = static_cast<uint32_t>(meshlet_vertices.size()),
+            });
+
+            meshlet_start     = ordered.size();
+            meshlet_triangles = 0;
+            meshlet_vertices.clear();
+            stamp++;
+        };
+
+        for (size_t emitted_count = 0; emitted_count < triangle_count; emitted_count++) {
+            uint32_t next = std::numeric_limits<uint32_t>::max();
+
+            // grow around the last triangle first, then around the whole meshlet, then fall back to index order.
+            if (last_triangle != std::numeric_limits<uint32_t>::max())
+                next = best_adjacent(std::span<const uint32_t>(indices.data() + last_triangle * 3, 3));
+            if (next == std::numeric_limits<uint32_t>::max() && !meshlet_vertices.empty())
+                next = best_adjacent(meshlet_vertices);
+            if (next == std::numeric_limits<uint32_t>::max()) {
+                while (emitted[cursor]) {
+                    cursor++;
+                }
+                next = static_cast<uint32_t>(cursor);
+            }
+
+            if (meshlet_vertices.size() + new_vertex_count(next) > max_vertices || meshlet_triangles + 1 > max_triangles)
+                flush();
+
+            for (int k = 0; k < 3; k++) {
+                const uint32_t v = indices[next * 3 + k];
+                if (vertex_stamp[v] != stamp) {
+                    vertex_stamp[v] = stamp;
+                    meshlet_vertices.push_back(v);
+                }
+                ordered.push_back(v);
+            }
+
+            emitted[next] = true;
+            meshlet_triangles++;
+            last_triangle = next;
+        }
+
+        flush();
+
+        std::copy(ordered.begin(), ordered.end(), indices.begin());
+
+        const size_t padded = (data.meshlets.size() + 3) & ~size_t{ 3 };
+        for (auto *array : { &data.bounds.center_x, &data.bounds.center_y, &data.bounds.center_z, &data.bounds.radius,
+                             &data.bounds.axis_x, &data.bounds.axis_y, &data.bounds.axis_z, &data.bounds.cutoff }) {
+            array->assign(padded, 0.0f);
+        }
+
+        // a sphere of negative infinite radius is outside every plane, so the padding is always culled
+        data.bounds.radius.assign(padded, -std::numeric_limits<float>::infinity());
+
+        std::vector<uint32_t> unique;
+        for (size_t m = 0; m < data.meshlets.size(); m++) {
+            const Meshlet            &meshlet = data.meshlets[m];
+            std::span<const uint32_t> range(indices.data() + meshlet.first_index, meshlet.index_count);
+
+            unique.assign(range.begin(), range.end());
+            std::sort(unique.begin(), unique.end());
+            unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+
+            const glm::vec4 sphere = bounding_sphere(vertices, unique);
+            const glm::vec4 cone   = normal_cone(vertices, range);
+
+            data.bounds.center_x[m] = sphere.x;
+            data.bounds.center_y[m] = sphere.y;
+            data.bounds.center_z[m] = sphere.z;
+            data.bounds.radius[m]   = sphere.w;
+            data.bounds.axis_x[m]   = cone.x;
+            data.bounds.axis_y[m]   = cone.y;
+            data.bounds.axis_z[m]   = cone.z;
+            data.bounds.cutoff[m]   = cone.w;
+        }
+
+        return data;
+    }
+
+} // namespace kat
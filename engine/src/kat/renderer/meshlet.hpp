@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    struct StandardVertex;
+
+    constexpr size_t MESHLET_MAX_VERTICES  = 64;
+    constexpr size_t MESHLET_MAX_TRIANGLES = 124;
+
+    // A cluster of triangles that is contiguous in the owning mesh's index range.
+    struct Meshlet {
+        uint32_t first_index;
+        uint32_t index_count;
+        uint32_t vertex_count;
+    };
+
+    // Bounding spheres and normal cones, stored as structure of arrays so four meshlets can be tested at once. Arrays
+    // are padded to a multiple of four with spheres of radius -infinity, which never pass the frustum test.
+    struct MeshletBounds {
+        std::vector<float> center_x, center_y, center_z, radius;
+        std::vector<float> axis_x, axis_y, axis_z, cutoff;
+
+        [[nodiscard]] size_t padded_size() const noexcept { return center_x.size(); }
+    };
+
+    // std430 layout of one meshlet for GPU culling.
+    struct GpuMeshlet {
+        glm::vec4 sphere; // xyz = center, w = radius
+        glm::vec4 cone;   // xyz = axis, w = cutoff
+        uint32_t  first_index;
+        uint32_t  index_count;
+        uint32_t  padding[2];
+    };
+
+    struct MeshletData {
+        std::vector<Meshlet> meshlets;
+        MeshletBounds        bounds;
+
+        [[nodiscard]] bool empty() const noexcept { return meshlets.empty(); }
+
+        [[nodiscard]] std::vector<GpuMeshlet> to_gpu() const;
+    };
+
+    // Greedily groups triangles into meshlets. `indices` is reordered in place so that every meshlet is a contiguous
+    // range of it; the returned ranges are relative to the start of `indices`.
+    MeshletData build_meshlets(std::span<const StandardVertex> vertices, std::span<uint32_t> indices,
+                               size_t max_vertices = MESHLET_MAX_VERTICES, size_t max_triangles = MESHLET_MAX_TRIANGLES);
+
+} // namespace kat
@@ -0,0 +1,241 @@
+#include "meshlet_culler.hpp"
+
+#include <bit>
+#include <string>
+
+#include "kat/utils/frustum.hpp"
+#include "kat/utils/simd.hpp"
+
+namespace kat {
+    namespace {
+        // the command array starts after a 16 byte header holding the draw count
+        constexpr size_t GPU_COMMANDS_OFFSET = 16;
+
+        const std::string CULL_SHADER_SOURCE = R"(#version 460 core
+layout(local_size_x = 64) in;
+
+struct Meshlet {
+    vec4 sphere;
+    vec4 cone;
+    uint first_index;
+    uint index_count;
+    uint padding0;
+    uint padding1;
+};
+
+struct DrawCommand {
+    uint count;
+    uint instance_count;
+    uint first_index;
+    int  base_vertex;
+    uint base_instance;
+};
+
+layout(std430, binding = 0) readonly buffer Meshlets {
+    Meshlet meshlets[];
+};
+
+layout(std430, binding = 1) buffer Commands {
+    uint        draw_count;
+    uint        padding[3];
+    DrawCommand commands[];
+};
+
+uniform vec4 u_planes[6];
+uniform vec3 u_camera;
+uniform uint u_meshlet_count;
+uniform uint u_base_index;
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= u_meshlet_count)
+        return;
+
+    Meshlet m = meshlets[i];
+    vec3 center = m.sphere.xyz;
+    float radius = m.sphere.w;
+
+    for (int p = 0; p < 6; p++) {
+        if (dot(u_planes[p].xyz, center) + u_planes[p].w < -radius)
+            return;
+    }
+
+    vec3 v = center - u_camera;
+    if (dot(v, m.cone.xyz) >= m.cone.w * length(v) + radius)
+        return;
+
+    uint slot = atomicAdd(draw_count, 1u);
+    commands[slot] = DrawCommand(m.index_count, 1u, u_base_index + m.first_index, 0, 0u);
+}
+)";
+
+        void push_command(std::vector<DrawElementsIndirectCommand> &commands, size_t &added, uint32_t first_index,
+                          uint32_t count) {
+            // neighbouring meshlets are contiguous in the index buffer, so runs of survivors collapse into one draw.
+            if (added > 0) {
+                auto &last = commands.back();
+                if (last.first_index + last.count == first_index) {
+                    last.count += count;
+                    return;
+                }
+            }
+
+            commands.push_back({ count, 1, first_index, 0, 0 });
+            added++;
+        }
+    } // namespace
+
+    MeshletCuller::MeshletCuller(const std::shared_ptr<GpuResources> &resources) : m_resources(resources) {
+        m_indirect_buffer = m_resources->create_buffer();
+        m_gpu_commands    = m_resources->create_buffer();
+    }
+
+    MeshletCuller::~MeshletCuller() {
+        m_resources->destroy(m_indirect_buffer);
+        m_resources->destroy(m_gpu_commands);
+    }
+
+    size_t MeshletCuller::cull(const Mesh &mesh, const glm::mat4 &model, const glm::mat4 &view_projection,
+                               const glm::vec3 &camera_position,
+                               std::vector<DrawElementsIndirectCommand> &commands) const {
+        if (!mesh.has_meshlets())
+            return 0;
+
+        // work in model space: planes of (view_projection * model) and the camera brought into the mesh's frame.
+        const Frustum   frustum = Frustum::from_matrix(view_projection * model);
+        const glm::vec3 camera  = glm::vec3(glm::inverse(model) * glm::vec4(camera_position, 1.0f));
+
+        const MeshletData   &data       = mesh.get_meshlets();
+        const MeshletBounds &b          = data.bounds;
+        const size_t         count      = data.meshlets.size();
+        const auto           base_index = static_cast<uint32_t>(mesh.get_index_offset() / sizeof(uint32_t));
+
+        size_t added = 0;
+
+#ifdef KAT_SIMD_SSE2
+        const __m128 camera_x = _mm_set1_ps(camera.x);
+        const __m128 camera_y = _mm_set1_ps(camera.y);
+        const __m128 camera_z = _mm_set1_ps(camera.z);
+
+        for (size_t i = 0; i < count; i += 4) {
+            const __m128 cx     = _mm_loadu_ps(&b.center_x[i]);
+            const __m128 cy     = _mm_loadu_ps(&b.center_y[i]);
+            const __m128 cz     = _mm_loadu_ps(&b.center_z[i]);
+            const __m128 radius = _mm_loadu_ps(&b.radius[i]);
+
+            const __m128 negative_radius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+            __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const auto &plane : frustum.planes) {
+                const __m128 d = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+                    _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+                visible = _mm_and_ps(visible, _mm_cmpge_ps(d, negative_radius));
+            }
+
+            const __m128 vx = _mm_sub_ps(cx, camera_x);
+            const __m128 vy = _mm_sub_ps(cy, camera_y);
+            const __m128 vz = _mm_sub_ps(cz, camera_z);
+
+            const __m128 distance = _mm_sqrt_ps(
+                _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+            const __m128 facing = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(vx, _mm_loadu_ps(&b.axis_x[i])), _mm_mul_ps(vy, _mm_loadu_ps(&b.axis_y[i]))),
+                _mm_mul_ps(vz, _mm_loadu_ps(&b.axis_z[i])));
+            const __m128 back_facing =
+                _mm_cmpge_ps(facing, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&b.cutoff[i]), distance), radius));
+
+            visible = _mm_andnot_ps(back_facing, visible);
+
+            const size_t lanes = std::min<size_t>(count - i, 4);
+            unsigned int mask  = static_cast<unsigned int>(_mm_movemask_ps(visible)) & ((1u << lanes) - 1);
+            while (mask != 0) {
+                const size_t   m       = i + std::countr_zero(mask);
+                const Meshlet &meshlet = data.meshlets[m];
+                push_command(commands, added, base_index + meshlet.first_index, meshlet.index_count);
+                mask &= mask - 1;
+            }
+        }
+#else
+        for (size_t i = 0; i < count; i++) {
+            const glm::vec3 center = { b.center_x[i], b.center_y[i], b.center_z[i] };
+            if (!frustum.intersects_sphere(center, b.radius[i]))
+                continue;
+
+            const glm::vec3 v    = center - camera;
+            const glm::vec3 axis = { b.axis_x[i], b.axis_y[i], b.axis_z[i] };
+            if (glm::dot(v, axis) >= b.cutoff[i] * glm::length(v) + b.radius[i])
+                continue;
+
+            push_command(commands, added, base_index + data.meshlets[i].first_index, data.meshlets[i].index_count);
+        }
+#endif
+
+        return added;
+    }
+
+    void MeshletCuller::draw(const Mesh &mesh, std::span<const DrawElementsIndirectCommand> commands) {
+        if (commands.empty())
+            return;
+
+        Buffer &indirect_buffer = m_resources->get(m_indirect_buffer);
+        indirect_buffer.set(commands.data(), commands.size_bytes(), BufferUsage::StreamDraw);
+        indirect_buffer.bind(BufferTarget::DrawIndirect);
+
+        mesh.get_vertex_array().bind();
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(commands.size()), 0);
+    }
+
+    void MeshletCuller::cull_gpu(const Mesh &mesh, const glm::mat4 &model, const glm::mat4 &view_projection,
+                                 const glm::vec3 &camera_position) {
+        if (!mesh.has_meshlets())
+            return;
+
+        Buffer &gpu_commands = m_resources->get(m_gpu_commands);
+        if (!m_cull_pipeline) {
+            m_cull_pipeline = ComputePipeline::create(CULL_SHADER_SOURCE);
+            m_cull_pipeline->set_storage(1, gpu_commands);
+        }
+
+        const auto   meshlet_count = static_cast<uint32_t>(mesh.get_meshlets().meshlets.size());
+        const size_t required      = GPU_COMMANDS_OFFSET + meshlet_count * sizeof(DrawElementsIndirectCommand);
+        if (gpu_commands.get_size() < required)
+            gpu_commands.set(nullptr, required, BufferUsage::DynamicCopy);
+
+        m_gpu_max_draws = meshlet_count;
+
+        MemoryBarriers::require(gpu_commands, GL_BUFFER_UPDATE_BARRIER_BIT);
+        glClearNamedBufferSubData(gpu_commands.get_handle(), GL_R32UI, 0, sizeof(uint32_t), GL_RED_INTEGER,
+                                  GL_UNSIGNED_INT, nullptr);
+
+        const Frustum   frustum = Frustum::from_matrix(view_projection * model);
+        const glm::vec3 camera  = glm::vec3(glm::inverse(model) * glm::vec4(camera_position, 1.0f));
+
+        const Shader &shader = m_cull_pipeline->get_shader();
+        for (int p = 0; p < 6; p++) {
+            shader.uniform4f("u_planes[" + std::to_string(p) + "]", frustum.planes[p]);
+        }
+        shader.uniform3f("u_camera", camera);
+        shader.uniform1ui("u_meshlet_count", meshlet_count);
+        shader.uniform1ui("u_base_index", static_cast<uint32_t>(mesh.get_index_offset() / sizeof(uint32_t)));
+
+        m_cull_pipeline->set_storage(0, mesh.get_resources()->get(mesh.get_meshlet_buffer()), ComputeAccess::ReadOnly);
+        m_cull_pipeline->dispatch(meshlet_count);
+    }
+
+    void MeshletCuller::draw_gpu(const Mesh &mesh) const {
+        if (m_gpu_max_draws == 0)
+            return;
+
+        const Buffer &gpu_commands = m_resources->get(m_gpu_commands);
+        MemoryBarriers::require(gpu_commands, GL_COMMAND_BARRIER_BIT);
+        gpu_commands.bind(BufferTarget::DrawIndirect);
+        gpu_commands.bind(BufferTarget::Parameter);
+
+        mesh.get_vertex_array().bind();
+        glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                         reinterpret_cast<const void *>(GPU_COMMANDS_OFFSET), 0,
+                                         static_cast<GLsizei>(m_gpu_max_draws), sizeof(DrawElementsIndirectCommand));
+    }
+
+} // namespace kat
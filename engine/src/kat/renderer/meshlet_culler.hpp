@@ -0,0 +1,45 @@
+#pragma once
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "compute_pipeline.hpp"
+#include "gpu_resources.hpp"
+#include "mesh.hpp"
+
+namespace kat {
+
+    // Drops meshlets that are outside the frustum or entirely back facing and draws the survivors with a single
+    // multi-draw-indirect call. The cone test assumes the model matrix carries no non-uniform scale.
+    class MeshletCuller {
+      public:
+        explicit MeshletCuller(const std::shared_ptr<GpuResources> &resources);
+
+        ~MeshletCuller();
+
+        MeshletCuller(const MeshletCuller &)            = delete;
+        MeshletCuller &operator=(const MeshletCuller &) = delete;
+
+        // CPU path: appends draws covering the visible meshlets of `mesh` (adjacent survivors share one command) and
+        // returns how many commands were added.
+        size_t cull(const Mesh &mesh, const glm::mat4 &model, const glm::mat4 &view_projection,
+                    const glm::vec3 &camera_position, std::vector<DrawElementsIndirectCommand> &commands) const;
+
+        void draw(const Mesh &mesh, std::span<const DrawElementsIndirectCommand> commands);
+
+        // GPU path: culls in a compute shader into an indirect buffer, no CPU readback. Rebind the draw shader
+        // before draw_gpu, the compute program is left bound.
+        void cull_gpu(const Mesh &mesh, const glm::mat4 &model, const glm::mat4 &view_projection,
+                      const glm::vec3 &camera_position);
+
+        void draw_gpu(const Mesh &mesh) const;
+
+      private:
+        std::shared_ptr<GpuResources>    m_resources;
+        Handle<Buffer>                   m_indirect_buffer;
+        Handle<Buffer>                   m_gpu_commands;
+        std::shared_ptr<ComputePipeline> m_cull_pipeline;
+        uint32_t                         m_gpu_max_draws = 0;
+    };
+
+} // namespace kat
@@ -0,0 +1,354 @@
+#include "occlusion_culler.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <string>
+
+#include "kat/utils/frustum.hpp"
+
+namespace kat {
+    namespace {
+        // the command array starts after a 16 byte header holding the draw count
+        constexpr size_t GPU_COMMANDS_OFFSET = 16;
+
+        // u_phase values of the cull shader
+        constexpr uint32_t PHASE_PREVIOUS = 0;
+        constexpr uint32_t PHASE_NEW      = 1;
+
+        const std::string CULL_SHADER_SOURCE = R"(#version 460 core
+layout(local_size_x = 64) in;
+
+struct Object {
+    vec4 min;
+    vec4 max;
+    uint count;
+    uint first_index;
+    int  base_vertex;
+    uint base_instance;
+};
+
+struct DrawCommand {
+    uint count;
+    uint instance_count;
+    uint first_index;
+    int  base_vertex;
+    uint base_instance;
+};
+
+layout(std430, binding = 0) readonly buffer Objects {
+    Object objects[];
+};
+
+layout(std430, binding = 1) buffer Visibility {
+    uint visible[];
+};
+
+layout(std430, binding = 2) buffer Commands {
+    uint        draw_count;
+    uint        padding[3];
+    DrawCommand commands[];
+};
+
+layout(binding = 0) uniform sampler2D u_hiz;
+
+uniform mat4 u_view_projection;
+uniform vec4 u_planes[6];
+uniform uint u_object_count;
+uniform uint u_phase;
+uniform int  u_hiz_levels;
+
+bool in_frustum(vec3 lo, vec3 hi) {
+    for (int p = 0; p < 6; p++) {
+        vec3 corner = mix(lo, hi, greaterThanEqual(u_planes[p].xyz, vec3(0.0)));
+        if (dot(u_planes[p].xyz, corner) + u_planes[p].w < 0.0)
+            return false;
+    }
+    return true;
+}
+
+bool passes_hiz(vec3 lo, vec3 hi) {
+    if (u_hiz_levels == 0)
+        return true;
+
+    vec2  uv_min = vec2(1e30);
+    vec2  uv_max = vec2(-1e30);
+    float depth  = 1.0;
+    for (int i = 0; i < 8; i++) {
+        vec3 corner = vec3((i & 1) != 0 ? hi.x : lo.x, (i & 2) != 0 ? hi.y : lo.y, (i & 4) != 0 ? hi.z : lo.z);
+        vec4 clip   = u_view_projection * vec4(corner, 1.0);
+        if (clip.z + clip.w <= 0.0)
+            return true; // crosses the near plane
+
+        vec3 ndc = clip.xyz / clip.w;
+        uv_min   = min(uv_min, ndc.xy * 0.5 + 0.5);
+        uv_max   = max(uv_max, ndc.xy * 0.5 + 0.5);
+        depth    = min(depth, ndc.z * 0.5 + 0.5);
+    }
+
+    uv_min = clamp(uv_min, 0.0, 1.0);
+    uv_max = clamp(uv_max, 0.0, 1.0);
+
+    // the level where the rectangle covers at most 2x2 texels
+    vec2 extent = (uv_max - uv_min) * vec2(textureSize(u_hiz, 0));
+    int  level  = min(int(ceil(log2(max(max(extent.x, extent.y), 1.0)))), u_hiz_levels - 1);
+
+    ivec2 size = textureSize(u_hiz, level);
+    ivec2 lo_texel = min(ivec2(uv_min * vec2(size)), size - 1);
+    ivec2 hi_texel = min(ivec2(uv_max * vec2(size)), size - 1);
+    if (any(greaterThan(hi_texel - lo_texel, ivec2(1))) && level < u_hiz_levels - 1) {
+        level++;
+        size     = textureSize(u_hiz, level);
+        lo_texel = min(ivec2(uv_min * vec2(size)), size - 1);
+        hi_texel = min(ivec2(uv_max * vec2(size)), size - 1);
+    }
+
+    float occluder = max(max(texelFetch(u_hiz, lo_texel, level).r, texelFetch(u_hiz, hi_texel, level).r),
+                         max(texelFetch(u_hiz, ivec2(hi_texel.x, lo_texel.y), level).r,
+                             texelFetch(u_hiz, ivec2(lo_texel.x, hi_texel.y), level).r));
+    return depth <= occluder;
+}
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= u_object_count)
+        return;
+
+    Object o       = objects[i];
+    bool   frustum = in_frustum(o.min.xyz, o.max.xyz);
+
+    if (u_phase == 0u) {
+        if (!frustum || visible[i] == 0u)
+            return;
+    } else {
+        // objects the first phase drew are only re-tested for the next frame
+        bool drawn = frustum && visible[i] != 0u;
+        bool pass  = frustum && passes_hiz(o.min.xyz, o.max.xyz);
+
+        visible[i] = pass ? 1u : 0u;
+        if (!pass || drawn)
+            return;
+    }
+
+    uint slot = atomicAdd(draw_count, 1u);
+    commands[slot] = DrawCommand(o.count, 1u, o.first_index, o.base_vertex, o.base_instance);
+}
+)";
+
+        const std::string HIZ_COPY_SOURCE = R"(#version 460 core
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D u_depth;
+layout(r32f, binding = 0) writeonly uniform image2D u_output;
+
+void main() {
+    ivec2 p    = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(u_output);
+    if (any(greaterThanEqual(p, size)))
+        return;
+
+    // every depth texel this texel overlaps, the pyramid is at most 2x smaller so that is up to 3x3
+    ivec2 depth_size = textureSize(u_depth, 0);
+    ivec2 lo         = p * depth_size / size;
+    ivec2 hi         = min(((p + 1) * depth_size + size - 1) / size, depth_size);
+
+    float depth = 0.0;
+    for (int y = lo.y; y < hi.y; y++) {
+        for (int x = lo.x; x < hi.x; x++) {
+            depth = max(depth, texelFetch(u_depth, ivec2(x, y), 0).r);
+        }
+    }
+
+    imageStore(u_output, p, vec4(depth));
+}
+)";
+
+        const std::string HIZ_REDUCE_SOURCE = R"(#version 460 core
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(r32f, binding = 0) readonly uniform image2D u_input;
+layout(r32f, binding = 1) writeonly uniform image2D u_output;
+
+void main() {
+    ivec2 p    = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(u_output);
+    if (any(greaterThanEqual(p, size)))
+        return;
+
+    // a side that is already 1 texel wide repeats its only texel
+    ivec2 last = imageSize(u_input) - 1;
+    ivec2 s    = p * 2;
+
+    float depth = max(max(imageLoad(u_input, min(s, last)).r, imageLoad(u_input, min(s + ivec2(1, 0), last)).r),
+                      max(imageLoad(u_input, min(s + ivec2(0, 1), last)).r, imageLoad(u_input, min(s + 1, last)).r));
+
+    imageStore(u_output, p, vec4(depth));
+}
+)";
+    } // namespace
+
+    OcclusionCuller::OcclusionCuller(const std::shared_ptr<GpuResources> &resources) : m_resources(resources) {
+        m_object_buffer     = m_resources->create_buffer();
+        m_visibility        = m_resources->create_buffer();
+        m_previous_commands = m_resources->create_buffer();
+        m_new_commands      = m_resources->create_buffer();
+        m_indirect_buffer   = m_resources->create_buffer();
+    }
+
+    OcclusionCuller::~OcclusionCuller() {
+        m_resources->destroy(m_object_buffer);
+        m_resources->destroy(m_visibility);
+        m_resources->destroy(m_previous_commands);
+        m_resources->destroy(m_new_commands);
+        m_resources->destroy(m_indirect_buffer);
+    }
+
+    std::shared_ptr<OcclusionCuller> OcclusionCuller::create(const std::shared_ptr<GpuResources> &resources) {
+        return std::make_shared<OcclusionCuller>(resources);
+    }
+
+    OcclusionCuller::GpuObject OcclusionCuller::to_gpu(const OcclusionObject &object) {
+        return { glm::vec4(object.bounds.min, 0.0f), glm::vec4(object.bounds.max, 0.0f), object.count,
+                 object.first_index, object.base_vertex, object.base_instance };
+    }
+
+    void OcclusionCuller::set_objects(std::span<const OcclusionObject> objects) {
+        m_objects.assign(objects.begin(), objects.end());
+        if (m_objects.empty())
+            return;
+
+        std::vector<GpuObject> gpu;
+        gpu.reserve(m_objects.size());
+        for (const auto &object : m_objects) {
+            gpu.push_back(to_gpu(object));
+        }
+
+        const std::vector<uint32_t> visible(m_objects.size(), 1);
+        const size_t commands = GPU_COMMANDS_OFFSET + m_objects.size() * sizeof(DrawElementsIndirectCommand);
+
+        m_resources->get(m_object_buffer).set(gpu.data(), gpu.size() * sizeof(GpuObject), BufferUsage::DynamicDraw);
+        m_resources->get(m_visibility).set(visible.data(), visible.size() * sizeof(uint32_t), BufferUsage::DynamicCopy);
+        m_resources->get(m_previous_commands).set(nullptr, commands, BufferUsage::DynamicCopy);
+        m_resources->get(m_new_commands).set(nullptr, commands, BufferUsage::DynamicCopy);
+    }
+
+    void OcclusionCuller::set_bounds(uint32_t index, const Aabb &bounds) {
+        m_objects.at(index).bounds = bounds;
+
+        const GpuObject gpu = to_gpu(m_objects[index]);
+        glNamedBufferSubData(m_resources->get(m_object_buffer).get_handle(),
+                             static_cast<GLintptr>(index * sizeof(GpuObject)), sizeof(GpuObject), &gpu);
+    }
+
+    void OcclusionCuller::cull_previous(const glm::mat4 &view_projection) {
+        dispatch_cull(view_projection, m_resources->get(m_previous_commands), PHASE_PREVIOUS);
+    }
+
+    void OcclusionCuller::draw_previous() const { draw_commands(m_resources->get(m_previous_commands)); }
+
+    void OcclusionCuller::cull_new(const glm::mat4 &view_projection) {
+        dispatch_cull(view_projection, m_resources->get(m_new_commands), PHASE_NEW);
+    }
+
+    void OcclusionCuller::draw_new() const { draw_commands(m_resources->get(m_new_commands)); }
+
+    void OcclusionCuller::build_hiz(const Texture2D &depth) {
+        if (!m_copy_pipeline) {
+            m_copy_pipeline   = ComputePipeline::create(HIZ_COPY_SOURCE);
+            m_reduce_pipeline = ComputePipeline::create(HIZ_REDUCE_SOURCE);
+        }
+
+        // power of two levels halve exactly, so a texel of any level covers the same screen area as in level 0
+        const uint32_t width  = std::bit_floor(depth.get_width());
+        const uint32_t height = std::bit_floor(depth.get_height());
+        if (!m_hiz || m_hiz->get_width() != width || m_hiz->get_height() != height) {
+            m_hiz = Texture2D::create(width, height, TextureFormat::R32F);
+            m_hiz->set_sampler({ .min_filter = TextureFilter::NearestMipmapNearest,
+                                 .mag_filter = TextureFilter::Nearest,
+                                 .wrap_s     = TextureWrap::ClampToEdge,
+                                 .wrap_t     = TextureWrap::ClampToEdge });
+        }
+
+        m_copy_pipeline->set_texture(0, depth);
+        m_copy_pipeline->set_image(0, *m_hiz, 0, ComputeAccess::WriteOnly, TextureFormat::R32F);
+        m_copy_pipeline->dispatch(width, height);
+
+        // each level waits for the previous one through the barrier tracking
+        for (uint32_t level = 1; level < m_hiz->get_levels(); level++) {
+            m_reduce_pipeline->set_image(0, *m_hiz, level - 1, ComputeAccess::ReadOnly, TextureFormat::R32F);
+            m_reduce_pipeline->set_image(1, *m_hiz, level, ComputeAccess::WriteOnly, TextureFormat::R32F);
+            m_reduce_pipeline->dispatch(std::max(width >> level, 1u), std::max(height >> level, 1u));
+        }
+    }
+
+    void OcclusionCuller::dispatch_cull(const glm::mat4 &view_projection, const Buffer &commands, uint32_t phase) {
+        if (m_objects.empty())
+            return;
+
+        if (!m_cull_pipeline) {
+            m_cull_pipeline = ComputePipeline::create(CULL_SHADER_SOURCE);
+            m_cull_pipeline->set_storage(0, m_resources->get(m_object_buffer), ComputeAccess::ReadOnly);
+            m_cull_pipeline->set_storage(1, m_resources->get(m_visibility));
+        }
+
+        MemoryBarriers::require(commands, GL_BUFFER_UPDATE_BARRIER_BIT);
+        glClearNamedBufferSubData(commands.get_handle(), GL_R32UI, 0, sizeof(uint32_t), GL_RED_INTEGER,
+                                  GL_UNSIGNED_INT, nullptr);
+
+        const Shader &shader  = m_cull_pipeline->get_shader();
+        const Frustum frustum = Frustum::from_matrix(view_projection);
+        for (int p = 0; p < 6; p++) {
+            shader.uniform4f("u_planes[" + std::to_string(p) + "]", frustum.planes[p]);
+        }
+        shader.uniform_matrix4f("u_view_projection", view_projection);
+        shader.uniform1ui("u_object_count", static_cast<uint32_t>(m_objects.size()));
+        shader.uniform1ui("u_phase", phase);
+        shader.uniform1i("u_hiz_levels", m_hiz ? static_cast<int>(m_hiz->get_levels()) : 0);
+
+        // phase two reads the visibility phase one wrote, the next frame's phase one what phase two wrote; the
+        // pipeline waits for those writes itself
+        if (m_hiz)
+            m_cull_pipeline->set_texture(0, *m_hiz);
+        m_cull_pipeline->set_storage(2, commands);
+        m_cull_pipeline->dispatch(static_cast<uint32_t>(m_objects.size()));
+    }
+
+    void OcclusionCuller::draw_commands(const Buffer &commands) const {
+        if (m_objects.empty())
+            return;
+
+        MemoryBarriers::require(commands, GL_COMMAND_BARRIER_BIT);
+        commands.bind(BufferTarget::DrawIndirect);
+        commands.bind(BufferTarget::Parameter);
+
+        glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                         reinterpret_cast<const void *>(GPU_COMMANDS_OFFSET), 0,
+                                         static_cast<GLsizei>(m_objects.size()), sizeof(DrawElementsIndirectCommand));
+    }
+
+    size_t OcclusionCuller::cull(const glm::mat4 &view_projection, const SoftwareOcclusion &occlusion,
+                                 std::vector<DrawElementsIndirectCommand> &commands) const {
+        const Frustum frustum = Frustum::from_matrix(view_projection);
+
+        size_t added = 0;
+        for (const auto &object : m_objects) {
+            if (!frustum.intersects_aabb(object.bounds.min, object.bounds.max) || !occlusion.is_visible(object.bounds))
+                continue;
+
+            commands.push_back({ object.count, 1, object.first_index, object.base_vertex, object.base_instance });
+            added++;
+        }
+        return added;
+    }
+
+    void OcclusionCuller::draw(std::span<const DrawElementsIndirectCommand> commands) {
+        if (commands.empty())
+            return;
+
+        Buffer &indirect_buffer = m_resources->get(m_indirect_buffer);
+        indirect_buffer.set(commands.data(), commands.size_bytes(), BufferUsage::StreamDraw);
+        indirect_buffer.bind(BufferTarget::DrawIndirect);
+
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(commands.size()), 0);
+    }
+
+} // namespace kat
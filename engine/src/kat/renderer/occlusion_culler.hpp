@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "compute_pipeline.hpp"
+#include "gpu_resources.hpp"
+#include "software_occlusion.hpp"
+#include "texture.hpp"
+#include "kat/utils/aabb.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    // One draw that is culled as a whole. All objects share the caller's vertex array and index buffer.
+    struct OcclusionObject {
+        Aabb     bounds; // world space
+        uint32_t count;
+        uint32_t first_index;
+        int32_t  base_vertex   = 0;
+        uint32_t base_instance = 0; // e.g. the draw table index for KAT_DRAW_INDEX
+    };
+
+    // Two phase occlusion culling on the GPU, without CPU readback:
+    //
+    //   cull_previous(vp); draw_previous();   objects visible last frame, frustum culled only
+    //   build_hiz(depth);                     max-depth pyramid of what was just drawn
+    //   cull_new(vp); draw_new();             everything else that passes the pyramid test
+    //
+    // cull_new() also stores which objects passed, that is the visible set of the next frame. Objects start out
+    // visible, so the first frame draws everything in phase one. Bind the vertex array and draw shader before
+    // drawing, the cull and pyramid programs are left bound. Depth is expected in the default [0, 1] range with a
+    // less-than test.
+    class OcclusionCuller {
+      public:
+        explicit OcclusionCuller(const std::shared_ptr<GpuResources> &resources);
+
+        ~OcclusionCuller();
+
+        OcclusionCuller(const OcclusionCuller &)            = delete;
+        OcclusionCuller &operator=(const OcclusionCuller &) = delete;
+
+        static std::shared_ptr<OcclusionCuller> create(const std::shared_ptr<GpuResources> &resources);
+
+        // Replaces the object list and marks everything visible.
+        void set_objects(std::span<const OcclusionObject> objects);
+
+        // Updates bounds of objects that moved, keeps their visibility.
+        void set_bounds(uint32_t index, const Aabb &bounds);
+
+        void cull_previous(const glm::mat4 &view_projection);
+
+        void draw_previous() const;
+
+        // Rebuilds the pyramid from a depth texture (Depth32F, Depth24Stencil8 or R32F). The pyramid's level 0 is
+        // the largest power of two size no bigger than the depth texture.
+        void build_hiz(const Texture2D &depth);
+
+        void cull_new(const glm::mat4 &view_projection);
+
+        void draw_new() const;
+
+        // CPU path for software drivers: appends a command for every object inside the frustum that `occlusion`
+        // doesn't hide. Draw them with draw().
+        size_t cull(const glm::mat4 &view_projection, const SoftwareOcclusion &occlusion,
+                    std::vector<DrawElementsIndirectCommand> &commands) const;
+
+        void draw(std::span<const DrawElementsIndirectCommand> commands);
+
+        // sampling it outside the culler needs MemoryBarriers::require(hiz, GL_TEXTURE_FETCH_BARRIER_BIT) first
+        [[nodiscard]] const std::shared_ptr<Texture2D> &get_hiz() const noexcept { return m_hiz; }
+
+        [[nodiscard]] size_t get_count() const noexcept { return m_objects.size(); }
+
+      private:
+        // std430 layout of Object in the cull shader
+        struct GpuObject {
+            glm::vec4 min;
+            glm::vec4 max;
+            uint32_t  count;
+            uint32_t  first_index;
+            int32_t   base_vertex;
+            uint32_t  base_instance;
+        };
+
+        void dispatch_cull(const glm::mat4 &view_projection, const Buffer &commands, uint32_t phase);
+
+        void draw_commands(const Buffer &commands) const;
+
+        [[nodiscard]] static GpuObject to_gpu(const OcclusionObject &object);
+
+        std::vector<OcclusionObject> m_objects;
+
+        std::shared_ptr<GpuResources> m_resources;
+        Handle<Buffer>                m_object_buffer;
+        Handle<Buffer>                m_visibility;
+        Handle<Buffer>                m_previous_commands;
+        Handle<Buffer>                m_new_commands;
+        Handle<Buffer>                m_indirect_buffer;
+
+        std::shared_ptr<Texture2D>       m_hiz;
+        std::shared_ptr<ComputePipeline> m_cull_pipeline;
+        std::shared_ptr<ComputePipeline> m_copy_pipeline;
+        std::shared_ptr<ComputePipeline> m_reduce_pipeline;
+    };
+
+} // namespace kat
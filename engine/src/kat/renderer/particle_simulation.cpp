@@ -0,0 +1,166 @@
+#include "particle_simulation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "kat/utils/simd.hpp"
+
+namespace kat {
+
+    ParticleSimulation::ParticleSimulation(uint32_t capacity) : m_capacity(capacity) {
+        for (auto *array : { &m_position_x, &m_position_y, &m_position_z, &m_velocity_x, &m_velocity_y, &m_velocity_z,
+                             &m_age, &m_lifetime }) {
+            array->resize(capacity);
+        }
+    }
+
+    void ParticleSimulation::emit(uint32_t count) {
+        // requests that find no room still use up their random states, like on the GPU
+        const uint32_t first = m_emitted;
+        m_emitted += count;
+        count = std::min(count, m_capacity - m_count);
+
+        const ParticleEmitter &e = m_emitter;
+        for (uint32_t n = 0; n < count; n++, m_count++) {
+            // the same draws in the same order as the emit shader
+            uint32_t state = first + n;
+            const float px = particle_random(state) * 2.0f - 1.0f;
+            const float py = particle_random(state) * 2.0f - 1.0f;
+            const float pz = particle_random(state) * 2.0f - 1.0f;
+            const float vx = particle_random(state) * 2.0f - 1.0f;
+            const float vy = particle_random(state) * 2.0f - 1.0f;
+            const float vz = particle_random(state) * 2.0f - 1.0f;
+            const float lt = particle_random(state) * 2.0f - 1.0f;
+
+            m_position_x[m_count] = e.position.x + px * e.position_spread.x;
+            m_position_y[m_count] = e.position.y + py * e.position_spread.y;
+            m_position_z[m_count] = e.position.z + pz * e.position_spread.z;
+            m_velocity_x[m_count] = e.velocity.x + vx * e.velocity_spread.x;
+            m_velocity_y[m_count] = e.velocity.y + vy * e.velocity_spread.y;
+            m_velocity_z[m_count] = e.velocity.z + vz * e.velocity_spread.z;
+            m_age[m_count]        = 0.0f;
+            m_lifetime[m_count]   = std::max(e.lifetime + lt * e.lifetime_spread, 1e-3f);
+        }
+    }
+
+    void ParticleSimulation::update(float dt) {
+        m_pending += m_emitter.rate * dt;
+        const float whole = std::floor(m_pending);
+        m_pending -= whole;
+        emit(static_cast<uint32_t>(std::min(whole, static_cast<float>(m_capacity))));
+
+        integrate(0, m_count, dt, std::max(1.0f - m_emitter.drag * dt, 0.0f));
+
+        // stable compaction of the survivors
+        uint32_t alive = 0;
+        for (uint32_t i = 0; i < m_count; i++) {
+            if (m_age[i] >= m_lifetime[i])
+                continue;
+
+            if (alive != i) {
+                m_position_x[alive] = m_position_x[i];
+                m_position_y[alive] = m_position_y[i];
+                m_position_z[alive] = m_position_z[i];
+                m_velocity_x[alive] = m_velocity_x[i];
+                m_velocity_y[alive] = m_velocity_y[i];
+                m_velocity_z[alive] = m_velocity_z[i];
+                m_age[alive]        = m_age[i];
+                m_lifetime[alive]   = m_lifetime[i];
+            }
+            alive++;
+        }
+        m_count = alive;
+    }
+
+    void ParticleSimulation::integrate(uint32_t begin, uint32_t end, float dt, float damping) {
+        const glm::vec3 gravity_step = m_emitter.gravity * dt;
+
+        uint32_t i = begin;
+#ifdef KAT_SIMD_AVX2
+        {
+            const __m256 step = _mm256_set1_ps(dt);
+            const __m256 damp = _mm256_set1_ps(damping);
+            const __m256 gx   = _mm256_set1_ps(gravity_step.x);
+            const __m256 gy   = _mm256_set1_ps(gravity_step.y);
+            const __m256 gz   = _mm256_set1_ps(gravity_step.z);
+
+            // no fused multiply-add, the results have to match the scalar tail and the shader's operation order
+            for (; i + 8 <= end; i += 8) {
+                _mm256_storeu_ps(m_age.data() + i, _mm256_add_ps(_mm256_loadu_ps(m_age.data() + i), step));
+
+                const __m256 vx = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(m_velocity_x.data() + i), gx), damp);
+                const __m256 vy = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(m_velocity_y.data() + i), gy), damp);
+                const __m256 vz = _mm256_mul_ps(_mm256_add_ps(_mm256_loadu_ps(m_velocity_z.data() + i), gz), damp);
+                _mm256_storeu_ps(m_velocity_x.data() + i, vx);
+                _mm256_storeu_ps(m_velocity_y.data() + i, vy);
+                _mm256_storeu_ps(m_velocity_z.data() + i, vz);
+
+                _mm256_storeu_ps(m_position_x.data() + i,
+                                 _mm256_add_ps(_mm256_loadu_ps(m_position_x.data() + i), _mm256_mul_ps(vx, step)));
+                _mm256_storeu_ps(m_position_y.data() + i,
+                                 _mm256_add_ps(_mm256_loadu_ps(m_position_y.data() + i), _mm256_mul_ps(vy, step)));
+                _mm256_storeu_ps(m_position_z.data() + i,
+                                 _mm256_add_ps(_mm256_loadu_ps(m_position_z.data() + i), _mm256_mul_ps(vz, step)));
+            }
+        }
+#endif
+#ifdef KAT_SIMD_SSE2
+        {
+            const __m128 step = _mm_set1_ps(dt);
+            const __m128 damp = _mm_set1_ps(damping);
+            const __m128 gx   = _mm_set1_ps(gravity_step.x);
+            const __m128 gy   = _mm_set1_ps(gravity_step.y);
+            const __m128 gz   = _mm_set1_ps(gravity_step.z);
+
+            for (; i + 4 <= end; i += 4) {
+                _mm_storeu_ps(m_age.data() + i, _mm_add_ps(_mm_loadu_ps(m_age.data() + i), step));
+
+                const __m128 vx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(m_velocity_x.data() + i), gx), damp);
+                const __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(m_velocity_y.data() + i), gy), damp);
+                const __m128 vz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(m_velocity_z.data() + i), gz), damp);
+                _mm_storeu_ps(m_velocity_x.data() + i, vx);
+                _mm_storeu_ps(m_velocity_y.data() + i, vy);
+                _mm_storeu_ps(m_velocity_z.data() + i, vz);
+
+                _mm_storeu_ps(m_position_x.data() + i,
+                              _mm_add_ps(_mm_loadu_ps(m_position_x.data() + i), _mm_mul_ps(vx, step)));
+                _mm_storeu_ps(m_position_y.data() + i,
+                              _mm_add_ps(_mm_loadu_ps(m_position_y.data() + i), _mm_mul_ps(vy, step)));
+                _mm_storeu_ps(m_position_z.data() + i,
+                              _mm_add_ps(_mm_loadu_ps(m_position_z.data() + i), _mm_mul_ps(vz, step)));
+            }
+        }
+#endif
+        for (; i < end; i++) {
+            m_age[i] += dt;
+
+            m_velocity_x[i] = (m_velocity_x[i] + gravity_step.x) * damping;
+            m_velocity_y[i] = (m_velocity_y[i] + gravity_step.y) * damping;
+            m_velocity_z[i] = (m_velocity_z[i] + gravity_step.z) * damping;
+
+            m_position_x[i] += m_velocity_x[i] * dt;
+            m_position_y[i] += m_velocity_y[i] * dt;
+            m_position_z[i] += m_velocity_z[i] * dt;
+        }
+    }
+
+    void ParticleSimulation::clear() noexcept {
+        m_count   = 0;
+        m_pending = 0.0f;
+    }
+
+    void ParticleSimulation::sort_back_to_front(const glm::mat4 &view, std::vector<uint32_t> &order) const {
+        // view space z, the third row of the view matrix; more negative is further away
+        std::vector<float> depth(m_count);
+        for (uint32_t i = 0; i < m_count; i++) {
+            depth[i] = view[0][2] * m_position_x[i] + view[1][2] * m_position_y[i] + view[2][2] * m_position_z[i] +
+                       view[3][2];
+        }
+
+        order.resize(m_count);
+        std::iota(order.begin(), order.end(), 0u);
+        std::ranges::sort(order, {}, [&](uint32_t i) { return depth[i]; });
+    }
+
+} // namespace kat
@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    // What a particle system emits and how its particles move, shared by the GPU and CPU simulations.
+    struct ParticleEmitter {
+        glm::vec3 position        = { 0.0f, 0.0f, 0.0f };
+        glm::vec3 position_spread = { 0.0f, 0.0f, 0.0f }; // half extents of the box particles start in
+        glm::vec3 velocity        = { 0.0f, 1.0f, 0.0f };
+        glm::vec3 velocity_spread = { 0.5f, 0.5f, 0.5f }; // added per axis, uniformly in [-spread, spread]
+        float     rate            = 1000.0f;              // particles per second
+        float     lifetime        = 2.0f;                 // seconds
+        float     lifetime_spread = 0.5f;
+
+        glm::vec3 gravity = { 0.0f, -9.81f, 0.0f };
+        float     drag    = 0.1f; // fraction of the velocity lost per second
+
+        // interpolated over a particle's life when drawing
+        glm::vec4 start_color = { 1.0f, 1.0f, 1.0f, 1.0f };
+        glm::vec4 end_color   = { 1.0f, 1.0f, 1.0f, 0.0f };
+        float     start_size  = 0.1f;
+        float     end_size    = 0.05f;
+    };
+
+    // PCG hash. Emission draws its random numbers from it on both simulations, particle n of a system starts from
+    // state n, so the same emitter emits the same particles on either.
+    [[nodiscard]] constexpr uint32_t particle_hash(uint32_t x) noexcept {
+        const uint32_t state = x * 747796405u + 2891336453u;
+        const uint32_t word  = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+        return (word >> 22u) ^ word;
+    }
+
+    // next random number in [0, 1)
+    [[nodiscard]] constexpr float particle_random(uint32_t &state) noexcept {
+        state = particle_hash(state);
+        return static_cast<float>(state >> 8u) * (1.0f / 16777216.0f);
+    }
+
+    // The particle simulation on the CPU, structure of arrays and 8 (AVX2) or 4 (SSE2) particles per iteration. It
+    // follows the compute shaders of ParticleSystem step for step, which makes it the reference to check them
+    // against, and is enough on its own for effects too small to be worth the dispatches.
+    class ParticleSimulation {
+      public:
+        explicit ParticleSimulation(uint32_t capacity);
+
+        void set_emitter(const ParticleEmitter &emitter) noexcept { m_emitter = emitter; }
+
+        [[nodiscard]] const ParticleEmitter &get_emitter() const noexcept { return m_emitter; }
+
+        // emits right away, as many as there is room for
+        void emit(uint32_t count);
+
+        // emits at the emitter's rate, then ages and moves every particle and drops the ones that died
+        void update(float dt);
+
+        void clear() noexcept;
+
+        // Indices of the particles ordered back to front for `view`, for alpha blending.
+        void sort_back_to_front(const glm::mat4 &view, std::vector<uint32_t> &order) const;
+
+        [[nodiscard]] uint32_t get_count() const noexcept { return m_count; }
+
+        [[nodiscard]] uint32_t get_capacity() const noexcept { return m_capacity; }
+
+        [[nodiscard]] glm::vec3 get_position(uint32_t i) const {
+            return { m_position_x[i], m_position_y[i], m_position_z[i] };
+        }
+
+        [[nodiscard]] glm::vec3 get_velocity(uint32_t i) const {
+            return { m_velocity_x[i], m_velocity_y[i], m_velocity_z[i] };
+        }
+
+        [[nodiscard]] float get_age(uint32_t i) const { return m_age[i]; }
+
+        [[nodiscard]] float get_lifetime(uint32_t i) const { return m_lifetime[i]; }
+
+      private:
+        // ages and moves [begin, end)
+        void integrate(uint32_t begin, uint32_t end, float dt, float damping);
+
+        ParticleEmitter m_emitter;
+        uint32_t        m_capacity;
+        uint32_t        m_count   = 0;
+        uint32_t        m_emitted = 0; // random state of the next particle
+        float           m_pending = 0.0f;
+
+        std::vector<float> m_position_x;
+        std::vector<float> m_position_y;
+        std::vector<float> m_position_z;
+        std::vector<float> m_velocity_x;
+        std::vector<float> m_velocity_y;
+        std::vector<float> m_velocity_z;
+        std::vector<float> m_age;
+        std::vector<float> m_lifetime;
+    };
+
+} // namespace kat
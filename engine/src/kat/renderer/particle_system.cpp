@@ -0,0 +1,480 @@
+#include "particle_system.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace kat {
+    namespace {
+        constexpr uint32_t SORT_BLOCK = 512; // keys one work group of the local sort holds in shared memory
+
+        const std::string PARTICLES_INCLUDE_SOURCE = R"(
+struct KatParticle {
+    vec4 position_age;
+    vec4 velocity_lifetime;
+};
+
+layout(std430, binding = 0) buffer KatParticles {
+    KatParticle kat_particles[];
+};
+
+layout(std430, binding = 1) buffer KatParticleState {
+    uvec4 kat_dispatch;
+    uvec4 kat_draw;
+    int   kat_dead_count;
+    uint  kat_alive_count[2];
+};
+
+layout(std430, binding = 2) buffer KatDeadList {
+    uint kat_dead[];
+};
+
+layout(std430, binding = 3) buffer KatAliveList {
+    uint kat_alive[];
+};
+
+layout(std430, binding = 4) buffer KatAliveNext {
+    uint kat_alive_next[];
+};
+
+layout(std430, binding = 5) buffer KatSortKeys {
+    float kat_sort_keys[];
+};
+
+// particle_hash() and particle_random() of particle_simulation.hpp
+uint kat_particle_hash(uint x) {
+    uint state = x * 747796405u + 2891336453u;
+    uint word  = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+float kat_particle_random(inout uint state) {
+    state = kat_particle_hash(state);
+    return float(state >> 8u) * (1.0 / 16777216.0);
+}
+)";
+
+        const std::string EMIT_SHADER_SOURCE = R"(#version 460 core
+#include "kat/particles.glsl"
+layout(local_size_x = 64) in;
+
+uniform uint  u_count;
+uniform uint  u_seed;
+uniform uint  u_current;
+uniform vec3  u_position;
+uniform vec3  u_position_spread;
+uniform vec3  u_velocity;
+uniform vec3  u_velocity_spread;
+uniform float u_lifetime;
+uniform float u_lifetime_spread;
+
+void main() {
+    uint id = gl_GlobalInvocationID.x;
+    if (id >= u_count)
+        return;
+
+    // pop a dead slot, putting the count back when the list ran dry
+    int dead = atomicAdd(kat_dead_count, -1);
+    if (dead <= 0) {
+        atomicAdd(kat_dead_count, 1);
+        return;
+    }
+
+    uint  state = u_seed + id;
+    float px    = kat_particle_random(state) * 2.0 - 1.0;
+    float py    = kat_particle_random(state) * 2.0 - 1.0;
+    float pz    = kat_particle_random(state) * 2.0 - 1.0;
+    float vx    = kat_particle_random(state) * 2.0 - 1.0;
+    float vy    = kat_particle_random(state) * 2.0 - 1.0;
+    float vz    = kat_particle_random(state) * 2.0 - 1.0;
+    float lt    = kat_particle_random(state) * 2.0 - 1.0;
+
+    uint index = kat_dead[dead - 1];
+    kat_particles[index] = KatParticle(vec4(u_position + vec3(px, py, pz) * u_position_spread, 0.0),
+                                       vec4(u_velocity + vec3(vx, vy, vz) * u_velocity_spread,
+                                            max(u_lifetime + lt * u_lifetime_spread, 1e-3)));
+    kat_alive[atomicAdd(kat_alive_count[u_current], 1u)] = index;
+}
+)";
+
+        const std::string PREPARE_SHADER_SOURCE = R"(#version 460 core
+#include "kat/particles.glsl"
+layout(local_size_x = 1) in;
+
+uniform uint u_current;
+
+void main() {
+    kat_dispatch                    = uvec4((kat_alive_count[u_current] + 63u) / 64u, 1u, 1u, 0u);
+    kat_alive_count[1u - u_current] = 0u;
+}
+)";
+
+        const std::string SIMULATE_SHADER_SOURCE = R"(#version 460 core
+#include "kat/particles.glsl"
+layout(local_size_x = 64) in;
+
+uniform uint  u_current;
+uniform float u_dt;
+uniform vec3  u_gravity_step;
+uniform float u_damping;
+uniform vec4  u_depth_row; // third row of the view matrix
+
+void main() {
+    uint id = gl_GlobalInvocationID.x;
+    if (id >= kat_alive_count[u_current])
+        return;
+
+    uint        index = kat_alive[id];
+    KatParticle p     = kat_particles[index];
+
+    p.position_age.w += u_dt;
+    if (p.position_age.w >= p.velocity_lifetime.w) {
+        kat_dead[atomicAdd(kat_dead_count, 1)] = index;
+        return;
+    }
+
+    p.velocity_lifetime.xyz = (p.velocity_lifetime.xyz + u_gravity_step) * u_damping;
+    p.position_age.xyz += p.velocity_lifetime.xyz * u_dt;
+    kat_particles[index] = p;
+
+    // survivors are compacted into the other list, with their view depth as sort key
+    uint slot            = atomicAdd(kat_alive_count[1u - u_current], 1u);
+    kat_alive_next[slot] = index;
+    kat_sort_keys[slot]  = dot(u_depth_row, vec4(p.position_age.xyz, 1.0));
+}
+)";
+
+        const std::string FINISH_SHADER_SOURCE = R"(#version 460 core
+#include "kat/particles.glsl"
+layout(local_size_x = 1) in;
+
+uniform uint u_current;
+
+void main() {
+    kat_draw = uvec4(4u, kat_alive_count[u_current], 0u, 0u);
+}
+)";
+
+        // Bitonic sort, ascending view depth is back to front. Both shaders treat element i and i + j as a pair,
+        // ordered ascending when bit k of i is clear.
+        const std::string SORT_LOCAL_SHADER_SOURCE = R"(#version 460 core
+#include "kat/particles.glsl"
+layout(local_size_x = 256) in;
+
+// 0 sorts every block of 512 on its own, otherwise the steps of stage u_k that stay inside a block
+uniform uint u_k;
+
+shared float s_keys[512];
+shared uint  s_values[512];
+
+void main() {
+    uint t    = gl_LocalInvocationID.x;
+    uint base = gl_WorkGroupID.x * 512u;
+
+    s_keys[t]          = kat_sort_keys[base + t];
+    s_keys[t + 256u]   = kat_sort_keys[base + t + 256u];
+    s_values[t]        = kat_alive[base + t];
+    s_values[t + 256u] = kat_alive[base + t + 256u];
+    memoryBarrierShared();
+    barrier();
+
+    uint first = u_k == 0u ? 2u : u_k;
+    uint last  = u_k == 0u ? 512u : u_k;
+    for (uint k = first; k <= last; k <<= 1u) {
+        for (uint j = min(k, 512u) >> 1u; j > 0u; j >>= 1u) {
+            uint i = 2u * t - (t & (j - 1u));
+            if ((s_keys[i] > s_keys[i + j]) == (((base + i) & k) == 0u)) {
+                float key       = s_keys[i];
+                uint  value     = s_values[i];
+                s_keys[i]       = s_keys[i + j];
+                s_values[i]     = s_values[i + j];
+                s_keys[i + j]   = key;
+                s_values[i + j] = value;
+            }
+            memoryBarrierShared();
+            barrier();
+        }
+    }
+
+    kat_sort_keys[base + t]        = s_keys[t];
+    kat_sort_keys[base + t + 256u] = s_keys[t + 256u];
+    kat_alive[base + t]            = s_values[t];
+    kat_alive[base + t + 256u]     = s_values[t + 256u];
+}
+)";
+
+        const std::string SORT_GLOBAL_SHADER_SOURCE = R"(#version 460 core
+#include "kat/particles.glsl"
+layout(local_size_x = 256) in;
+
+uniform uint u_k;
+uniform uint u_j;
+
+void main() {
+    uint t = gl_GlobalInvocationID.x;
+    uint i = 2u * t - (t & (u_j - 1u));
+    uint l = i + u_j;
+
+    float a = kat_sort_keys[i];
+    float b = kat_sort_keys[l];
+    if ((a > b) == ((i & u_k) == 0u)) {
+        uint value       = kat_alive[i];
+        kat_sort_keys[i] = b;
+        kat_sort_keys[l] = a;
+        kat_alive[i]     = kat_alive[l];
+        kat_alive[l]     = value;
+    }
+}
+)";
+
+        const std::string DRAW_VERTEX_SOURCE = R"(#version 460 core
+#include "kat/particles.glsl"
+
+uniform mat4  u_view;
+uniform mat4  u_projection;
+uniform vec4  u_start_color;
+uniform vec4  u_end_color;
+uniform float u_start_size;
+uniform float u_end_size;
+
+out vec2 v_corner;
+out vec4 v_color;
+
+void main() {
+    KatParticle p = kat_particles[kat_alive[gl_InstanceID]];
+    float       t = clamp(p.position_age.w / p.velocity_lifetime.w, 0.0, 1.0);
+
+    v_corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+    v_color  = mix(u_start_color, u_end_color, t);
+
+    vec4 position = u_view * vec4(p.position_age.xyz, 1.0);
+    position.xy += v_corner * (mix(u_start_size, u_end_size, t) * 0.5);
+    gl_Position = u_projection * position;
+}
+)";
+
+        const std::string DRAW_FRAGMENT_SOURCE = R"(#version 460 core
+in vec2 v_corner;
+in vec4 v_color;
+
+out vec4 color_out;
+
+void main() {
+    float alpha = v_color.a * (1.0 - smoothstep(0.5, 1.0, length(v_corner)));
+    if (alpha <= 0.0)
+        discard;
+    color_out = vec4(v_color.rgb, alpha);
+}
+)";
+    } // namespace
+
+    ParticleSystem::ParticleSystem(const std::shared_ptr<GpuResources> &resources, uint32_t capacity) :
+        m_resources(resources), m_capacity(capacity), m_sort_size(std::max(std::bit_ceil(capacity), SORT_BLOCK)) {
+        ShaderModule::register_include("kat/particles.glsl", PARTICLES_INCLUDE_SOURCE);
+
+        // the alive lists and keys are padded to the sort size, the padding sorts behind every live particle
+        m_particles = m_resources->create_buffer(nullptr, static_cast<size_t>(capacity) * sizeof(GpuParticle),
+                                                 BufferUsage::DynamicCopy);
+        m_state     = m_resources->create_buffer();
+        m_dead      = m_resources->create_buffer();
+        m_alive[0]  = m_resources->create_buffer(nullptr, m_sort_size * sizeof(uint32_t), BufferUsage::DynamicCopy);
+        m_alive[1]  = m_resources->create_buffer(nullptr, m_sort_size * sizeof(uint32_t), BufferUsage::DynamicCopy);
+        m_sort_keys = m_resources->create_buffer(nullptr, m_sort_size * sizeof(float), BufferUsage::DynamicCopy);
+        clear();
+
+        const Buffer &particles = m_resources->get(m_particles);
+        const Buffer &state     = m_resources->get(m_state);
+        const Buffer &dead      = m_resources->get(m_dead);
+        const Buffer &sort_keys = m_resources->get(m_sort_keys);
+
+        m_emit_pipeline        = ComputePipeline::create(EMIT_SHADER_SOURCE);
+        m_prepare_pipeline     = ComputePipeline::create(PREPARE_SHADER_SOURCE);
+        m_simulate_pipeline    = ComputePipeline::create(SIMULATE_SHADER_SOURCE);
+        m_finish_pipeline      = ComputePipeline::create(FINISH_SHADER_SOURCE);
+        m_sort_local_pipeline  = ComputePipeline::create(SORT_LOCAL_SHADER_SOURCE);
+        m_sort_global_pipeline = ComputePipeline::create(SORT_GLOBAL_SHADER_SOURCE);
+
+        m_emit_pipeline->set_storage(0, particles, ComputeAccess::WriteOnly);
+        m_emit_pipeline->set_storage(1, state);
+        m_emit_pipeline->set_storage(2, dead, ComputeAccess::ReadOnly);
+        m_prepare_pipeline->set_storage(1, state);
+        m_simulate_pipeline->set_storage(0, particles);
+        m_simulate_pipeline->set_storage(1, state);
+        m_simulate_pipeline->set_storage(2, dead, ComputeAccess::WriteOnly);
+        m_simulate_pipeline->set_storage(5, sort_keys, ComputeAccess::WriteOnly);
+        m_finish_pipeline->set_storage(1, state);
+        m_sort_local_pipeline->set_storage(5, sort_keys);
+        m_sort_global_pipeline->set_storage(5, sort_keys);
+
+        m_draw_shader = m_resources->create_shader({
+            { DRAW_VERTEX_SOURCE, ShaderType::Vertex },
+            { DRAW_FRAGMENT_SOURCE, ShaderType::Fragment },
+        });
+        m_vertex_array = m_resources->create_vertex_array();
+    }
+
+    ParticleSystem::~ParticleSystem() {
+        m_resources->destroy(m_particles);
+        m_resources->destroy(m_state);
+        m_resources->destroy(m_dead);
+        m_resources->destroy(m_alive[0]);
+        m_resources->destroy(m_alive[1]);
+        m_resources->destroy(m_sort_keys);
+        m_resources->destroy(m_draw_shader);
+        m_resources->destroy(m_vertex_array);
+    }
+
+    std::shared_ptr<ParticleSystem> ParticleSystem::create(const std::shared_ptr<GpuResources> &resources,
+                                                           uint32_t                             capacity) {
+        return std::make_shared<ParticleSystem>(resources, capacity);
+    }
+
+    void ParticleSystem::clear() {
+        std::vector<uint32_t> dead(m_capacity);
+        std::iota(dead.begin(), dead.end(), 0u);
+        m_resources->get(m_dead).set(dead.data(), dead.size() * sizeof(uint32_t), BufferUsage::DynamicCopy);
+
+        const State state = { { 0, 1, 1, 0 }, { 4, 0, 0, 0 }, static_cast<int32_t>(m_capacity), { 0, 0 }, 0 };
+        m_resources->get(m_state).set(&state, sizeof(State), BufferUsage::DynamicCopy);
+
+        m_pending = 0.0f;
+        m_burst   = 0;
+    }
+
+    void ParticleSystem::update(float dt, const glm::mat4 &view) {
+        m_pending += m_emitter.rate * dt;
+        const float whole = std::floor(m_pending);
+        m_pending -= whole;
+
+        const auto count = static_cast<uint32_t>(
+            std::min(static_cast<float>(m_burst) + whole, static_cast<float>(m_capacity)));
+        m_burst = 0;
+
+        // the alive lists swap roles every update
+        const Buffer &current = m_resources->get(m_alive[m_current]);
+        m_emit_pipeline->set_storage(3, current, ComputeAccess::WriteOnly);
+        m_simulate_pipeline->set_storage(3, current, ComputeAccess::ReadOnly);
+        m_simulate_pipeline->set_storage(4, m_resources->get(m_alive[1 - m_current]), ComputeAccess::WriteOnly);
+
+        if (count > 0) {
+            const Shader &emit = m_emit_pipeline->get_shader();
+            emit.uniform1ui("u_count", count);
+            emit.uniform1ui("u_seed", m_emitted);
+            emit.uniform1ui("u_current", m_current);
+            emit.uniform3f("u_position", m_emitter.position);
+            emit.uniform3f("u_position_spread", m_emitter.position_spread);
+            emit.uniform3f("u_velocity", m_emitter.velocity);
+            emit.uniform3f("u_velocity_spread", m_emitter.velocity_spread);
+            emit.uniform1f("u_lifetime", m_emitter.lifetime);
+            emit.uniform1f("u_lifetime_spread", m_emitter.lifetime_spread);
+            m_emit_pipeline->dispatch(count);
+
+            m_emitted += count;
+        }
+
+        m_prepare_pipeline->get_shader().uniform1ui("u_current", m_current);
+        m_prepare_pipeline->dispatch(1);
+
+        if (m_sorting) {
+            const float padding = std::numeric_limits<float>::max();
+            const Buffer &sort_keys = m_resources->get(m_sort_keys);
+            MemoryBarriers::require(sort_keys, GL_BUFFER_UPDATE_BARRIER_BIT);
+            glClearNamedBufferData(sort_keys.get_handle(), GL_R32F, GL_RED, GL_FLOAT, &padding);
+        }
+
+        const Shader &simulate = m_simulate_pipeline->get_shader();
+        simulate.uniform1ui("u_current", m_current);
+        simulate.uniform1f("u_dt", dt);
+        simulate.uniform3f("u_gravity_step", m_emitter.gravity * dt);
+        simulate.uniform1f("u_damping", std::max(1.0f - m_emitter.drag * dt, 0.0f));
+        simulate.uniform4f("u_depth_row", glm::vec4(view[0][2], view[1][2], view[2][2], view[3][2]));
+        m_simulate_pipeline->dispatch_indirect(m_resources->get(m_state), offsetof(State, dispatch));
+
+        m_current = 1 - m_current;
+
+        m_finish_pipeline->get_shader().uniform1ui("u_current", m_current);
+        m_finish_pipeline->dispatch(1);
+
+        if (m_sorting)
+            sort();
+    }
+
+    void ParticleSystem::sort() {
+        const Buffer &alive = m_resources->get(m_alive[m_current]);
+        m_sort_local_pipeline->set_storage(3, alive);
+        m_sort_global_pipeline->set_storage(3, alive);
+
+        const uint32_t groups = m_sort_size / SORT_BLOCK;
+
+        // stages up to the block size run entirely in shared memory, larger ones only go through memory for the
+        // steps that cross blocks
+        m_sort_local_pipeline->get_shader().uniform1ui("u_k", 0);
+        m_sort_local_pipeline->dispatch_groups(groups);
+
+        for (uint32_t k = SORT_BLOCK * 2; k <= m_sort_size; k *= 2) {
+            for (uint32_t j = k / 2; j >= SORT_BLOCK; j /= 2) {
+                m_sort_global_pipeline->get_shader().uniform1ui("u_k", k);
+                m_sort_global_pipeline->get_shader().uniform1ui("u_j", j);
+                m_sort_global_pipeline->dispatch_groups(groups);
+            }
+
+            m_sort_local_pipeline->get_shader().uniform1ui("u_k", k);
+            m_sort_local_pipeline->dispatch_groups(groups);
+        }
+    }
+
+    void ParticleSystem::draw(const glm::mat4 &view, const glm::mat4 &projection) const {
+        const Buffer &state     = m_resources->get(m_state);
+        const Buffer &particles = m_resources->get(m_particles);
+        const Buffer &alive     = m_resources->get(m_alive[m_current]);
+        MemoryBarriers::issue(MemoryBarriers::pending(state, GL_COMMAND_BARRIER_BIT) |
+                              MemoryBarriers::pending(particles, GL_SHADER_STORAGE_BARRIER_BIT) |
+                              MemoryBarriers::pending(alive, GL_SHADER_STORAGE_BARRIER_BIT));
+
+        particles.bind_base(BufferTarget::ShaderStorage, 0);
+        alive.bind_base(BufferTarget::ShaderStorage, 3);
+
+        const Shader &shader = m_resources->get(m_draw_shader);
+        shader.uniform_matrix4f("u_view", view);
+        shader.uniform_matrix4f("u_projection", projection);
+        shader.uniform4f("u_start_color", m_emitter.start_color);
+        shader.uniform4f("u_end_color", m_emitter.end_color);
+        shader.uniform1f("u_start_size", m_emitter.start_size);
+        shader.uniform1f("u_end_size", m_emitter.end_size);
+        shader.bind();
+
+        // restored after the draw, later draws shouldn't inherit blending or lose their depth writes
+        const GLboolean previous_blend      = glIsEnabled(GL_BLEND);
+        const GLboolean previous_depth_test = glIsEnabled(GL_DEPTH_TEST);
+        GLboolean       previous_depth_mask;
+        GLint           previous_blend_func[4];
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &previous_depth_mask);
+        glGetIntegerv(GL_BLEND_SRC_RGB, &previous_blend_func[0]);
+        glGetIntegerv(GL_BLEND_DST_RGB, &previous_blend_func[1]);
+        glGetIntegerv(GL_BLEND_SRC_ALPHA, &previous_blend_func[2]);
+        glGetIntegerv(GL_BLEND_DST_ALPHA, &previous_blend_func[3]);
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_FALSE);
+
+        m_resources->get(m_vertex_array).bind();
+        state.bind(BufferTarget::DrawIndirect);
+        glDrawArraysIndirect(GL_TRIANGLE_STRIP, reinterpret_cast<const void *>(offsetof(State, draw)));
+
+        glBlendFuncSeparate(static_cast<GLenum>(previous_blend_func[0]), static_cast<GLenum>(previous_blend_func[1]),
+                            static_cast<GLenum>(previous_blend_func[2]), static_cast<GLenum>(previous_blend_func[3]));
+        glDepthMask(previous_depth_mask);
+        if (!previous_blend)
+            glDisable(GL_BLEND);
+        if (!previous_depth_test)
+            glDisable(GL_DEPTH_TEST);
+    }
+
+} // namespace kat
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+
+#include "compute_pipeline.hpp"
+#include "gpu_resources.hpp"
+#include "particle_simulation.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    // std430 layout of KatParticle
+    struct GpuParticle {
+        glm::vec4 position_age;
+        glm::vec4 velocity_lifetime;
+    };
+
+    static_assert(sizeof(GpuParticle) == 32);
+
+    // Particles that never leave the GPU. Dead particle slots sit on a free list: emission pops slots from it,
+    // simulation pushes the slots of particles that died back and appends the survivors to a compacted alive list,
+    // whose count drives the next dispatch and the draw indirectly, so the CPU never learns how many are alive.
+    // The alive list is then bitonic sorted back to front for alpha blending, which can be turned off for
+    // additive effects that don't care about order.
+    //
+    // Emission and motion follow ParticleEmitter exactly as ParticleSimulation does on the CPU.
+    class ParticleSystem {
+      public:
+        ParticleSystem(const std::shared_ptr<GpuResources> &resources, uint32_t capacity);
+
+        ~ParticleSystem();
+
+        ParticleSystem(const ParticleSystem &)            = delete;
+        ParticleSystem &operator=(const ParticleSystem &) = delete;
+
+        static std::shared_ptr<ParticleSystem> create(const std::shared_ptr<GpuResources> &resources,
+                                                      uint32_t                             capacity);
+
+        void set_emitter(const ParticleEmitter &emitter) noexcept { m_emitter = emitter; }
+
+        [[nodiscard]] const ParticleEmitter &get_emitter() const noexcept { return m_emitter; }
+
+        // a burst on top of the rate, emitted by the next update()
+        void emit(uint32_t count) noexcept { m_burst += count; }
+
+        // Emits, simulates and, unless disabled, sorts for `view`. Leaves a compute program bound.
+        void update(float dt, const glm::mat4 &view);
+
+        // camera facing quads, alpha blended without depth writes, the previous blend and depth state is restored
+        void draw(const glm::mat4 &view, const glm::mat4 &projection) const;
+
+        // kills every particle
+        void clear();
+
+        void set_sorting(bool sorting) noexcept { m_sorting = sorting; }
+
+        [[nodiscard]] uint32_t get_capacity() const noexcept { return m_capacity; }
+
+      private:
+        // std430 layout of KatParticleState
+        struct State {
+            uint32_t dispatch[4]; // indirect dispatch of the simulation, w unused
+            uint32_t draw[4];     // DrawArraysIndirectCommand
+            int32_t  dead_count;
+            uint32_t alive_count[2];
+            uint32_t padding;
+        };
+
+        void sort();
+
+        std::shared_ptr<GpuResources> m_resources;
+        uint32_t                      m_capacity;
+        uint32_t                      m_sort_size; // power of two of at least a local sort block
+        ParticleEmitter               m_emitter;
+        uint32_t                      m_burst   = 0;
+        uint32_t                      m_emitted = 0; // random state of the next particle
+        float                         m_pending = 0.0f;
+        uint32_t                      m_current = 0; // which alive list holds the live particles
+        bool                          m_sorting = true;
+
+        Handle<Buffer> m_particles;
+        Handle<Buffer> m_state;
+        Handle<Buffer> m_dead;
+        Handle<Buffer> m_alive[2];
+        Handle<Buffer> m_sort_keys;
+
+        std::shared_ptr<ComputePipeline> m_emit_pipeline;
+        std::shared_ptr<ComputePipeline> m_prepare_pipeline;
+        std::shared_ptr<ComputePipeline> m_simulate_pipeline;
+        std::shared_ptr<ComputePipeline> m_finish_pipeline;
+        std::shared_ptr<ComputePipeline> m_sort_local_pipeline;
+        std::shared_ptr<ComputePipeline> m_sort_global_pipeline;
+        Handle<Shader>                   m_draw_shader;
+        Handle<VertexArray>              m_vertex_array;
+    };
+
+} // namespace kat
@@ -0,0 +1,200 @@
+#include "render_queue.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+#include "shader.hpp"
+
+namespace kat {
+
+    RenderQueue::RenderQueue(const std::shared_ptr<GpuResources> &resources, size_t stream_size) :
+        m_resources(resources), m_stream(StreamBuffer::create(stream_size)) {
+        GLint alignment;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        m_storage_alignment = static_cast<size_t>(std::max(alignment, 16));
+
+        ShaderModule::register_include("kat/draws.glsl",
+                                       "struct KatDraw {\n"
+                                       "    mat4 model;\n"
+                                       "    uint material;\n"
+                                       "    uint padding0;\n"
+                                       "    uint padding1;\n"
+                                       "    uint padding2;\n"
+                                       "};\n"
+                                       "layout(std430, binding = " +
+                                           std::to_string(DRAW_TABLE_BINDING) +
+                                           ") readonly buffer KatDrawTable {\n"
+                                           "    KatDraw kat_draws[];\n"
+                                           "};\n"
+                                           "// vertex shader only, hand the material on as a flat varying\n"
+                                           "#define KAT_DRAW_INDEX (gl_BaseInstance + gl_InstanceID)\n");
+    }
+
+    RenderQueue::~RenderQueue() {
+        for (const Batch &batch : m_batches) {
+            m_resources->destroy(batch.vertex_array);
+        }
+    }
+
+    std::shared_ptr<RenderQueue> RenderQueue::create(const std::shared_ptr<GpuResources> &resources,
+                                                     size_t                               stream_size) {
+        return std::make_shared<RenderQueue>(resources, stream_size);
+    }
+
+    void RenderQueue::submit(const Mesh &mesh, const glm::mat4 &model, uint32_t material, size_t lod) {
+        Batch         &batch = batch_for(mesh);
+        const MeshLod &level = mesh.get_lod(std::min(lod, mesh.get_lod_count() - 1));
+
+        const auto first_index = static_cast<uint32_t>(mesh.get_index_offset() / sizeof(uint32_t)) + level.first_index;
+        const auto base_vertex = static_cast<int32_t>(mesh.get_vertex_offset() / sizeof(StandardVertex));
+
+        // instance_count and base_instance are filled in by flush once draws are grouped
+        batch.commands.push_back({ level.index_count, 1, first_index, base_vertex, 0 });
+        batch.draws.push_back({ model, material, {} });
+    }
+
+    void RenderQueue::flush() {
+        const size_t count = get_draw_count();
+
+        if (count > 0) {
+            // One command per draw at most, fewer once repeated meshes are merged. Draw data and commands share one
+            // allocation, so neither can wait on or wrap over the other, and a flush too big for the ring throws.
+            const size_t draws_size      = count * sizeof(DrawData);
+            const size_t commands_offset = (draws_size + 15) / 16 * 16;
+            const size_t block_size      = commands_offset + count * sizeof(DrawElementsIndirectCommand);
+            const auto   block           = m_stream->allocate(block_size, m_storage_alignment);
+
+            auto *draw_data    = static_cast<DrawData *>(block.data);
+            auto *command_data = reinterpret_cast<DrawElementsIndirectCommand *>(static_cast<std::byte *>(block.data) +
+                                                                                 commands_offset);
+
+            size_t next         = 0;
+            size_t next_command = 0;
+            for (Batch &batch : m_batches) {
+                const size_t first_command = next_command;
+                if (batch.draws.empty()) {
+                    batch.command_count = 0;
+                    continue;
+                }
+
+                // Draws of the same mesh range become instances of one command. Their draw data has to be
+                // contiguous for KAT_DRAW_INDEX, so order by range, then by material to keep those together too.
+                auto key = [&](uint32_t i) {
+                    const auto &c = batch.commands[i];
+                    return std::tuple(c.first_index, c.count, c.base_vertex, batch.draws[i].material);
+                };
+
+                m_order.resize(batch.draws.size());
+                std::iota(m_order.begin(), m_order.end(), 0u);
+                if (!std::ranges::is_sorted(m_order, {}, key))
+                    std::ranges::stable_sort(m_order, {}, key);
+
+                // built locally, the mapping is write-combined and slow to read back
+                DrawElementsIndirectCommand run = batch.commands[m_order.front()];
+                run.instance_count              = 0;
+                run.base_instance               = static_cast<uint32_t>(next);
+
+                for (const uint32_t i : m_order) {
+                    const auto &command = batch.commands[i];
+                    if (command.first_index != run.first_index || command.count != run.count ||
+                        command.base_vertex != run.base_vertex) {
+                        command_data[next_command++] = run;
+
+                        run                = command;
+                        run.instance_count = 0;
+                        run.base_instance  = static_cast<uint32_t>(next);
+                    }
+
+                    run.instance_count++;
+                    draw_data[next++] = batch.draws[i];
+                }
+
+                command_data[next_command++] = run;
+                batch.command_count          = next_command - first_command;
+            }
+
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, DRAW_TABLE_BINDING, m_stream->get_handle(),
+                              static_cast<GLintptr>(block.offset), static_cast<GLsizeiptr>(draws_size));
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_stream->get_handle());
+
+            size_t first = 0;
+            for (const Batch &batch : m_batches) {
+                if (batch.command_count == 0)
+                    continue;
+
+                m_resources->get(batch.vertex_array).bind();
+                glMultiDrawElementsIndirect(
+                    GL_TRIANGLES, GL_UNSIGNED_INT,
+                    reinterpret_cast<const void *>(block.offset + commands_offset +
+                                                   first * sizeof(DrawElementsIndirectCommand)),
+                    static_cast<GLsizei>(batch.command_count), 0);
+                first += batch.command_count;
+            }
+
+            m_command_count = next_command;
+            m_stream->fence();
+        }
+        else {
+            m_command_count = 0;
+        }
+
+        for (Batch &batch : m_batches) {
+            batch.commands.clear();
+            batch.draws.clear();
+        }
+
+        // drop vertex arrays of buffers that no longer exist
+        std::erase_if(m_batches, [&](const Batch &b) {
+            const bool gone = !m_resources->contains(b.vertices) || !m_resources->contains(b.indices);
+            if (gone)
+                m_resources->destroy(b.vertex_array);
+            return gone;
+        });
+        m_last_batch = 0;
+    }
+
+    size_t RenderQueue::get_draw_count() const noexcept {
+        size_t count = 0;
+        for (const auto &batch : m_batches) {
+            count += batch.draws.size();
+        }
+        return count;
+    }
+
+    RenderQueue::Batch &RenderQueue::batch_for(const Mesh &mesh) {
+        const Handle<Buffer> vertices = mesh.get_vertex_buffer();
+        const Handle<Buffer> indices  = mesh.get_index_buffer();
+
+        auto matches = [&](const Batch &batch) { return batch.vertices == vertices && batch.indices == indices; };
+
+        // consecutive submits usually come from the same model
+        if (m_last_batch < m_batches.size() && matches(m_batches[m_last_batch]))
+            return m_batches[m_last_batch];
+
+        for (size_t i = 0; i < m_batches.size(); i++) {
+            if (matches(m_batches[i])) {
+                m_last_batch = i;
+                return m_batches[i];
+            }
+        }
+
+        if (mesh.get_resources() != m_resources)
+            throw std::runtime_error("Mesh submitted to a RenderQueue of other GpuResources");
+
+        Batch batch;
+        batch.vertices     = vertices;
+        batch.indices      = indices;
+        batch.vertex_array = m_resources->create_vertex_array();
+        Mesh::setup_vertex_array(m_resources->get(batch.vertex_array), m_resources->get(vertices),
+                                 m_resources->get(indices));
+        m_batches.push_back(std::move(batch));
+
+        m_last_batch = m_batches.size() - 1;
+        return m_batches.back();
+    }
+
+} // namespace kat
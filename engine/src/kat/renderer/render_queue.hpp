@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "buffer.hpp"
+#include "gpu_resources.hpp"
+#include "mesh.hpp"
+#include "stream_buffer.hpp"
+#include "vertex_array.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    // shader storage binding of the per-draw data, see the "kat/draws.glsl" include
+    constexpr unsigned int DRAW_TABLE_BINDING = 10;
+
+    // std430 layout of KatDraw
+    struct DrawData {
+        glm::mat4 model;
+        uint32_t  material;
+        uint32_t  padding[3];
+    };
+
+    // Collects a frame's draws and issues one glMultiDrawElementsIndirect per vertex/index buffer pair. Per-draw data
+    // lives in a shader storage buffer that the vertex shader indexes with KAT_DRAW_INDEX ("kat/draws.glsl"), and
+    // with materials and textures coming from a MaterialTable and TextureRegistry nothing is rebound between draws.
+    // Meshes that share buffers (e.g. all primitives of a glTF model) end up in one batch, and repeated submits of
+    // the same mesh and level become instances of a single command, whatever their materials.
+    class RenderQueue {
+      public:
+        // Submitted meshes have to live in `resources`. stream_size bounds the commands and draw data of a single
+        // flush.
+        explicit RenderQueue(const std::shared_ptr<GpuResources> &resources, size_t stream_size = 8 * 1024 * 1024);
+
+        ~RenderQueue();
+
+        RenderQueue(const RenderQueue &)            = delete;
+        RenderQueue &operator=(const RenderQueue &) = delete;
+
+        static std::shared_ptr<RenderQueue> create(const std::shared_ptr<GpuResources> &resources,
+                                                   size_t                               stream_size = 8 * 1024 * 1024);
+
+        void submit(const Mesh &mesh, const glm::mat4 &model, uint32_t material, size_t lod = 0);
+
+        // Draws everything submitted since the last flush with the bound shader, then empties the queue.
+        void flush();
+
+        [[nodiscard]] size_t get_draw_count() const noexcept;
+
+        // indirect commands issued by the last flush, after instancing
+        [[nodiscard]] size_t get_command_count() const noexcept { return m_command_count; }
+
+      private:
+        struct Batch {
+            // a destroyed buffer's slot can come back for a new one, but never with the same generation
+            Handle<Buffer>      vertices;
+            Handle<Buffer>      indices;
+            Handle<VertexArray> vertex_array;
+
+            std::vector<DrawElementsIndirectCommand> commands;
+            std::vector<DrawData>                    draws;
+            size_t                                   command_count = 0;
+        };
+
+        Batch &batch_for(const Mesh &mesh);
+
+        std::shared_ptr<GpuResources> m_resources;
+        std::vector<Batch>            m_batches;
+        size_t                        m_last_batch = 0;
+        std::shared_ptr<StreamBuffer> m_stream;
+        size_t                        m_storage_alignment;
+        size_t                        m_command_count = 0;
+        std::vector<uint32_t>         m_order; // scratch for flush
+    };
+
+} // namespace kat
@@ -0,0 +1,80 @@
+#include "render_target_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace kat {
+
+    RenderTargetPool::RenderTargetPool(const std::shared_ptr<Engine> &engine, uint32_t max_idle_frames) :
+        m_max_idle_frames(max_idle_frames), m_viewport_size(engine->get_current_viewport().size) {
+        m_viewport_signal = engine->get_viewport_changed_signal().connect([this](const Viewport &viewport) {
+            m_viewport_size = viewport.size;
+            m_resize_frame  = m_frame;
+        });
+    }
+
+    std::shared_ptr<RenderTargetPool> RenderTargetPool::create(const std::shared_ptr<Engine> &engine,
+                                                               uint32_t                       max_idle_frames) {
+        return std::make_shared<RenderTargetPool>(engine, max_idle_frames);
+    }
+
+    std::shared_ptr<RenderTarget> RenderTargetPool::acquire(const RenderTargetDesc &desc) {
+        for (auto &entry : m_targets) {
+            if (entry.last_frame != m_frame && entry.target->get_desc() == desc) {
+                entry.last_frame = m_frame;
+                return entry.target;
+            }
+        }
+
+        m_targets.push_back({ RenderTarget::create(desc), m_frame });
+        return m_targets.back().target;
+    }
+
+    std::shared_ptr<RenderTarget> RenderTargetPool::acquire_scaled(float scale, TextureFormat format,
+                                                                   uint32_t samples) {
+        const glm::uvec2 size = { std::max(static_cast<uint32_t>(std::lround(m_viewport_size.x * scale)), 1u),
+                                  std::max(static_cast<uint32_t>(std::lround(m_viewport_size.y * scale)), 1u) };
+        return acquire({ size, format, samples });
+    }
+
+    std::shared_ptr<Framebuffer>
+    RenderTargetPool::get_framebuffer(std::span<const std::shared_ptr<RenderTarget>> colors,
+                                      const std::shared_ptr<RenderTarget>           &depth) {
+        for (auto &entry : m_framebuffers) {
+            if (entry.depth == depth.get() &&
+                std::ranges::equal(entry.colors, colors, {}, {}, &std::shared_ptr<RenderTarget>::get)) {
+                entry.last_frame = m_frame;
+                return entry.framebuffer;
+            }
+        }
+
+        auto framebuffer = Framebuffer::create();
+
+        CachedFramebuffer entry = { {}, depth.get(), framebuffer, m_frame };
+        for (uint32_t i = 0; i < colors.size(); i++) {
+            framebuffer->attach_color(i, colors[i]);
+            entry.colors.push_back(colors[i].get());
+        }
+        if (depth)
+            framebuffer->attach_depth(depth);
+
+        framebuffer->check();
+
+        m_framebuffers.push_back(std::move(entry));
+        return framebuffer;
+    }
+
+    void RenderTargetPool::end_frame() {
+        // after a resize the old sizes are not coming back, free them as soon as they sat out a frame
+        const auto unused = [this](uint64_t last_frame) {
+            return last_frame != m_frame && (last_frame <= m_resize_frame || m_frame - last_frame >= m_max_idle_frames);
+        };
+
+        // framebuffers first, they hold references to their attachments
+        std::erase_if(m_framebuffers, [&](const CachedFramebuffer &entry) { return unused(entry.last_frame); });
+        std::erase_if(m_targets, [&](const Target &entry) { return unused(entry.last_frame); });
+
+        m_frame++;
+    }
+
+} // namespace kat
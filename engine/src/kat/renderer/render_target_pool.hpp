@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "framebuffer.hpp"
+#include "kat/engine.hpp"
+
+namespace kat {
+
+    // Lends render targets and framebuffers for one frame at a time. A target acquired this frame is not handed out
+    // again before end_frame(), after that it goes back to the pool and is reused by the next request with the same
+    // size, format and sample count. Targets nobody asked for in `max_idle_frames` frames are freed.
+    //
+    // Viewport sized targets follow the engine's viewport lazily: a resize only records the new size, targets are
+    // allocated at that size the next time they are acquired, and targets of the old size are freed at the end of
+    // the first frame that didn't use them. Dragging a window edge therefore allocates at most once per frame.
+    //
+    // Targets that must survive across frames (history buffers and the like) should be created directly.
+    class RenderTargetPool {
+      public:
+        explicit RenderTargetPool(const std::shared_ptr<Engine> &engine, uint32_t max_idle_frames = 3);
+
+        RenderTargetPool(const RenderTargetPool &)            = delete;
+        RenderTargetPool &operator=(const RenderTargetPool &) = delete;
+
+        static std::shared_ptr<RenderTargetPool> create(const std::shared_ptr<Engine> &engine,
+                                                        uint32_t                       max_idle_frames = 3);
+
+        std::shared_ptr<RenderTarget> acquire(const RenderTargetDesc &desc);
+
+        // sized relative to the current viewport, e.g. 0.5 for half resolution
+        std::shared_ptr<RenderTarget> acquire_scaled(float scale, TextureFormat format, uint32_t samples = 1);
+
+        // Framebuffer with exactly these attachments, cached for as long as it keeps being asked for.
+        std::shared_ptr<Framebuffer> get_framebuffer(std::span<const std::shared_ptr<RenderTarget>> colors,
+                                                     const std::shared_ptr<RenderTarget>           &depth = nullptr);
+
+        // returns this frame's targets to the pool and frees idle ones
+        void end_frame();
+
+        [[nodiscard]] glm::uvec2 get_viewport_size() const noexcept { return m_viewport_size; }
+
+        [[nodiscard]] size_t get_target_count() const noexcept { return m_targets.size(); }
+
+        [[nodiscard]] size_t get_framebuffer_count() const noexcept { return m_framebuffers.size(); }
+
+      private:
+        struct Target {
+            std::shared_ptr<RenderTarget> target;
+            uint64_t                      last_frame;
+        };
+
+        struct CachedFramebuffer {
+            std::vector<const RenderTarget *> colors;
+            const RenderTarget               *depth;
+            std::shared_ptr<Framebuffer>      framebuffer;
+            uint64_t                          last_frame;
+        };
+
+        std::vector<Target>            m_targets;
+        std::vector<CachedFramebuffer> m_framebuffers;
+        uint64_t                       m_frame = 1;
+        uint32_t                       m_max_idle_frames;
+
+        glm::uvec2 m_viewport_size;
+        uint64_t   m_resize_frame = 0;
+
+        std::shared_ptr<signal_connection<void(const Viewport &)>> m_viewport_signal;
+    };
+
+} // namespace kat
@@ -1,14 +1,67 @@
 #include "shader.hpp"
 
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "destruction_queue.hpp"
 
 namespace kat {
+    namespace {
+        std::unordered_map<std::string, std::string> &includes() {
+            static std::unordered_map<std::string, std::string> registry;
+            return registry;
+        }
+
+        void expand_includes(const std::string &source, std::unordered_set<std::string> &seen, std::string &out) {
+            std::istringstream stream(source);
+            std::string        line;
+            size_t             line_number = 0;
+
+            while (std::getline(stream, line)) {
+                line_number++;
+
+                const size_t start = line.find_first_not_of(" \t");
+                if (start == std::string::npos || line.compare(start, 8, "#include") != 0) {
+                    out += line;
+                    out += '\n';
+                    continue;
+                }
+
+                const size_t open  = line.find('"', start);
+                const size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+                const std::string name =
+                    close == std::string::npos ? std::string() : line.substr(open + 1, close - open - 1);
+
+                const auto it = includes().find(name);
+                if (it == includes().end()) {
+                    // leave the line in so the compiler reports where it was
+                    std::cerr << "Shader Include Error: unknown include '" << name << "'" << std::endl;
+                    out += line;
+                    out += '\n';
+                    continue;
+                }
+
+                if (seen.insert(name).second) {
+                    expand_includes(it->second, seen, out);
+                }
+                // keep compiler messages pointing at the right line of this file
+                out += "#line " + std::to_string(line_number + 1) + '\n';
+            }
+        }
+    } // namespace
 
     ShaderModule::ShaderModule(const std::string &source, ShaderType type) {
+        std::unordered_set<std::string> seen;
+        std::string                     expanded;
+        expand_includes(source, seen, expanded);
+
         m_shader             = glCreateShader(static_cast<GLenum>(type));
-        const char *cstr_src = source.c_str();
+        const char *cstr_src = expanded.c_str();
         glShaderSource(m_shader, 1, &cstr_src, nullptr);
         glCompileShader(m_shader);
 
@@ -31,14 +84,30 @@ namespace kat {
         return std::shared_ptr<ShaderModule>(new ShaderModule(source, type));
     }
 
+    void ShaderModule::register_include(const std::string &name, const std::string &source) {
+        includes()[name] = source;
+    }
+
     ShaderModule::~ShaderModule() {
-        glDeleteShader(m_shader);
+        DestructionQueue::get().enqueue(GpuObjectType::Shader, m_shader);
     }
 
     Shader::Shader(const std::vector<std::shared_ptr<ShaderModule>> &modules) {
+        std::vector<const ShaderModule *> pointers;
+        for (const auto &module : modules) {
+            pointers.push_back(module.get());
+        }
+        link(pointers);
+    }
+
+    Shader::Shader(std::span<const ShaderModule *const> modules) {
+        link(modules);
+    }
+
+    void Shader::link(std::span<const ShaderModule *const> modules) {
         m_program = glCreateProgram();
 
-        for (const auto& module : modules) {
+        for (const ShaderModule *module : modules) {
             glAttachShader(m_program, module->get_handle());
         }
 
@@ -80,7 +149,7 @@ namespace kat {
     }
 
     Shader::~Shader() {
-        glDeleteProgram(m_program);
+        DestructionQueue::get().enqueue(GpuObjectType::Program, m_program);
     }
 
     void Shader::bind() const {
@@ -90,4 +159,27 @@ namespace kat {
     int Shader::get_uniform_location(const std::string &name) const {
         return glGetUniformLocation(m_program, name.c_str());
     }
+
+    glm::uvec3 Shader::get_work_group_size() const {
+        GLint linked = GL_FALSE;
+        glGetProgramiv(m_program, GL_LINK_STATUS, &linked);
+
+        GLint attached = 0;
+        glGetProgramiv(m_program, GL_ATTACHED_SHADERS, &attached);
+        std::vector<GLuint> shaders(static_cast<size_t>(attached));
+        glGetAttachedShaders(m_program, attached, nullptr, shaders.data());
+
+        // querying the size of anything but a linked compute program is an error
+        const bool compute = std::ranges::any_of(shaders, [](GLuint shader) {
+            GLint type = 0;
+            glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+            return type == GL_COMPUTE_SHADER;
+        });
+        if (linked != GL_TRUE || !compute)
+            return { 0, 0, 0 };
+
+        GLint size[3] = {};
+        glGetProgramiv(m_program, GL_COMPUTE_WORK_GROUP_SIZE, size);
+        return { static_cast<uint32_t>(size[0]), static_cast<uint32_t>(size[1]), static_cast<uint32_t>(size[2]) };
+    }
 } // namespace kat
@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -23,12 +24,22 @@ namespace kat {
 
         ~ShaderModule();
 
+        ShaderModule(const ShaderModule &)            = delete;
+        ShaderModule &operator=(const ShaderModule &) = delete;
+
         static std::shared_ptr<ShaderModule> load(const std::string& path, ShaderType type);
         static std::shared_ptr<ShaderModule> create(const std::string& source, ShaderType type);
 
+        // Makes `source` available to `#include "name"` lines of shaders compiled afterwards. Each include is pasted
+        // in at most once per shader, registering a name again replaces it.
+        static void register_include(const std::string& name, const std::string& source);
+
         inline unsigned int get_handle() const noexcept { return m_shader; };
 
     private:
+        template <typename>
+        friend class HandlePool;
+
         ShaderModule(const std::string& source, ShaderType type);
 
         unsigned int m_shader;
@@ -46,10 +57,18 @@ namespace kat {
 
         ~Shader();
 
+        Shader(const Shader &)            = delete;
+        Shader &operator=(const Shader &) = delete;
+
         void bind() const;
 
         int get_uniform_location(const std::string& name) const;
 
+        [[nodiscard]] unsigned int get_handle() const noexcept { return m_program; }
+
+        // local_size_x/y/z of a compute program, zero for other programs
+        [[nodiscard]] glm::uvec3 get_work_group_size() const;
+
         // Vector : float | glm::vec
         inline void uniform1f(const std::string &uniform_name, float x) const {
             glProgramUniform1f(m_program, get_uniform_location(uniform_name), x);
@@ -211,8 +230,15 @@ namespace kat {
 
 
       private:
+        template <typename>
+        friend class HandlePool;
+
         Shader(const std::vector<std::shared_ptr<ShaderModule>> &modules);
 
+        explicit Shader(std::span<const ShaderModule *const> modules);
+
+        void link(std::span<const ShaderModule *const> modules);
+
         unsigned int m_program;
     };
 
@@ -0,0 +1,246 @@
+#include "shadow_atlas.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <string>
+
+#include "shader.hpp"
+#include "kat/utils/frustum.hpp"
+
+namespace kat {
+    namespace {
+        const std::string SHADOWS_INCLUDE_SOURCE = R"(
+// 1 lit, 0 in shadow. 3x3 PCF, clamped so the filter never reads a neighbouring tile.
+float kat_shadow(sampler2DShadow atlas, mat4 atlas_matrix, vec4 uv_rect, vec3 position) {
+    vec4 p = atlas_matrix * vec4(position, 1.0);
+    p.xyz /= p.w;
+    if (p.z >= 1.0)
+        return 1.0;
+
+    vec2 texel = 1.0 / vec2(textureSize(atlas, 0));
+    vec2 lo    = uv_rect.xy + texel * 0.5;
+    vec2 hi    = uv_rect.zw - texel * 0.5;
+
+    float lit = 0.0;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            lit += texture(atlas, vec3(clamp(p.xy + vec2(x, y) * texel, lo, hi), p.z));
+        }
+    }
+    return lit / 9.0;
+}
+
+// tile of a point light's cube, in CubeFace order, for the direction from the light to the surface
+uint kat_cube_face(vec3 direction) {
+    vec3 a = abs(direction);
+    if (a.x >= a.y && a.x >= a.z)
+        return direction.x > 0.0 ? 0u : 1u;
+    if (a.y >= a.z)
+        return direction.y > 0.0 ? 2u : 3u;
+    return direction.z > 0.0 ? 4u : 5u;
+}
+)";
+    } // namespace
+
+    float shadow_screen_size(const glm::vec4 &bounds, const glm::mat4 &view, const glm::mat4 &projection,
+                             float viewport_height) {
+        const glm::vec3 center   = glm::vec3(view * glm::vec4(glm::vec3(bounds), 1.0f));
+        const float     distance = glm::length(center);
+        if (distance <= bounds.w)
+            return std::numeric_limits<float>::max();
+
+        // projected diameter of the sphere at its distance, as if it sat in the middle of the screen
+        return bounds.w / distance * projection[1][1] * viewport_height;
+    }
+
+    ShadowAtlas::ShadowAtlas(uint32_t size, uint32_t min_tile) : m_allocator(size, min_tile) {
+        m_texture        = Texture2D::create(size, size, TextureFormat::Depth32F, 1);
+        m_static_texture = Texture2D::create(size, size, TextureFormat::Depth32F, 1);
+
+        m_texture->set_sampler({ .min_filter = TextureFilter::Linear,
+                                 .mag_filter = TextureFilter::Linear,
+                                 .wrap_s     = TextureWrap::ClampToEdge,
+                                 .wrap_t     = TextureWrap::ClampToEdge });
+        glTextureParameteri(m_texture->get_handle(), GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTextureParameteri(m_texture->get_handle(), GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+        m_framebuffer = Framebuffer::create();
+        m_framebuffer->attach_depth(m_texture);
+        m_framebuffer->check();
+
+        m_static_framebuffer = Framebuffer::create();
+        m_static_framebuffer->attach_depth(m_static_texture);
+        m_static_framebuffer->check();
+
+        ShaderModule::register_include("kat/shadows.glsl", SHADOWS_INCLUDE_SOURCE);
+    }
+
+    std::shared_ptr<ShadowAtlas> ShadowAtlas::create(uint32_t size, uint32_t min_tile) {
+        return std::make_shared<ShadowAtlas>(size, min_tile);
+    }
+
+    std::optional<ShadowTile> ShadowAtlas::request(uint64_t key, const glm::mat4 &view_projection, float resolution) {
+        const float clamped = std::clamp(resolution, static_cast<float>(m_allocator.get_min_size()),
+                                         static_cast<float>(m_allocator.get_size()));
+        const uint32_t size = std::bit_ceil(static_cast<uint32_t>(clamped));
+
+        auto it = m_entries.find(key);
+        if (it != m_entries.end() && it->second.last_frame == m_frame)
+            return it->second.tile;
+
+        if (it != m_entries.end()) {
+            Entry &entry   = it->second;
+            PackRect rect  = entry.tile.rect;
+            const bool grow   = size > rect.width;
+            const bool shrink = size * 4 <= rect.width;
+
+            if (grow || shrink) {
+                // the old tile goes back first, so at worst the shadow ends up where it was
+                m_allocator.free(rect);
+                const auto moved = allocate(size);
+                if (!moved) {
+                    m_entries.erase(it);
+                    return std::nullopt;
+                }
+                rect = *moved;
+            }
+
+            if (rect.x != entry.tile.rect.x || rect.y != entry.tile.rect.y || rect.width != entry.tile.rect.width ||
+                view_projection != entry.tile.view_projection) {
+                entry.tile         = make_tile(view_projection, rect);
+                entry.static_dirty = true;
+            }
+
+            entry.last_frame = m_frame;
+            m_frame_keys.push_back(key);
+            return entry.tile;
+        }
+
+        const auto rect = allocate(size);
+        if (!rect)
+            return std::nullopt;
+
+        const Entry &entry = m_entries.emplace(key, Entry{ make_tile(view_projection, *rect), m_frame, true })
+                                 .first->second;
+        m_frame_keys.push_back(key);
+        return entry.tile;
+    }
+
+    std::optional<PackRect> ShadowAtlas::allocate(uint32_t size) {
+        for (; size >= m_allocator.get_min_size(); size /= 2) {
+            if (auto rect = m_allocator.allocate(size))
+                return rect;
+        }
+        return std::nullopt;
+    }
+
+    ShadowTile ShadowAtlas::make_tile(const glm::mat4 &view_projection, const PackRect &rect) const {
+        const auto size = static_cast<float>(m_allocator.get_size());
+
+        const glm::vec2 scale  = glm::vec2(rect.width, rect.height) / size;
+        const glm::vec2 offset = glm::vec2(rect.x, rect.y) / size;
+
+        // clip space [-1, 1] to the tile's texture coordinates, depth to [0, 1]
+        glm::mat4 to_atlas(1.0f);
+        to_atlas[0][0] = scale.x * 0.5f;
+        to_atlas[1][1] = scale.y * 0.5f;
+        to_atlas[2][2] = 0.5f;
+        to_atlas[3]    = glm::vec4(offset + scale * 0.5f, 0.5f, 1.0f);
+
+        return { view_projection, to_atlas * view_projection, glm::vec4(offset, offset + scale), rect };
+    }
+
+    void ShadowAtlas::invalidate(const Aabb &bounds) {
+        for (auto &[key, entry] : m_entries) {
+            if (!entry.static_dirty &&
+                Frustum::from_matrix(entry.tile.view_projection).intersects_aabb(bounds.min, bounds.max))
+                entry.static_dirty = true;
+        }
+    }
+
+    void ShadowAtlas::invalidate_all() {
+        for (auto &[key, entry] : m_entries) {
+            entry.static_dirty = true;
+        }
+    }
+
+    void ShadowAtlas::render(const std::function<void(const ShadowTile &)> &draw_static,
+                             const std::function<void(const ShadowTile &)> &draw_dynamic) {
+        m_static_render_count = 0;
+        if (m_frame_keys.empty())
+            return;
+
+        const auto viewport = [](const PackRect &rect) {
+            glViewport(static_cast<GLint>(rect.x), static_cast<GLint>(rect.y), static_cast<GLsizei>(rect.width),
+                       static_cast<GLsizei>(rect.height));
+            glScissor(static_cast<GLint>(rect.x), static_cast<GLint>(rect.y), static_cast<GLsizei>(rect.width),
+                      static_cast<GLsizei>(rect.height));
+        };
+
+        // the tiles set their own viewport and need depth writes, the caller gets its state back afterwards
+        glm::ivec4 previous_viewport;
+        GLboolean  previous_depth_mask;
+        glGetIntegerv(GL_VIEWPORT, &previous_viewport.x);
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &previous_depth_mask);
+        const GLboolean previous_depth_test = glIsEnabled(GL_DEPTH_TEST);
+
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
+        glEnable(GL_SCISSOR_TEST);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(m_slope_bias, m_constant_bias);
+
+        m_static_framebuffer->bind();
+        for (const uint64_t key : m_frame_keys) {
+            Entry &entry = m_entries.at(key);
+            if (!entry.static_dirty)
+                continue;
+
+            viewport(entry.tile.rect);
+            m_static_framebuffer->clear_depth();
+            draw_static(entry.tile);
+
+            entry.static_dirty = false;
+            m_static_render_count++;
+        }
+
+        for (const uint64_t key : m_frame_keys) {
+            const PackRect &rect = m_entries.at(key).tile.rect;
+            glCopyImageSubData(m_static_texture->get_handle(), GL_TEXTURE_2D, 0, static_cast<GLint>(rect.x),
+                               static_cast<GLint>(rect.y), 0, m_texture->get_handle(), GL_TEXTURE_2D, 0,
+                               static_cast<GLint>(rect.x), static_cast<GLint>(rect.y), 0,
+                               static_cast<GLsizei>(rect.width), static_cast<GLsizei>(rect.height), 1);
+        }
+
+        m_framebuffer->bind();
+        for (const uint64_t key : m_frame_keys) {
+            const ShadowTile &tile = m_entries.at(key).tile;
+            viewport(tile.rect);
+            draw_dynamic(tile);
+        }
+
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glDisable(GL_SCISSOR_TEST);
+        Framebuffer::bind_default();
+
+        glViewport(previous_viewport.x, previous_viewport.y, previous_viewport.z, previous_viewport.w);
+        glDepthMask(previous_depth_mask);
+        if (!previous_depth_test)
+            glDisable(GL_DEPTH_TEST);
+    }
+
+    void ShadowAtlas::end_frame() {
+        std::erase_if(m_entries, [this](const auto &item) {
+            if (item.second.last_frame == m_frame)
+                return false;
+
+            m_allocator.free(item.second.tile.rect);
+            return true;
+        });
+
+        m_frame_keys.clear();
+        m_frame++;
+    }
+
+} // namespace kat
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "framebuffer.hpp"
+#include "texture.hpp"
+#include "kat/utils/aabb.hpp"
+#include "kat/utils/quadtree_allocator.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    struct ShadowTile {
+        glm::mat4 view_projection;
+        glm::mat4 atlas_matrix; // world space to atlas texture coordinates and depth, divide by w
+        glm::vec4 uv_rect;      // min and max texture coordinates of the tile, samples must stay inside
+        PackRect  rect;
+    };
+
+    // Pixels the world space bounding sphere `bounds` (xyz center, w radius) covers on screen vertically, the
+    // importance measure to pick a shadow map resolution from. Huge when the camera is inside the sphere.
+    [[nodiscard]] float shadow_screen_size(const glm::vec4 &bounds, const glm::mat4 &view, const glm::mat4 &projection,
+                                           float viewport_height);
+
+    // All shadow maps of a frame in one depth texture, tiles handed out by a quadtree. Shaders include
+    // "kat/shadows.glsl" and sample the atlas (a sampler2DShadow) with a tile's atlas_matrix and uv_rect.
+    //
+    // Static casters are drawn into a second, cached atlas and only redrawn for tiles whose view changed or that
+    // invalidate() touched. Every frame the cached depth is copied into the atlas and the dynamic casters are drawn
+    // on top, so a still light over a still level costs one copy and its moving objects.
+    class ShadowAtlas {
+      public:
+        // size and min_tile are powers of two
+        explicit ShadowAtlas(uint32_t size = 8192, uint32_t min_tile = 128);
+
+        ShadowAtlas(const ShadowAtlas &)            = delete;
+        ShadowAtlas &operator=(const ShadowAtlas &) = delete;
+
+        static std::shared_ptr<ShadowAtlas> create(uint32_t size = 8192, uint32_t min_tile = 128);
+
+        // Asks for a shadow map this frame. `key` identifies the shadow across frames (a light and its cascade or
+        // cube face), `resolution` is rounded to a power of two and halved until the tile fits, so request the most
+        // important shadows first. A tile only shrinks once the resolution dropped to a quarter, which keeps
+        // shadows near a size boundary from reallocating every frame. nullopt when even the smallest tile is taken.
+        std::optional<ShadowTile> request(uint64_t key, const glm::mat4 &view_projection, float resolution);
+
+        // static casters moved, appeared or disappeared within these world space bounds
+        void invalidate(const Aabb &bounds);
+
+        void invalidate_all();
+
+        // Draws this frame's tiles. Both callbacks run with the tile's framebuffer bound and its viewport set and
+        // draw depth only, with the view projection of the tile. Static casters are only drawn for tiles that
+        // need it.
+        void render(const std::function<void(const ShadowTile &)> &draw_static,
+                    const std::function<void(const ShadowTile &)> &draw_dynamic);
+
+        // frees the tiles of shadows not requested since the last end_frame()
+        void end_frame();
+
+        void set_depth_bias(float slope, float constant) noexcept {
+            m_slope_bias    = slope;
+            m_constant_bias = constant;
+        }
+
+        // depth comparison sampling enabled
+        [[nodiscard]] const std::shared_ptr<Texture2D> &get_texture() const noexcept { return m_texture; }
+
+        [[nodiscard]] const std::shared_ptr<Texture2D> &get_static_texture() const noexcept {
+            return m_static_texture;
+        }
+
+        [[nodiscard]] uint32_t get_size() const noexcept { return m_allocator.get_size(); }
+
+        [[nodiscard]] size_t get_tile_count() const noexcept { return m_frame_keys.size(); }
+
+        // tiles whose static casters were redrawn by the last render()
+        [[nodiscard]] size_t get_static_render_count() const noexcept { return m_static_render_count; }
+
+        [[nodiscard]] float get_occupancy() const noexcept { return m_allocator.get_occupancy(); }
+
+      private:
+        struct Entry {
+            ShadowTile tile;
+            uint64_t   last_frame;
+            bool       static_dirty;
+        };
+
+        [[nodiscard]] ShadowTile make_tile(const glm::mat4 &view_projection, const PackRect &rect) const;
+
+        // halves the size until something fits, down to the minimum tile
+        std::optional<PackRect> allocate(uint32_t size);
+
+        QuadtreeAllocator                   m_allocator;
+        std::unordered_map<uint64_t, Entry> m_entries;
+        std::vector<uint64_t>               m_frame_keys; // requested this frame, in order
+        uint64_t                            m_frame = 1;
+
+        std::shared_ptr<Texture2D>   m_texture;
+        std::shared_ptr<Texture2D>   m_static_texture;
+        std::shared_ptr<Framebuffer> m_framebuffer;
+        std::shared_ptr<Framebuffer> m_static_framebuffer;
+
+        float  m_slope_bias          = 2.0f;
+        float  m_constant_bias       = 2.0f;
+        size_t m_static_render_count = 0;
+    };
+
+} // namespace kat
@@ -0,0 +1,97 @@
+#include "shadow_cascades.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace kat {
+    namespace {
+        glm::vec3 up_for(const glm::vec3 &direction) {
+            return std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+    } // namespace
+
+    std::vector<ShadowCascade> compute_cascades(const glm::mat4 &view, const glm::mat4 &projection, float near,
+                                                float far, const glm::vec3 &light_direction,
+                                                const CascadeSettings &settings) {
+        const glm::mat4 inverse_projection = glm::inverse(projection);
+        const glm::mat4 inverse_view       = glm::inverse(view);
+
+        // a fixed orientation, only the translation follows the camera, in whole texels
+        const glm::vec3 direction  = glm::normalize(light_direction);
+        const glm::mat4 light_view = glm::lookAt(glm::vec3(0.0f), direction, up_for(direction));
+
+        const auto world_corner = [&](const glm::vec2 &ndc, float view_depth) {
+            glm::vec4 p = inverse_projection * glm::vec4(ndc, -1.0f, 1.0f);
+            p /= p.w;
+            return glm::vec3(inverse_view * glm::vec4(glm::vec3(p) * (view_depth / -p.z), 1.0f));
+        };
+
+        std::vector<ShadowCascade> cascades;
+        cascades.reserve(settings.count);
+
+        float split_near = near;
+        for (uint32_t i = 0; i < settings.count; i++) {
+            const float fraction    = static_cast<float>(i + 1) / static_cast<float>(settings.count);
+            const float logarithmic = near * std::pow(far / near, fraction);
+            const float uniform     = near + (far - near) * fraction;
+            const float split_far   = uniform + (logarithmic - uniform) * settings.split_lambda;
+
+            glm::vec3 corners[8];
+            glm::vec3 center(0.0f);
+            for (int c = 0; c < 8; c++) {
+                const glm::vec2 ndc = { c & 1 ? 1.0f : -1.0f, c & 2 ? 1.0f : -1.0f };
+                corners[c]          = world_corner(ndc, c & 4 ? split_far : split_near);
+                center += corners[c] / 8.0f;
+            }
+
+            float radius = 0.0f;
+            for (const auto &corner : corners) {
+                radius = std::max(radius, glm::length(corner - center));
+            }
+            // rounded up so floating point noise doesn't change the texel size from frame to frame
+            radius = std::ceil(radius * 16.0f) / 16.0f;
+
+            const float texel = 2.0f * radius / static_cast<float>(settings.resolution);
+            glm::vec3   light = glm::vec3(light_view * glm::vec4(center, 1.0f));
+            light.x           = std::floor(light.x / texel) * texel;
+            light.y           = std::floor(light.y / texel) * texel;
+
+            const glm::mat4 ortho = glm::ortho(light.x - radius, light.x + radius, light.y - radius, light.y + radius,
+                                               -light.z - radius - settings.caster_distance, -light.z + radius);
+
+            cascades.push_back({ ortho * light_view, split_far });
+            split_near = split_far;
+        }
+
+        return cascades;
+    }
+
+    glm::mat4 spot_shadow_matrix(const Light &light, float near) {
+        // a single map can't cover a cone of half a sphere or more
+        const float fov = std::min(light.outer_angle * 2.0f, std::numbers::pi_v<float> * 0.95f);
+
+        const glm::mat4 view =
+            glm::lookAt(light.position, light.position + light.direction, up_for(light.direction));
+        return glm::perspective(fov, 1.0f, near, light.range) * view;
+    }
+
+    std::array<glm::mat4, 6> point_shadow_matrices(const Light &light, float near) {
+        // the GL cube map face orientations
+        static const glm::vec3 TARGETS[6] = { { 1.0f, 0.0f, 0.0f },  { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+                                              { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f },  { 0.0f, 0.0f, -1.0f } };
+        static const glm::vec3 UPS[6]     = { { 0.0f, -1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f },
+                                              { 0.0f, 0.0f, -1.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } };
+
+        const glm::mat4 projection = glm::perspective(std::numbers::pi_v<float> * 0.5f, 1.0f, near, light.range);
+
+        std::array<glm::mat4, 6> matrices;
+        for (size_t i = 0; i < 6; i++) {
+            matrices[i] = projection * glm::lookAt(light.position, light.position + TARGETS[i], UPS[i]);
+        }
+        return matrices;
+    }
+
+} // namespace kat
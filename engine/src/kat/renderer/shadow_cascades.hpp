@@ -0,0 +1,41 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "clustered_lighting.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    struct CascadeSettings {
+        uint32_t count      = 4;
+        uint32_t resolution = 2048; // of every cascade, used to snap them to whole texels
+
+        // 0 splits the depth range evenly, 1 logarithmically (same resolution ratio in every cascade)
+        float split_lambda = 0.75f;
+
+        // how far beyond a cascade, towards the light, casters still throw shadows into it
+        float caster_distance = 100.0f;
+    };
+
+    struct ShadowCascade {
+        glm::mat4 view_projection;
+        float     far; // view depth at which this cascade ends and the next takes over
+    };
+
+    // Cascaded shadow maps of a directional light for a perspective camera, nearest cascade first. Each cascade
+    // bounds its slice of the view frustum with a sphere, so its size doesn't change as the camera turns, and
+    // moves in whole texels, so shadow edges don't shimmer while the camera moves.
+    std::vector<ShadowCascade> compute_cascades(const glm::mat4 &view, const glm::mat4 &projection, float near,
+                                                float far, const glm::vec3 &light_direction,
+                                                const CascadeSettings &settings = {});
+
+    // view projection of a spot light's shadow, covering its outer cone
+    [[nodiscard]] glm::mat4 spot_shadow_matrix(const Light &light, float near = 0.05f);
+
+    // view projections of a point light's six cube faces, in CubeFace order (see kat_cube_face())
+    [[nodiscard]] std::array<glm::mat4, 6> point_shadow_matrices(const Light &light, float near = 0.05f);
+
+} // namespace kat
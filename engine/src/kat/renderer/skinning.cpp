@@ -0,0 +1,315 @@
+#include "skinning.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace kat {
+    namespace {
+        constexpr uint32_t MAX_INSTANCES_PER_DISPATCH = 65535; // guaranteed work group count in y
+
+        const std::string SKIN_SHADER_SOURCE = R"(#version 460 core
+layout(local_size_x = 64) in;
+
+struct KatSkinInstance {
+    uint source_first;
+    uint vertex_count;
+    uint output_first;
+    uint palette_first;
+};
+
+// SkinnedVertex in, StandardVertex out
+layout(std430, binding = 0) readonly buffer Source {
+    uint source[];
+};
+
+layout(std430, binding = 1) writeonly buffer Output {
+    uint outputs[];
+};
+
+// three rows per joint
+layout(std430, binding = 2) readonly buffer Palette {
+    vec4 palette[];
+};
+
+layout(std430, binding = 3) readonly buffer Instances {
+    KatSkinInstance instances[];
+};
+
+uniform uint u_instance_base;
+
+vec3 load_vec3(uint i) {
+    return uintBitsToFloat(uvec3(source[i], source[i + 1u], source[i + 2u]));
+}
+
+void store_vec3(uint i, vec3 v) {
+    uvec3 bits      = floatBitsToUint(v);
+    outputs[i]      = bits.x;
+    outputs[i + 1u] = bits.y;
+    outputs[i + 2u] = bits.z;
+}
+
+void main() {
+    KatSkinInstance instance = instances[u_instance_base + gl_WorkGroupID.y];
+
+    uint v = gl_GlobalInvocationID.x;
+    if (v >= instance.vertex_count)
+        return;
+
+    uint s        = (instance.source_first + v) * 15u;
+    vec4 position = vec4(load_vec3(s), 1.0);
+    vec3 normal   = load_vec3(s + 3u);
+    uint joints   = source[s + 12u];
+    vec4 weights  = vec4(unpackUnorm2x16(source[s + 13u]), unpackUnorm2x16(source[s + 14u]));
+    weights /= max(weights.x + weights.y + weights.z + weights.w, 1e-6);
+
+    // linear blend skinning, normals go through the same matrices, which assumes uniformly scaled joints
+    vec3 skinned_position = vec3(0.0);
+    vec3 skinned_normal   = vec3(0.0);
+    for (uint i = 0u; i < 4u; i++) {
+        uint j  = (instance.palette_first + bitfieldExtract(joints, int(i * 8u), 8)) * 3u;
+        vec4 r0 = palette[j];
+        vec4 r1 = palette[j + 1u];
+        vec4 r2 = palette[j + 2u];
+        skinned_position += weights[i] * vec3(dot(r0, position), dot(r1, position), dot(r2, position));
+        skinned_normal += weights[i] * vec3(dot(r0.xyz, normal), dot(r1.xyz, normal), dot(r2.xyz, normal));
+    }
+    skinned_normal *= inversesqrt(max(dot(skinned_normal, skinned_normal), 1e-12));
+
+    uint o = (instance.output_first + v) * 12u;
+    store_vec3(o, skinned_position);
+    store_vec3(o + 3u, skinned_normal);
+
+    // color and uv
+    for (uint i = 6u; i < 12u; i++) {
+        outputs[o + i] = source[s + i];
+    }
+}
+)";
+
+        void advance(AnimationPlayback &playback, float dt) {
+            if (!playback.clip)
+                return;
+
+            const float duration = playback.clip->get_duration();
+            playback.time += dt * playback.speed;
+            if (playback.loop && duration > 0.0f) {
+                playback.time = std::fmod(playback.time, duration);
+                if (playback.time < 0.0f)
+                    playback.time += duration;
+            } else {
+                playback.time = std::clamp(playback.time, 0.0f, duration);
+            }
+        }
+    } // namespace
+
+    SkinnedVertex make_skinned_vertex(const StandardVertex &vertex, const glm::uvec4 &joints,
+                                      const glm::vec4 &weights) {
+        if (std::max({ joints.x, joints.y, joints.z, joints.w }) > 255)
+            throw std::runtime_error("Skinned vertices address at most 256 joints");
+
+        const float sum = weights.x + weights.y + weights.z + weights.w;
+        const auto  unorm = [sum](float w) {
+            return static_cast<uint32_t>(std::lround(std::clamp(sum > 0.0f ? w / sum : 0.0f, 0.0f, 1.0f) * 65535.0f));
+        };
+
+        SkinnedVertex skinned;
+        skinned.position   = vertex.position;
+        skinned.normal     = vertex.normal;
+        skinned.color      = vertex.color;
+        skinned.uv         = vertex.uv;
+        skinned.joints     = joints.x | joints.y << 8 | joints.z << 16 | joints.w << 24;
+        skinned.weights[0] = unorm(weights.x) | unorm(weights.y) << 16;
+        skinned.weights[1] = unorm(weights.z) | unorm(weights.w) << 16;
+        return skinned;
+    }
+
+    SkinningSystem::SkinningSystem(const std::shared_ptr<GpuResources> &resources,
+                                   const std::shared_ptr<JobSystem> &job_system, size_t stream_size) :
+        m_resources(resources), m_job_system(job_system), m_stream(StreamBuffer::create(stream_size)) {
+        GLint alignment;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        m_storage_alignment = static_cast<size_t>(std::max(alignment, 16));
+
+        m_source       = m_resources->create_buffer();
+        m_index_buffer = m_resources->create_buffer();
+        m_output       = m_resources->create_buffer();
+        m_vertex_array = m_resources->create_vertex_array();
+        Mesh::setup_vertex_array(m_resources->get(m_vertex_array), m_resources->get(m_output),
+                                 m_resources->get(m_index_buffer));
+
+        // the palette and instance table are ranges of the stream buffer, bound directly in skin()
+        m_pipeline = ComputePipeline::create(SKIN_SHADER_SOURCE);
+        m_pipeline->set_storage(0, m_resources->get(m_source), ComputeAccess::ReadOnly);
+        m_pipeline->set_storage(1, m_resources->get(m_output), ComputeAccess::WriteOnly);
+    }
+
+    SkinningSystem::~SkinningSystem() {
+        m_resources->destroy(m_vertex_array);
+        m_resources->destroy(m_source);
+        m_resources->destroy(m_index_buffer);
+        m_resources->destroy(m_output);
+    }
+
+    std::shared_ptr<SkinningSystem> SkinningSystem::create(const std::shared_ptr<GpuResources> &resources,
+                                                           const std::shared_ptr<JobSystem>    &job_system,
+                                                           size_t                               stream_size) {
+        return std::make_shared<SkinningSystem>(resources, job_system, stream_size);
+    }
+
+    uint32_t SkinningSystem::add_mesh(std::span<const SkinnedVertex> vertices, std::span<const uint32_t> indices) {
+        if (vertices.empty() || indices.empty())
+            throw std::runtime_error("Skinned mesh has no vertices or indices");
+
+        uint32_t max_joint = 0;
+        for (const SkinnedVertex &v : vertices) {
+            for (int i = 0; i < 4; i++) {
+                // influences without weight may point anywhere
+                if ((v.weights[i / 2] >> (i % 2 * 16) & 0xffff) != 0)
+                    max_joint = std::max(max_joint, v.joints >> (i * 8) & 0xff);
+            }
+        }
+
+        m_meshes.push_back({ static_cast<uint32_t>(m_source_vertices.size()), static_cast<uint32_t>(vertices.size()),
+                             static_cast<uint32_t>(m_indices.size()), static_cast<uint32_t>(indices.size()),
+                             max_joint });
+        m_source_vertices.insert(m_source_vertices.end(), vertices.begin(), vertices.end());
+        m_indices.insert(m_indices.end(), indices.begin(), indices.end());
+        m_max_vertices = std::max(m_max_vertices, static_cast<uint32_t>(vertices.size()));
+
+        // resizing keeps the buffer names, so the pipeline and vertex array stay valid
+        m_resources->get(m_source).set(m_source_vertices, BufferUsage::StaticDraw);
+        m_resources->get(m_index_buffer).set(m_indices, BufferUsage::StaticDraw);
+        return static_cast<uint32_t>(m_meshes.size() - 1);
+    }
+
+    uint32_t SkinningSystem::add_instance(uint32_t mesh, const std::shared_ptr<const Skeleton> &skeleton) {
+        const MeshRange &range = m_meshes.at(mesh);
+        if (!skeleton || skeleton->get_joint_count() <= range.max_joint)
+            throw std::runtime_error("Skeleton has fewer joints than the mesh uses");
+
+        Instance instance;
+        instance.mesh         = mesh;
+        instance.skeleton     = skeleton;
+        instance.first_joint  = static_cast<uint32_t>(m_palette.size());
+        instance.first_vertex = m_output_vertices;
+        m_instances.push_back(std::move(instance));
+
+        m_palette.resize(m_palette.size() + skeleton->get_joint_count());
+        build_palette(*skeleton, skeleton->get_rest_pose(),
+                      std::span(m_palette).subspan(m_instances.back().first_joint, skeleton->get_joint_count()));
+
+        m_output_vertices += range.vertex_count;
+        Buffer &output = m_resources->get(m_output);
+        MemoryBarriers::require(output, GL_BUFFER_UPDATE_BARRIER_BIT);
+        output.set(nullptr, static_cast<size_t>(m_output_vertices) * sizeof(StandardVertex), BufferUsage::DynamicCopy);
+        return static_cast<uint32_t>(m_instances.size() - 1);
+    }
+
+    void SkinningSystem::play(uint32_t instance, const std::shared_ptr<const AnimationClip> &clip, float fade,
+                              float speed, bool loop) {
+        Instance &target = m_instances.at(instance);
+        if (clip && clip->get_joint_count() != target.skeleton->get_joint_count())
+            throw std::runtime_error("Animation clip doesn't match the instance's skeleton");
+
+        if (fade > 0.0f && target.current.clip) {
+            target.previous  = std::move(target.current);
+            target.fade_time = fade;
+            target.fade      = 0.0f;
+        } else {
+            target.previous.clip.reset();
+        }
+
+        target.current       = {};
+        target.current.clip  = clip;
+        target.current.speed = speed;
+        target.current.loop  = loop;
+    }
+
+    void SkinningSystem::animate(Instance &instance, float dt) {
+        advance(instance.current, dt);
+        advance(instance.previous, dt);
+
+        instance.fade += dt;
+        if (instance.previous.clip && instance.fade >= instance.fade_time)
+            instance.previous.clip.reset();
+
+        // scratch poses per worker thread
+        thread_local Pose pose;
+        thread_local Pose fading;
+
+        const Skeleton &skeleton = *instance.skeleton;
+        if (instance.current.clip)
+            instance.current.clip->sample(instance.current.time, pose, instance.current.cache);
+        else
+            pose = skeleton.get_rest_pose();
+
+        if (instance.previous.clip) {
+            instance.previous.clip->sample(instance.previous.time, fading, instance.previous.cache);
+            blend_poses(fading, pose, instance.fade / instance.fade_time, pose);
+        }
+
+        build_palette(skeleton, pose,
+                      std::span(m_palette).subspan(instance.first_joint, skeleton.get_joint_count()));
+    }
+
+    void SkinningSystem::update(float dt) {
+        const auto animate_range = [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                animate(m_instances[i], dt);
+            }
+        };
+
+        if (m_job_system)
+            m_job_system->parallel_for(m_instances.size(), 16, animate_range);
+        else
+            animate_range(0, m_instances.size());
+    }
+
+    void SkinningSystem::skin() {
+        if (m_instances.empty())
+            return;
+
+        const auto palette = m_stream->allocate(m_palette.size() * sizeof(JointMatrix), m_storage_alignment);
+        std::memcpy(palette.data, m_palette.data(), palette.size);
+
+        const auto table = m_stream->allocate(m_instances.size() * sizeof(GpuInstance), m_storage_alignment);
+        auto      *gpu   = static_cast<GpuInstance *>(table.data);
+        for (const Instance &instance : m_instances) {
+            const MeshRange &mesh = m_meshes[instance.mesh];
+            *gpu++ = { mesh.first_vertex, mesh.vertex_count, instance.first_vertex, instance.first_joint };
+        }
+
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 2, m_stream->get_handle(), static_cast<GLintptr>(palette.offset),
+                          static_cast<GLsizeiptr>(palette.size));
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 3, m_stream->get_handle(), static_cast<GLintptr>(table.offset),
+                          static_cast<GLsizeiptr>(table.size));
+
+        // a row of work groups per instance, wide enough for the largest mesh
+        const auto     count  = static_cast<uint32_t>(m_instances.size());
+        const uint32_t groups = (m_max_vertices + m_pipeline->get_work_group_size().x - 1) /
+                                m_pipeline->get_work_group_size().x;
+        for (uint32_t base = 0; base < count; base += MAX_INSTANCES_PER_DISPATCH) {
+            m_pipeline->get_shader().uniform1ui("u_instance_base", base);
+            m_pipeline->dispatch_groups(groups, std::min(count - base, MAX_INSTANCES_PER_DISPATCH));
+        }
+        m_stream->fence();
+
+        // the output is read as vertex attributes next
+        MemoryBarriers::require(m_resources->get(m_output), GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+    }
+
+    DrawElementsIndirectCommand SkinningSystem::get_draw_command(uint32_t instance) const {
+        const Instance  &target = m_instances.at(instance);
+        const MeshRange &mesh   = m_meshes[target.mesh];
+        return { mesh.index_count, 1, mesh.first_index, static_cast<int32_t>(target.first_vertex), 0 };
+    }
+
+    std::span<const JointMatrix> SkinningSystem::get_palette(uint32_t instance) const {
+        const Instance &target = m_instances.at(instance);
+        return std::span(m_palette).subspan(target.first_joint, target.skeleton->get_joint_count());
+    }
+
+} // namespace kat
@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "animation.hpp"
+#include "compute_pipeline.hpp"
+#include "gpu_resources.hpp"
+#include "mesh.hpp"
+#include "stream_buffer.hpp"
+#include "kat/utils/job_system.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    // A StandardVertex with up to four joint influences, read by the skinning shader as 15 uints.
+    struct SkinnedVertex {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec4 color;
+        glm::vec2 uv;
+        uint32_t  joints;     // four 8 bit joint indices, the first in the low byte
+        uint32_t  weights[2]; // four 16 bit unorm weights, the first in the low half
+    };
+
+    static_assert(sizeof(SkinnedVertex) == 60);
+
+    // Normalizes the weights. Throws for joint indices above 255.
+    [[nodiscard]] SkinnedVertex make_skinned_vertex(const StandardVertex &vertex, const glm::uvec4 &joints,
+                                                    const glm::vec4 &weights);
+
+    struct AnimationPlayback {
+        std::shared_ptr<const AnimationClip> clip;
+        float                                time  = 0.0f;
+        float                                speed = 1.0f;
+        bool                                 loop  = true;
+        SamplingCache                        cache;
+    };
+
+    // Animated characters skinned on the GPU. update() samples and cross fades every character's clips and builds
+    // its joint palette, spread over the job system. skin() streams all palettes through a ring buffer and runs one
+    // compute dispatch that writes the skinned vertices of every character, as StandardVertex, into a shared output
+    // buffer. From there characters draw like static meshes: one vertex array and index buffer for all of them and a
+    // DrawElementsIndirectCommand each, so any number fit in a single multi draw.
+    class SkinningSystem {
+      public:
+        // `stream_size` bytes of ring buffer hold the palettes of the frames in flight, three frames of
+        // 48 bytes per joint of every instance plus a little
+        explicit SkinningSystem(const std::shared_ptr<GpuResources> &resources,
+                                const std::shared_ptr<JobSystem> &job_system = nullptr, size_t stream_size = 16 << 20);
+
+        ~SkinningSystem();
+
+        SkinningSystem(const SkinningSystem &)            = delete;
+        SkinningSystem &operator=(const SkinningSystem &) = delete;
+
+        static std::shared_ptr<SkinningSystem> create(const std::shared_ptr<GpuResources> &resources,
+                                                      const std::shared_ptr<JobSystem>    &job_system  = nullptr,
+                                                      size_t                               stream_size = 16 << 20);
+
+        // Copies the mesh into the shared source buffers, returns its id. Meant for load time, every call uploads
+        // all meshes again.
+        uint32_t add_mesh(std::span<const SkinnedVertex> vertices, std::span<const uint32_t> indices);
+
+        // A character drawing `mesh` with `skeleton`, in the skeleton's rest pose until something plays.
+        uint32_t add_instance(uint32_t mesh, const std::shared_ptr<const Skeleton> &skeleton);
+
+        // Starts `clip` from the beginning, fading out whatever played before over `fade` seconds.
+        void play(uint32_t instance, const std::shared_ptr<const AnimationClip> &clip, float fade = 0.0f,
+                  float speed = 1.0f, bool loop = true);
+
+        void update(float dt);
+
+        // Uploads the palettes of the last update() and skins every instance. Leaves the compute program bound.
+        void skin();
+
+        // draws the instance from the output buffer with get_vertex_array()
+        [[nodiscard]] DrawElementsIndirectCommand get_draw_command(uint32_t instance) const;
+
+        // StandardVertex layout over the skinned vertices and the shared indices
+        [[nodiscard]] const VertexArray &get_vertex_array() const { return m_resources->get(m_vertex_array); }
+
+        [[nodiscard]] std::span<const JointMatrix> get_palette(uint32_t instance) const;
+
+        [[nodiscard]] Handle<Buffer> get_output_buffer() const noexcept { return m_output; }
+
+        [[nodiscard]] Handle<Buffer> get_index_buffer() const noexcept { return m_index_buffer; }
+
+        [[nodiscard]] size_t get_instance_count() const noexcept { return m_instances.size(); }
+
+      private:
+        struct MeshRange {
+            uint32_t first_vertex;
+            uint32_t vertex_count;
+            uint32_t first_index;
+            uint32_t index_count;
+            uint32_t max_joint;
+        };
+
+        struct Instance {
+            uint32_t                        mesh;
+            std::shared_ptr<const Skeleton> skeleton;
+            uint32_t                        first_joint;  // in the palette
+            uint32_t                        first_vertex; // in the output
+
+            AnimationPlayback current;
+            AnimationPlayback previous; // fading out
+            float             fade_time = 0.0f;
+            float             fade      = 0.0f;
+        };
+
+        // std430 layout of KatSkinInstance
+        struct GpuInstance {
+            uint32_t source_first;
+            uint32_t vertex_count;
+            uint32_t output_first;
+            uint32_t palette_first;
+        };
+
+        void animate(Instance &instance, float dt);
+
+        std::shared_ptr<GpuResources> m_resources;
+        std::shared_ptr<JobSystem>    m_job_system;
+        std::shared_ptr<StreamBuffer> m_stream;
+        size_t                        m_storage_alignment;
+
+        std::vector<SkinnedVertex> m_source_vertices;
+        std::vector<uint32_t>      m_indices;
+        std::vector<MeshRange>     m_meshes;
+        std::vector<Instance>      m_instances;
+        std::vector<JointMatrix>   m_palette;
+        uint32_t                   m_output_vertices = 0;
+        uint32_t                   m_max_vertices    = 0; // of any mesh, sizes the dispatch
+
+        Handle<Buffer>                   m_source;
+        Handle<Buffer>                   m_index_buffer;
+        Handle<Buffer>                   m_output;
+        Handle<VertexArray>              m_vertex_array;
+        std::shared_ptr<ComputePipeline> m_pipeline;
+    };
+
+} // namespace kat
@@ -0,0 +1,205 @@
+#include "software_occlusion.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace kat {
+    namespace {
+        // twice the signed area of (a, b, p), positive when p is left of a -> b
+        float edge(const glm::vec2 &a, const glm::vec2 &b, const glm::vec2 &p) {
+            return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+        }
+
+        // distance to the GL near plane (z = -w), negative behind it
+        float near_distance(const glm::vec4 &v) { return v.z + v.w; }
+    } // namespace
+
+    SoftwareOcclusion::SoftwareOcclusion(uint32_t width, uint32_t height) : m_width(width), m_height(height) {
+        if (!std::has_single_bit(width) || !std::has_single_bit(height))
+            throw std::runtime_error("occlusion buffer size must be a power of two");
+
+        for (glm::uvec2 size = { width, height };; size = glm::max(size / 2u, glm::uvec2(1))) {
+            m_level_sizes.push_back(size);
+            m_levels.emplace_back(static_cast<size_t>(size.x) * size.y, 1.0f);
+            if (size.x == 1 && size.y == 1)
+                break;
+        }
+    }
+
+    std::shared_ptr<SoftwareOcclusion> SoftwareOcclusion::create(uint32_t width, uint32_t height) {
+        return std::make_shared<SoftwareOcclusion>(width, height);
+    }
+
+    void SoftwareOcclusion::clear(const glm::mat4 &view_projection) {
+        m_view_projection = view_projection;
+        std::ranges::fill(m_levels.front(), 1.0f);
+    }
+
+    void SoftwareOcclusion::rasterize(std::span<const glm::vec3> positions, std::span<const uint32_t> indices,
+                                      const glm::mat4 &model) {
+        const glm::mat4 transform = m_view_projection * model;
+
+        std::vector<glm::vec4> clip(positions.size());
+        for (size_t i = 0; i < positions.size(); i++) {
+            clip[i] = transform * glm::vec4(positions[i], 1.0f);
+        }
+
+        const auto to_window = [this](const glm::vec4 &v) {
+            const glm::vec3 ndc = glm::vec3(v) / v.w;
+            return glm::vec3((ndc.x * 0.5f + 0.5f) * static_cast<float>(m_width),
+                             (ndc.y * 0.5f + 0.5f) * static_cast<float>(m_height), ndc.z * 0.5f + 0.5f);
+        };
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            const glm::vec4 triangle[3] = { clip[indices[i]], clip[indices[i + 1]], clip[indices[i + 2]] };
+
+            // clip against the near plane only, the other sides are handled by the bounding box clamp
+            glm::vec4 polygon[4];
+            size_t    count = 0;
+            for (size_t v = 0; v < 3; v++) {
+                const glm::vec4 &current = triangle[v];
+                const glm::vec4 &next    = triangle[(v + 1) % 3];
+                const float      d0      = near_distance(current);
+                const float      d1      = near_distance(next);
+
+                if (d0 >= 0.0f)
+                    polygon[count++] = current;
+                if ((d0 >= 0.0f) != (d1 >= 0.0f))
+                    polygon[count++] = current + (next - current) * (d0 / (d0 - d1));
+            }
+
+            if (count < 3)
+                continue;
+
+            const glm::vec3 first = to_window(polygon[0]);
+            for (size_t v = 1; v + 1 < count; v++) {
+                rasterize_triangle(first, to_window(polygon[v]), to_window(polygon[v + 1]));
+            }
+        }
+    }
+
+    void SoftwareOcclusion::rasterize_triangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) {
+        glm::vec2 p0 = glm::vec2(a), p1 = glm::vec2(b), p2 = glm::vec2(c);
+        float     z0 = a.z, z1 = b.z, z2 = c.z;
+
+        float area = edge(p0, p1, p2);
+        if (std::abs(area) < 1e-6f)
+            return;
+        if (area < 0.0f) {
+            std::swap(p1, p2);
+            std::swap(z1, z2);
+            area = -area;
+        }
+
+        const float width  = static_cast<float>(m_width);
+        const float height = static_cast<float>(m_height);
+
+        const float min_x = std::max(std::floor(std::min({ p0.x, p1.x, p2.x })), 0.0f);
+        const float min_y = std::max(std::floor(std::min({ p0.y, p1.y, p2.y })), 0.0f);
+        const float max_x = std::min(std::ceil(std::max({ p0.x, p1.x, p2.x })), width);
+        const float max_y = std::min(std::ceil(std::max({ p0.y, p1.y, p2.y })), height);
+        if (min_x >= max_x || min_y >= max_y)
+            return;
+
+        // edge functions are affine in the pixel position, step them instead of evaluating per pixel
+        const glm::vec3 step_x = { p1.y - p2.y, p2.y - p0.y, p0.y - p1.y };
+        const glm::vec3 step_y = { p2.x - p1.x, p0.x - p2.x, p1.x - p0.x };
+        const glm::vec3 depth  = glm::vec3(z0, z1, z2) / area;
+
+        const glm::vec2 start = { min_x + 0.5f, min_y + 0.5f };
+        glm::vec3       row   = { edge(p1, p2, start), edge(p2, p0, start), edge(p0, p1, start) };
+
+        std::vector<float> &buffer = m_levels.front();
+
+        for (auto y = static_cast<uint32_t>(min_y); y < static_cast<uint32_t>(max_y); y++, row += step_y) {
+            glm::vec3 w    = row;
+            float    *line = buffer.data() + static_cast<size_t>(y) * m_width;
+
+            for (auto x = static_cast<uint32_t>(min_x); x < static_cast<uint32_t>(max_x); x++, w += step_x) {
+                if (w.x < 0.0f || w.y < 0.0f || w.z < 0.0f)
+                    continue;
+
+                const float z = std::clamp(glm::dot(w, depth), 0.0f, 1.0f);
+                line[x]       = std::min(line[x], z);
+            }
+        }
+    }
+
+    void SoftwareOcclusion::finish() {
+        for (size_t level = 1; level < m_levels.size(); level++) {
+            const glm::uvec2          src_size = m_level_sizes[level - 1];
+            const glm::uvec2          dst_size = m_level_sizes[level];
+            const std::vector<float> &src      = m_levels[level - 1];
+            std::vector<float>       &dst      = m_levels[level];
+
+            for (uint32_t y = 0; y < dst_size.y; y++) {
+                const uint32_t y0 = std::min(y * 2, src_size.y - 1);
+                const uint32_t y1 = std::min(y * 2 + 1, src_size.y - 1);
+
+                for (uint32_t x = 0; x < dst_size.x; x++) {
+                    const uint32_t x0 = std::min(x * 2, src_size.x - 1);
+                    const uint32_t x1 = std::min(x * 2 + 1, src_size.x - 1);
+
+                    dst[y * dst_size.x + x] = std::max({ src[y0 * src_size.x + x0], src[y0 * src_size.x + x1],
+                                                         src[y1 * src_size.x + x0], src[y1 * src_size.x + x1] });
+                }
+            }
+        }
+    }
+
+    bool SoftwareOcclusion::is_visible(const Aabb &bounds) const {
+        glm::vec2 uv_min    = glm::vec2(std::numeric_limits<float>::max());
+        glm::vec2 uv_max    = glm::vec2(-std::numeric_limits<float>::max());
+        float     depth_min = 1.0f;
+
+        for (int i = 0; i < 8; i++) {
+            const glm::vec3 corner = { i & 1 ? bounds.max.x : bounds.min.x, i & 2 ? bounds.max.y : bounds.min.y,
+                                       i & 4 ? bounds.max.z : bounds.min.z };
+            const glm::vec4 clip   = m_view_projection * glm::vec4(corner, 1.0f);
+            if (near_distance(clip) <= 0.0f)
+                return true;
+
+            const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            uv_min              = glm::min(uv_min, glm::vec2(ndc) * 0.5f + 0.5f);
+            uv_max              = glm::max(uv_max, glm::vec2(ndc) * 0.5f + 0.5f);
+            depth_min           = std::min(depth_min, ndc.z * 0.5f + 0.5f);
+        }
+
+        if (uv_max.x < 0.0f || uv_max.y < 0.0f || uv_min.x > 1.0f || uv_min.y > 1.0f)
+            return false;
+
+        uv_min = glm::clamp(uv_min, glm::vec2(0.0f), glm::vec2(1.0f));
+        uv_max = glm::clamp(uv_max, glm::vec2(0.0f), glm::vec2(1.0f));
+
+        // the level where the rectangle covers at most 2x2 texels
+        const glm::vec2 extent = (uv_max - uv_min) * glm::vec2(m_width, m_height);
+        const float     texels = std::max({ extent.x, extent.y, 1.0f });
+        const auto      last   = static_cast<uint32_t>(m_levels.size() - 1);
+        uint32_t        level  = std::min(static_cast<uint32_t>(std::ceil(std::log2(texels))), last);
+
+        glm::uvec2 lo, hi;
+        for (;; level++) {
+            const glm::uvec2 size = m_level_sizes[level];
+            lo = glm::min(glm::uvec2(uv_min * glm::vec2(size)), size - 1u);
+            hi = glm::min(glm::uvec2(uv_max * glm::vec2(size)), size - 1u);
+            if ((hi.x - lo.x <= 1 && hi.y - lo.y <= 1) || level == last)
+                break;
+        }
+
+        const glm::uvec2          size  = m_level_sizes[level];
+        const std::vector<float> &depth = m_levels[level];
+
+        float occluder = 0.0f;
+        for (uint32_t y = lo.y; y <= hi.y; y++) {
+            for (uint32_t x = lo.x; x <= hi.x; x++) {
+                occluder = std::max(occluder, depth[y * size.x + x]);
+            }
+        }
+
+        return depth_min <= occluder;
+    }
+
+} // namespace kat
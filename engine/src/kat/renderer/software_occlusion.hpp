@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "kat/utils/aabb.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    // Small CPU depth buffer for occlusion tests without a GPU round trip, e.g. on software GL drivers where compute
+    // culling costs more than it saves. Occluders are rasterized at low resolution, then finish() builds a max-depth
+    // pyramid that is_visible() tests boxes against the same way the GPU Hi-Z pass does. Depth is window depth with
+    // the default [0, 1] range, 1 is far.
+    class SoftwareOcclusion {
+      public:
+        // both sides must be powers of two
+        explicit SoftwareOcclusion(uint32_t width = 256, uint32_t height = 128);
+
+        static std::shared_ptr<SoftwareOcclusion> create(uint32_t width = 256, uint32_t height = 128);
+
+        // resets the depth to far and sets the camera for the following rasterize() and is_visible() calls
+        void clear(const glm::mat4 &view_projection);
+
+        // Both faces are rasterized. Occluders should be simple and lie inside the geometry they stand for, a
+        // triangle that pokes out of its object hides things that are actually visible.
+        void rasterize(std::span<const glm::vec3> positions, std::span<const uint32_t> indices,
+                       const glm::mat4 &model = glm::mat4(1.0f));
+
+        // builds the pyramid, call after the last rasterize()
+        void finish();
+
+        // false when the box is off screen or entirely behind the occluders, boxes crossing the near plane count as
+        // visible
+        [[nodiscard]] bool is_visible(const Aabb &bounds) const;
+
+        [[nodiscard]] uint32_t get_width() const noexcept { return m_width; }
+
+        [[nodiscard]] uint32_t get_height() const noexcept { return m_height; }
+
+        // level 0 is the rasterized depth, row major from the bottom left
+        [[nodiscard]] std::span<const float> get_depth(uint32_t level = 0) const { return m_levels.at(level); }
+
+        [[nodiscard]] uint32_t get_level_count() const noexcept { return static_cast<uint32_t>(m_levels.size()); }
+
+      private:
+        void rasterize_triangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c);
+
+        uint32_t  m_width;
+        uint32_t  m_height;
+        glm::mat4 m_view_projection = glm::mat4(1.0f);
+
+        std::vector<std::vector<float>> m_levels;
+        std::vector<glm::uvec2>         m_level_sizes;
+    };
+
+} // namespace kat
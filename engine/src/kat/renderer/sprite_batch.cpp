@@ -0,0 +1,281 @@
+#include "sprite_batch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+namespace kat {
+    namespace {
+        const std::string SPRITE_VERTEX_SOURCE = R"(#version 460 core
+#include "kat/sprites.glsl"
+
+uniform mat4 u_projection;
+
+out vec2 v_uv;
+out vec4 v_color;
+
+void main() {
+    KatSprite sprite = kat_sprite();
+    gl_Position = u_projection * vec4(kat_sprite_vertex(sprite), 0.0, 1.0);
+    v_uv        = kat_sprite_uv(sprite);
+    v_color     = unpackUnorm4x8(sprite.color);
+}
+)";
+
+        const std::string SPRITE_FRAGMENT_SOURCE = R"(#version 460 core
+layout(binding = 0) uniform sampler2D u_texture;
+
+in vec2 v_uv;
+in vec4 v_color;
+
+out vec4 color_out;
+
+void main() {
+    color_out = texture(u_texture, v_uv) * v_color;
+}
+)";
+        // smallest block a texture and layer starts a frame with
+        constexpr size_t MIN_BLOCK_SPRITES = 256;
+    } // namespace
+
+    uint32_t pack_color(const color &c) {
+        auto unorm = [](float v) { return static_cast<uint32_t>(std::clamp(v, 0.0f, 1.0f) * 255.0f + 0.5f); };
+        return unorm(c.r) | unorm(c.g) << 8 | unorm(c.b) << 16 | unorm(c.a) << 24;
+    }
+
+    SpriteBatch::SpriteBatch(const std::shared_ptr<GpuResources> &resources, size_t stream_size) :
+        m_resources(resources) {
+        GLint alignment;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        m_storage_alignment = static_cast<size_t>(std::max(alignment, 16));
+
+        // ring offsets are positions modulo the capacity, they stay aligned only if the capacity is
+        m_stream = StreamBuffer::create(std::max(stream_size / m_storage_alignment, size_t(1)) * m_storage_alignment);
+
+        // corners come from gl_VertexID of a 4 vertex triangle strip, the instance from the draw's base instance
+        ShaderModule::register_include("kat/sprites.glsl",
+                                       "struct KatSprite {\n"
+                                       "    vec2 position;\n"
+                                       "    vec2 size;\n"
+                                       "    vec4 uv;\n"
+                                       "    vec2 origin;\n"
+                                       "    float rotation;\n"
+                                       "    uint color;\n"
+                                       "};\n"
+                                       "layout(std430, binding = " +
+                                           std::to_string(SPRITE_BINDING) +
+                                           ") readonly buffer KatSprites {\n"
+                                           "    KatSprite kat_sprites[];\n"
+                                           "};\n"
+                                           "vec2 kat_sprite_corner() {\n"
+                                           "    return vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+                                           "}\n"
+                                           "KatSprite kat_sprite() {\n"
+                                           "    return kat_sprites[gl_BaseInstance + gl_InstanceID];\n"
+                                           "}\n"
+                                           "vec2 kat_sprite_vertex(KatSprite s) {\n"
+                                           "    vec2 local = (kat_sprite_corner() - s.origin) * s.size;\n"
+                                           "    float c = cos(s.rotation), r = sin(s.rotation);\n"
+                                           "    return s.position + vec2(local.x * c - local.y * r, "
+                                           "local.x * r + local.y * c);\n"
+                                           "}\n"
+                                           "vec2 kat_sprite_uv(KatSprite s) {\n"
+                                           "    return mix(s.uv.xy, s.uv.zw, kat_sprite_corner());\n"
+                                           "}\n");
+
+        m_shader = m_resources->create_shader({
+            { SPRITE_VERTEX_SOURCE, ShaderType::Vertex },
+            { SPRITE_FRAGMENT_SOURCE, ShaderType::Fragment },
+        });
+        m_vertex_array = m_resources->create_vertex_array();
+
+        const uint32_t white = 0xFFFFFFFF;
+        m_white              = Texture2D::create(1, 1, TextureFormat::Rgba8, 1);
+        m_white->upload(0, { 0, 0 }, { 1, 1 }, PixelFormat::Rgba, PixelType::UnsignedByte, &white);
+        m_white->set_sampler({ .min_filter = TextureFilter::Nearest, .mag_filter = TextureFilter::Nearest });
+    }
+
+    SpriteBatch::~SpriteBatch() {
+        m_resources->destroy(m_shader);
+        m_resources->destroy(m_vertex_array);
+    }
+
+    std::shared_ptr<SpriteBatch> SpriteBatch::create(const std::shared_ptr<GpuResources> &resources,
+                                                     size_t                               stream_size) {
+        return std::make_shared<SpriteBatch>(resources, stream_size);
+    }
+
+    void SpriteBatch::begin(const glm::mat4 &projection, Handle<Shader> shader) {
+        m_projection   = projection;
+        m_frame_shader = shader.is_null() ? m_shader : shader;
+        m_draw_calls   = 0;
+    }
+
+    void SpriteBatch::begin(const Viewport &viewport, Handle<Shader> shader) {
+        const auto size = glm::vec2(viewport.size);
+        // y is flipped so that (0, 0) is the top left corner
+        begin(glm::mat4(glm::vec4(2.0f / size.x, 0.0f, 0.0f, 0.0f), glm::vec4(0.0f, -2.0f / size.y, 0.0f, 0.0f),
+                        glm::vec4(0.0f, 0.0f, 1.0f, 0.0f), glm::vec4(-1.0f, 1.0f, 0.0f, 1.0f)),
+              shader);
+    }
+
+    void SpriteBatch::draw(const std::shared_ptr<Texture2D> &texture, const Sprite &sprite, uint32_t layer) {
+        *reserve(bucket_for(texture, layer), 1) = { sprite.position, sprite.size,     sprite.uv,
+                                                    sprite.origin,   sprite.rotation, pack_color(sprite.tint) };
+    }
+
+    void SpriteBatch::draw(const TextureAtlas &atlas, uint32_t region, Sprite sprite, uint32_t layer) {
+        sprite.uv = atlas.get(region).uv;
+        draw(atlas.get_texture(), sprite, layer);
+    }
+
+    std::span<SpriteInstance> SpriteBatch::allocate(const std::shared_ptr<Texture2D> &texture, size_t count,
+                                                    uint32_t layer) {
+        if (count == 0)
+            return {};
+        return std::span(reserve(bucket_for(texture, layer), count), count);
+    }
+
+    void SpriteBatch::end() {
+        flush();
+
+        // buckets nobody drew into this frame are dropped, the rest size their first block from this frame
+        std::erase_if(m_buckets, [](const Bucket &b) { return b.frame_count == 0; });
+        for (Bucket &b : m_buckets) {
+            b.last_frame_count = b.frame_count;
+            b.frame_count      = 0;
+            b.texture.reset();
+        }
+        m_last_bucket = 0;
+    }
+
+    size_t SpriteBatch::get_sprite_count() const noexcept {
+        size_t count = 0;
+        for (const auto &bucket : m_buckets) {
+            count += bucket.frame_count;
+        }
+        return count;
+    }
+
+    size_t SpriteBatch::bucket_for(const std::shared_ptr<Texture2D> &texture, uint32_t layer) {
+        const Texture2D *key = texture.get();
+
+        // consecutive sprites usually share a texture
+        auto matches = [&](const Bucket &b) { return b.key == key && b.layer == layer; };
+
+        size_t index = m_last_bucket;
+        if (index >= m_buckets.size() || !matches(m_buckets[index])) {
+            const auto it = std::ranges::find_if(m_buckets, matches);
+            index         = static_cast<size_t>(it - m_buckets.begin());
+            if (it == m_buckets.end())
+                m_buckets.push_back({ .layer = layer, .key = key });
+        }
+
+        // the first sprite of a frame takes the reference, an old key may belong to a freed texture at that address
+        Bucket &bucket = m_buckets[index];
+        if (bucket.frame_count == 0)
+            bucket.texture = texture;
+
+        m_last_bucket = index;
+        return index;
+    }
+
+    SpriteInstance *SpriteBatch::reserve(size_t bucket, size_t count) {
+        if (m_buckets[bucket].capacity - m_buckets[bucket].count < count) {
+            const size_t max_sprites = m_stream->get_capacity() / sizeof(SpriteInstance);
+            if (count > max_sprites)
+                throw std::runtime_error("Sprite allocation larger than the stream buffer");
+
+            // Enough for the rest of what this texture and layer drew last frame, or twice the previous block. Blocks
+            // leave room for other textures and layers unless one allocation needs more.
+            const Bucket &b         = m_buckets[bucket];
+            const size_t  remaining = b.last_frame_count > b.frame_count ? b.last_frame_count - b.frame_count : 0;
+            const size_t  wanted    = std::max({ remaining, 2 * b.capacity, MIN_BLOCK_SPRITES });
+            const size_t  size      = std::max(count, std::min(wanted, max_sprites / 4));
+            const size_t  bytes     = size * sizeof(SpriteInstance);
+
+            close(bucket);
+
+            auto allocation = m_stream->try_allocate(bytes, m_storage_alignment);
+            if (!allocation) {
+                // only wait for the GPU once everything written so far is drawn and fenced
+                flush();
+                allocation = m_stream->allocate(bytes, m_storage_alignment);
+            }
+
+            Bucket &block  = m_buckets[bucket];
+            block.data     = static_cast<SpriteInstance *>(allocation->data);
+            block.offset   = allocation->offset;
+            block.capacity = size;
+        }
+
+        Bucket         &b    = m_buckets[bucket];
+        SpriteInstance *room = b.data + b.count;
+        b.count += count;
+        b.frame_count += count;
+        return room;
+    }
+
+    void SpriteBatch::close(size_t bucket) {
+        Bucket &b = m_buckets[bucket];
+        if (b.count > 0)
+            m_runs.push_back({ b.layer, static_cast<uint32_t>(bucket), b.offset, b.count });
+
+        b.data     = nullptr;
+        b.count    = 0;
+        b.capacity = 0;
+    }
+
+    void SpriteBatch::flush() {
+        for (size_t i = 0; i < m_buckets.size(); i++) {
+            close(i);
+        }
+        if (m_runs.empty())
+            return;
+
+        // only the runs are sorted, the sprites stay where they were written; a bucket's runs keep their order
+        std::ranges::stable_sort(m_runs, {}, [](const Run &r) { return std::tuple(r.layer, r.bucket); });
+
+        const Shader &program = m_resources->get(m_frame_shader.is_null() ? m_shader : m_frame_shader);
+        program.bind();
+        program.uniform_matrix4f("u_projection", m_projection);
+
+        // restored once the sprites are drawn, later draws shouldn't inherit straight alpha blending
+        const GLboolean previous_blend      = glIsEnabled(GL_BLEND);
+        const GLboolean previous_depth_test = glIsEnabled(GL_DEPTH_TEST);
+        GLint           previous_blend_func[4];
+        glGetIntegerv(GL_BLEND_SRC_RGB, &previous_blend_func[0]);
+        glGetIntegerv(GL_BLEND_DST_RGB, &previous_blend_func[1]);
+        glGetIntegerv(GL_BLEND_SRC_ALPHA, &previous_blend_func[2]);
+        glGetIntegerv(GL_BLEND_DST_ALPHA, &previous_blend_func[3]);
+
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glDisable(GL_DEPTH_TEST);
+        m_resources->get(m_vertex_array).bind();
+
+        for (const Run &run : m_runs) {
+            const Bucket &b = m_buckets[run.bucket];
+
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, SPRITE_BINDING, m_stream->get_handle(),
+                              static_cast<GLintptr>(run.offset),
+                              static_cast<GLsizeiptr>(run.count * sizeof(SpriteInstance)));
+            (b.texture ? *b.texture : *m_white).bind(0);
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(run.count));
+            m_draw_calls++;
+        }
+
+        m_stream->fence();
+        m_runs.clear();
+
+        glBlendFuncSeparate(static_cast<GLenum>(previous_blend_func[0]), static_cast<GLenum>(previous_blend_func[1]),
+                            static_cast<GLenum>(previous_blend_func[2]), static_cast<GLenum>(previous_blend_func[3]));
+        if (!previous_blend)
+            glDisable(GL_BLEND);
+        if (previous_depth_test)
+            glEnable(GL_DEPTH_TEST);
+    }
+
+} // namespace kat
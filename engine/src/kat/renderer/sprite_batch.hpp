@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "kat/engine.hpp"
+#include "kat/renderer/gpu_resources.hpp"
+#include "kat/renderer/stream_buffer.hpp"
+#include "kat/renderer/texture.hpp"
+#include "kat/renderer/texture_atlas.hpp"
+#include "kat/utils/color.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    // shader storage binding of the sprite instances, see the "kat/sprites.glsl" include
+    constexpr unsigned int SPRITE_BINDING = 13;
+
+    // std430 layout of KatSprite, one per instance
+    struct SpriteInstance {
+        glm::vec2 position;
+        glm::vec2 size;
+        glm::vec4 uv;       // u0, v0, u1, v1
+        glm::vec2 origin;   // pivot in [0, 1] of the size, position and rotation are around it
+        float     rotation; // radians
+        uint32_t  color;    // RGBA8, red in the low byte
+    };
+
+    static_assert(sizeof(SpriteInstance) == 48);
+
+    struct Sprite {
+        glm::vec2 position;
+        glm::vec2 size;
+        glm::vec4 uv       = { 0.0f, 0.0f, 1.0f, 1.0f };
+        glm::vec2 origin   = { 0.0f, 0.0f };
+        float     rotation = 0.0f;
+        color     tint     = colors::WHITE;
+    };
+
+    [[nodiscard]] uint32_t pack_color(const color &c);
+
+    // Draws textured quads as instances of one 4 vertex triangle strip, pulled by the vertex shader from a shader
+    // storage buffer. Every texture and layer writes into its own block of a persistently mapped stream buffer, so
+    // draw() and allocate() write instance data where the GPU reads it and end() only sorts the blocks. A block is
+    // sized from the sprites its texture and layer had last frame and grows when it runs out, a frame usually costs
+    // one draw call per texture and layer.
+    //
+    // Sprites are grouped by layer, lower layers first, and within a layer by texture; sprites with the same texture
+    // and layer keep their submission order, the order between textures of one layer is unspecified. A frame that
+    // doesn't fit into the stream buffer is drawn in parts as it is submitted, layers are only ordered within a part.
+    // The built-in shader blends with straight alpha and ignores depth; custom shaders include "kat/sprites.glsl" and
+    // call kat_sprite_vertex() in their vertex shader.
+    class SpriteBatch {
+      public:
+        // stream_size bounds the instance data in flight, bigger frames are drawn in several parts
+        explicit SpriteBatch(const std::shared_ptr<GpuResources> &resources, size_t stream_size = 64 * 1024 * 1024);
+
+        ~SpriteBatch();
+
+        SpriteBatch(const SpriteBatch &)            = delete;
+        SpriteBatch &operator=(const SpriteBatch &) = delete;
+
+        static std::shared_ptr<SpriteBatch> create(const std::shared_ptr<GpuResources> &resources,
+                                                   size_t                               stream_size = 64 * 1024 * 1024);
+
+        // Sprites are drawn with the built-in shader or `shader`, a shader of the batch's GpuResources.
+        void begin(const glm::mat4 &projection, Handle<Shader> shader = {});
+
+        // pixel coordinates with the origin in the top left corner
+        void begin(const Viewport &viewport, Handle<Shader> shader = {});
+
+        // null draws untextured quads
+        void draw(const std::shared_ptr<Texture2D> &texture, const Sprite &sprite, uint32_t layer = 0);
+
+        // uv comes from the region
+        void draw(const TextureAtlas &atlas, uint32_t region, Sprite sprite, uint32_t layer = 0);
+
+        // Room for `count` sprites in the stream buffer that the caller fills in place, the cheapest way to submit
+        // many at once. Valid until the next call on the batch. Throws when `count` sprites don't fit into the stream
+        // buffer.
+        [[nodiscard]] std::span<SpriteInstance> allocate(const std::shared_ptr<Texture2D> &texture, size_t count,
+                                                         uint32_t layer = 0);
+
+        // Draws everything since begin() that wasn't drawn yet.
+        void end();
+
+        // sprites submitted since begin()
+        [[nodiscard]] size_t get_sprite_count() const noexcept;
+
+        [[nodiscard]] size_t get_draw_call_count() const noexcept { return m_draw_calls; }
+
+      private:
+        struct Bucket {
+            uint32_t                   layer;
+            const Texture2D           *key;
+            std::shared_ptr<Texture2D> texture;
+
+            // the block being filled, in the stream buffer
+            SpriteInstance *data     = nullptr;
+            size_t          offset   = 0;
+            size_t          count    = 0;
+            size_t          capacity = 0;
+
+            size_t frame_count      = 0; // sprites since begin()
+            size_t last_frame_count = 0; // sizes the first block of a frame
+        };
+
+        // a filled block waiting to be drawn
+        struct Run {
+            uint32_t layer;
+            uint32_t bucket;
+            size_t   offset;
+            size_t   count;
+        };
+
+        size_t bucket_for(const std::shared_ptr<Texture2D> &texture, uint32_t layer);
+
+        // room for `count` more sprites in the bucket's block, starting a new block if needed
+        SpriteInstance *reserve(size_t bucket, size_t count);
+
+        // turns the bucket's block into a run
+        void close(size_t bucket);
+
+        // draws and fences all runs and open blocks
+        void flush();
+
+        std::shared_ptr<GpuResources> m_resources;
+        std::shared_ptr<StreamBuffer> m_stream;
+        Handle<Shader>                m_shader;
+        std::shared_ptr<Texture2D>    m_white;
+        Handle<VertexArray>           m_vertex_array;
+        size_t                        m_storage_alignment;
+
+        glm::mat4           m_projection = glm::mat4(1.0f);
+        Handle<Shader>      m_frame_shader;
+        std::vector<Bucket> m_buckets;
+        std::vector<Run>    m_runs;
+        size_t              m_last_bucket = 0;
+        size_t              m_draw_calls  = 0;
+    };
+
+} // namespace kat
@@ -0,0 +1,102 @@
+#include "stream_buffer.hpp"
+
+namespace kat {
+
+    StreamBuffer::StreamBuffer(size_t size) : m_capacity(size) {
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glCreateBuffers(1, &m_buffer);
+        glNamedBufferStorage(m_buffer, static_cast<GLsizeiptr>(size), nullptr, flags);
+        m_mapping = static_cast<std::byte *>(glMapNamedBufferRange(m_buffer, 0, static_cast<GLsizeiptr>(size), flags));
+
+        if (!m_mapping)
+            throw std::runtime_error("Failed to map stream buffer");
+    }
+
+    StreamBuffer::~StreamBuffer() {
+        for (const auto &segment : m_segments) {
+            glDeleteSync(segment.sync);
+        }
+
+        glUnmapNamedBuffer(m_buffer);
+        glDeleteBuffers(1, &m_buffer);
+    }
+
+    std::shared_ptr<StreamBuffer> StreamBuffer::create(size_t size) {
+        return std::make_shared<StreamBuffer>(size);
+    }
+
+    std::optional<StreamBuffer::Allocation> StreamBuffer::try_allocate(size_t size, size_t alignment) {
+        retire(false);
+        return allocate_unchecked(size, alignment);
+    }
+
+    StreamBuffer::Allocation StreamBuffer::allocate(size_t size, size_t alignment) {
+        if (size > m_capacity)
+            throw std::runtime_error("Stream buffer allocation larger than the buffer");
+
+        retire(false);
+        while (true) {
+            if (auto allocation = allocate_unchecked(size, alignment))
+                return *allocation;
+
+            if (m_segments.empty()) {
+                // everything outstanding is unfenced, fence it so there is something to wait on
+                fence();
+            }
+            retire(true);
+        }
+    }
+
+    std::optional<StreamBuffer::Allocation> StreamBuffer::allocate_unchecked(size_t size, size_t alignment) {
+        // nothing in flight, start over at the beginning so the wrap padding can't keep a large allocation out
+        if (m_segments.empty() && m_head == m_tail) {
+            m_head = 0;
+            m_tail = 0;
+        }
+
+        uint64_t start  = (m_head + alignment - 1) / alignment * alignment;
+        size_t   offset = start % m_capacity;
+
+        // allocations never straddle the end of the ring
+        if (offset + size > m_capacity) {
+            start += m_capacity - offset;
+            offset = 0;
+        }
+
+        if (start + size - m_tail > m_capacity)
+            return std::nullopt;
+
+        m_head = start + size;
+        return Allocation{ m_mapping + offset, offset, size };
+    }
+
+    void StreamBuffer::fence() {
+        const uint64_t fenced = m_segments.empty() ? m_tail : m_segments.back().end;
+        if (m_head == fenced)
+            return;
+
+        m_segments.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), m_head });
+    }
+
+    void StreamBuffer::retire(bool wait) {
+        while (!m_segments.empty()) {
+            const Segment &segment = m_segments.front();
+
+            const GLuint64 timeout = wait ? GL_TIMEOUT_IGNORED : 0;
+            const GLenum   status  = glClientWaitSync(segment.sync, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+            if (status == GL_TIMEOUT_EXPIRED)
+                return;
+            if (status == GL_WAIT_FAILED)
+                throw std::runtime_error("glClientWaitSync failed on stream buffer fence");
+
+            glDeleteSync(segment.sync);
+            m_tail = segment.end;
+            m_segments.pop_front();
+
+            // only block for the first one, the rest are checked without waiting
+            wait = false;
+        }
+    }
+
+} // namespace kat
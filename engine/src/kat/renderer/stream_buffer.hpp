@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+
+#include "kat/engine.hpp"
+
+namespace kat {
+
+    // Persistently mapped ring buffer for CPU -> GPU streaming (pixel unpack, per-frame uniforms, sprite vertices).
+    // Writes go straight into the mapping; fence() marks everything written so far as in use by the GPU, and the
+    // space is only reused once that fence has signalled.
+    class StreamBuffer {
+      public:
+        struct Allocation {
+            void  *data;
+            size_t offset; // from the start of the GL buffer
+            size_t size;
+        };
+
+        explicit StreamBuffer(size_t size);
+
+        ~StreamBuffer();
+
+        StreamBuffer(const StreamBuffer &)            = delete;
+        StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+        static std::shared_ptr<StreamBuffer> create(size_t size);
+
+        // Returns nullopt instead of waiting when the GPU still holds the space.
+        [[nodiscard]] std::optional<Allocation> try_allocate(size_t size, size_t alignment = 16);
+
+        // Waits on the oldest fences until there is room. Throws when size exceeds the capacity.
+        [[nodiscard]] Allocation allocate(size_t size, size_t alignment = 16);
+
+        // Call after issuing the GL commands that read the allocations made since the last fence.
+        void fence();
+
+        [[nodiscard]] unsigned int get_handle() const noexcept { return m_buffer; }
+
+        [[nodiscard]] size_t get_capacity() const noexcept { return m_capacity; }
+
+      private:
+        struct Segment {
+            GLsync   sync;
+            uint64_t end;
+        };
+
+        // frees segments whose fence has signalled, optionally blocking on the oldest one
+        void retire(bool wait);
+
+        std::optional<Allocation> allocate_unchecked(size_t size, size_t alignment);
+
+        unsigned int m_buffer   = 0;
+        std::byte   *m_mapping  = nullptr;
+        size_t       m_capacity = 0;
+
+        // monotonic byte positions, the ring offset is position % capacity
+        uint64_t            m_head = 0;
+        uint64_t            m_tail = 0;
+        std::deque<Segment> m_segments;
+    };
+
+} // namespace kat
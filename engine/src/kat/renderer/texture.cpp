@@ -0,0 +1,325 @@
+#include "texture.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace kat {
+
+    bool is_compressed(TextureFormat format) {
+        return block_size(format) != 0;
+    }
+
+    size_t block_size(TextureFormat format) {
+        switch (format) {
+        case TextureFormat::Bc1Rgb:
+        case TextureFormat::Bc1Srgb:
+        case TextureFormat::Bc1Rgba:
+        case TextureFormat::Bc1SrgbAlpha:
+        case TextureFormat::Bc4:
+        case TextureFormat::Bc4Signed:
+            return 8;
+        case TextureFormat::Bc2:
+        case TextureFormat::Bc2Srgb:
+        case TextureFormat::Bc3:
+        case TextureFormat::Bc3Srgb:
+        case TextureFormat::Bc5:
+        case TextureFormat::Bc5Signed:
+        case TextureFormat::Bc6hUfloat:
+        case TextureFormat::Bc6hSfloat:
+        case TextureFormat::Bc7:
+        case TextureFormat::Bc7Srgb:
+            return 16;
+        default:
+            return 0;
+        }
+    }
+
+    size_t compressed_image_size(TextureFormat format, uint32_t width, uint32_t height) {
+        return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * block_size(format);
+    }
+
+    size_t texture_level_size(TextureFormat format, uint32_t width, uint32_t height) {
+        if (is_compressed(format))
+            return compressed_image_size(format, width, height);
+
+        size_t texel;
+        switch (format) {
+        case TextureFormat::R8:
+            texel = 1;
+            break;
+        case TextureFormat::Rg8:
+        case TextureFormat::R16F:
+            texel = 2;
+            break;
+        case TextureFormat::Rg16F:
+        case TextureFormat::R32F:
+            texel = 4;
+            break;
+        case TextureFormat::Rgb16F:
+        case TextureFormat::Rgba16F:
+        case TextureFormat::Rg32F:
+            texel = 8;
+            break;
+        case TextureFormat::Rgb32F:
+        case TextureFormat::Rgba32F:
+            texel = 16;
+            break;
+        default:
+            texel = 4;
+            break;
+        }
+        return static_cast<size_t>(width) * height * texel;
+    }
+
+    Texture::Texture(GLenum target, TextureFormat format, uint32_t width, uint32_t height, uint32_t layers,
+                     uint32_t levels, bool sparse) :
+        m_target(target), m_format(format), m_width(width), m_height(height), m_layers(layers),
+        m_levels(levels == 0 ? mip_levels(width, height) : levels), m_sparse(sparse) {
+        if (width == 0 || height == 0 || layers == 0)
+            throw std::runtime_error("Cannot create an empty texture");
+
+        glCreateTextures(target, 1, &m_texture);
+
+        if (sparse)
+            glTextureParameteri(m_texture, GL_TEXTURE_SPARSE_ARB, GL_TRUE);
+
+        const auto internal_format = static_cast<GLenum>(format);
+        if (target == GL_TEXTURE_2D_ARRAY) {
+            glTextureStorage3D(m_texture, static_cast<GLsizei>(m_levels), internal_format, static_cast<GLsizei>(width),
+                               static_cast<GLsizei>(height), static_cast<GLsizei>(layers));
+        }
+        else {
+            // cube maps take 2D storage, the six faces are implied
+            glTextureStorage2D(m_texture, static_cast<GLsizei>(m_levels), internal_format, static_cast<GLsizei>(width),
+                               static_cast<GLsizei>(height));
+        }
+
+        glTextureParameteri(m_texture, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(m_levels - 1));
+        set_sampler({});
+    }
+
+    Texture::~Texture() {
+        glDeleteTextures(1, &m_texture);
+    }
+
+    void Texture::bind(unsigned int unit) const {
+        glBindTextureUnit(unit, m_texture);
+    }
+
+    void Texture::set_sampler(const SamplerState &sampler) {
+        TextureFilter min_filter = sampler.min_filter;
+        if (m_levels == 1) {
+            // a mipmapped filter on a single level texture would make it incomplete
+            if (min_filter == TextureFilter::NearestMipmapNearest || min_filter == TextureFilter::NearestMipmapLinear)
+                min_filter = TextureFilter::Nearest;
+            else if (min_filter != TextureFilter::Nearest)
+                min_filter = TextureFilter::Linear;
+        }
+
+        glTextureParameteri(m_texture, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(min_filter));
+        glTextureParameteri(m_texture, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(sampler.mag_filter));
+        glTextureParameteri(m_texture, GL_TEXTURE_WRAP_S, static_cast<GLint>(sampler.wrap_s));
+        glTextureParameteri(m_texture, GL_TEXTURE_WRAP_T, static_cast<GLint>(sampler.wrap_t));
+        glTextureParameteri(m_texture, GL_TEXTURE_WRAP_R, static_cast<GLint>(sampler.wrap_r));
+        glTextureParameterf(m_texture, GL_TEXTURE_MAX_ANISOTROPY, std::max(sampler.max_anisotropy, 1.0f));
+    }
+
+    void Texture::generate_mipmaps() {
+        if (m_levels > 1)
+            glGenerateTextureMipmap(m_texture);
+    }
+
+    uint32_t Texture::mip_levels(uint32_t width, uint32_t height) {
+        return static_cast<uint32_t>(std::bit_width(std::max({ width, height, 1u })));
+    }
+
+    void Texture::sub_image(uint32_t level, uint32_t layer, const glm::uvec2 &offset, const glm::uvec2 &size,
+                            PixelFormat format, PixelType type, const void *pixels, unsigned int unpack_buffer) const {
+        // decoded images are tightly packed, rows of RGB8 data are not 4 byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpack_buffer);
+
+        if (m_target == GL_TEXTURE_2D) {
+            glTextureSubImage2D(m_texture, static_cast<GLint>(level), static_cast<GLint>(offset.x),
+                                static_cast<GLint>(offset.y), static_cast<GLsizei>(size.x),
+                                static_cast<GLsizei>(size.y), static_cast<GLenum>(format), static_cast<GLenum>(type),
+                                pixels);
+        }
+        else {
+            // arrays and cube faces are both addressed through the z offset
+            glTextureSubImage3D(m_texture, static_cast<GLint>(level), static_cast<GLint>(offset.x),
+                                static_cast<GLint>(offset.y), static_cast<GLint>(layer), static_cast<GLsizei>(size.x),
+                                static_cast<GLsizei>(size.y), 1, static_cast<GLenum>(format),
+                                static_cast<GLenum>(type), pixels);
+        }
+
+        if (unpack_buffer != 0)
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    void Texture::compressed_sub_image(uint32_t level, uint32_t layer, const glm::uvec2 &offset,
+                                       const glm::uvec2 &size, const void *data, size_t bytes,
+                                       unsigned int unpack_buffer) const {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpack_buffer);
+
+        const auto format = static_cast<GLenum>(m_format);
+        if (m_target == GL_TEXTURE_2D) {
+            glCompressedTextureSubImage2D(m_texture, static_cast<GLint>(level), static_cast<GLint>(offset.x),
+                                          static_cast<GLint>(offset.y), static_cast<GLsizei>(size.x),
+                                          static_cast<GLsizei>(size.y), format, static_cast<GLsizei>(bytes), data);
+        }
+        else {
+            glCompressedTextureSubImage3D(m_texture, static_cast<GLint>(level), static_cast<GLint>(offset.x),
+                                          static_cast<GLint>(offset.y), static_cast<GLint>(layer),
+                                          static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y), 1, format,
+                                          static_cast<GLsizei>(bytes), data);
+        }
+
+        if (unpack_buffer != 0)
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    Texture2D::Texture2D(uint32_t width, uint32_t height, TextureFormat format, uint32_t levels, bool sparse) :
+        Texture(GL_TEXTURE_2D, format, width, height, 1, levels, sparse) {}
+
+    std::shared_ptr<Texture2D> Texture2D::create(uint32_t width, uint32_t height, TextureFormat format,
+                                                 uint32_t levels) {
+        return std::make_shared<Texture2D>(width, height, format, levels);
+    }
+
+    std::shared_ptr<Texture2D> Texture2D::create_sparse(uint32_t width, uint32_t height, TextureFormat format,
+                                                        uint32_t levels) {
+        if (!supports_sparse(format, width, height))
+            throw std::runtime_error("Sparse textures are not supported for this format and size");
+        return std::make_shared<Texture2D>(width, height, format, levels, true);
+    }
+
+    bool Texture2D::supports_sparse(TextureFormat format, uint32_t width, uint32_t height) {
+        if (!GLAD_GL_ARB_sparse_texture)
+            return false;
+
+        const auto internal_format = static_cast<GLenum>(format);
+
+        GLint page_sizes = 0;
+        glGetInternalformativ(GL_TEXTURE_2D, internal_format, GL_NUM_VIRTUAL_PAGE_SIZES_ARB, 1, &page_sizes);
+        if (page_sizes <= 0)
+            return false;
+
+        // storage is allocated with the first page size, GL_INVALID_VALUE for a size off its grid
+        GLint page_x = 0, page_y = 0;
+        glGetInternalformativ(GL_TEXTURE_2D, internal_format, GL_VIRTUAL_PAGE_SIZE_X_ARB, 1, &page_x);
+        glGetInternalformativ(GL_TEXTURE_2D, internal_format, GL_VIRTUAL_PAGE_SIZE_Y_ARB, 1, &page_y);
+        return page_x > 0 && page_y > 0 && width % static_cast<uint32_t>(page_x) == 0 &&
+               height % static_cast<uint32_t>(page_y) == 0;
+    }
+
+    uint32_t Texture2D::get_sparse_levels() const {
+        if (!m_sparse)
+            return m_levels;
+
+        GLint levels = 0;
+        glGetTextureParameteriv(m_texture, GL_NUM_SPARSE_LEVELS_ARB, &levels);
+        return std::min(static_cast<uint32_t>(levels), m_levels);
+    }
+
+    void Texture2D::commit(uint32_t level, bool commit) const {
+        const auto width  = static_cast<GLsizei>(std::max(m_width >> level, 1u));
+        const auto height = static_cast<GLsizei>(std::max(m_height >> level, 1u));
+
+        // a region reaching the level's edge may end off the page grid, so whole levels are always valid
+        if (GLAD_GL_EXT_direct_state_access) {
+            glTexturePageCommitmentEXT(m_texture, static_cast<GLint>(level), 0, 0, 0, width, height, 1, commit);
+        }
+        else {
+            glBindTexture(GL_TEXTURE_2D, m_texture);
+            glTexPageCommitmentARB(GL_TEXTURE_2D, static_cast<GLint>(level), 0, 0, 0, width, height, 1, commit);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+    }
+
+    void Texture2D::upload(uint32_t level, const glm::uvec2 &offset, const glm::uvec2 &size, PixelFormat format,
+                           PixelType type, const void *pixels) const {
+        sub_image(level, 0, offset, size, format, type, pixels, 0);
+    }
+
+    void Texture2D::upload(uint32_t level, const glm::uvec2 &offset, const glm::uvec2 &size, PixelFormat format,
+                           PixelType type, unsigned int unpack_buffer, size_t buffer_offset) const {
+        sub_image(level, 0, offset, size, format, type, reinterpret_cast<const void *>(buffer_offset), unpack_buffer);
+    }
+
+    void Texture2D::upload_compressed(uint32_t level, const glm::uvec2 &offset, const glm::uvec2 &size,
+                                      const void *data, size_t bytes) const {
+        compressed_sub_image(level, 0, offset, size, data, bytes, 0);
+    }
+
+    void Texture2D::upload_compressed(uint32_t level, const glm::uvec2 &offset, const glm::uvec2 &size, size_t bytes,
+                                      unsigned int unpack_buffer, size_t buffer_offset) const {
+        compressed_sub_image(level, 0, offset, size, reinterpret_cast<const void *>(buffer_offset), bytes,
+                             unpack_buffer);
+    }
+
+    Texture2DArray::Texture2DArray(uint32_t width, uint32_t height, uint32_t layers, TextureFormat format,
+                                   uint32_t levels) :
+        Texture(GL_TEXTURE_2D_ARRAY, format, width, height, layers, levels) {}
+
+    std::shared_ptr<Texture2DArray> Texture2DArray::create(uint32_t width, uint32_t height, uint32_t layers,
+                                                           TextureFormat format, uint32_t levels) {
+        return std::make_shared<Texture2DArray>(width, height, layers, format, levels);
+    }
+
+    void Texture2DArray::upload(uint32_t level, uint32_t layer, const glm::uvec2 &offset, const glm::uvec2 &size,
+                                PixelFormat format, PixelType type, const void *pixels) const {
+        sub_image(level, layer, offset, size, format, type, pixels, 0);
+    }
+
+    void Texture2DArray::upload(uint32_t level, uint32_t layer, const glm::uvec2 &offset, const glm::uvec2 &size,
+                                PixelFormat format, PixelType type, unsigned int unpack_buffer,
+                                size_t buffer_offset) const {
+        sub_image(level, layer, offset, size, format, type, reinterpret_cast<const void *>(buffer_offset),
+                  unpack_buffer);
+    }
+
+    void Texture2DArray::upload_compressed(uint32_t level, uint32_t layer, const glm::uvec2 &offset,
+                                           const glm::uvec2 &size, const void *data, size_t bytes) const {
+        compressed_sub_image(level, layer, offset, size, data, bytes, 0);
+    }
+
+    void Texture2DArray::upload_compressed(uint32_t level, uint32_t layer, const glm::uvec2 &offset,
+                                           const glm::uvec2 &size, size_t bytes, unsigned int unpack_buffer,
+                                           size_t buffer_offset) const {
+        compressed_sub_image(level, layer, offset, size, reinterpret_cast<const void *>(buffer_offset), bytes,
+                             unpack_buffer);
+    }
+
+    TextureCube::TextureCube(uint32_t size, TextureFormat format, uint32_t levels) :
+        Texture(GL_TEXTURE_CUBE_MAP, format, size, size, 6, levels) {}
+
+    std::shared_ptr<TextureCube> TextureCube::create(uint32_t size, TextureFormat format, uint32_t levels) {
+        return std::make_shared<TextureCube>(size, format, levels);
+    }
+
+    void TextureCube::upload(uint32_t level, CubeFace face, const glm::uvec2 &offset, const glm::uvec2 &size,
+                             PixelFormat format, PixelType type, const void *pixels) const {
+        sub_image(level, static_cast<uint32_t>(face), offset, size, format, type, pixels, 0);
+    }
+
+    void TextureCube::upload(uint32_t level, CubeFace face, const glm::uvec2 &offset, const glm::uvec2 &size,
+                             PixelFormat format, PixelType type, unsigned int unpack_buffer,
+                             size_t buffer_offset) const {
+        sub_image(level, static_cast<uint32_t>(face), offset, size, format, type,
+                  reinterpret_cast<const void *>(buffer_offset), unpack_buffer);
+    }
+
+    void TextureCube::upload_compressed(uint32_t level, CubeFace face, const glm::uvec2 &offset,
+                                        const glm::uvec2 &size, const void *data, size_t bytes) const {
+        compressed_sub_image(level, static_cast<uint32_t>(face), offset, size, data, bytes, 0);
+    }
+
+    void TextureCube::upload_compressed(uint32_t level, CubeFace face, const glm::uvec2 &offset,
+                                        const glm::uvec2 &size, size_t bytes, unsigned int unpack_buffer,
+                                        size_t buffer_offset) const {
+        compressed_sub_image(level, static_cast<uint32_t>(face), offset, size,
+                             reinterpret_cast<const void *>(buffer_offset), bytes, unpack_buffer);
+    }
+
+} // namespace kat
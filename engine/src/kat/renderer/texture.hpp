@@ -0,0 +1,232 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+
+#include "kat/engine.hpp"
+
+namespace kat {
+
+    enum class TextureFormat : GLenum {
+        R8          = GL_R8,
+        Rg8         = GL_RG8,
+        Rgb8        = GL_RGB8,
+        Rgba8       = GL_RGBA8,
+        Srgb8       = GL_SRGB8,
+        Srgb8Alpha8 = GL_SRGB8_ALPHA8,
+
+        R16F    = GL_R16F,
+        Rg16F   = GL_RG16F,
+        Rgb16F  = GL_RGB16F,
+        Rgba16F = GL_RGBA16F,
+        R32F    = GL_R32F,
+        Rg32F   = GL_RG32F,
+        Rgb32F  = GL_RGB32F,
+        Rgba32F = GL_RGBA32F,
+
+        Depth24Stencil8 = GL_DEPTH24_STENCIL8,
+        Depth32F        = GL_DEPTH_COMPONENT32F,
+
+        // block compressed, 4x4 texel blocks
+        Bc1Rgb       = GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+        Bc1Srgb      = GL_COMPRESSED_SRGB_S3TC_DXT1_EXT,
+        Bc1Rgba      = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,
+        Bc1SrgbAlpha = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT,
+        Bc2          = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT,
+        Bc2Srgb      = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT,
+        Bc3          = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+        Bc3Srgb      = GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT,
+        Bc4          = GL_COMPRESSED_RED_RGTC1,
+        Bc4Signed    = GL_COMPRESSED_SIGNED_RED_RGTC1,
+        Bc5          = GL_COMPRESSED_RG_RGTC2,
+        Bc5Signed    = GL_COMPRESSED_SIGNED_RG_RGTC2,
+        Bc6hUfloat   = GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT,
+        Bc6hSfloat   = GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT,
+        Bc7          = GL_COMPRESSED_RGBA_BPTC_UNORM,
+        Bc7Srgb      = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM,
+    };
+
+    [[nodiscard]] bool is_compressed(TextureFormat format);
+
+    // bytes per 4x4 block of a compressed format
+    [[nodiscard]] size_t block_size(TextureFormat format);
+
+    // bytes of a width x height image, rounded up to whole blocks for compressed formats
+    [[nodiscard]] size_t compressed_image_size(TextureFormat format, uint32_t width, uint32_t height);
+
+    // GPU bytes of one width x height level in any format (RGB formats count as padded to four channels)
+    [[nodiscard]] size_t texture_level_size(TextureFormat format, uint32_t width, uint32_t height);
+
+    // client side layout of pixel data handed to upload()
+    enum class PixelFormat : GLenum {
+        Red  = GL_RED,
+        Rg   = GL_RG,
+        Rgb  = GL_RGB,
+        Rgba = GL_RGBA,
+        Bgra = GL_BGRA,
+    };
+
+    enum class PixelType : GLenum {
+        UnsignedByte = GL_UNSIGNED_BYTE,
+        HalfFloat    = GL_HALF_FLOAT,
+        Float        = GL_FLOAT,
+    };
+
+    enum class TextureFilter : GLenum {
+        Nearest              = GL_NEAREST,
+        Linear               = GL_LINEAR,
+        NearestMipmapNearest = GL_NEAREST_MIPMAP_NEAREST,
+        LinearMipmapNearest  = GL_LINEAR_MIPMAP_NEAREST,
+        NearestMipmapLinear  = GL_NEAREST_MIPMAP_LINEAR,
+        LinearMipmapLinear   = GL_LINEAR_MIPMAP_LINEAR,
+    };
+
+    enum class TextureWrap : GLenum {
+        Repeat         = GL_REPEAT,
+        MirroredRepeat = GL_MIRRORED_REPEAT,
+        ClampToEdge    = GL_CLAMP_TO_EDGE,
+        ClampToBorder  = GL_CLAMP_TO_BORDER,
+    };
+
+    struct SamplerState {
+        TextureFilter min_filter     = TextureFilter::LinearMipmapLinear;
+        TextureFilter mag_filter     = TextureFilter::Linear;
+        TextureWrap   wrap_s         = TextureWrap::Repeat;
+        TextureWrap   wrap_t         = TextureWrap::Repeat;
+        TextureWrap   wrap_r         = TextureWrap::Repeat;
+        float         max_anisotropy = 1.0f;
+    };
+
+    enum class CubeFace : uint32_t { PositiveX, NegativeX, PositiveY, NegativeY, PositiveZ, NegativeZ };
+
+    // Immutable storage texture. Size and level count are fixed at creation, contents are filled with upload().
+    class Texture {
+      public:
+        virtual ~Texture();
+
+        Texture(const Texture &)            = delete;
+        Texture &operator=(const Texture &) = delete;
+
+        void bind(unsigned int unit) const;
+
+        void set_sampler(const SamplerState &sampler);
+
+        void generate_mipmaps();
+
+        [[nodiscard]] unsigned int get_handle() const noexcept { return m_texture; }
+
+        [[nodiscard]] GLenum get_target() const noexcept { return m_target; }
+
+        [[nodiscard]] TextureFormat get_format() const noexcept { return m_format; }
+
+        [[nodiscard]] uint32_t get_width() const noexcept { return m_width; }
+
+        [[nodiscard]] uint32_t get_height() const noexcept { return m_height; }
+
+        // array layers, or 6 for cube maps
+        [[nodiscard]] uint32_t get_layers() const noexcept { return m_layers; }
+
+        [[nodiscard]] uint32_t get_levels() const noexcept { return m_levels; }
+
+        [[nodiscard]] bool is_sparse() const noexcept { return m_sparse; }
+
+        // length of the full mip chain for a width x height image
+        [[nodiscard]] static uint32_t mip_levels(uint32_t width, uint32_t height);
+
+      protected:
+        // levels == 0 allocates the full mip chain. Sparse textures only reserve address space, see Texture2D::commit.
+        Texture(GLenum target, TextureFormat format, uint32_t width, uint32_t height, uint32_t layers,
+                uint32_t levels, bool sparse = false);
+
+        // unpack_buffer != 0 reads the pixels from that buffer, `pixels` is then a byte offset into it
+        void sub_image(uint32_t level, uint32_t layer, const glm::uvec2 &offset, const glm::uvec2 &size,
+                       PixelFormat format, PixelType type, const void *pixels, unsigned int unpack_buffer) const;
+
+        // same for block compressed data in the texture's own format, offset and size are in texels
+        void compressed_sub_image(uint32_t level, uint32_t layer, const glm::uvec2 &offset, const glm::uvec2 &size,
+                                  const void *data, size_t bytes, unsigned int unpack_buffer) const;
+
+        unsigned int  m_texture = 0;
+        GLenum        m_target;
+        TextureFormat m_format;
+        uint32_t      m_width;
+        uint32_t      m_height;
+        uint32_t      m_layers;
+        uint32_t      m_levels;
+        bool          m_sparse;
+    };
+
+    class Texture2D : public Texture {
+      public:
+        Texture2D(uint32_t width, uint32_t height, TextureFormat format, uint32_t levels = 0, bool sparse = false);
+
+        static std::shared_ptr<Texture2D> create(uint32_t width, uint32_t height, TextureFormat format,
+                                                 uint32_t levels = 0);
+
+        // GL_ARB_sparse_texture: no memory is backing the levels until they are committed
+        static std::shared_ptr<Texture2D> create_sparse(uint32_t width, uint32_t height, TextureFormat format,
+                                                        uint32_t levels = 0);
+
+        // the size has to be a multiple of the format's page size
+        [[nodiscard]] static bool supports_sparse(TextureFormat format, uint32_t width, uint32_t height);
+
+        // Levels from here on share one allocation (the mip tail), committing any of them commits them all.
+        [[nodiscard]] uint32_t get_sparse_levels() const;
+
+        // Backs a whole level with memory or releases it. Sampling an uncommitted level reads undefined values, clamp
+        // the sampled level range to what is committed.
+        void commit(uint32_t level, bool commit) const;
+
+        void upload(uint32_t level, const glm::uvec2 &offset, const glm::uvec2 &size, PixelFormat format,
+                    PixelType type, const void *pixels) const;
+
+        // PBO path, the data starts at buffer_offset in unpack_buffer
+        void upload(uint32_t level, const glm::uvec2 &offset, const glm::uvec2 &size, PixelFormat format,
+                    PixelType type, unsigned int unpack_buffer, size_t buffer_offset) const;
+
+        void upload_compressed(uint32_t level, const glm::uvec2 &offset, const glm::uvec2 &size, const void *data,
+                               size_t bytes) const;
+
+        void upload_compressed(uint32_t level, const glm::uvec2 &offset, const glm::uvec2 &size, size_t bytes,
+                               unsigned int unpack_buffer, size_t buffer_offset) const;
+    };
+
+    class Texture2DArray : public Texture {
+      public:
+        Texture2DArray(uint32_t width, uint32_t height, uint32_t layers, TextureFormat format, uint32_t levels = 0);
+
+        static std::shared_ptr<Texture2DArray> create(uint32_t width, uint32_t height, uint32_t layers,
+                                                      TextureFormat format, uint32_t levels = 0);
+
+        void upload(uint32_t level, uint32_t layer, const glm::uvec2 &offset, const glm::uvec2 &size,
+                    PixelFormat format, PixelType type, const void *pixels) const;
+
+        void upload(uint32_t level, uint32_t layer, const glm::uvec2 &offset, const glm::uvec2 &size,
+                    PixelFormat format, PixelType type, unsigned int unpack_buffer, size_t buffer_offset) const;
+
+        void upload_compressed(uint32_t level, uint32_t layer, const glm::uvec2 &offset, const glm::uvec2 &size,
+                               const void *data, size_t bytes) const;
+
+        void upload_compressed(uint32_t level, uint32_t layer, const glm::uvec2 &offset, const glm::uvec2 &size,
+                               size_t bytes, unsigned int unpack_buffer, size_t buffer_offset) const;
+    };
+
+    class TextureCube : public Texture {
+      public:
+        TextureCube(uint32_t size, TextureFormat format, uint32_t levels = 0);
+
+        static std::shared_ptr<TextureCube> create(uint32_t size, TextureFormat format, uint32_t levels = 0);
+
+        void upload(uint32_t level, CubeFace face, const glm::uvec2 &offset, const glm::uvec2 &size,
+                    PixelFormat format, PixelType type, const void *pixels) const;
+
+        void upload(uint32_t level, CubeFace face, const glm::uvec2 &offset, const glm::uvec2 &size,
+                    PixelFormat format, PixelType type, unsigned int unpack_buffer, size_t buffer_offset) const;
+
+        void upload_compressed(uint32_t level, CubeFace face, const glm::uvec2 &offset, const glm::uvec2 &size,
+                               const void *data, size_t bytes) const;
+
+        void upload_compressed(uint32_t level, CubeFace face, const glm::uvec2 &offset, const glm::uvec2 &size,
+                               size_t bytes, unsigned int unpack_buffer, size_t buffer_offset) const;
+    };
+
+} // namespace kat
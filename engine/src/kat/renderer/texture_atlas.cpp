@@ -0,0 +1,204 @@
+#include "texture_atlas.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace kat {
+    namespace {
+        uint32_t round_up(uint32_t value, uint32_t alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        uint32_t cell_alignment(const AtlasOptions &options) {
+            if (options.levels == 0 || options.levels > 16)
+                throw std::runtime_error("atlas level count must be between 1 and 16");
+
+            const uint32_t alignment = 1u << (options.levels - 1);
+            if (options.width % alignment != 0 || options.height % alignment != 0)
+                throw std::runtime_error("atlas size must be a multiple of 2^(levels - 1)");
+            return alignment;
+        }
+
+        // size of the cell holding a width x height image, in texels
+        glm::uvec2 cell_size(uint32_t width, uint32_t height, const AtlasOptions &options, uint32_t alignment) {
+            return { round_up(width + 2 * options.padding, alignment),
+                     round_up(height + 2 * options.padding, alignment) };
+        }
+
+        // RGBA8 cell with the image at (padding, padding) and its edge texels extruded up to the cell border
+        Image make_cell(const Image &image, glm::uvec2 size, uint32_t padding) {
+            if (image.hdr || image.channels == 0 || image.channels > 4)
+                throw std::runtime_error("atlas images must be 8 bit with 1 to 4 channels");
+
+            Image cell;
+            cell.width    = size.x;
+            cell.height   = size.y;
+            cell.channels = 4;
+            cell.pixels.resize(static_cast<size_t>(size.x) * size.y * 4);
+
+            const auto *src = reinterpret_cast<const uint8_t *>(image.pixels.data());
+            auto       *dst = reinterpret_cast<uint8_t *>(cell.pixels.data());
+
+            for (uint32_t y = 0; y < size.y; y++) {
+                const uint32_t sy  = std::min(y - std::min(y, padding), image.height - 1);
+                const uint8_t *row = src + static_cast<size_t>(sy) * image.row_size();
+
+                for (uint32_t x = 0; x < size.x; x++) {
+                    const uint32_t sx = std::min(x - std::min(x, padding), image.width - 1);
+                    const uint8_t *p  = row + static_cast<size_t>(sx) * image.channels;
+                    uint8_t       *d  = dst + (static_cast<size_t>(y) * size.x + x) * 4;
+
+                    switch (image.channels) {
+                    case 1:
+                        d[0] = d[1] = d[2] = p[0];
+                        d[3]               = 255;
+                        break;
+                    case 2:
+                        d[0] = d[1] = d[2] = p[0];
+                        d[3]               = p[1];
+                        break;
+                    case 3:
+                        std::memcpy(d, p, 3);
+                        d[3] = 255;
+                        break;
+                    default:
+                        std::memcpy(d, p, 4);
+                        break;
+                    }
+                }
+            }
+
+            return cell;
+        }
+
+        AtlasRegion make_region(uint32_t id, const PackRect &cell, uint32_t alignment, const Image &image,
+                                const AtlasOptions &options) {
+            const PackRect rect = { cell.x * alignment + options.padding, cell.y * alignment + options.padding,
+                                    image.width, image.height };
+
+            const float w = static_cast<float>(options.width);
+            const float h = static_cast<float>(options.height);
+            return {
+                .id   = id,
+                .rect = rect,
+                .uv   = { static_cast<float>(rect.x) / w, static_cast<float>(rect.y) / h,
+                          static_cast<float>(rect.x + rect.width) / w, static_cast<float>(rect.y + rect.height) / h },
+            };
+        }
+    } // namespace
+
+    TextureAtlas::TextureAtlas(const AtlasOptions &options) :
+        m_options(options), m_alignment(cell_alignment(options)),
+        m_packer(options.width / m_alignment, options.height / m_alignment) {
+        m_texture = Texture2D::create(options.width, options.height,
+                                      options.srgb ? TextureFormat::Srgb8Alpha8 : TextureFormat::Rgba8,
+                                      options.levels);
+        m_texture->set_sampler({
+            .min_filter = options.levels > 1 ? TextureFilter::LinearMipmapLinear : TextureFilter::Linear,
+            .mag_filter = TextureFilter::Linear,
+            .wrap_s     = TextureWrap::ClampToEdge,
+            .wrap_t     = TextureWrap::ClampToEdge,
+            .wrap_r     = TextureWrap::ClampToEdge,
+        });
+    }
+
+    std::shared_ptr<TextureAtlas> TextureAtlas::create(const AtlasOptions &options) {
+        return std::make_shared<TextureAtlas>(options);
+    }
+
+    std::optional<AtlasRegion> TextureAtlas::add(const Image &image) {
+        if (image.width == 0 || image.height == 0)
+            throw std::runtime_error("atlas images can't be empty");
+        if (image.pixels.size() < image.row_size() * image.height)
+            throw std::runtime_error("atlas image has fewer pixels than its size says");
+
+        const glm::uvec2 size = cell_size(image.width, image.height, m_options, m_alignment);
+        const auto       cell = m_packer.insert(size.x / m_alignment, size.y / m_alignment);
+        if (!cell)
+            return std::nullopt;
+
+        const MipOptions mips = {
+            .filter     = m_options.filter,
+            .srgb       = m_options.srgb,
+            .max_levels = m_options.levels,
+        };
+        const std::vector<Image> chain = generate_mip_chain(make_cell(image, size, m_options.padding), mips);
+
+        for (uint32_t level = 0; level < chain.size(); level++) {
+            const Image &mip = chain[level];
+            m_texture->upload(level, { (cell->x * m_alignment) >> level, (cell->y * m_alignment) >> level },
+                              { mip.width, mip.height }, PixelFormat::Rgba, PixelType::UnsignedByte,
+                              mip.pixels.data());
+        }
+
+        uint32_t id;
+        if (!m_free.empty()) {
+            id = m_free.back();
+            m_free.pop_back();
+        }
+        else {
+            id = static_cast<uint32_t>(m_slots.size());
+            m_slots.emplace_back();
+        }
+
+        Slot &slot  = m_slots[id];
+        slot.region = make_region(id, *cell, m_alignment, image, m_options);
+        slot.cell   = *cell;
+        slot.used   = true;
+        return slot.region;
+    }
+
+    void TextureAtlas::remove(uint32_t id) {
+        Slot &slot = m_slots.at(id);
+        if (!slot.used)
+            return;
+
+        m_packer.remove(slot.cell);
+        slot.used = false;
+        m_free.push_back(id);
+    }
+
+    void TextureAtlas::clear() {
+        m_packer.reset();
+        m_slots.clear();
+        m_free.clear();
+    }
+
+    AtlasBuild build_atlas(std::span<const Image> images, const AtlasOptions &options) {
+        const uint32_t alignment = cell_alignment(options);
+
+        std::vector<glm::uvec2> cells(images.size());
+        for (size_t i = 0; i < images.size(); i++) {
+            cells[i] = cell_size(images[i].width, images[i].height, options, alignment) / alignment;
+        }
+
+        const auto placed = pack_rects(cells, options.width / alignment, options.height / alignment);
+
+        AtlasBuild build;
+        build.image.width    = options.width;
+        build.image.height   = options.height;
+        build.image.channels = 4;
+        build.image.pixels.resize(static_cast<size_t>(options.width) * options.height * 4);
+        build.regions.resize(images.size());
+
+        for (size_t i = 0; i < images.size(); i++) {
+            if (!placed[i])
+                continue;
+
+            const glm::uvec2 size = cells[i] * alignment;
+            const Image      cell = make_cell(images[i], size, options.padding);
+            const glm::uvec2 at   = glm::uvec2(placed[i]->x, placed[i]->y) * alignment;
+
+            for (uint32_t y = 0; y < size.y; y++) {
+                std::memcpy(build.image.pixels.data() + ((static_cast<size_t>(at.y) + y) * options.width + at.x) * 4,
+                            cell.pixels.data() + static_cast<size_t>(y) * size.x * 4, static_cast<size_t>(size.x) * 4);
+            }
+
+            build.regions[i] = make_region(static_cast<uint32_t>(i), *placed[i], alignment, images[i], options);
+        }
+
+        return build;
+    }
+
+} // namespace kat
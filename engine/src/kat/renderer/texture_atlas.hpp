@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "kat/assets/image.hpp"
+#include "kat/assets/mipmap.hpp"
+#include "kat/renderer/texture.hpp"
+#include "kat/utils/rect_packer.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    struct AtlasOptions {
+        uint32_t width  = 2048;
+        uint32_t height = 2048;
+
+        // Every image sits in its own cell, aligned to 2^(levels - 1) texels, so a level never mixes neighbouring
+        // cells. More levels waste more space on small images.
+        uint32_t levels = 4;
+
+        // gutter of extruded edge texels around each image, keeps bilinear filtering off the neighbours
+        uint32_t padding = 2;
+
+        bool      srgb   = true;
+        MipFilter filter = MipFilter::Box;
+    };
+
+    struct AtlasRegion {
+        uint32_t  id;
+        PackRect  rect; // image texels in level 0, without the gutter
+        glm::vec4 uv;   // u0, v0, u1, v1
+    };
+
+    // Runtime atlas for sprites, glyphs and UI images that come and go. Images are packed with MaxRects into one
+    // RGBA8 texture; each gets a padded, mip-aligned cell whose mip levels are built on the CPU from that cell alone.
+    // Removing an image returns its cell to the packer.
+    class TextureAtlas {
+      public:
+        explicit TextureAtlas(const AtlasOptions &options = {});
+
+        static std::shared_ptr<TextureAtlas> create(const AtlasOptions &options = {});
+
+        // 8 bit images with 1 to 4 channels: grey, grey + alpha, RGB, RGBA. Returns nullopt when the atlas is full.
+        std::optional<AtlasRegion> add(const Image &image);
+
+        void remove(uint32_t id);
+
+        // drops every image, the texture keeps its stale contents until overwritten
+        void clear();
+
+        [[nodiscard]] const AtlasRegion &get(uint32_t id) const { return m_slots.at(id).region; }
+
+        [[nodiscard]] const std::shared_ptr<Texture2D> &get_texture() const noexcept { return m_texture; }
+
+        [[nodiscard]] const AtlasOptions &get_options() const noexcept { return m_options; }
+
+        [[nodiscard]] size_t get_count() const noexcept { return m_slots.size() - m_free.size(); }
+
+        // fraction of the texture taken by cells, gutters and alignment included
+        [[nodiscard]] float get_occupancy() const noexcept { return m_packer.get_occupancy(); }
+
+      private:
+        struct Slot {
+            AtlasRegion region;
+            PackRect    cell; // in alignment units
+            bool        used = false;
+        };
+
+        AtlasOptions               m_options;
+        uint32_t                   m_alignment;
+        RectPacker                 m_packer;
+        std::shared_ptr<Texture2D> m_texture;
+        std::vector<Slot>          m_slots;
+        std::vector<uint32_t>      m_free;
+    };
+
+    struct AtlasBuild {
+        // RGBA8, level 0 only
+        Image image;
+
+        // in input order, nullopt for images that did not fit; ids are input indices
+        std::vector<std::optional<AtlasRegion>> regions;
+    };
+
+    // Offline packing of a fixed set of images, largest first, with the same cell layout as TextureAtlas. Mips built
+    // from the result with generate_mip_chain (box filter, max_levels = options.levels) stay inside each cell, so the
+    // image can go through compress_mip_chain and save_ktx2 like any other texture; with BC formats keep levels high
+    // enough that cells are multiples of 4 texels.
+    AtlasBuild build_atlas(std::span<const Image> images, const AtlasOptions &options = {});
+
+} // namespace kat
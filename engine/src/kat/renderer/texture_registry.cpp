@@ -0,0 +1,267 @@
+#include "texture_registry.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "shader.hpp"
+
+namespace kat {
+    namespace {
+        // GL_MAX_ARRAY_TEXTURE_LAYERS is at least this everywhere
+        constexpr uint32_t MAX_ARRAY_LAYERS     = 2048;
+        constexpr uint32_t INITIAL_ARRAY_LAYERS = 8;
+
+        bool same_sampler(const SamplerState &a, const SamplerState &b) {
+            return a.min_filter == b.min_filter && a.mag_filter == b.mag_filter && a.wrap_s == b.wrap_s &&
+                   a.wrap_t == b.wrap_t && a.wrap_r == b.wrap_r && a.max_anisotropy == b.max_anisotropy;
+        }
+
+        // same as Texture::set_sampler, mipmapped filters on a single level would leave the texture incomplete
+        SamplerState complete_sampler(SamplerState state, uint32_t levels) {
+            if (levels == 1) {
+                if (state.min_filter == TextureFilter::NearestMipmapNearest ||
+                    state.min_filter == TextureFilter::NearestMipmapLinear)
+                    state.min_filter = TextureFilter::Nearest;
+                else if (state.min_filter != TextureFilter::Nearest)
+                    state.min_filter = TextureFilter::Linear;
+            }
+            return state;
+        }
+
+        void copy_levels(const Texture &source, GLenum source_target, uint32_t source_layer,
+                         const Texture &destination, uint32_t destination_layer, uint32_t layers) {
+            for (uint32_t level = 0; level < source.get_levels(); level++) {
+                const uint32_t width  = std::max(source.get_width() >> level, 1u);
+                const uint32_t height = std::max(source.get_height() >> level, 1u);
+                glCopyImageSubData(source.get_handle(), source_target, static_cast<GLint>(level), 0, 0,
+                                   static_cast<GLint>(source_layer), destination.get_handle(), GL_TEXTURE_2D_ARRAY,
+                                   static_cast<GLint>(level), 0, 0, static_cast<GLint>(destination_layer),
+                                   static_cast<GLsizei>(width), static_cast<GLsizei>(height),
+                                   static_cast<GLsizei>(layers));
+            }
+        }
+    } // namespace
+
+    TextureRegistry::TextureRegistry(const std::shared_ptr<GpuResources> &resources, bool prefer_bindless) :
+        m_bindless(prefer_bindless && GLAD_GL_ARB_bindless_texture), m_resources(resources),
+        m_buffer(resources->create_buffer()) {
+        register_include();
+    }
+
+    TextureRegistry::~TextureRegistry() {
+        for (const auto &entry : m_entries) {
+            if (entry.resident)
+                glMakeTextureHandleNonResidentARB(entry.handle);
+        }
+
+        for (const auto &sampler : m_samplers) {
+            glDeleteSamplers(1, &sampler.sampler);
+        }
+
+        m_resources->destroy(m_buffer);
+    }
+
+    std::shared_ptr<TextureRegistry> TextureRegistry::create(const std::shared_ptr<GpuResources> &resources,
+                                                             bool                                 prefer_bindless) {
+        return std::make_shared<TextureRegistry>(resources, prefer_bindless);
+    }
+
+    uint32_t TextureRegistry::add(const std::shared_ptr<Texture2D> &texture, const SamplerState &sampler) {
+        Entry            entry;
+        const glm::uvec2 value = make_entry(texture, sampler, entry);
+
+        uint32_t index;
+        if (!m_free.empty()) {
+            index = m_free.back();
+            m_free.pop_back();
+            m_entries[index] = std::move(entry);
+            m_table[index]   = value;
+        }
+        else {
+            index = static_cast<uint32_t>(m_entries.size());
+            m_entries.push_back(std::move(entry));
+            m_table.push_back(value);
+        }
+
+        m_dirty = true;
+        return index;
+    }
+
+    void TextureRegistry::remove(uint32_t index) {
+        release_entry(m_entries.at(index));
+
+        m_table[index] = { 0, 0 };
+        m_free.push_back(index);
+        m_dirty = true;
+    }
+
+    void TextureRegistry::replace(uint32_t index, const std::shared_ptr<Texture2D> &texture,
+                                  const SamplerState &sampler) {
+        Entry &entry = m_entries.at(index);
+        release_entry(entry);
+
+        m_table[index] = make_entry(texture, sampler, entry);
+        m_dirty        = true;
+    }
+
+    glm::uvec2 TextureRegistry::make_entry(const std::shared_ptr<Texture2D> &texture, const SamplerState &sampler,
+                                           Entry &entry) {
+        const SamplerState state = complete_sampler(sampler, texture->get_levels());
+
+        if (m_bindless) {
+            entry.texture  = texture;
+            entry.handle   = glGetTextureSamplerHandleARB(texture->get_handle(), sampler_object(state));
+            entry.resident = true;
+            glMakeTextureHandleResidentARB(entry.handle);
+            return { static_cast<uint32_t>(entry.handle), static_cast<uint32_t>(entry.handle >> 32) };
+        }
+
+        const glm::uvec2 slot = allocate_layer(*texture, state);
+        entry.array           = slot.x;
+        entry.layer           = slot.y;
+        copy_levels(*texture, GL_TEXTURE_2D, 0, *m_arrays[entry.array].texture, entry.layer, 1);
+        return slot;
+    }
+
+    void TextureRegistry::release_entry(Entry &entry) {
+        if (m_bindless) {
+            if (entry.resident)
+                glMakeTextureHandleNonResidentARB(entry.handle);
+        }
+        else {
+            m_arrays[entry.array].free_layers.push_back(entry.layer);
+        }
+
+        entry = {};
+    }
+
+    void TextureRegistry::set_resident(uint32_t index, bool resident) {
+        Entry &entry = m_entries.at(index);
+        if (!m_bindless || !entry.texture || entry.resident == resident)
+            return;
+
+        if (resident)
+            glMakeTextureHandleResidentARB(entry.handle);
+        else
+            glMakeTextureHandleNonResidentARB(entry.handle);
+        entry.resident = resident;
+    }
+
+    bool TextureRegistry::is_resident(uint32_t index) const {
+        // array layers are always there
+        return !m_bindless || m_entries.at(index).resident;
+    }
+
+    void TextureRegistry::update() {
+        if (!m_dirty)
+            return;
+
+        // an empty storage buffer can't be bound, keep one unused entry around
+        Buffer &buffer = m_resources->get(m_buffer);
+        if (m_table.empty())
+            buffer.set(std::vector<glm::uvec2>{ { 0, 0 } }, BufferUsage::DynamicDraw);
+        else
+            buffer.set(m_table, BufferUsage::DynamicDraw);
+        m_dirty = false;
+    }
+
+    void TextureRegistry::bind() const {
+        m_resources->get(m_buffer).bind_base(BufferTarget::ShaderStorage, TEXTURE_TABLE_BINDING);
+
+        for (size_t i = 0; i < m_arrays.size(); i++) {
+            m_arrays[i].texture->bind(TEXTURE_ARRAY_FIRST_UNIT + static_cast<unsigned int>(i));
+        }
+    }
+
+    unsigned int TextureRegistry::sampler_object(const SamplerState &state) {
+        for (const auto &sampler : m_samplers) {
+            if (same_sampler(sampler.state, state))
+                return sampler.sampler;
+        }
+
+        unsigned int sampler;
+        glCreateSamplers(1, &sampler);
+        glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(state.min_filter));
+        glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(state.mag_filter));
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, static_cast<GLint>(state.wrap_s));
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, static_cast<GLint>(state.wrap_t));
+        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_R, static_cast<GLint>(state.wrap_r));
+        glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY, std::max(state.max_anisotropy, 1.0f));
+
+        m_samplers.push_back({ state, sampler });
+        return sampler;
+    }
+
+    glm::uvec2 TextureRegistry::allocate_layer(const Texture2D &texture, const SamplerState &sampler) {
+        for (uint32_t i = 0; i < m_arrays.size(); i++) {
+            Array                &array = m_arrays[i];
+            const Texture2DArray &t     = *array.texture;
+            if (t.get_width() != texture.get_width() || t.get_height() != texture.get_height() ||
+                t.get_format() != texture.get_format() || t.get_levels() != texture.get_levels() ||
+                !same_sampler(array.sampler, sampler))
+                continue;
+
+            if (!array.free_layers.empty()) {
+                const uint32_t layer = array.free_layers.back();
+                array.free_layers.pop_back();
+                return { i, layer };
+            }
+
+            if (array.used == t.get_layers()) {
+                if (t.get_layers() >= MAX_ARRAY_LAYERS)
+                    continue;
+
+                // grow by doubling, the old layers move over on the GPU
+                auto grown = Texture2DArray::create(t.get_width(), t.get_height(),
+                                                    std::min(t.get_layers() * 2, MAX_ARRAY_LAYERS), t.get_format(),
+                                                    t.get_levels());
+                grown->set_sampler(sampler);
+                copy_levels(t, GL_TEXTURE_2D_ARRAY, 0, *grown, 0, array.used);
+                array.texture = std::move(grown);
+            }
+
+            return { i, array.used++ };
+        }
+
+        if (m_arrays.size() >= MAX_TEXTURE_ARRAYS)
+            throw std::runtime_error("Texture registry ran out of texture arrays, too many distinct texture shapes");
+
+        Array array;
+        array.texture = Texture2DArray::create(texture.get_width(), texture.get_height(), INITIAL_ARRAY_LAYERS,
+                                               texture.get_format(), texture.get_levels());
+        array.sampler = sampler;
+        array.used    = 1;
+        array.texture->set_sampler(sampler);
+        m_arrays.push_back(std::move(array));
+
+        return { static_cast<uint32_t>(m_arrays.size() - 1), 0 };
+    }
+
+    void TextureRegistry::register_include() const {
+        const std::string table = "layout(std430, binding = " + std::to_string(TEXTURE_TABLE_BINDING) +
+                                  ") readonly buffer KatTextureTable {\n"
+                                  "    uvec2 kat_textures[];\n"
+                                  "};\n"
+                                  "const uint KAT_NO_TEXTURE = 0xFFFFFFFFu;\n";
+
+        if (m_bindless) {
+            ShaderModule::register_include("kat/textures.glsl",
+                                           "#extension GL_ARB_bindless_texture : require\n" + table +
+                                               "vec4 kat_sample(uint index, vec2 uv) {\n"
+                                               "    return texture(sampler2D(kat_textures[index]), uv);\n"
+                                               "}\n");
+        }
+        else {
+            ShaderModule::register_include(
+                "kat/textures.glsl",
+                table + "layout(binding = " + std::to_string(TEXTURE_ARRAY_FIRST_UNIT) +
+                    ") uniform sampler2DArray kat_texture_arrays[" + std::to_string(MAX_TEXTURE_ARRAYS) + "];\n" +
+                    "vec4 kat_sample(uint index, vec2 uv) {\n"
+                    "    uvec2 entry = kat_textures[index];\n"
+                    "    return texture(kat_texture_arrays[entry.x], vec3(uv, float(entry.y)));\n"
+                    "}\n");
+        }
+    }
+
+} // namespace kat
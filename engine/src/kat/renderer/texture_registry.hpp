@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "gpu_resources.hpp"
+#include "texture.hpp"
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    // shader storage binding of the texture table, see the "kat/textures.glsl" include
+    constexpr unsigned int TEXTURE_TABLE_BINDING = 8;
+
+    // fallback path: texture arrays are bound to units FIRST .. FIRST + MAX - 1
+    constexpr unsigned int TEXTURE_ARRAY_FIRST_UNIT = 16;
+    constexpr unsigned int MAX_TEXTURE_ARRAYS       = 16;
+
+    constexpr uint32_t NO_TEXTURE = 0xFFFFFFFF;
+
+    // Gives 2D textures a stable index that shaders resolve through one shader storage buffer, so draws that use
+    // different textures need no binds in between and can share a multi-draw call.
+    //
+    // With GL_ARB_bindless_texture every entry is a resident texture/sampler handle. Without it, textures are copied
+    // into shared texture arrays (one per size, format, level count and sampler) and an entry is an (array, layer)
+    // pair. Shaders include "kat/textures.glsl" right after #version and call kat_sample(index, uv); the index must be
+    // the same for the whole draw (e.g. from a material), the fallback indexes a sampler array with it.
+    class TextureRegistry {
+      public:
+        explicit TextureRegistry(const std::shared_ptr<GpuResources> &resources, bool prefer_bindless = true);
+
+        ~TextureRegistry();
+
+        TextureRegistry(const TextureRegistry &)            = delete;
+        TextureRegistry &operator=(const TextureRegistry &) = delete;
+
+        static std::shared_ptr<TextureRegistry> create(const std::shared_ptr<GpuResources> &resources,
+                                                       bool                                 prefer_bindless = true);
+
+        // Bindless handles keep the texture alive until it is removed. The fallback copies the contents right away,
+        // later uploads to `texture` are not seen.
+        uint32_t add(const std::shared_ptr<Texture2D> &texture, const SamplerState &sampler = {});
+
+        void remove(uint32_t index);
+
+        // Points an existing index at another texture (e.g. after the streamer reallocated it), shaders keep using
+        // the same index.
+        void replace(uint32_t index, const std::shared_ptr<Texture2D> &texture, const SamplerState &sampler = {});
+
+        // Bindless only: non-resident handles must not be sampled, but free up residency for textures that are not
+        // drawn for a while. Everything is resident after add().
+        void set_resident(uint32_t index, bool resident);
+
+        [[nodiscard]] bool is_resident(uint32_t index) const;
+
+        // Uploads the table if it changed. Call before drawing, then bind().
+        void update();
+
+        void bind() const;
+
+        [[nodiscard]] bool is_bindless() const noexcept { return m_bindless; }
+
+        [[nodiscard]] size_t get_count() const noexcept { return m_entries.size() - m_free.size(); }
+
+      private:
+        struct Entry {
+            std::shared_ptr<Texture2D> texture;
+            uint64_t                   handle   = 0;
+            bool                       resident = false;
+            uint32_t                   array    = 0;
+            uint32_t                   layer    = 0;
+        };
+
+        struct Sampler {
+            SamplerState state;
+            unsigned int sampler;
+        };
+
+        struct Array {
+            std::shared_ptr<Texture2DArray> texture;
+            SamplerState                    sampler;
+            uint32_t                        used = 0;
+            std::vector<uint32_t>           free_layers;
+        };
+
+        unsigned int sampler_object(const SamplerState &state);
+
+        // fills a fresh entry for texture and returns its table value
+        glm::uvec2 make_entry(const std::shared_ptr<Texture2D> &texture, const SamplerState &sampler, Entry &entry);
+
+        void release_entry(Entry &entry);
+
+        // returns {array, layer} for a texture of this shape, growing or creating an array as needed
+        glm::uvec2 allocate_layer(const Texture2D &texture, const SamplerState &sampler);
+
+        void register_include() const;
+
+        bool m_bindless;
+
+        std::vector<Entry>      m_entries;
+        std::vector<uint32_t>   m_free;
+        std::vector<Sampler>    m_samplers;
+        std::vector<Array>      m_arrays;
+        std::vector<glm::uvec2> m_table;
+
+        std::shared_ptr<GpuResources> m_resources;
+        Handle<Buffer>                m_buffer;
+        bool                          m_dirty = true;
+    };
+
+} // namespace kat
@@ -1,5 +1,7 @@
 #include "vertex_array.hpp"
 
+#include "destruction_queue.hpp"
+
 namespace kat {
 
     VertexArray::VertexArray() {
@@ -7,15 +9,15 @@ namespace kat {
     }
 
     VertexArray::~VertexArray() {
-        glDeleteVertexArrays(1, &m_vertex_array);
+        DestructionQueue::get().enqueue(GpuObjectType::VertexArray, m_vertex_array);
     }
 
     void VertexArray::bind() const {
         glBindVertexArray(m_vertex_array);
     }
 
-    void VertexArray::vertex_buffer(const std::shared_ptr<Buffer> &buffer, const std::vector<size_t> &sizes) {
-        buffer->bind(BufferTarget::Vertex);
+    void VertexArray::vertex_buffer(const Buffer &buffer, const std::vector<size_t> &sizes) {
+        buffer.bind(BufferTarget::Vertex);
         size_t stride = 0;
 
         const unsigned int binding = m_next_binding++;
@@ -30,12 +32,12 @@ namespace kat {
             stride += size * sizeof(float);
         }
 
-        glVertexArrayVertexBuffer(m_vertex_array, binding, buffer->get_handle(), 0, stride);
+        glVertexArrayVertexBuffer(m_vertex_array, binding, buffer.get_handle(), 0, stride);
     }
 
-    void VertexArray::vertex_buffer(const std::shared_ptr<Buffer>      &buffer,
-                                    const std::vector<VertexAttribute> &attributes, size_t stride, size_t offset) {
-        buffer->bind(BufferTarget::Vertex);
+    void VertexArray::vertex_buffer(const Buffer &buffer, const std::vector<VertexAttribute> &attributes, size_t stride,
+                                    size_t offset) {
+        buffer.bind(BufferTarget::Vertex);
 
         const unsigned int binding = m_next_binding++;
 
@@ -47,11 +49,44 @@ namespace kat {
             glEnableVertexArrayAttrib(m_vertex_array, attribute);
         }
 
-        glVertexArrayVertexBuffer(m_vertex_array, binding, buffer->get_handle(), offset, stride);
+        glVertexArrayVertexBuffer(m_vertex_array, binding, buffer.get_handle(), offset, stride);
+    }
+
+    void VertexArray::vertex_buffer(const std::shared_ptr<Buffer> &buffer, const std::vector<size_t> &sizes) {
+        vertex_buffer(*buffer, sizes);
+    }
+
+    void VertexArray::vertex_buffer(const std::shared_ptr<Buffer>      &buffer,
+                                    const std::vector<VertexAttribute> &attributes, size_t stride, size_t offset) {
+        vertex_buffer(*buffer, attributes, stride, offset);
+    }
+
+    unsigned int VertexArray::instance_binding(const std::vector<VertexAttribute> &attributes, unsigned int divisor) {
+        const unsigned int binding = m_next_binding++;
+
+        for (const auto &a : attributes) {
+            const unsigned int attribute = m_next_attribute++;
+
+            glVertexArrayAttribFormat(m_vertex_array, attribute, static_cast<GLint>(a.size), GL_FLOAT, false,
+                                      static_cast<GLuint>(a.offset));
+            glVertexArrayAttribBinding(m_vertex_array, attribute, binding);
+            glEnableVertexArrayAttrib(m_vertex_array, attribute);
+        }
+
+        glVertexArrayBindingDivisor(m_vertex_array, binding, divisor);
+        return binding;
+    }
+
+    void VertexArray::set_vertex_buffer(unsigned int binding, unsigned int buffer, size_t offset, size_t stride) {
+        glVertexArrayVertexBuffer(m_vertex_array, binding, buffer, static_cast<GLintptr>(offset),
+                                  static_cast<GLsizei>(stride));
+    }
 
+    void VertexArray::element_buffer(const Buffer &buffer) {
+        glVertexArrayElementBuffer(m_vertex_array, buffer.get_handle());
     }
 
     void VertexArray::element_buffer(const std::shared_ptr<Buffer> &buffer) {
-        glVertexArrayElementBuffer(m_vertex_array, buffer->get_handle());
+        element_buffer(*buffer);
     }
 } // kat
\ No newline at end of file
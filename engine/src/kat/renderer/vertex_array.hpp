@@ -9,6 +9,8 @@ namespace kat {
     struct VertexAttribute {
         size_t size;
         size_t offset;
+
+        friend bool operator==(const VertexAttribute &lhs, const VertexAttribute &rhs) = default;
     };
 
     class VertexArray {
@@ -17,11 +19,26 @@ namespace kat {
 
         ~VertexArray();
 
+        VertexArray(const VertexArray &)            = delete;
+        VertexArray &operator=(const VertexArray &) = delete;
+
         void bind() const;
 
+        void vertex_buffer(const Buffer &buffer, const std::vector<size_t> &sizes);
+        void vertex_buffer(const Buffer &buffer, const std::vector<VertexAttribute> &attributes, size_t stride,
+                           size_t offset = 0);
+
         void vertex_buffer(const std::shared_ptr<Buffer>& buffer, const std::vector<size_t>& sizes);
         void vertex_buffer(const std::shared_ptr<Buffer>& buffer, const std::vector<VertexAttribute>& attributes, size_t stride, size_t offset = 0);
 
+        // Attributes that advance once every `divisor` instances instead of every vertex, taking the next attribute
+        // locations. The buffer is set later with set_vertex_buffer, returns the binding for it.
+        unsigned int instance_binding(const std::vector<VertexAttribute> &attributes, unsigned int divisor = 1);
+
+        // points a binding at another buffer or offset, e.g. this frame's range of a stream buffer
+        void set_vertex_buffer(unsigned int binding, unsigned int buffer, size_t offset, size_t stride);
+
+        void element_buffer(const Buffer &buffer);
         void element_buffer(const std::shared_ptr<Buffer>& buffer);
       private:
 
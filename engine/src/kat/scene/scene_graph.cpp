@@ -0,0 +1,310 @@
+#include "scene_graph.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace kat {
+    namespace {
+        constexpr size_t UPDATE_GRAIN = 4096;
+
+        // values[i] = old values[from[i]]
+        template <typename T>
+        void gather(std::vector<T> &values, const std::vector<uint32_t> &from) {
+            std::vector<T> sorted(from.size());
+            for (size_t i = 0; i < from.size(); i++) {
+                sorted[i] = values[from[i]];
+            }
+            values.swap(sorted);
+        }
+
+        template <typename T>
+        void swap_remove(std::vector<T> &values, uint32_t slot) {
+            values[slot] = values.back();
+            values.pop_back();
+        }
+    } // namespace
+
+    SceneGraph::SceneGraph(const std::shared_ptr<JobSystem> &job_system) : m_job_system(job_system), m_levels{ 0 } {}
+
+    std::shared_ptr<SceneGraph> SceneGraph::create(const std::shared_ptr<JobSystem> &job_system) {
+        return std::make_shared<SceneGraph>(job_system);
+    }
+
+    NodeId SceneGraph::create_node(NodeId parent, const Transform &local) {
+        const uint32_t parent_slot = parent == NO_NODE ? NO_NODE : slot_of(parent);
+
+        NodeId node;
+        if (!m_free.empty()) {
+            node = m_free.back();
+            m_free.pop_back();
+        } else {
+            node = static_cast<NodeId>(m_slots.size());
+            m_slots.push_back(NO_NODE);
+            m_parent_ids.push_back(NO_NODE);
+            m_first_child.push_back(NO_NODE);
+            m_next_sibling.push_back(NO_NODE);
+            m_previous_sibling.push_back(NO_NODE);
+        }
+
+        const uint32_t slot = static_cast<uint32_t>(m_ids.size());
+        m_slots[node]       = slot;
+        m_ids.push_back(node);
+        m_translation.push_back(local.translation);
+        m_rotation.push_back(local.rotation);
+        m_scale.push_back(local.scale);
+        m_world.emplace_back(1.0f);
+        m_parent.push_back(parent_slot);
+        m_flags.push_back(0);
+
+        link(node, parent);
+        mark_dirty(slot);
+
+        // appending keeps the order as long as the node lands in the deepest level or starts a new one below it
+        if (m_sorted) {
+            const size_t levels = m_levels.size() - 1;
+            const size_t depth =
+                parent == NO_NODE ? 0 : std::ranges::upper_bound(m_levels, parent_slot) - m_levels.begin();
+            if (depth + 1 == levels)
+                m_levels.back()++;
+            else if (depth == levels)
+                m_levels.push_back(m_levels.back() + 1);
+            else
+                m_sorted = false;
+        }
+
+        return node;
+    }
+
+    void SceneGraph::destroy_node(NodeId node) {
+        slot_of(node);
+        unlink(node);
+
+        std::vector<NodeId> stack = { node };
+        while (!stack.empty()) {
+            const NodeId current = stack.back();
+            stack.pop_back();
+
+            for (NodeId child = m_first_child[current]; child != NO_NODE; child = m_next_sibling[child]) {
+                stack.push_back(child);
+            }
+
+            remove_slot(m_slots[current]);
+            m_slots[current]            = NO_NODE;
+            m_parent_ids[current]       = NO_NODE;
+            m_first_child[current]      = NO_NODE;
+            m_next_sibling[current]     = NO_NODE;
+            m_previous_sibling[current] = NO_NODE;
+            m_free.push_back(current);
+        }
+
+        m_sorted = false;
+    }
+
+    void SceneGraph::set_parent(NodeId node, NodeId parent) {
+        const uint32_t slot = slot_of(node);
+        if (parent != NO_NODE)
+            slot_of(parent);
+
+        for (NodeId ancestor = parent; ancestor != NO_NODE; ancestor = m_parent_ids[ancestor]) {
+            if (ancestor == node)
+                throw std::runtime_error("Scene node cannot be parented to itself or its descendants");
+        }
+
+        if (m_parent_ids[node] == parent)
+            return;
+
+        unlink(node);
+        link(node, parent);
+        mark_dirty(slot);
+        m_sorted = false;
+    }
+
+    void SceneGraph::set_local(NodeId node, const Transform &local) {
+        const uint32_t slot = slot_of(node);
+        m_translation[slot] = local.translation;
+        m_rotation[slot]    = local.rotation;
+        m_scale[slot]       = local.scale;
+        mark_dirty(slot);
+    }
+
+    void SceneGraph::set_translation(NodeId node, const glm::vec3 &translation) {
+        const uint32_t slot = slot_of(node);
+        m_translation[slot] = translation;
+        mark_dirty(slot);
+    }
+
+    void SceneGraph::set_rotation(NodeId node, const glm::quat &rotation) {
+        const uint32_t slot = slot_of(node);
+        m_rotation[slot]    = rotation;
+        mark_dirty(slot);
+    }
+
+    void SceneGraph::set_scale(NodeId node, const glm::vec3 &scale) {
+        const uint32_t slot = slot_of(node);
+        m_scale[slot]       = scale;
+        mark_dirty(slot);
+    }
+
+    void SceneGraph::update() {
+        if (!m_sorted)
+            sort();
+
+        const uint32_t count = static_cast<uint32_t>(m_ids.size());
+        const uint32_t first = std::min(m_first_dirty, count);
+
+        // no node before the first dirty one changes, only the flags of the last update need clearing there
+        if (m_first_changed < first)
+            std::fill(m_flags.begin() + m_first_changed, m_flags.begin() + first, uint8_t{ 0 });
+
+        for (size_t level = 0; level + 1 < m_levels.size(); level++) {
+            const uint32_t begin = std::max(m_levels[level], first);
+            const uint32_t end   = m_levels[level + 1];
+            if (begin >= end)
+                continue;
+
+            if (m_job_system) {
+                m_job_system->parallel_for(end - begin, UPDATE_GRAIN, [&](size_t b, size_t e) {
+                    update_range(begin + static_cast<uint32_t>(b), begin + static_cast<uint32_t>(e));
+                });
+            } else {
+                update_range(begin, end);
+            }
+        }
+
+        m_first_changed = first;
+        m_first_dirty   = NO_NODE;
+    }
+
+    Transform SceneGraph::get_local(NodeId node) const {
+        const uint32_t slot = slot_of(node);
+        return { .rotation = m_rotation[slot], .translation = m_translation[slot], .scale = m_scale[slot] };
+    }
+
+    NodeId SceneGraph::get_parent(NodeId node) const {
+        slot_of(node);
+        return m_parent_ids[node];
+    }
+
+    uint32_t SceneGraph::slot_of(NodeId node) const {
+        if (!contains(node))
+            throw std::runtime_error("Invalid scene node");
+        return m_slots[node];
+    }
+
+    void SceneGraph::mark_dirty(uint32_t slot) {
+        m_flags[slot] |= DIRTY;
+        m_first_dirty  = std::min(m_first_dirty, slot);
+    }
+
+    void SceneGraph::link(NodeId node, NodeId parent) {
+        m_parent_ids[node] = parent;
+        if (parent == NO_NODE)
+            return;
+
+        const NodeId next        = m_first_child[parent];
+        m_next_sibling[node]     = next;
+        m_previous_sibling[node] = NO_NODE;
+        if (next != NO_NODE)
+            m_previous_sibling[next] = node;
+        m_first_child[parent] = node;
+    }
+
+    void SceneGraph::unlink(NodeId node) {
+        const NodeId parent = m_parent_ids[node];
+        if (parent == NO_NODE)
+            return;
+
+        const NodeId previous = m_previous_sibling[node];
+        const NodeId next     = m_next_sibling[node];
+        if (previous != NO_NODE)
+            m_next_sibling[previous] = next;
+        else
+            m_first_child[parent] = next;
+        if (next != NO_NODE)
+            m_previous_sibling[next] = previous;
+
+        m_parent_ids[node]       = NO_NODE;
+        m_next_sibling[node]     = NO_NODE;
+        m_previous_sibling[node] = NO_NODE;
+    }
+
+    void SceneGraph::remove_slot(uint32_t slot) {
+        // the order is restored by the next sort, so the last node can simply move into the hole
+        swap_remove(m_translation, slot);
+        swap_remove(m_rotation, slot);
+        swap_remove(m_scale, slot);
+        swap_remove(m_world, slot);
+        swap_remove(m_parent, slot);
+        swap_remove(m_flags, slot);
+        swap_remove(m_ids, slot);
+
+        if (slot < m_ids.size())
+            m_slots[m_ids[slot]] = slot;
+    }
+
+    void SceneGraph::sort() {
+        std::vector<NodeId> order;
+        order.reserve(m_ids.size());
+        for (const NodeId node : m_ids) {
+            if (m_parent_ids[node] == NO_NODE)
+                order.push_back(node);
+        }
+
+        // breadth first, one level at a time
+        m_levels.assign(1, 0);
+        for (size_t begin = 0; begin < order.size();) {
+            const size_t end = order.size();
+            m_levels.push_back(static_cast<uint32_t>(end));
+
+            for (size_t i = begin; i < end; i++) {
+                for (NodeId child = m_first_child[order[i]]; child != NO_NODE; child = m_next_sibling[child]) {
+                    order.push_back(child);
+                }
+            }
+            begin = end;
+        }
+
+        std::vector<uint32_t> from(order.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            from[i] = m_slots[order[i]];
+        }
+
+        gather(m_translation, from);
+        gather(m_rotation, from);
+        gather(m_scale, from);
+        gather(m_world, from);
+        gather(m_flags, from);
+
+        // parents come first, so their new slot is already known
+        m_first_dirty = NO_NODE;
+        for (uint32_t slot = 0; slot < order.size(); slot++) {
+            const NodeId node   = order[slot];
+            const NodeId parent = m_parent_ids[node];
+
+            m_slots[node]  = slot;
+            m_parent[slot] = parent == NO_NODE ? NO_NODE : m_slots[parent];
+            m_flags[slot] &= DIRTY;
+            if (m_flags[slot] & DIRTY)
+                m_first_dirty = std::min(m_first_dirty, slot);
+        }
+
+        m_ids           = std::move(order);
+        m_first_changed = NO_NODE;
+        m_sorted        = true;
+    }
+
+    void SceneGraph::update_range(uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            const uint32_t parent = m_parent[i];
+            if (!(m_flags[i] & DIRTY) && (parent == NO_NODE || !(m_flags[parent] & CHANGED))) {
+                m_flags[i] = 0;
+                continue;
+            }
+
+            const glm::mat4 local = compose_transform(m_translation[i], m_rotation[i], m_scale[i]);
+            m_world[i]            = parent == NO_NODE ? local : m_world[parent] * local;
+            m_flags[i]            = CHANGED;
+        }
+    }
+
+} // namespace kat
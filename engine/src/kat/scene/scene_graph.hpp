@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "kat/utils/job_system.hpp"
+#include "kat/utils/transform.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace kat {
+
+    using NodeId = uint32_t;
+
+    constexpr NodeId NO_NODE = std::numeric_limits<NodeId>::max();
+
+    // A transform hierarchy stored as structure of arrays: local translations, rotations, scales and world matrices
+    // each in their own array, sorted breadth first so every parent comes before its children and each depth is one
+    // contiguous range. update() is then a linear pass that only recomputes nodes whose local transform changed or
+    // whose parent moved; the nodes of one depth never depend on each other and are split across the job system.
+    class SceneGraph {
+      public:
+        explicit SceneGraph(const std::shared_ptr<JobSystem> &job_system = nullptr);
+
+        static std::shared_ptr<SceneGraph> create(const std::shared_ptr<JobSystem> &job_system = nullptr);
+
+        NodeId create_node(NodeId parent = NO_NODE, const Transform &local = {});
+
+        // destroys the node and all of its descendants
+        void destroy_node(NodeId node);
+
+        // The node keeps its local transform, so it moves along with the new parent. Throws if `parent` is the node
+        // itself or one of its descendants.
+        void set_parent(NodeId node, NodeId parent);
+
+        void set_local(NodeId node, const Transform &local);
+
+        void set_translation(NodeId node, const glm::vec3 &translation);
+
+        void set_rotation(NodeId node, const glm::quat &rotation);
+
+        void set_scale(NodeId node, const glm::vec3 &scale);
+
+        // Brings the world matrices up to date. Structural changes since the last call re-sort the nodes first.
+        void update();
+
+        [[nodiscard]] Transform get_local(NodeId node) const;
+
+        // as of the last update()
+        [[nodiscard]] const glm::mat4 &get_world(NodeId node) const { return m_world[slot_of(node)]; }
+
+        // NO_NODE for roots
+        [[nodiscard]] NodeId get_parent(NodeId node) const;
+
+        // whether the last update() changed the node's world matrix
+        [[nodiscard]] bool is_changed(NodeId node) const { return m_flags[slot_of(node)] & CHANGED; }
+
+        [[nodiscard]] bool contains(NodeId node) const noexcept {
+            return node < m_slots.size() && m_slots[node] != NO_NODE;
+        }
+
+        // World matrices in storage order, get_ids() has the node of each. Both are reordered by update() after
+        // structural changes.
+        [[nodiscard]] std::span<const glm::mat4> get_world_matrices() const noexcept { return m_world; }
+
+        [[nodiscard]] std::span<const NodeId> get_ids() const noexcept { return m_ids; }
+
+        [[nodiscard]] size_t get_count() const noexcept { return m_ids.size(); }
+
+      private:
+        enum Flags : uint8_t {
+            DIRTY   = 1, // local transform set since the last update
+            CHANGED = 2, // world matrix recomputed by the last update
+        };
+
+        // throws for destroyed or unknown nodes
+        uint32_t slot_of(NodeId node) const;
+
+        void mark_dirty(uint32_t slot);
+
+        void link(NodeId node, NodeId parent);
+
+        void unlink(NodeId node);
+
+        void remove_slot(uint32_t slot);
+
+        // breadth first from the roots, rebuilds the parent slots and depth ranges
+        void sort();
+
+        void update_range(uint32_t begin, uint32_t end);
+
+        std::shared_ptr<JobSystem> m_job_system;
+
+        // by slot
+        std::vector<glm::vec3> m_translation;
+        std::vector<glm::quat> m_rotation;
+        std::vector<glm::vec3> m_scale;
+        std::vector<glm::mat4> m_world;
+        std::vector<uint32_t>  m_parent; // slot of the parent, NO_NODE for roots
+        std::vector<uint8_t>   m_flags;
+        std::vector<NodeId>    m_ids;
+
+        // by id
+        std::vector<uint32_t> m_slots;
+        std::vector<NodeId>   m_parent_ids;
+        std::vector<NodeId>   m_first_child;
+        std::vector<NodeId>   m_next_sibling;
+        std::vector<NodeId>   m_previous_sibling;
+        std::vector<NodeId>   m_free;
+
+        std::vector<uint32_t> m_levels;                  // first slot of every depth, then the count
+        bool                  m_sorted        = true;
+        uint32_t              m_first_dirty   = NO_NODE; // lowest dirty slot, nothing before it needs work
+        uint32_t              m_first_changed = NO_NODE; // lowest slot the last update may have flagged
+    };
+
+} // namespace kat
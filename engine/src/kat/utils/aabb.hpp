@@ -0,0 +1,73 @@
+#pragma once
+#include <algorithm>
+#include <limits>
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    // Axis aligned bounding box. Default constructed boxes are empty (min > max) and merge as the identity.
+    struct Aabb {
+        glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+        [[nodiscard]] bool empty() const noexcept { return min.x > max.x || min.y > max.y || min.z > max.z; }
+
+        [[nodiscard]] glm::vec3 center() const noexcept { return (min + max) * 0.5f; }
+
+        [[nodiscard]] glm::vec3 extents() const noexcept { return (max - min) * 0.5f; }
+
+        // half the surface area, all SAH costs need is the ratio
+        [[nodiscard]] float half_area() const noexcept {
+            const glm::vec3 d = max - min;
+            return d.x * d.y + d.y * d.z + d.z * d.x;
+        }
+
+        // Component wise on purpose: in tight loops that update the same few boxes (SAH bins), whole vector
+        // temporaries stall on store forwarding.
+        void merge(const Aabb &other) noexcept {
+            min.x = std::min(min.x, other.min.x);
+            min.y = std::min(min.y, other.min.y);
+            min.z = std::min(min.z, other.min.z);
+            max.x = std::max(max.x, other.max.x);
+            max.y = std::max(max.y, other.max.y);
+            max.z = std::max(max.z, other.max.z);
+        }
+
+        void expand(const glm::vec3 &point) noexcept {
+            min.x = std::min(min.x, point.x);
+            min.y = std::min(min.y, point.y);
+            min.z = std::min(min.z, point.z);
+            max.x = std::max(max.x, point.x);
+            max.y = std::max(max.y, point.y);
+            max.z = std::max(max.z, point.z);
+        }
+
+        [[nodiscard]] Aabb merged(const Aabb &other) const noexcept {
+            Aabb result = *this;
+            result.merge(other);
+            return result;
+        }
+
+        [[nodiscard]] bool overlaps(const Aabb &other) const noexcept {
+            return min.x <= other.max.x && max.x >= other.min.x && min.y <= other.max.y && max.y >= other.min.y &&
+                   min.z <= other.max.z && max.z >= other.min.z;
+        }
+
+        [[nodiscard]] bool contains(const Aabb &other) const noexcept {
+            return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z && max.x >= other.max.x &&
+                   max.y >= other.max.y && max.z >= other.max.z;
+        }
+
+        // bounds of the transformed box, e.g. a mesh's bounds in world space
+        [[nodiscard]] Aabb transformed(const glm::mat4 &m) const noexcept {
+            const glm::vec3 c = glm::vec3(m * glm::vec4(center(), 1.0f));
+            const glm::vec3 e = extents();
+
+            const glm::vec3 r = glm::abs(glm::vec3(m[0])) * e.x + glm::abs(glm::vec3(m[1])) * e.y +
+                                glm::abs(glm::vec3(m[2])) * e.z;
+            return { c - r, c + r };
+        }
+    };
+
+} // namespace kat
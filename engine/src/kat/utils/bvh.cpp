@@ -0,0 +1,568 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace kat {
+    namespace {
+        constexpr size_t SAH_BINS = 16;
+
+        enum class Containment { Outside, Intersects, Inside };
+
+        Containment classify(const Frustum &frustum, const glm::vec3 &min, const glm::vec3 &max) {
+            Containment result = Containment::Inside;
+            for (const auto &plane : frustum.planes) {
+                // corners furthest along and against the plane normal
+                const glm::vec3 p = { plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y,
+                                      plane.z >= 0.0f ? max.z : min.z };
+                const glm::vec3 n = { plane.x >= 0.0f ? min.x : max.x, plane.y >= 0.0f ? min.y : max.y,
+                                      plane.z >= 0.0f ? min.z : max.z };
+
+                if (glm::dot(glm::vec3(plane), p) + plane.w < 0.0f)
+                    return Containment::Outside;
+                if (glm::dot(glm::vec3(plane), n) + plane.w < 0.0f)
+                    result = Containment::Intersects;
+            }
+            return result;
+        }
+
+        // entry distance of the ray into the box, or a value above `limit` when it misses
+        float intersect(const glm::vec3 &min, const glm::vec3 &max, const glm::vec3 &origin,
+                        const glm::vec3 &inverse_direction, float limit) {
+            const glm::vec3 t0 = (min - origin) * inverse_direction;
+            const glm::vec3 t1 = (max - origin) * inverse_direction;
+
+            const glm::vec3 near = glm::min(t0, t1);
+            const glm::vec3 far  = glm::max(t0, t1);
+
+            const float enter = std::max(std::max(near.x, near.y), std::max(near.z, 0.0f));
+            const float exit  = std::min(std::min(far.x, far.y), std::min(far.z, limit));
+            return enter <= exit ? enter : std::numeric_limits<float>::infinity();
+        }
+    } // namespace
+
+    Bvh::Bvh(float margin) : m_margin(margin) {}
+
+    void Bvh::build(std::span<const Aabb> bounds) {
+        m_leaves.assign(bounds.size(), NO_NODE);
+        m_free_ids.clear();
+        m_count = bounds.size();
+
+        std::vector<BuildItem> items(bounds.size());
+        for (size_t i = 0; i < bounds.size(); i++) {
+            const Aabb fat = { bounds[i].min - m_margin, bounds[i].max + m_margin };
+            items[i]       = { fat, fat.center(), static_cast<uint32_t>(i) };
+        }
+
+        build_items(items);
+    }
+
+    void Bvh::rebuild() {
+        std::vector<BuildItem> items;
+        items.reserve(m_count);
+        for (uint32_t id = 0; id < m_leaves.size(); id++) {
+            if (m_leaves[id] != NO_NODE) {
+                const Aabb bounds = m_nodes[m_leaves[id]].bounds();
+                items.push_back({ bounds, bounds.center(), id });
+            }
+        }
+
+        build_items(items);
+    }
+
+    void Bvh::build_items(std::vector<BuildItem> &items) {
+        m_nodes.clear();
+        m_parents.clear();
+        m_dirty.clear();
+        m_free_nodes.clear();
+        m_needs_refit = false;
+
+        m_nodes.reserve(items.size() * 2);
+        m_parents.reserve(items.size() * 2);
+        m_dirty.reserve(items.size() * 2);
+
+        if (items.empty()) {
+            m_root = NO_NODE;
+            return;
+        }
+
+        Aabb bounds;
+        Aabb centers;
+        for (const auto &item : items) {
+            bounds.merge(item.bounds);
+            centers.expand(item.center);
+        }
+
+        m_root            = build_range(items, 0, items.size(), bounds, centers);
+        m_parents[m_root] = NO_NODE;
+    }
+
+    uint32_t Bvh::build_range(std::vector<BuildItem> &items, size_t begin, size_t end, const Aabb &bounds,
+                              const Aabb &centers) {
+        const uint32_t node = allocate_node();
+
+        if (end - begin == 1) {
+            const BuildItem &item = items[begin];
+            m_nodes[node]         = { item.bounds.min, item.id, item.bounds.max, LEAF };
+            m_leaves[item.id]     = node;
+            return node;
+        }
+
+        const glm::vec3 extent = centers.max - centers.min;
+        const int       axis   = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+        // binned SAH: cost of a split = area(left) * count(left) + area(right) * count(right). The bins also collect
+        // the bounds of both sides, so children never rescan their items.
+        struct Bin {
+            Aabb   bounds;
+            Aabb   centers;
+            size_t count = 0;
+        };
+
+        size_t mid = begin;
+        Aabb   left_bounds, left_centers, right_bounds, right_centers;
+
+        if (extent[axis] > 0.0f) {
+            // small ranges near the leaves don't need all the bins
+            const size_t              bin_count = std::min(SAH_BINS, end - begin);
+            std::array<Bin, SAH_BINS> bins;
+
+            const float scale = static_cast<float>(bin_count) / extent[axis];
+            auto        bin   = [&](const BuildItem &item) {
+                const auto b = static_cast<size_t>((item.center[axis] - centers.min[axis]) * scale);
+                return std::min(b, bin_count - 1);
+            };
+
+            for (size_t i = begin; i < end; i++) {
+                Bin &b = bins[bin(items[i])];
+                b.bounds.merge(items[i].bounds);
+                b.centers.expand(items[i].center);
+                b.count++;
+            }
+
+            std::array<float, SAH_BINS> right_cost{};
+            Aabb                        right;
+            size_t                      right_count = 0;
+            for (size_t b = bin_count - 1; b > 0; b--) {
+                right.merge(bins[b].bounds);
+                right_count += bins[b].count;
+                right_cost[b] = right_count > 0 ? right.half_area() * static_cast<float>(right_count) : 0.0f;
+            }
+
+            Aabb   left;
+            size_t left_count = 0;
+            float  best_cost  = std::numeric_limits<float>::infinity();
+            size_t best_split = 0;
+            for (size_t split = 1; split < bin_count; split++) {
+                left.merge(bins[split - 1].bounds);
+                left_count += bins[split - 1].count;
+                if (left_count == 0 || left_count == end - begin)
+                    continue;
+
+                const float cost = left.half_area() * static_cast<float>(left_count) + right_cost[split];
+                if (cost < best_cost) {
+                    best_cost  = cost;
+                    best_split = split;
+                }
+            }
+
+            if (best_split > 0) {
+                const auto it = std::partition(items.begin() + static_cast<ptrdiff_t>(begin),
+                                               items.begin() + static_cast<ptrdiff_t>(end),
+                                               [&](const BuildItem &item) { return bin(item) < best_split; });
+                mid = static_cast<size_t>(it - items.begin());
+
+                for (size_t b = 0; b < bin_count; b++) {
+                    (b < best_split ? left_bounds : right_bounds).merge(bins[b].bounds);
+                    (b < best_split ? left_centers : right_centers).merge(bins[b].centers);
+                }
+            }
+        }
+
+        // every center in one bin: fall back to a median split
+        if (mid == begin || mid == end) {
+            mid = (begin + end) / 2;
+            std::nth_element(items.begin() + static_cast<ptrdiff_t>(begin), items.begin() + static_cast<ptrdiff_t>(mid),
+                             items.begin() + static_cast<ptrdiff_t>(end),
+                             [&](const BuildItem &a, const BuildItem &b) { return a.center[axis] < b.center[axis]; });
+
+            left_bounds = left_centers = right_bounds = right_centers = {};
+            for (size_t i = begin; i < end; i++) {
+                (i < mid ? left_bounds : right_bounds).merge(items[i].bounds);
+                (i < mid ? left_centers : right_centers).expand(items[i].center);
+            }
+        }
+
+        const uint32_t left  = build_range(items, begin, mid, left_bounds, left_centers);
+        const uint32_t right = build_range(items, mid, end, right_bounds, right_centers);
+
+        m_nodes[node]    = { bounds.min, left, bounds.max, right };
+        m_parents[left]  = node;
+        m_parents[right] = node;
+        return node;
+    }
+
+    uint32_t Bvh::insert(const Aabb &bounds) {
+        uint32_t id;
+        if (!m_free_ids.empty()) {
+            id = m_free_ids.back();
+            m_free_ids.pop_back();
+        } else {
+            id = static_cast<uint32_t>(m_leaves.size());
+            m_leaves.push_back(NO_NODE);
+        }
+
+        const Aabb     fat  = { bounds.min - m_margin, bounds.max + m_margin };
+        const uint32_t leaf = allocate_node();
+        m_nodes[leaf]       = { fat.min, id, fat.max, LEAF };
+        m_leaves[id]        = leaf;
+        m_count++;
+
+        if (m_root == NO_NODE) {
+            m_root          = leaf;
+            m_parents[leaf] = NO_NODE;
+            return id;
+        }
+
+        // descend towards the sibling that adds the least area to the tree
+        uint32_t sibling = m_root;
+        while (!m_nodes[sibling].is_leaf()) {
+            const Node &node     = m_nodes[sibling];
+            const float area     = node.bounds().half_area();
+            const float combined = node.bounds().merged(fat).half_area();
+
+            // pairing with this node creates a parent of the combined size, going deeper grows this node anyway
+            const float cost    = combined;
+            const float inherit = combined - area;
+
+            auto descend_cost = [&](uint32_t child) {
+                const Aabb b = m_nodes[child].bounds();
+                const float grown = b.merged(fat).half_area();
+                return (m_nodes[child].is_leaf() ? grown : grown - b.half_area()) + inherit;
+            };
+
+            const float left  = descend_cost(node.left);
+            const float right = descend_cost(node.right);
+            if (cost < left && cost < right)
+                break;
+
+            sibling = left < right ? node.left : node.right;
+        }
+
+        const uint32_t old_parent = m_parents[sibling];
+        const uint32_t parent     = allocate_node();
+        const Aabb     merged     = m_nodes[sibling].bounds().merged(fat);
+        m_nodes[parent]           = { merged.min, sibling, merged.max, leaf };
+        m_parents[parent]         = old_parent;
+        m_parents[sibling]        = parent;
+        m_parents[leaf]           = parent;
+
+        // a pending refit of the sibling's subtree has to pass through the new parent
+        m_dirty[parent] = m_dirty[sibling];
+
+        if (old_parent == NO_NODE)
+            m_root = parent;
+        else
+            set_child(old_parent, sibling, parent);
+
+        refit_upwards(old_parent);
+        return id;
+    }
+
+    void Bvh::remove(uint32_t id) {
+        const uint32_t leaf = m_leaves.at(id);
+        if (leaf == NO_NODE)
+            throw std::runtime_error("Bvh object removed twice");
+
+        m_leaves[id] = NO_NODE;
+        m_free_ids.push_back(id);
+        m_count--;
+
+        if (leaf == m_root) {
+            m_root = NO_NODE;
+            free_node(leaf);
+            return;
+        }
+
+        // the sibling takes the parent's place
+        const uint32_t parent  = m_parents[leaf];
+        const uint32_t grand   = m_parents[parent];
+        const uint32_t sibling = m_nodes[parent].left == leaf ? m_nodes[parent].right : m_nodes[parent].left;
+
+        if (grand == NO_NODE) {
+            m_root             = sibling;
+            m_parents[sibling] = NO_NODE;
+        } else {
+            set_child(grand, parent, sibling);
+            m_parents[sibling] = grand;
+        }
+
+        // a pending refit may still pass through the parent
+        m_dirty[sibling] |= m_dirty[parent];
+        free_node(parent);
+        free_node(leaf);
+        refit_upwards(grand);
+    }
+
+    void Bvh::update(uint32_t id, const Aabb &bounds) {
+        const uint32_t leaf = m_leaves.at(id);
+        if (leaf == NO_NODE)
+            throw std::runtime_error("Bvh object doesn't exist");
+
+        // still inside the fattened box, nothing to do
+        if (m_margin > 0.0f && m_nodes[leaf].bounds().contains(bounds))
+            return;
+
+        m_nodes[leaf].set_bounds({ bounds.min - m_margin, bounds.max + m_margin });
+
+        for (uint32_t node = m_parents[leaf]; node != NO_NODE && !m_dirty[node]; node = m_parents[node]) {
+            m_dirty[node] = 1;
+        }
+        m_needs_refit = true;
+    }
+
+    void Bvh::refit() {
+        if (!m_needs_refit)
+            return;
+
+        if (m_root != NO_NODE)
+            refit_node(m_root);
+        m_needs_refit = false;
+    }
+
+    void Bvh::refit_node(uint32_t node) {
+        if (m_nodes[node].is_leaf() || !m_dirty[node])
+            return;
+
+        refit_node(m_nodes[node].left);
+        refit_node(m_nodes[node].right);
+
+        const Node &n = m_nodes[node];
+        m_nodes[node].set_bounds(m_nodes[n.left].bounds().merged(m_nodes[n.right].bounds()));
+        rotate(node);
+        m_dirty[node] = 0;
+    }
+
+    void Bvh::refit_upwards(uint32_t node) {
+        for (; node != NO_NODE; node = m_parents[node]) {
+            const Node &n = m_nodes[node];
+            m_nodes[node].set_bounds(m_nodes[n.left].bounds().merged(m_nodes[n.right].bounds()));
+            rotate(node);
+        }
+    }
+
+    void Bvh::rotate(uint32_t node) {
+        const uint32_t left  = m_nodes[node].left;
+        const uint32_t right = m_nodes[node].right;
+
+        // candidate swaps: (child kept as is, its sibling's child to swap with, the grandchild staying)
+        float    best_gain = 0.0f;
+        uint32_t swap_a    = NO_NODE; // node's child
+        uint32_t swap_b    = NO_NODE; // grandchild on the other side
+        uint32_t inner     = NO_NODE; // the child whose subtree changes
+
+        auto consider = [&](uint32_t child, uint32_t other) {
+            const Node &o = m_nodes[other];
+            if (o.is_leaf())
+                return;
+
+            // subtrees still waiting for refit() must stay below their dirty ancestors
+            if (m_dirty[child] || m_dirty[o.left] || m_dirty[o.right])
+                return;
+
+            const float area = o.bounds().half_area();
+            const Aabb  c    = m_nodes[child].bounds();
+
+            // child <-> o.left leaves o with (child, o.right), child <-> o.right leaves it with (o.left, child)
+            const float gain_left  = area - c.merged(m_nodes[o.right].bounds()).half_area();
+            const float gain_right = area - c.merged(m_nodes[o.left].bounds()).half_area();
+
+            if (gain_left > best_gain) {
+                best_gain = gain_left;
+                swap_a    = child;
+                swap_b    = o.left;
+                inner     = other;
+            }
+            if (gain_right > best_gain) {
+                best_gain = gain_right;
+                swap_a    = child;
+                swap_b    = o.right;
+                inner     = other;
+            }
+        };
+
+        consider(left, right);
+        consider(right, left);
+
+        if (swap_a == NO_NODE)
+            return;
+
+        set_child(node, swap_a, swap_b);
+        set_child(inner, swap_b, swap_a);
+        m_parents[swap_b] = node;
+        m_parents[swap_a] = inner;
+
+        const Node &n = m_nodes[inner];
+        m_nodes[inner].set_bounds(m_nodes[n.left].bounds().merged(m_nodes[n.right].bounds()));
+    }
+
+    void Bvh::set_child(uint32_t parent, uint32_t old_child, uint32_t new_child) {
+        if (m_nodes[parent].left == old_child)
+            m_nodes[parent].left = new_child;
+        else
+            m_nodes[parent].right = new_child;
+    }
+
+    uint32_t Bvh::allocate_node() {
+        if (!m_free_nodes.empty()) {
+            const uint32_t node = m_free_nodes.back();
+            m_free_nodes.pop_back();
+            m_dirty[node] = 0;
+            return node;
+        }
+
+        m_nodes.emplace_back();
+        m_parents.push_back(NO_NODE);
+        m_dirty.push_back(0);
+        return static_cast<uint32_t>(m_nodes.size() - 1);
+    }
+
+    void Bvh::free_node(uint32_t node) {
+        m_dirty[node] = 0;
+        m_free_nodes.push_back(node);
+    }
+
+    void Bvh::query_frustum(const Frustum &frustum, std::vector<uint32_t> &out) const {
+        out.clear();
+        if (m_root == NO_NODE)
+            return;
+
+        // the flag skips the plane tests below nodes that are entirely inside
+        std::vector<std::pair<uint32_t, bool>> stack;
+        stack.reserve(64);
+        stack.emplace_back(m_root, false);
+
+        while (!stack.empty()) {
+            auto [index, inside] = stack.back();
+            stack.pop_back();
+
+            const Node &node = m_nodes[index];
+            if (!inside) {
+                const Containment c = classify(frustum, node.min, node.max);
+                if (c == Containment::Outside)
+                    continue;
+                inside = c == Containment::Inside;
+            }
+
+            if (node.is_leaf()) {
+                out.push_back(node.left);
+            } else {
+                stack.emplace_back(node.right, inside);
+                stack.emplace_back(node.left, inside);
+            }
+        }
+    }
+
+    void Bvh::query_aabb(const Aabb &bounds, std::vector<uint32_t> &out) const {
+        out.clear();
+        if (m_root == NO_NODE)
+            return;
+
+        std::vector<uint32_t> stack;
+        stack.reserve(64);
+        stack.push_back(m_root);
+
+        while (!stack.empty()) {
+            const Node &node = m_nodes[stack.back()];
+            stack.pop_back();
+
+            if (!node.bounds().overlaps(bounds))
+                continue;
+
+            if (node.is_leaf()) {
+                out.push_back(node.left);
+            } else {
+                stack.push_back(node.right);
+                stack.push_back(node.left);
+            }
+        }
+    }
+
+    std::optional<RayHit> Bvh::raycast(const Ray &ray, float max_distance, const RayTest &test) const {
+        if (m_root == NO_NODE)
+            return std::nullopt;
+
+        // divisions by zero give infinities, which the slab test handles
+        const glm::vec3 inverse = 1.0f / ray.direction;
+
+        std::optional<RayHit> hit;
+        float                 best = max_distance;
+
+        std::vector<std::pair<uint32_t, float>> stack;
+        stack.reserve(64);
+
+        const float root = intersect(m_nodes[m_root].min, m_nodes[m_root].max, ray.origin, inverse, best);
+        if (root <= best)
+            stack.emplace_back(m_root, root);
+
+        while (!stack.empty()) {
+            const auto [index, distance] = stack.back();
+            stack.pop_back();
+
+            // something closer was found since this node was pushed
+            if (distance > best)
+                continue;
+
+            const Node &node = m_nodes[index];
+            if (node.is_leaf()) {
+                const std::optional<float> t = test ? test(node.left, ray) : std::optional(distance);
+                if (t && *t <= best) {
+                    best = *t;
+                    hit  = RayHit{ node.left, *t };
+                }
+                continue;
+            }
+
+            const float left  = intersect(m_nodes[node.left].min, m_nodes[node.left].max, ray.origin, inverse, best);
+            const float right = intersect(m_nodes[node.right].min, m_nodes[node.right].max, ray.origin, inverse, best);
+
+            // nearer child on top
+            const bool left_first = left <= right;
+            const auto near       = left_first ? std::pair(node.left, left) : std::pair(node.right, right);
+            const auto far        = left_first ? std::pair(node.right, right) : std::pair(node.left, left);
+            if (far.second <= best)
+                stack.push_back(far);
+            if (near.second <= best)
+                stack.push_back(near);
+        }
+
+        return hit;
+    }
+
+    Aabb Bvh::get_bounds(uint32_t id) const {
+        const uint32_t leaf = m_leaves.at(id);
+        if (leaf == NO_NODE)
+            throw std::runtime_error("Bvh object doesn't exist");
+        return m_nodes[leaf].bounds();
+    }
+
+    float Bvh::get_sah_cost() const {
+        if (m_root == NO_NODE)
+            return 0.0f;
+
+        float cost = 0.0f;
+        for (size_t i = 0; i < m_nodes.size(); i++) {
+            if (!m_nodes[i].is_leaf())
+                cost += m_nodes[i].bounds().half_area();
+        }
+
+        // free nodes are still in the array
+        for (const uint32_t node : m_free_nodes) {
+            if (!m_nodes[node].is_leaf())
+                cost -= m_nodes[node].bounds().half_area();
+        }
+        return cost / std::max(m_nodes[m_root].bounds().half_area(), 1e-12f);
+    }
+
+} // namespace kat
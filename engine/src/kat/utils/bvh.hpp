@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "kat/utils/aabb.hpp"
+#include "kat/utils/frustum.hpp"
+#include "kat/utils/ray.hpp"
+
+namespace kat {
+
+    struct RayHit {
+        uint32_t id;
+        float    distance;
+    };
+
+    // Exact intersection for one object, called by Bvh::raycast for leaves whose box the ray enters. Returns the hit
+    // distance along the ray, nullopt for a miss.
+    using RayTest = std::function<std::optional<float>(uint32_t id, const Ray &ray)>;
+
+    // Dynamic bounding volume hierarchy with one object per leaf. build() creates a tree with binned SAH in depth
+    // first order, so a node's left child is usually right next to it; insert() and remove() keep the tree valid
+    // between builds, and moved objects are refitted with tree rotations that keep the surface area low.
+    class Bvh {
+      public:
+        // `margin` fattens leaf boxes so that small moves don't need a refit; queries become that much more
+        // conservative.
+        explicit Bvh(float margin = 0.0f);
+
+        // Replaces the whole tree, object ids are indices into `bounds`.
+        void build(std::span<const Aabb> bounds);
+
+        // SAH build over the current objects, keeping their ids. Worth it after many inserts and removes.
+        void rebuild();
+
+        uint32_t insert(const Aabb &bounds);
+
+        void remove(uint32_t id);
+
+        // Moves an object. The tree is only correct again after refit().
+        void update(uint32_t id, const Aabb &bounds);
+
+        // Refits every node above an update, rotating subtrees where that lowers the surface area.
+        void refit();
+
+        void query_frustum(const Frustum &frustum, std::vector<uint32_t> &out) const;
+
+        void query_aabb(const Aabb &bounds, std::vector<uint32_t> &out) const;
+
+        // Closest hit within max_distance. Without `test` the leaf boxes are the hit surfaces.
+        [[nodiscard]] std::optional<RayHit> raycast(const Ray &ray, float max_distance = 1e30f,
+                                                    const RayTest &test = {}) const;
+
+        // stored bounds, margin included
+        [[nodiscard]] Aabb get_bounds(uint32_t id) const;
+
+        [[nodiscard]] size_t get_count() const noexcept { return m_count; }
+
+        [[nodiscard]] size_t get_node_count() const noexcept { return m_nodes.size() - m_free_nodes.size(); }
+
+        // sum of the internal node surface areas relative to the root's, lower is better
+        [[nodiscard]] float get_sah_cost() const;
+
+      private:
+        static constexpr uint32_t NO_NODE = 0xFFFFFFFF;
+        static constexpr uint32_t LEAF    = 0xFFFFFFFF;
+
+        // 32 bytes, two per cache line
+        struct Node {
+            glm::vec3 min;
+            uint32_t  left; // object id for leaves
+            glm::vec3 max;
+            uint32_t  right; // LEAF for leaves
+
+            [[nodiscard]] bool is_leaf() const noexcept { return right == LEAF; }
+
+            [[nodiscard]] Aabb bounds() const noexcept { return { min, max }; }
+
+            void set_bounds(const Aabb &b) noexcept {
+                min = b.min;
+                max = b.max;
+            }
+        };
+
+        struct BuildItem {
+            Aabb      bounds;
+            glm::vec3 center;
+            uint32_t  id;
+        };
+
+        uint32_t allocate_node();
+
+        void free_node(uint32_t node);
+
+        // builds the subtree over items[begin, end), which `bounds` and `centers` enclose, and returns its root
+        uint32_t build_range(std::vector<BuildItem> &items, size_t begin, size_t end, const Aabb &bounds,
+                             const Aabb &centers);
+
+        void build_items(std::vector<BuildItem> &items);
+
+        // recomputes the bounds of `node` and its ancestors
+        void refit_upwards(uint32_t node);
+
+        void refit_node(uint32_t node);
+
+        // swaps a child with a grandchild when that shrinks the node's children
+        void rotate(uint32_t node);
+
+        void set_child(uint32_t parent, uint32_t old_child, uint32_t new_child);
+
+        float m_margin;
+
+        std::vector<Node>     m_nodes;
+        std::vector<uint32_t> m_parents;
+        std::vector<uint8_t>  m_dirty;
+        std::vector<uint32_t> m_free_nodes;
+        uint32_t              m_root = NO_NODE;
+
+        std::vector<uint32_t> m_leaves; // object id -> leaf node, NO_NODE for unused ids
+        std::vector<uint32_t> m_free_ids;
+        size_t                m_count = 0;
+        bool                  m_needs_refit = false;
+    };
+
+} // namespace kat
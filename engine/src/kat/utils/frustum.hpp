@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    // Six normalized planes (xyz = normal pointing inwards, w = distance), extracted from an OpenGL style clip matrix.
+    // Extracting from projection * view * model yields the planes in model space.
+    struct Frustum {
+        enum Plane { Left, Right, Bottom, Top, Near, Far };
+
+        glm::vec4 planes[6];
+
+        static Frustum from_matrix(const glm::mat4 &m) {
+            const glm::vec4 r0 = { m[0][0], m[1][0], m[2][0], m[3][0] };
+            const glm::vec4 r1 = { m[0][1], m[1][1], m[2][1], m[3][1] };
+            const glm::vec4 r2 = { m[0][2], m[1][2], m[2][2], m[3][2] };
+            const glm::vec4 r3 = { m[0][3], m[1][3], m[2][3], m[3][3] };
+
+            Frustum f{ { r3 + r0, r3 - r0, r3 + r1, r3 - r1, r3 + r2, r3 - r2 } };
+            for (auto &plane : f.planes) {
+                plane /= glm::length(glm::vec3(plane));
+            }
+            return f;
+        }
+
+        [[nodiscard]] bool intersects_sphere(const glm::vec3 &center, float radius) const {
+            for (const auto &plane : planes) {
+                if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+                    return false;
+            }
+            return true;
+        }
+
+        [[nodiscard]] bool intersects_aabb(const glm::vec3 &min, const glm::vec3 &max) const {
+            for (const auto &plane : planes) {
+                // test the box corner furthest along the plane normal
+                const glm::vec3 p = { plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y,
+                                      plane.z >= 0.0f ? max.z : min.z };
+                if (glm::dot(glm::vec3(plane), p) + plane.w < 0.0f)
+                    return false;
+            }
+            return true;
+        }
+    };
+
+} // namespace kat
@@ -0,0 +1,151 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace kat {
+
+    // A typed index into a HandlePool plus the generation of its slot. Stale handles fail lookups instead of reaching
+    // whatever reuses the slot. Trivially copyable and compared by value, unlike shared_ptr it keeps nothing alive.
+    template <typename T>
+    struct Handle {
+        uint32_t index      = std::numeric_limits<uint32_t>::max();
+        uint32_t generation = 0;
+
+        [[nodiscard]] bool is_null() const noexcept { return index == std::numeric_limits<uint32_t>::max(); }
+
+        friend bool operator==(const Handle &lhs, const Handle &rhs) = default;
+    };
+
+    // Objects stored in place in pages of contiguous slots, addressed by generational handles. Objects never move, so
+    // references stay valid until release, and types need not be copyable or movable.
+    //
+    // release() invalidates the handle at once but only destroys the object once collect() is given a frame at or
+    // past the one it was released in, so work already submitted with it can finish.
+    template <typename T>
+    class HandlePool {
+      public:
+        static constexpr uint32_t PAGE_SIZE = 256;
+
+        HandlePool() = default;
+
+        ~HandlePool() {
+            for (uint32_t index = 0; index < m_slots.size(); index++) {
+                if (m_slots[index].occupied)
+                    object(index)->~T();
+            }
+        }
+
+        HandlePool(const HandlePool &)            = delete;
+        HandlePool &operator=(const HandlePool &) = delete;
+
+        template <typename... Args>
+        Handle<T> emplace(Args &&...args) {
+            uint32_t index;
+            if (!m_free.empty()) {
+                index = m_free.back();
+                m_free.pop_back();
+            } else {
+                index = static_cast<uint32_t>(m_slots.size());
+                if (index % PAGE_SIZE == 0)
+                    m_pages.push_back(std::make_unique<Storage[]>(PAGE_SIZE));
+                m_slots.emplace_back();
+            }
+
+            try {
+                new (object(index)) T(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                m_free.push_back(index);
+                throw;
+            }
+
+            Slot &slot    = m_slots[index];
+            slot.occupied = true;
+            slot.alive    = true;
+            m_count++;
+            return { index, slot.generation };
+        }
+
+        // nullptr for stale or null handles
+        [[nodiscard]] T *get(Handle<T> handle) const noexcept {
+            return contains(handle) ? object(handle.index) : nullptr;
+        }
+
+        [[nodiscard]] T &at(Handle<T> handle) const {
+            if (!contains(handle))
+                throw std::runtime_error("Stale or null handle");
+            return *object(handle.index);
+        }
+
+        [[nodiscard]] bool contains(Handle<T> handle) const noexcept {
+            return handle.index < m_slots.size() && m_slots[handle.index].alive &&
+                   m_slots[handle.index].generation == handle.generation;
+        }
+
+        // Invalidates the handle, the object lives on until collect(`frame`) or later. Stale handles are ignored.
+        void release(Handle<T> handle, uint64_t frame) {
+            if (!contains(handle))
+                return;
+
+            Slot &slot = m_slots[handle.index];
+            slot.alive = false;
+            slot.generation++;
+            m_count--;
+            m_released.push_back({ handle.index, frame });
+        }
+
+        // destroys the objects released in `frame` or earlier and recycles their slots
+        void collect(uint64_t frame) {
+            size_t kept = 0;
+            for (const Released &released : m_released) {
+                if (released.frame > frame) {
+                    m_released[kept++] = released;
+                    continue;
+                }
+
+                object(released.index)->~T();
+                m_slots[released.index].occupied = false;
+                m_free.push_back(released.index);
+            }
+            m_released.resize(kept);
+        }
+
+        // live objects, not counting released ones that wait for collect()
+        [[nodiscard]] size_t size() const noexcept { return m_count; }
+
+        [[nodiscard]] size_t get_pending_count() const noexcept { return m_released.size(); }
+
+      private:
+        struct Storage {
+            alignas(T) std::byte bytes[sizeof(T)];
+        };
+
+        struct Slot {
+            uint32_t generation = 0;
+            bool     occupied   = false; // holds a constructed object
+            bool     alive      = false; // and it hasn't been released
+        };
+
+        struct Released {
+            uint32_t index;
+            uint64_t frame;
+        };
+
+        [[nodiscard]] T *object(uint32_t index) const noexcept {
+            return std::launder(reinterpret_cast<T *>(m_pages[index / PAGE_SIZE][index % PAGE_SIZE].bytes));
+        }
+
+        std::vector<std::unique_ptr<Storage[]>> m_pages;
+        std::vector<Slot>                       m_slots;
+        std::vector<uint32_t>                   m_free;
+        std::vector<Released>                   m_released;
+        size_t                                  m_count = 0;
+    };
+
+} // namespace kat
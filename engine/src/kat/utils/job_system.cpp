@@ -0,0 +1,121 @@
+#include "job_system.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace kat {
+
+    JobSystem::JobSystem(unsigned int thread_count) {
+        if (thread_count == 0) {
+            thread_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        }
+
+        m_threads.reserve(thread_count);
+        for (unsigned int i = 0; i < thread_count; i++) {
+            m_threads.emplace_back([this] { worker_main(); });
+        }
+    }
+
+    JobSystem::~JobSystem() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_condition.notify_all();
+
+        for (auto &thread : m_threads) {
+            thread.join();
+        }
+    }
+
+    std::shared_ptr<JobSystem> JobSystem::create(unsigned int thread_count) {
+        return std::make_shared<JobSystem>(thread_count);
+    }
+
+    void JobSystem::enqueue(std::function<void()> job) {
+        {
+            std::lock_guard lock(m_mutex);
+            m_jobs.push_back(std::move(job));
+        }
+        m_condition.notify_one();
+    }
+
+    void JobSystem::worker_main() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock lock(m_mutex);
+                m_condition.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+
+                if (m_stopping && m_jobs.empty())
+                    return;
+
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+
+            job();
+        }
+    }
+
+    void JobSystem::parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)> &fn) {
+        if (count == 0)
+            return;
+
+        grain                = std::max<size_t>(grain, 1);
+        const size_t chunks  = (count + grain - 1) / grain;
+        const size_t helpers = std::min<size_t>(chunks - 1, m_threads.size());
+
+        if (helpers == 0) {
+            fn(0, count);
+            return;
+        }
+
+        // shared so that helpers which only get scheduled after the loop finished never touch a dead stack frame.
+        struct State {
+            std::atomic<size_t>     next_chunk  = 0;
+            std::atomic<size_t>     done_chunks = 0;
+            std::mutex              mutex;
+            std::condition_variable done;
+            std::exception_ptr      error;
+        };
+
+        auto state = std::make_shared<State>();
+
+        auto run = [state, count, grain, chunks, &fn] {
+            size_t chunk;
+            while ((chunk = state->next_chunk.fetch_add(1)) < chunks) {
+                const size_t begin = chunk * grain;
+                const size_t end   = std::min(begin + grain, count);
+
+                try {
+                    fn(begin, end);
+                }
+                catch (...) {
+                    std::lock_guard lock(state->mutex);
+                    if (!state->error)
+                        state->error = std::current_exception();
+                }
+
+                if (state->done_chunks.fetch_add(1) + 1 == chunks) {
+                    std::lock_guard lock(state->mutex);
+                    state->done.notify_all();
+                }
+            }
+        };
+
+        for (size_t i = 0; i < helpers; i++) {
+            enqueue(run);
+        }
+
+        run();
+
+        std::unique_lock lock(state->mutex);
+        state->done.wait(lock, [&] { return state->done_chunks.load() == chunks; });
+
+        if (state->error)
+            std::rethrow_exception(state->error);
+    }
+
+} // namespace kat
@@ -0,0 +1,57 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace kat {
+
+    class JobSystem {
+      public:
+        // thread_count == 0 picks one worker per hardware thread, minus the calling thread.
+        explicit JobSystem(unsigned int thread_count = 0);
+
+        ~JobSystem();
+
+        JobSystem(const JobSystem &)            = delete;
+        JobSystem &operator=(const JobSystem &) = delete;
+
+        static std::shared_ptr<JobSystem> create(unsigned int thread_count = 0);
+
+        template <typename F>
+        auto submit(F &&f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+            using R   = std::invoke_result_t<std::decay_t<F>>;
+            auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+
+            std::future<R> future = task->get_future();
+            enqueue([task] { (*task)(); });
+            return future;
+        }
+
+        // Splits [0, count) into chunks of at most `grain` items and runs fn(begin, end) on each chunk.
+        // The calling thread takes part in the work, so this is safe to call from inside a job.
+        void parallel_for(size_t count, size_t grain, const std::function<void(size_t, size_t)> &fn);
+
+        [[nodiscard]] unsigned int get_thread_count() const noexcept {
+            return static_cast<unsigned int>(m_threads.size());
+        }
+
+      private:
+        void enqueue(std::function<void()> job);
+
+        void worker_main();
+
+        std::vector<std::thread>          m_threads;
+        std::deque<std::function<void()>> m_jobs;
+        std::mutex                        m_mutex;
+        std::condition_variable           m_condition;
+        bool                              m_stopping = false;
+    };
+
+} // namespace kat
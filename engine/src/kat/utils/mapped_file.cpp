@@ -0,0 +1,62 @@
+#include "mapped_file.hpp"
+
+#include <filesystem>
+#include <stdexcept>
+
+namespace kat {
+
+    MappedFile::MappedFile(const std::string &path) {
+        const std::wstring wpath = std::filesystem::path(path).wstring();
+
+        m_file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("Failed to open file: " + path);
+
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(m_file, &size)) {
+            CloseHandle(m_file);
+            throw std::runtime_error("Failed to query file size: " + path);
+        }
+
+        m_size = static_cast<size_t>(size.QuadPart);
+
+        // zero length files cannot be mapped, they are simply an empty span.
+        if (m_size == 0)
+            return;
+
+        m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping == nullptr) {
+            CloseHandle(m_file);
+            throw std::runtime_error("Failed to create file mapping: " + path);
+        }
+
+        m_data = static_cast<const std::byte *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (m_data == nullptr) {
+            CloseHandle(m_mapping);
+            CloseHandle(m_file);
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+    }
+
+    MappedFile::~MappedFile() {
+        if (m_data)
+            UnmapViewOfFile(m_data);
+        if (m_mapping)
+            CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+    }
+
+    std::shared_ptr<MappedFile> MappedFile::open(const std::string &path) {
+        return std::make_shared<MappedFile>(path);
+    }
+
+    std::span<const std::byte> MappedFile::span(size_t offset, size_t size) const {
+        if (offset > m_size || size > m_size - offset)
+            throw std::out_of_range("Mapped file range out of bounds");
+
+        return { m_data + offset, size };
+    }
+
+} // namespace kat
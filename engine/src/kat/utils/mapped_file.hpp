@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+
+#include <Windows.h>
+
+namespace kat {
+
+    // Read-only memory mapping of a whole file. Pages are only faulted in when touched, so large binary chunks can be
+    // consumed straight from the mapping without first copying them into memory.
+    class MappedFile {
+      public:
+        explicit MappedFile(const std::string &path);
+
+        ~MappedFile();
+
+        MappedFile(const MappedFile &)            = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        static std::shared_ptr<MappedFile> open(const std::string &path);
+
+        [[nodiscard]] const std::byte *data() const noexcept { return m_data; }
+
+        [[nodiscard]] size_t size() const noexcept { return m_size; }
+
+        [[nodiscard]] std::span<const std::byte> span() const noexcept { return { m_data, m_size }; }
+
+        [[nodiscard]] std::span<const std::byte> span(size_t offset, size_t size) const;
+
+      private:
+        HANDLE           m_file    = INVALID_HANDLE_VALUE;
+        HANDLE           m_mapping = nullptr;
+        const std::byte *m_data    = nullptr;
+        size_t           m_size    = 0;
+    };
+
+} // namespace kat
@@ -0,0 +1,114 @@
+#include "quadtree_allocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+namespace kat {
+
+    QuadtreeAllocator::QuadtreeAllocator(uint32_t size, uint32_t min_size) : m_size(size), m_min_size(min_size) {
+        if (!std::has_single_bit(size) || !std::has_single_bit(min_size) || min_size > size)
+            throw std::runtime_error("Quadtree sizes must be powers of two with the minimum not above the size");
+
+        const auto levels = static_cast<uint32_t>(std::countr_zero(size / min_size)) + 1;
+        m_levels.resize(levels);
+        for (uint32_t level = 0; level < levels; level++) {
+            m_levels[level].resize(static_cast<size_t>(1) << (2 * level));
+        }
+        reset();
+    }
+
+    std::optional<PackRect> QuadtreeAllocator::allocate(uint32_t size) {
+        size = std::bit_ceil(std::max(size, m_min_size));
+        if (size > m_size)
+            return std::nullopt;
+
+        const auto target = static_cast<uint32_t>(std::countr_zero(m_size / size));
+
+        std::optional<Found> best;
+        find(0, 0, 0, target, best);
+        if (!best)
+            return std::nullopt;
+
+        // split down to the requested size, always continuing in the first child
+        auto [level, x, y] = *best;
+        while (level < target) {
+            node(level, x, y) = Node::Split;
+            level++;
+            x *= 2;
+            y *= 2;
+            node(level, x, y)         = Node::Free;
+            node(level, x + 1, y)     = Node::Free;
+            node(level, x, y + 1)     = Node::Free;
+            node(level, x + 1, y + 1) = Node::Free;
+        }
+
+        node(level, x, y) = Node::Used;
+        m_used_area += static_cast<uint64_t>(size) * size;
+        return PackRect{ x * size, y * size, size, size };
+    }
+
+    void QuadtreeAllocator::find(uint32_t level, uint32_t x, uint32_t y, uint32_t target,
+                                 std::optional<Found> &best) const {
+        const Node state = node(level, x, y);
+        if (state == Node::Used)
+            return;
+
+        if (state == Node::Free) {
+            // the smallest free node that fits keeps large nodes whole for large requests
+            if (!best || level > best->level)
+                best = Found{ level, x, y };
+            return;
+        }
+
+        if (level == target)
+            return;
+
+        for (uint32_t i = 0; i < 4 && !(best && best->level == target); i++) {
+            find(level + 1, x * 2 + (i & 1), y * 2 + (i >> 1), target, best);
+        }
+    }
+
+    void QuadtreeAllocator::free(const PackRect &rect) {
+        if (rect.width != rect.height || !std::has_single_bit(rect.width) || rect.width < m_min_size ||
+            rect.width > m_size || rect.x % rect.width != 0 || rect.y % rect.width != 0)
+            return;
+
+        auto     level = static_cast<uint32_t>(std::countr_zero(m_size / rect.width));
+        uint32_t x     = rect.x / rect.width;
+        uint32_t y     = rect.y / rect.width;
+        if (x >= (1u << level) || y >= (1u << level) || node(level, x, y) != Node::Used)
+            return;
+
+        node(level, x, y) = Node::Free;
+        m_used_area -= static_cast<uint64_t>(rect.width) * rect.width;
+
+        // merge while all siblings are free
+        while (level > 0) {
+            const uint32_t px = x / 2;
+            const uint32_t py = y / 2;
+            if (node(level, px * 2, py * 2) != Node::Free || node(level, px * 2 + 1, py * 2) != Node::Free ||
+                node(level, px * 2, py * 2 + 1) != Node::Free || node(level, px * 2 + 1, py * 2 + 1) != Node::Free)
+                break;
+
+            level--;
+            x                 = px;
+            y                 = py;
+            node(level, x, y) = Node::Free;
+        }
+    }
+
+    void QuadtreeAllocator::reset() {
+        // allocation never looks below a free node, but free() goes straight to a rectangle's node, so one handed out
+        // before the reset mustn't find its old Used state there
+        for (std::vector<Node> &level : m_levels) {
+            std::ranges::fill(level, Node::Free);
+        }
+        m_used_area = 0;
+    }
+
+    float QuadtreeAllocator::get_occupancy() const noexcept {
+        return static_cast<float>(static_cast<double>(m_used_area) / (static_cast<double>(m_size) * m_size));
+    }
+
+} // namespace kat
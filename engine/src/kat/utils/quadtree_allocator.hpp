@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "rect_packer.hpp"
+
+namespace kat {
+
+    // Square power of two tiles out of a square power of two area, split as a quadtree. Allocation takes the
+    // smallest free node that fits and splits it down to size, freeing merges a node with its siblings again once
+    // all four are free. Unlike RectPacker this never fragments below the tile sizes in use, which suits atlases
+    // whose tiles come and go every frame (shadow maps).
+    class QuadtreeAllocator {
+      public:
+        // both powers of two, min_size <= size
+        QuadtreeAllocator(uint32_t size, uint32_t min_size);
+
+        // `size` is rounded up to a power of two and at least min_size, nullopt when there is no room
+        std::optional<PackRect> allocate(uint32_t size);
+
+        // `rect` as returned by allocate(), unknown rectangles are ignored
+        void free(const PackRect &rect);
+
+        void reset();
+
+        [[nodiscard]] uint32_t get_size() const noexcept { return m_size; }
+
+        [[nodiscard]] uint32_t get_min_size() const noexcept { return m_min_size; }
+
+        // used area over total area
+        [[nodiscard]] float get_occupancy() const noexcept;
+
+      private:
+        enum class Node : uint8_t { Free, Split, Used };
+
+        struct Found {
+            uint32_t level;
+            uint32_t x;
+            uint32_t y;
+        };
+
+        // deepest free node at or above `level` under the given one, stops early at an exact fit
+        void find(uint32_t level, uint32_t x, uint32_t y, uint32_t target, std::optional<Found> &best) const;
+
+        Node &node(uint32_t level, uint32_t x, uint32_t y) { return m_levels[level][(y << level) + x]; }
+
+        [[nodiscard]] Node node(uint32_t level, uint32_t x, uint32_t y) const {
+            return m_levels[level][(y << level) + x];
+        }
+
+        uint32_t                       m_size;
+        uint32_t                       m_min_size;
+        uint64_t                       m_used_area = 0;
+        std::vector<std::vector<Node>> m_levels; // level l is a 2^l by 2^l grid of nodes
+    };
+
+} // namespace kat
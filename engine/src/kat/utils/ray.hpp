@@ -0,0 +1,30 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    struct Ray {
+        glm::vec3 origin;
+        glm::vec3 direction; // normalized
+
+        [[nodiscard]] glm::vec3 at(float distance) const noexcept { return origin + direction * distance; }
+
+        // Picking ray through a window position in pixels (origin in the top left corner, as the input manager
+        // reports it), from the near plane into the scene.
+        static Ray from_screen(const glm::vec2 &position, const glm::vec2 &viewport_size,
+                               const glm::mat4 &view_projection) {
+            const glm::vec2 ndc     = { position.x / viewport_size.x * 2.0f - 1.0f,
+                                        1.0f - position.y / viewport_size.y * 2.0f };
+            const glm::mat4 inverse = glm::inverse(view_projection);
+
+            glm::vec4 near = inverse * glm::vec4(ndc, -1.0f, 1.0f);
+            glm::vec4 far  = inverse * glm::vec4(ndc, 1.0f, 1.0f);
+            near /= near.w;
+            far /= far.w;
+
+            return { glm::vec3(near), glm::normalize(glm::vec3(far - near)) };
+        }
+    };
+
+} // namespace kat
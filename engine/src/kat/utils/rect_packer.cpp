@@ -0,0 +1,158 @@
+#include "rect_packer.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace kat {
+    namespace {
+        bool contains(const PackRect &outer, const PackRect &inner) {
+            return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.width <= outer.x + outer.width &&
+                   inner.y + inner.height <= outer.y + outer.height;
+        }
+
+        bool overlaps(const PackRect &a, const PackRect &b) {
+            return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+        }
+    } // namespace
+
+    RectPacker::RectPacker(uint32_t width, uint32_t height) : m_width(width), m_height(height) {
+        reset();
+    }
+
+    std::optional<PackRect> RectPacker::insert(uint32_t width, uint32_t height) {
+        if (width == 0 || height == 0)
+            return std::nullopt;
+
+        if (m_rebuild)
+            rebuild();
+
+        // best short side fit: the free rectangle that leaves the smallest leftover along its tighter side
+        const PackRect *best       = nullptr;
+        uint32_t        best_short = std::numeric_limits<uint32_t>::max();
+        uint32_t        best_long  = std::numeric_limits<uint32_t>::max();
+        for (const auto &free : m_free) {
+            if (free.width < width || free.height < height)
+                continue;
+
+            const uint32_t dx         = free.width - width;
+            const uint32_t dy         = free.height - height;
+            const uint32_t short_side = std::min(dx, dy);
+            const uint32_t long_side  = std::max(dx, dy);
+            if (short_side < best_short || (short_side == best_short && long_side < best_long)) {
+                best       = &free;
+                best_short = short_side;
+                best_long  = long_side;
+            }
+        }
+
+        if (!best)
+            return std::nullopt;
+
+        const PackRect placed = { best->x, best->y, width, height };
+        split(placed);
+        prune();
+
+        m_used.push_back(placed);
+        m_used_area += static_cast<uint64_t>(width) * height;
+        return placed;
+    }
+
+    void RectPacker::remove(const PackRect &rect) {
+        const auto it = std::ranges::find_if(m_used, [&](const PackRect &used) {
+            return used.x == rect.x && used.y == rect.y && used.width == rect.width && used.height == rect.height;
+        });
+        if (it == m_used.end())
+            return;
+
+        *it = m_used.back();
+        m_used.pop_back();
+        m_used_area -= static_cast<uint64_t>(rect.width) * rect.height;
+        m_rebuild = true;
+    }
+
+    void RectPacker::reset() {
+        m_free.clear();
+        m_free.push_back({ 0, 0, m_width, m_height });
+        m_used.clear();
+        m_used_area = 0;
+        m_rebuild   = false;
+    }
+
+    void RectPacker::rebuild() {
+        m_free.clear();
+        m_free.push_back({ 0, 0, m_width, m_height });
+        for (const auto &used : m_used) {
+            split(used);
+            prune();
+        }
+        m_rebuild = false;
+    }
+
+    float RectPacker::get_occupancy() const noexcept {
+        return static_cast<float>(static_cast<double>(m_used_area) / (static_cast<double>(m_width) * m_height));
+    }
+
+    void RectPacker::split(const PackRect &used) {
+        const size_t count = m_free.size();
+        for (size_t i = 0; i < count; i++) {
+            const PackRect free = m_free[i];
+            if (!overlaps(free, used))
+                continue;
+
+            // up to four maximal pieces around the used rectangle
+            if (used.x > free.x)
+                m_free.push_back({ free.x, free.y, used.x - free.x, free.height });
+            if (used.x + used.width < free.x + free.width)
+                m_free.push_back({ used.x + used.width, free.y, free.x + free.width - used.x - used.width,
+                                   free.height });
+            if (used.y > free.y)
+                m_free.push_back({ free.x, free.y, free.width, used.y - free.y });
+            if (used.y + used.height < free.y + free.height)
+                m_free.push_back({ free.x, used.y + used.height, free.width,
+                                   free.y + free.height - used.y - used.height });
+
+            // mark for removal, pruned below
+            m_free[i].width = 0;
+        }
+
+        std::erase_if(m_free, [](const PackRect &r) { return r.width == 0 || r.height == 0; });
+    }
+
+    void RectPacker::prune() {
+        for (size_t i = 0; i < m_free.size(); i++) {
+            for (size_t j = i + 1; j < m_free.size();) {
+                if (contains(m_free[i], m_free[j])) {
+                    m_free.erase(m_free.begin() + static_cast<ptrdiff_t>(j));
+                }
+                else if (contains(m_free[j], m_free[i])) {
+                    m_free.erase(m_free.begin() + static_cast<ptrdiff_t>(i));
+                    i--;
+                    break;
+                }
+                else {
+                    j++;
+                }
+            }
+        }
+    }
+
+    std::vector<std::optional<PackRect>> pack_rects(std::span<const glm::uvec2> sizes, uint32_t width,
+                                                    uint32_t height) {
+        std::vector<size_t> order(sizes.size());
+        std::iota(order.begin(), order.end(), size_t{ 0 });
+        std::ranges::sort(order, [&](size_t a, size_t b) {
+            const uint32_t side_a = std::max(sizes[a].x, sizes[a].y);
+            const uint32_t side_b = std::max(sizes[b].x, sizes[b].y);
+            return side_a != side_b ? side_a > side_b : sizes[a].x * sizes[a].y > sizes[b].x * sizes[b].y;
+        });
+
+        RectPacker                           packer(width, height);
+        std::vector<std::optional<PackRect>> placed(sizes.size());
+        for (const size_t i : order) {
+            placed[i] = packer.insert(sizes[i].x, sizes[i].y);
+        }
+        return placed;
+    }
+
+} // namespace kat
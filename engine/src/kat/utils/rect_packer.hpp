@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace kat {
+
+    struct PackRect {
+        uint32_t x;
+        uint32_t y;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    // MaxRects bin packer with the best short side fit heuristic. The free space is kept as the set of maximal free
+    // rectangles. After remove() the set is rebuilt from the rectangles still in use on the next insert, so evicting
+    // many at once costs one rebuild and freed neighbours join into larger free space.
+    class RectPacker {
+      public:
+        RectPacker(uint32_t width, uint32_t height);
+
+        // nullopt when there is no room
+        std::optional<PackRect> insert(uint32_t width, uint32_t height);
+
+        // `rect` as returned by insert(), unknown rectangles are ignored
+        void remove(const PackRect &rect);
+
+        void reset();
+
+        [[nodiscard]] uint32_t get_width() const noexcept { return m_width; }
+
+        [[nodiscard]] uint32_t get_height() const noexcept { return m_height; }
+
+        // used area over total area
+        [[nodiscard]] float get_occupancy() const noexcept;
+
+      private:
+        // cuts `used` out of every free rectangle it overlaps
+        void split(const PackRect &used);
+
+        // drops free rectangles contained in others
+        void prune();
+
+        // free rectangles from scratch, after removals
+        void rebuild();
+
+        uint32_t              m_width;
+        uint32_t              m_height;
+        uint64_t              m_used_area = 0;
+        bool                  m_rebuild   = false;
+        std::vector<PackRect> m_free;
+        std::vector<PackRect> m_used;
+    };
+
+    // Offline packing of a known set: largest first, which packs much tighter than arrival order. Results are in
+    // input order, nullopt for rectangles that did not fit.
+    std::vector<std::optional<PackRect>> pack_rects(std::span<const glm::uvec2> sizes, uint32_t width,
+                                                    uint32_t height);
+
+} // namespace kat
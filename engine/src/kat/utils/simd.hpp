@@ -0,0 +1,30 @@
+#pragma once
+
+// SSE2 is part of the x64 baseline, AVX2 only when the compiler was told to target it (/arch:AVX2 or -mavx2).
+// KAT_FORCE_SCALAR turns every SIMD path off, to measure them against the scalar code.
+#if !defined(KAT_FORCE_SCALAR)
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KAT_SIMD_SSE2
+#endif
+
+#if defined(__AVX2__)
+#define KAT_SIMD_AVX2
+#endif
+#endif
+
+#if defined(KAT_SIMD_SSE2) || defined(KAT_SIMD_AVX2)
+#include <immintrin.h>
+#endif
+
+namespace kat {
+
+    // widest instruction set the SIMD paths were built with
+#if defined(KAT_SIMD_AVX2)
+    constexpr const char *SIMD_LEVEL = "AVX2";
+#elif defined(KAT_SIMD_SSE2)
+    constexpr const char *SIMD_LEVEL = "SSE2";
+#else
+    constexpr const char *SIMD_LEVEL = "scalar";
+#endif
+
+} // namespace kat
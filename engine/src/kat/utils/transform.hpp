@@ -0,0 +1,30 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace kat {
+
+    // translation * rotation * scale, written out so it costs no more than the 4x4 products it replaces
+    [[nodiscard]] inline glm::mat4 compose_transform(const glm::vec3 &translation, const glm::quat &rotation,
+                                                     const glm::vec3 &scale) noexcept {
+        const float x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+
+        glm::mat4 m;
+        m[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f) * scale.x;
+        m[1] = glm::vec4(2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f) * scale.y;
+        m[2] = glm::vec4(2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f) * scale.z;
+        m[3] = glm::vec4(translation, 1.0f);
+        return m;
+    }
+
+    // A local transform, scale applied first, then rotation (unit quaternion), then translation.
+    struct Transform {
+        glm::quat rotation    = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::vec3 translation = glm::vec3(0.0f);
+        glm::vec3 scale       = glm::vec3(1.0f);
+
+        [[nodiscard]] glm::mat4 to_matrix() const noexcept { return compose_transform(translation, rotation, scale); }
+    };
+
+} // namespace kat
@@ -6,6 +6,7 @@
 
 
 #include "input_manager.hpp"
+#include "renderer/destruction_queue.hpp"
 
 #include <windowsx.h>
 #include <winuser.h>
@@ -125,7 +126,17 @@ namespace kat {
     }
 
     Window::~Window() {
-        wglMakeCurrent(nullptr, nullptr);
+        // the context takes its objects with it, delete what is queued for it while they still exist
+        const HGLRC previous_context = wglGetCurrentContext();
+        const HDC   previous_dc      = wglGetCurrentDC();
+        make_current();
+        DestructionQueue::get().flush();
+
+        // other windows keep drawing with whatever context was current before
+        if (previous_context && previous_context != m_hglrc)
+            wglMakeCurrent(previous_dc, previous_context);
+        else
+            wglMakeCurrent(nullptr, nullptr);
         wglDeleteContext(m_hglrc);
         ReleaseDC(m_hwnd, m_dc);
         DestroyWindow(m_hwnd);
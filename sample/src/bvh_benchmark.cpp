@@ -0,0 +1,97 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "kat/utils/bvh.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// Times the Bvh on boxes scattered through a cube: a full build, moving a tenth of the objects followed by refit(),
+// frustum and box queries and raycasts. The object count is the first argument, a million by default.
+
+namespace {
+    template <typename Fn>
+    double time_ms(Fn &&fn) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    const size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+
+    constexpr float EXTENT  = 1000.0f;
+    constexpr int   QUERIES = 1000;
+    constexpr int   RAYS    = 100'000;
+
+    std::mt19937                          rng(1234);
+    std::uniform_real_distribution<float> position(-EXTENT, EXTENT);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+    std::vector<kat::Aabb> bounds(count);
+    for (kat::Aabb &box : bounds) {
+        const glm::vec3 center(position(rng), position(rng), position(rng));
+        const glm::vec3 extents(size(rng), size(rng), size(rng));
+        box = { center - extents, center + extents };
+    }
+
+    kat::Bvh bvh(0.5f);
+
+    std::cout << count << " objects" << std::endl;
+    std::cout << "build: " << time_ms([&] { bvh.build(bounds); }) << " ms, SAH cost " << bvh.get_sah_cost()
+              << std::endl;
+
+    // small moves, some within the margin and some not
+    const double update = time_ms([&] {
+        for (size_t id = 0; id < count; id += 10) {
+            const glm::vec3 offset = glm::vec3(unit(rng), unit(rng), unit(rng)) * 2.0f;
+            bvh.update(static_cast<uint32_t>(id), { bounds[id].min + offset, bounds[id].max + offset });
+        }
+    });
+    const double refit = time_ms([&] { bvh.refit(); });
+    std::cout << "update a tenth: " << update << " ms, refit: " << refit << " ms, SAH cost " << bvh.get_sah_cost()
+              << std::endl;
+
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, EXTENT * 2.0f);
+
+    std::vector<uint32_t> out;
+    size_t                found = 0;
+
+    const double frustum = time_ms([&] {
+        for (int i = 0; i < QUERIES; i++) {
+            const float     angle = glm::two_pi<float>() * static_cast<float>(i) / QUERIES;
+            const glm::vec3 eye   = glm::vec3(std::cos(angle), 0.2f, std::sin(angle)) * EXTENT * 0.5f;
+            bvh.query_frustum(
+                kat::Frustum::from_matrix(projection * glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f))),
+                out);
+            found += out.size();
+        }
+    });
+    std::cout << "query_frustum: " << frustum / QUERIES << " ms, " << found / QUERIES << " objects" << std::endl;
+
+    found             = 0;
+    const double aabb = time_ms([&] {
+        for (int i = 0; i < QUERIES; i++) {
+            const glm::vec3 center(position(rng), position(rng), position(rng));
+            bvh.query_aabb({ center - 50.0f, center + 50.0f }, out);
+            found += out.size();
+        }
+    });
+    std::cout << "query_aabb: " << aabb / QUERIES << " ms, " << found / QUERIES << " objects" << std::endl;
+
+    size_t       hits = 0;
+    const double rays = time_ms([&] {
+        for (int i = 0; i < RAYS; i++) {
+            const kat::Ray ray = { glm::vec3(position(rng), position(rng), position(rng)),
+                                   glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng))) };
+            if (bvh.raycast(ray))
+                hits++;
+        }
+    });
+    std::cout << "raycast: " << rays * 1000.0 / RAYS << " us, " << hits * 100 / RAYS << "% hit" << std::endl;
+}
@@ -0,0 +1,173 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <kat/engine.hpp>
+#include <kat/window.hpp>
+
+#include "kat/assets/gltf_importer.hpp"
+
+#include <Windows.h>
+#include <psapi.h>
+
+// Imports a glTF asset a few times and prints the import time and the process's peak memory. The asset is the first
+// argument; without one a flat grid of two million triangles is written to a temporary .glb first. Pass
+// --meshlets to also build meshlets.
+
+namespace {
+    constexpr int RUNS = 3;
+
+    // quads per side of the generated grid, two triangles each
+    constexpr uint32_t GRID_QUADS = 1000;
+
+    struct MemoryUsage {
+        size_t peak_working_set;
+        size_t peak_private;
+    };
+
+    MemoryUsage memory_usage() {
+        PROCESS_MEMORY_COUNTERS counters{};
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        return { counters.PeakWorkingSetSize, counters.PeakPagefileUsage };
+    }
+
+    template <typename T>
+    void write(std::ofstream &out, const std::vector<T> &values) {
+        out.write(reinterpret_cast<const char *>(values.data()),
+                  static_cast<std::streamsize>(values.size() * sizeof(T)));
+    }
+
+    // positions, normals, uvs and 32 bit indices of a quads x quads grid in the xz plane, written a row at a time so
+    // the generator doesn't raise the peak the import is measured against
+    void write_grid(const std::string &path, uint32_t quads) {
+        const uint32_t side     = quads + 1;
+        const size_t   vertices = static_cast<size_t>(side) * side;
+        const size_t   indices  = static_cast<size_t>(quads) * quads * 6;
+
+        const size_t positions_size = vertices * 12;
+        const size_t normals_size   = vertices * 12;
+        const size_t uvs_size       = vertices * 8;
+        const size_t indices_size   = indices * 4;
+        const size_t bin_size       = positions_size + normals_size + uvs_size + indices_size;
+
+        auto view = [](size_t offset, size_t length, int target) {
+            return "{\"buffer\":0,\"byteOffset\":" + std::to_string(offset) + ",\"byteLength\":" +
+                   std::to_string(length) + ",\"target\":" + std::to_string(target) + "}";
+        };
+        auto accessor = [](int view, int component, size_t count, const char *type, const std::string &bounds) {
+            return "{\"bufferView\":" + std::to_string(view) + ",\"componentType\":" + std::to_string(component) +
+                   ",\"count\":" + std::to_string(count) + ",\"type\":\"" + type + "\"" + bounds + "}";
+        };
+
+        std::string json =
+            "{\"asset\":{\"version\":\"2.0\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+            "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1,\"TEXCOORD_0\":2},"
+            "\"indices\":3}]}],\"buffers\":[{\"byteLength\":" +
+            std::to_string(bin_size) + "}],\"bufferViews\":[" + view(0, positions_size, 34962) + "," +
+            view(positions_size, normals_size, 34962) + "," + view(positions_size + normals_size, uvs_size, 34962) +
+            "," + view(positions_size + normals_size + uvs_size, indices_size, 34963) + "],\"accessors\":[" +
+            accessor(0, 5126, vertices, "VEC3",
+                     ",\"min\":[0,0,0],\"max\":[" + std::to_string(quads) + ",0," + std::to_string(quads) + "]") +
+            "," + accessor(1, 5126, vertices, "VEC3", "") + "," + accessor(2, 5126, vertices, "VEC2", "") + "," +
+            accessor(3, 5125, indices, "SCALAR", "") + "]}";
+        json.resize((json.size() + 3) & ~size_t(3), ' ');
+
+        const auto json_length = static_cast<uint32_t>(json.size());
+        const auto bin_length  = static_cast<uint32_t>(bin_size);
+        const auto length      = static_cast<uint32_t>(12 + 8 + json.size() + 8 + bin_size);
+
+        std::ofstream out(path, std::ios::binary);
+        write(out, std::vector<uint32_t>{ 0x46546C67, 2, length, json_length, 0x4E4F534A });
+        out.write(json.data(), static_cast<std::streamsize>(json.size()));
+        write(out, std::vector<uint32_t>{ bin_length, 0x004E4942 });
+
+        std::vector<float> row;
+        for (int attribute = 0; attribute < 3; attribute++) {
+            for (uint32_t z = 0; z < side; z++) {
+                row.clear();
+                for (uint32_t x = 0; x < side; x++) {
+                    const float fx = static_cast<float>(x), fz = static_cast<float>(z);
+                    if (attribute == 0)
+                        row.insert(row.end(), { fx, 0.0f, fz });
+                    else if (attribute == 1)
+                        row.insert(row.end(), { 0.0f, 1.0f, 0.0f });
+                    else
+                        row.insert(row.end(), { fx / static_cast<float>(quads), fz / static_cast<float>(quads) });
+                }
+                write(out, row);
+            }
+        }
+
+        std::vector<uint32_t> index_row;
+        for (uint32_t z = 0; z < quads; z++) {
+            index_row.clear();
+            for (uint32_t x = 0; x < quads; x++) {
+                const uint32_t i = z * side + x;
+                index_row.insert(index_row.end(), { i, i + side, i + 1, i + 1, i + side, i + side + 1 });
+            }
+            write(out, index_row);
+        }
+
+        if (!out)
+            throw std::runtime_error("Failed to write " + path);
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string path;
+    bool        meshlets = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--meshlets") == 0)
+            meshlets = true;
+        else
+            path = argv[i];
+    }
+
+    if (path.empty()) {
+        path = (std::filesystem::temp_directory_path() / "kat_gltf_benchmark.glb").string();
+        write_grid(path, GRID_QUADS);
+    }
+
+    auto engine = kat::Engine::create();
+    auto window = std::make_shared<kat::Window>(engine);
+    window->make_current();
+
+    const auto              resources = engine->get_gpu_resources();
+    const kat::GltfImporter importer(engine->get_job_system(), resources);
+
+    const MemoryUsage before = memory_usage();
+
+    for (int run = 0; run < RUNS; run++) {
+        const auto start = std::chrono::steady_clock::now();
+        auto       model = importer.load(path, { .build_meshlets = meshlets });
+        const auto end   = std::chrono::steady_clock::now();
+
+        size_t triangles = 0;
+        for (const auto &mesh : model.meshes) {
+            for (const auto &primitive : mesh.primitives) {
+                triangles += primitive.mesh->get_index_count() / 3;
+            }
+        }
+
+        std::cout << path << ": " << triangles << " triangles in "
+                  << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+
+        model.meshes.clear();
+        resources->destroy(model.vertex_buffer);
+        resources->destroy(model.index_buffer);
+    }
+
+    // mapped file pages count towards the working set but not towards private memory
+    constexpr size_t  MB    = 1024 * 1024;
+    const MemoryUsage after = memory_usage();
+    std::cout << "peak working set " << after.peak_working_set / MB << " MB (" << before.peak_working_set / MB
+              << " MB before importing), peak private memory " << after.peak_private / MB << " MB ("
+              << before.peak_private / MB << " MB before importing)" << std::endl;
+}
@@ -0,0 +1,59 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+
+#include "kat/assets/mipmap.hpp"
+#include "kat/utils/job_system.hpp"
+#include "kat/utils/simd.hpp"
+
+// Times the full mip chain of a random RGBA8 image with the box and the Kaiser filter, on one thread and on the job
+// system. The image size is the first argument, 4096 by default. The SIMD paths are picked at compile time, so
+// build the engine three times to compare them: as is for SSE2, with -DKAT_ENABLE_AVX2=ON for AVX2 and with
+// -DKAT_FORCE_SCALAR=ON for the scalar code.
+
+int main(int argc, char **argv) {
+    const auto size = static_cast<uint32_t>(argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096);
+
+    constexpr int RUNS = 5;
+
+    kat::Image image;
+    image.width    = size;
+    image.height   = size;
+    image.channels = 4;
+    image.pixels.resize(static_cast<size_t>(size) * size * 4);
+
+    std::mt19937                            rng(1234);
+    std::uniform_int_distribution<uint32_t> byte(0, 255);
+    for (std::byte &b : image.pixels) {
+        b = static_cast<std::byte>(byte(rng));
+    }
+
+    auto job_system = kat::JobSystem::create();
+
+    std::cout << size << "x" << size << " RGBA8, " << kat::SIMD_LEVEL << " paths" << std::endl;
+
+    for (const kat::MipFilter filter : { kat::MipFilter::Box, kat::MipFilter::Kaiser }) {
+        for (const bool threaded : { false, true }) {
+            // the best of a few runs, the first one also pays for page faults
+            double best = 0.0;
+            for (int run = 0; run < RUNS; run++) {
+                kat::Image source = image;
+
+                const auto start = std::chrono::steady_clock::now();
+                const auto chain =
+                    kat::generate_mip_chain(std::move(source), { .filter = filter }, threaded ? job_system : nullptr);
+                const auto elapsed = std::chrono::steady_clock::now() - start;
+
+                const double ms = std::chrono::duration<double, std::milli>(elapsed).count();
+                if (run == 0 || ms < best)
+                    best = ms;
+            }
+
+            std::cout << (filter == kat::MipFilter::Box ? "box" : "kaiser") << ", "
+                      << (threaded ? "job system" : "one thread") << ": " << best << " ms" << std::endl;
+        }
+    }
+}
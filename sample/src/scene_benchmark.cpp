@@ -0,0 +1,69 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "kat/scene/scene_graph.hpp"
+#include "kat/utils/job_system.hpp"
+
+// Times SceneGraph::update() on a forest of nodes with 8 children each, on one thread and on the job system: the
+// first update after building it, a full update with every node moved, and a sparse update with one node in a
+// thousand moved. The node count is the first argument, a million by default.
+
+namespace {
+    template <typename Fn>
+    double time_ms(Fn &&fn) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    const size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+
+    constexpr size_t ROOTS   = 64;
+    constexpr size_t FANOUT  = 8;
+    constexpr size_t SPARSE  = 1000; // one moved node in this many
+    constexpr int    UPDATES = 20;
+
+    auto job_system = kat::JobSystem::create();
+
+    for (const auto &jobs : { std::shared_ptr<kat::JobSystem>(), job_system }) {
+        auto graph = kat::SceneGraph::create(jobs);
+
+        std::mt19937                          rng(1234);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::uniform_int_distribution<size_t> pick(0, count - 1);
+
+        // breadth first ids, the parent of node i is node (i - ROOTS) / FANOUT
+        std::vector<kat::NodeId> nodes(count);
+        for (size_t i = 0; i < count; i++) {
+            const kat::NodeId    parent = i < ROOTS ? kat::NO_NODE : nodes[(i - ROOTS) / FANOUT];
+            const kat::Transform local  = { .translation = glm::vec3(unit(rng), unit(rng), unit(rng)) };
+            nodes[i]                    = graph->create_node(parent, local);
+        }
+
+        const double first = time_ms([&] { graph->update(); });
+
+        double full = 0.0;
+        for (int frame = 0; frame < UPDATES; frame++) {
+            for (const kat::NodeId node : nodes) {
+                graph->set_translation(node, glm::vec3(unit(rng), unit(rng), unit(rng)));
+            }
+            full += time_ms([&] { graph->update(); });
+        }
+
+        double sparse = 0.0;
+        for (int frame = 0; frame < UPDATES; frame++) {
+            for (size_t i = 0; i < count / SPARSE; i++) {
+                graph->set_translation(nodes[pick(rng)], glm::vec3(unit(rng), unit(rng), unit(rng)));
+            }
+            sparse += time_ms([&] { graph->update(); });
+        }
+
+        std::cout << count << " nodes, " << (jobs ? "job system" : "one thread") << ": first update " << first
+                  << " ms, full " << full / UPDATES << " ms, sparse " << sparse / UPDATES << " ms" << std::endl;
+    }
+}
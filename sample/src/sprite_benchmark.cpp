@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <kat/engine.hpp>
+#include <kat/window.hpp>
+
+#include "kat/renderer/renderer.hpp"
+#include "kat/renderer/sprite_batch.hpp"
+#include "kat/utils/job_system.hpp"
+
+// Bounces untextured sprites around the window and prints the frame rate once a second. The sprite count is the
+// first argument, a million by default.
+
+struct Particle {
+    glm::vec2 position;
+    glm::vec2 velocity;
+    uint32_t  color;
+};
+
+int main(int argc, char **argv) {
+    const size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000;
+
+    auto engine = kat::Engine::create();
+    auto window = std::make_shared<kat::Window>(engine);
+
+    window->set_resizable(true);
+
+    engine->set_vsync(false);
+
+    engine->set_primary_window(window);
+
+    auto renderer = kat::Renderer::create(engine);
+    renderer->set_background_color(kat::colors::BLACK);
+    renderer->set_does_clear(true);
+
+    // room for three frames in flight, a frame's sprites are one allocation
+    auto batch = kat::SpriteBatch::create(engine->get_gpu_resources(),
+                                          std::max<size_t>(3 * count * sizeof(kat::SpriteInstance), 64 * 1024 * 1024));
+
+    std::mt19937                          rng(1234);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    const glm::vec2       start_size(window->get_viewport().size);
+    std::vector<Particle> particles(count);
+    for (Particle &particle : particles) {
+        particle.position = glm::vec2(unit(rng), unit(rng)) * start_size;
+        particle.velocity = (glm::vec2(unit(rng), unit(rng)) - 0.5f) * 400.0f;
+        particle.color    = kat::pack_color({ unit(rng), unit(rng), unit(rng), 1.0f });
+    }
+
+    auto   last_frame  = std::chrono::steady_clock::now();
+    auto   last_report = last_frame;
+    size_t frames      = 0;
+
+    auto redraw_signal = window->get_redraw_signal().connect([&] {
+        const auto  now = std::chrono::steady_clock::now();
+        const float dt  = std::min(std::chrono::duration<float>(now - last_frame).count(), 0.1f);
+        last_frame      = now;
+
+        engine->set_viewport_to_window(window);
+        const kat::Viewport viewport = window->get_viewport();
+        const glm::vec2     bounds(viewport.size);
+
+        renderer->begin();
+        batch->begin(viewport);
+
+        // moved and written straight into the batch on every core
+        const std::span<kat::SpriteInstance> sprites = batch->allocate(nullptr, particles.size());
+        engine->get_job_system()->parallel_for(particles.size(), 16 * 1024, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                Particle &particle = particles[i];
+                particle.position += particle.velocity * dt;
+
+                for (int axis = 0; axis < 2; axis++) {
+                    if (particle.position[axis] < 0.0f || particle.position[axis] > bounds[axis]) {
+                        particle.position[axis] = std::clamp(particle.position[axis], 0.0f, bounds[axis]);
+                        particle.velocity[axis] = -particle.velocity[axis];
+                    }
+                }
+
+                sprites[i] = { particle.position, glm::vec2(4.0f), { 0.0f, 0.0f, 1.0f, 1.0f }, glm::vec2(0.5f), 0.0f,
+                               particle.color };
+            }
+        });
+
+        batch->end();
+        renderer->end();
+
+        frames++;
+        if (now - last_report >= std::chrono::seconds(1)) {
+            const float seconds = std::chrono::duration<float>(now - last_report).count();
+            std::cout << count << " sprites: " << static_cast<float>(frames) / seconds << " fps, "
+                      << batch->get_draw_call_count() << " draw calls" << std::endl;
+
+            frames      = 0;
+            last_report = now;
+        }
+    });
+
+    engine->mainloop();
+}